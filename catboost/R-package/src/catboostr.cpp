@@ -383,7 +383,7 @@ SEXP CatBoostPrepareEval_R(SEXP approxParam, SEXP typeParam, SEXP columnCountPar
 SEXP CatBoostShrinkModel_R(SEXP modelParam, SEXP treeCountStartParam, SEXP treeCountEndParam) {
     R_API_BEGIN();
     TFullModelHandle model = reinterpret_cast<TFullModelHandle>(R_ExternalPtrAddr(modelParam));
-    model->ObliviousTrees.Truncate(asInteger(treeCountStartParam), asInteger(treeCountEndParam));
+    model->Truncate(asInteger(treeCountStartParam), asInteger(treeCountEndParam));
     R_API_END();
     return ScalarLogical(1);
 }
@@ -220,6 +220,12 @@ void ParseCommandLine(int argc, const char* argv[],
         (*plainJsonPtr)["metric_period"] = FromString<int>(period);
     });
 
+    parser.AddLongOption("async-metrics", "calculate metrics of an iteration while the next tree is built, overfitting detector reacts one iteration later")
+        .NoArgument()
+        .Handler0([plainJsonPtr]() {
+            (*plainJsonPtr)["async_metrics"] = true;
+        });
+
     parser.AddLongOption("snapshot-file", "use progress file for restoring progress after crashes")
         .RequiredArgument("PATH")
         .Handler1T<TString>([plainJsonPtr](const TString& path) {
@@ -227,6 +233,18 @@ void ParseCommandLine(int argc, const char* argv[],
             (*plainJsonPtr)["snapshot_file"] = path;
         });
 
+    parser.AddLongOption("trace-file", "write chrome trace events of training stages to file")
+        .RequiredArgument("PATH")
+        .Handler1T<TString>([plainJsonPtr](const TString& path) {
+            (*plainJsonPtr)["trace_file"] = path;
+        });
+
+    parser.AddLongOption("snapshot-codec", "compress progress file with given block codec, e.g. lz4 or zstd08_1")
+        .RequiredArgument("CODEC")
+        .Handler1T<TString>([plainJsonPtr](const TString& codec) {
+            (*plainJsonPtr)["snapshot_codec"] = codec;
+        });
+
     parser.AddLongOption("output-columns")
             .RequiredArgument("Comma separated list of column indexes")
             .Handler1T<TString>([plainJsonPtr](const TString& indexesLine) {
@@ -430,6 +448,7 @@ void ParseCommandLine(int argc, const char* argv[],
               " Poisson,"
               " Bayesian,"
               " Bernoulli,"
+              " GOSS (CPU only),"
               " No. By default CatBoost uses bayesian bootstrap type")
         .Handler1T<TString>([plainJsonPtr](const TString& type) {
             (*plainJsonPtr)["bootstrap_type"] = type;
@@ -456,7 +475,17 @@ void ParseCommandLine(int argc, const char* argv[],
         .Handler1T<float>([plainJsonPtr](float rate) {
             (*plainJsonPtr)["subsample"] = rate;
         })
-        .Help("Controls sample rate for bagging. Could be used iff bootstrap-type is Poisson, Bernoulli. Possible values are from (0, 1]; 0.66 by default."
+        .Help("Controls sample rate for bagging. Could be used iff bootstrap-type is Poisson, Bernoulli, GOSS. Possible values are from (0, 1]; 0.66 by default."
+              " For GOSS it is the sample rate of documents outside of the top fraction."
+        );
+
+    parser
+        .AddLongOption("top-fraction")
+        .RequiredArgument("Float")
+        .Handler1T<float>([plainJsonPtr](float fraction) {
+            (*plainJsonPtr)["top_fraction"] = fraction;
+        })
+        .Help("CPU only. Fraction of documents with largest gradients which are always taken by GOSS bootstrap. Possible values are from (0, 1); 0.2 by default."
         );
 
     parser
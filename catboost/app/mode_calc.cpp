@@ -3,11 +3,14 @@
 #include "proceed_pool_in_blocks.h"
 
 #include <catboost/libs/data/load_data.h>
+#include <catboost/libs/data_util/compressed_stream.h>
 #include <catboost/libs/algo/apply.h>
 #include <catboost/libs/helpers/eval_helpers.h>
 #include <catboost/libs/helpers/multiclass_label_helpers/visible_label_helper.h>
+#include <catboost/libs/logging/trace_session.h>
 #include <catboost/libs/model/model.h>
 
+#include <library/chromium_trace/interface.h>
 #include <library/getopt/small/last_getopt.h>
 #include <library/threading/local_executor/local_executor.h>
 
@@ -26,29 +29,24 @@ static TEvalResult Apply(
 {
     TEvalResult resultApprox;
     TVector<TVector<TVector<double>>>& rawValues = resultApprox.GetRawValuesRef();
-    rawValues.resize(1);
-    if (pool.Docs.Baseline.ysize() > 0) {
-        rawValues[0].assign(pool.Docs.Baseline.begin(), pool.Docs.Baseline.end());
-    } else {
-        rawValues[0].resize(model.ObliviousTrees.ApproxDimension, TVector<double>(pool.Docs.GetDocCount(), 0.0));
-    }
-    TModelCalcerOnPool modelCalcerOnPool(model, pool, *executor);
-    TVector<double> flatApprox;
+    rawValues.clear();
+    TStagedModelCalcer stagedModelCalcer(model, pool, begin, end, Max<size_t>(evalPeriod, 1), *executor);
     TVector<TVector<double>> approx;
-    for (; begin < end; begin += evalPeriod) {
-        modelCalcerOnPool.ApplyModelMulti(EPredictionType::RawFormulaVal,
-                                          begin,
-                                          Min(begin + evalPeriod, end),
-                                          &flatApprox,
-                                          &approx);
-
-        for (size_t i = 0; i < approx.size(); ++i) {
-            for (size_t j = 0; j < approx[0].size(); ++j) {
-                rawValues.back()[i][j] += approx[i][j];
+    while (stagedModelCalcer.Next(EPredictionType::RawFormulaVal, &approx)) {
+        if (pool.Docs.Baseline.ysize() > 0) {
+            for (size_t i = 0; i < approx.size(); ++i) {
+                for (size_t j = 0; j < approx[0].size(); ++j) {
+                    approx[i][j] += pool.Docs.Baseline[i][j];
+                }
             }
         }
-        if (begin + evalPeriod < end) {
-            rawValues.push_back(rawValues.back());
+        rawValues.push_back(approx);
+    }
+    if (rawValues.empty()) {
+        if (pool.Docs.Baseline.ysize() > 0) {
+            rawValues.emplace_back(pool.Docs.Baseline.begin(), pool.Docs.Baseline.end());
+        } else {
+            rawValues.emplace_back(model.ObliviousTrees.ApproxDimension, TVector<double>(pool.Docs.GetDocCount(), 0.0));
         }
     }
     return resultApprox;
@@ -58,6 +56,7 @@ int mode_calc(int argc, const char* argv[]) {
     TAnalyticalModeCommonParams params;
     size_t iterationsLimit = 0;
     size_t evalPeriod = 0;
+    TString traceFile;
 
     auto parser = NLastGetopt::TOpts();
     parser.AddHelpOption();
@@ -84,6 +83,9 @@ int mode_calc(int argc, const char* argv[]) {
         });
     parser.AddLongOption("eval-period", "predictions are evaluated every <eval-period> trees")
         .StoreResult(&evalPeriod);
+    parser.AddLongOption("trace-file", "write chrome trace events of model application to file")
+        .RequiredArgument("PATH")
+        .StoreResult(&traceFile);
     parser.SetFreeArgsNum(0);
     NLastGetopt::TOptsParseResult parserResult{&parser, argc, argv};
 
@@ -108,7 +110,12 @@ int mode_calc(int argc, const char* argv[]) {
     }
 
     const int blockSize = Max<int>(32, static_cast<int>(10000. / (static_cast<double>(iterationsLimit) / evalPeriod) / model.ObliviousTrees.ApproxDimension));
-    TOFStream outputStream(params.OutputPath);
+    THolder<TTraceSession> traceSession;
+    if (!traceFile.empty()) {
+        traceSession = MakeHolder<TTraceSession>(traceFile);
+    }
+
+    THolder<IOutputStream> outputStream = NCB::OpenFileOutput(params.OutputPath);
     NPar::TLocalExecutor executor;
     executor.RunAdditionalThreads(params.ThreadCount - 1);
 
@@ -118,6 +125,7 @@ int mode_calc(int argc, const char* argv[]) {
         if (IsFirstBlock) {
             ValidateColumnOutput(params.OutputColumnsIds, poolPart, true);
         }
+        CHROMIUM_TRACE_SCOPE("Apply pool block");
         auto approx = Apply(model, poolPart, 0, iterationsLimit, evalPeriod, &executor);
         TVisibleLabelsHelper visibleLabelsHelper;
         if (model.ObliviousTrees.ApproxDimension > 1) {  // is multiclass?
@@ -135,7 +143,7 @@ int mode_calc(int argc, const char* argv[]) {
                 visibleLabelsHelper,
                 poolPart,
                 true,
-                &outputStream,
+                outputStream.Get(),
                 // TODO: src file columns output is incompatible with block processing
                 /*testSetPath*/NCB::TPathWithScheme(),
                 /*testFileWhichOf*/ {0, 0},
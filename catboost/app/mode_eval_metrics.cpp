@@ -6,6 +6,7 @@
 #include <catboost/libs/algo/plot.h>
 #include <catboost/libs/data/load_data.h>
 #include <catboost/libs/metrics/metric.h>
+#include <catboost/libs/options/system_options.h>
 
 #include <util/system/fs.h>
 #include <util/string/iterator.h>
@@ -19,6 +20,7 @@ struct TModeEvalMetricsParams {
     TString MetricsDescription;
     TString ResultDirectory;
     TString TmpDir;
+    TString ApproxRamLimit;
 
     void BindParserOpts(NLastGetopt::TOpts& parser) {
         parser.AddLongOption("ntree-start", "Start iteration.")
@@ -44,6 +46,10 @@ struct TModeEvalMetricsParams {
                 .RequiredArgument("String")
                 .DefaultValue("-")
                 .StoreResult(&TmpDir);
+        parser.AddLongOption("approx-ram-limit", "Memory for approxes of non-additive metrics, the rest is stored in tmp-dir.\nAllowed suffixes: GB, MB, KB in different cases")
+                .RequiredArgument("String")
+                .DefaultValue("1GB")
+                .StoreResult(&ApproxRamLimit);
     }
 };
 
@@ -124,7 +130,7 @@ int mode_eval_metrics(int argc, const char* argv[]) {
 
     bool calcOnParts = false;
     parser.AddLongOption("calc-on-parts")
-        .SetFlag(&saveStats)
+        .SetFlag(&calcOnParts)
         .NoArgument();
 
     parser.SetFreeArgsNum(0);
@@ -164,6 +170,7 @@ int mode_eval_metrics(int argc, const char* argv[]) {
         plotParams.TmpDir,
         metrics
     );
+    plotCalcer.SetApproxMemoryBudget(ParseMemorySizeDescription(plotParams.ApproxRamLimit));
 
     TLabelConverter labelConverter = BuildLabelConverter(model);
 
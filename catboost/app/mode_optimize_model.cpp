@@ -0,0 +1,48 @@
+#include "modes.h"
+
+#include <catboost/libs/helpers/exception.h>
+#include <catboost/libs/model/model.h>
+#include <catboost/libs/model/tree_reordering.h>
+
+#include <library/getopt/small/last_getopt.h>
+
+
+static NCatBoostFbs::ELeafValuesPrecision ParseLeafValuesPrecision(const TString& name) {
+    for (int precision = NCatBoostFbs::ELeafValuesPrecision_MIN; precision <= NCatBoostFbs::ELeafValuesPrecision_MAX; ++precision) {
+        if (name == NCatBoostFbs::EnumNamesELeafValuesPrecision()[precision]) {
+            return static_cast<NCatBoostFbs::ELeafValuesPrecision>(precision);
+        }
+    }
+    ythrow TCatboostException() << "Unknown leaf values precision " << name << ", should be one of Double, Float, Int16";
+}
+
+int mode_optimize_model(int argc, const char* argv[]) {
+    TString modelPath;
+    TString outputModelPath;
+    size_t preservedTreeRangeSize = 0;
+    TString leafValuesPrecision;
+    auto parser = NLastGetopt::TOpts();
+    parser.AddHelpOption();
+    parser.AddLongOption('m', "model-path", "path to model")
+        .StoreResult(&modelPath)
+        .DefaultValue("model.cbm");
+    parser.AddLongOption('o', "output-model-path", "path to optimized model, input model is overwritten by default")
+        .RequiredArgument("PATH")
+        .StoreResult(&outputModelPath);
+    parser.AddLongOption("preserve-tree-ranges", "reorder trees only inside consecutive ranges of this size, so staged predictions with this eval period are not changed; 0 means whole model")
+        .RequiredArgument("INT")
+        .StoreResult(&preservedTreeRangeSize);
+    parser.AddLongOption("leaf-values-precision", "compact leaf values encoding: Double, Float or Int16, by default leaf values are not changed")
+        .RequiredArgument("PRECISION")
+        .StoreResult(&leafValuesPrecision);
+    parser.SetFreeArgsMax(0);
+    NLastGetopt::TOptsParseResult parserResult{&parser, argc, argv};
+
+    TFullModel model = ReadModel(modelPath);
+    OptimizeTreeOrder(preservedTreeRangeSize, &model);
+    if (!leafValuesPrecision.empty()) {
+        QuantizeLeafValues(ParseLeafValuesPrecision(leafValuesPrecision), &model);
+    }
+    ExportModel(model, outputModelPath.empty() ? modelPath : outputModelPath);
+    return 0;
+}
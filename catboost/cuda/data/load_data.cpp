@@ -1,6 +1,8 @@
 #include "load_data.h"
 #include <catboost/libs/helpers/permutation.h>
 
+#include <util/generic/algorithm.h>
+
 namespace NCatboostCuda {
     void TDataProviderBuilder::StartNextBlock(ui32 blockSize) {
         Cursor = DataProvider.Targets.size();
@@ -23,7 +25,15 @@ namespace NCatboostCuda {
 
         for (ui32 featureId = 0; featureId < FeatureBlobs.size(); ++featureId) {
             if (IgnoreFeatures.count(featureId) == 0) {
-                FeatureBlobs[featureId].resize(newDataSize * GetBytesPerFeature(featureId));
+                auto& blob = FeatureBlobs[featureId];
+                blob.resize(newDataSize * GetBytesPerFeature(featureId));
+                // features which are not added are zero, zero float is stored as zero bytes, but zero bin can be nonzero
+                if (FeatureTypes[featureId] == EFeatureValuesType::BinarizedFloat) {
+                    const ui8 zeroBin = Binarize<ui8>(Borders[featureId], 0.0f);
+                    if (zeroBin != 0) {
+                        Fill(blob.begin() + Cursor, blob.end(), zeroBin);
+                    }
+                }
             }
         }
 
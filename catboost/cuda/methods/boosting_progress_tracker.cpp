@@ -133,7 +133,7 @@ namespace NCatboostCuda {
             return;
         }
 
-        TProgressHelper(GpuProgressLabel()).CheckedLoad(OutputFiles.SnapshotFile, [&](TIFStream* in) {
+        TProgressHelper(GpuProgressLabel()).CheckedLoad(OutputFiles.SnapshotFile, [&](IInputStream* in) {
             TString taskOptionsStr;
             ::Load(in, taskOptionsStr);
             ::Load(in, History);
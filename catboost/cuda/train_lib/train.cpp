@@ -132,7 +132,7 @@ namespace NCatboostCuda {
                 return nullptr;
             } else {
                 TString jsonOptionsStr;
-                TProgressHelper(ToString<ETaskType>(options->GetTaskType())).CheckedLoad(snapshotFullPath, [&](TIFStream* in) {
+                TProgressHelper(ToString<ETaskType>(options->GetTaskType())).CheckedLoad(snapshotFullPath, [&](IInputStream* in) {
                     ::Load(in, jsonOptionsStr);
                 });
 
@@ -5,13 +5,71 @@
 
 #include <catboost/libs/helpers/eval_helpers.h>
 
+#include <library/chromium_trace/interface.h>
 
-TVector<TVector<double>> ApplyModelMulti(const TFullModel& model,
-                                         const TPool& pool,
-                                         const EPredictionType predictionType,
-                                         int begin, /*= 0*/
-                                         int end,   /*= 0*/
-                                         NPar::TLocalExecutor& executor) {
+#include <util/generic/singleton.h>
+#include <util/system/atomic.h>
+#include <util/system/guard.h>
+#include <util/system/spinlock.h>
+
+namespace {
+    struct TApplyExecutor {
+        TAdaptiveLock Lock;
+        NPar::TLocalExecutor Executor;
+    };
+}
+
+NPar::TLocalExecutor& GetApplyExecutor(int threadCount) {
+    TApplyExecutor& applyExecutor = *Singleton<TApplyExecutor>();
+    with_lock (applyExecutor.Lock) {
+        const int missingThreadCount = threadCount - 1 - applyExecutor.Executor.GetThreadCount();
+        if (missingThreadCount > 0) {
+            applyExecutor.Executor.RunAdditionalThreads(missingThreadCount);
+        }
+    }
+    return applyExecutor.Executor;
+}
+
+// Chunks are small enough for their features to stay in cache, and there are several chunks per thread
+static NPar::TLocalExecutor::TExecRangeParams GetApplyChunkParams(int docCount, int threadCount) {
+    constexpr int maxChunkSize = 16 * FORMULA_EVALUATION_BLOCK_SIZE;
+    constexpr int chunksPerThread = 4;
+    const int minChunkCount = threadCount * chunksPerThread;
+    const int chunkSize = Max<int>(
+        FORMULA_EVALUATION_BLOCK_SIZE,
+        Min<int>(maxChunkSize, (docCount + minChunkCount - 1) / minChunkCount)
+    );
+    NPar::TLocalExecutor::TExecRangeParams chunkParams(0, docCount);
+    chunkParams.SetBlockSize(chunkSize);
+    return chunkParams;
+}
+
+// At most threadCount threads of the executor take chunks one by one, so a slow chunk doesn't hold the others
+template <class TChunkBody>
+static void ExecApplyChunks(
+    const NPar::TLocalExecutor::TExecRangeParams& chunkParams,
+    int threadCount,
+    NPar::TLocalExecutor* executor,
+    TChunkBody&& chunkBody
+) {
+    const int chunkCount = chunkParams.GetBlockCount();
+    TAtomic nextChunkId = 0;
+    executor->ExecRange([&](int /*workerId*/) {
+        for (int chunkId = AtomicGetAndIncrement(nextChunkId); chunkId < chunkCount; chunkId = AtomicGetAndIncrement(nextChunkId)) {
+            const int chunkFirstId = chunkParams.FirstId + chunkId * chunkParams.GetBlockSize();
+            const int chunkLastId = Min(chunkParams.LastId, chunkFirstId + chunkParams.GetBlockSize());
+            chunkBody(chunkId, chunkFirstId, chunkLastId);
+        }
+    }, 0, Min(threadCount, chunkCount), NPar::TLocalExecutor::WAIT_COMPLETE);
+}
+
+static TVector<TVector<double>> ApplyModelMultiImpl(const TFullModel& model,
+                                                    const TPool& pool,
+                                                    const EPredictionType predictionType,
+                                                    int begin,
+                                                    int end,
+                                                    int threadCount,
+                                                    NPar::TLocalExecutor& executor) {
     CB_ENSURE(pool.Docs.GetDocCount() != 0, "Pool should not be empty");
     const size_t poolCatFeaturesCount = pool.CatFeatures.size();
     CB_ENSURE(poolCatFeaturesCount >= model.ObliviousTrees.GetNumCatFeatures(), "Insufficient categorical features count");
@@ -19,9 +77,7 @@ TVector<TVector<double>> ApplyModelMulti(const TFullModel& model,
     const int docCount = (int)pool.Docs.GetDocCount();
     auto approxDimension = model.ObliviousTrees.ApproxDimension;
     TVector<double> approxFlat(static_cast<unsigned long>(docCount * approxDimension));
-    NPar::TLocalExecutor::TExecRangeParams blockParams(0, docCount);
-    const int threadCount = executor.GetThreadCount() + 1; //one for current thread
-    blockParams.SetBlockCount(threadCount);
+    const auto chunkParams = GetApplyChunkParams(docCount, threadCount);
 
     if (end == 0) {
         end = model.GetTreeCount();
@@ -29,16 +85,15 @@ TVector<TVector<double>> ApplyModelMulti(const TFullModel& model,
         end = Min<int>(end, model.GetTreeCount());
     }
 
-    executor.ExecRange([&](int blockId) {
+    ExecApplyChunks(chunkParams, threadCount, &executor, [&](int /*chunkId*/, int chunkFirstId, int chunkLastId) {
+        CHROMIUM_TRACE_SCOPE("Apply block");
         TVector<TConstArrayRef<float>> repackedFeatures;
-        const int blockFirstId = blockParams.FirstId + blockId * blockParams.GetBlockSize();
-        const int blockLastId = Min(blockParams.LastId, blockFirstId + blockParams.GetBlockSize());
         for (int i = 0; i < pool.Docs.GetEffectiveFactorCount(); ++i) {
-            repackedFeatures.emplace_back(MakeArrayRef(pool.Docs.Factors[i].data() + blockFirstId, blockLastId - blockFirstId));
+            repackedFeatures.emplace_back(MakeArrayRef(pool.Docs.Factors[i].data() + chunkFirstId, chunkLastId - chunkFirstId));
         }
-        TArrayRef<double> resultRef(approxFlat.data() + blockFirstId * approxDimension, (blockLastId - blockFirstId) * approxDimension);
+        TArrayRef<double> resultRef(approxFlat.data() + chunkFirstId * approxDimension, (chunkLastId - chunkFirstId) * approxDimension);
         model.CalcFlatTransposed(repackedFeatures, begin, end, resultRef);
-    }, 0, blockParams.GetBlockCount(), NPar::TLocalExecutor::WAIT_COMPLETE);
+    });
 
     TVector<TVector<double>> approx(approxDimension, TVector<double>(docCount));
     if (approxDimension == 1) { //shortcut
@@ -55,10 +110,21 @@ TVector<TVector<double>> ApplyModelMulti(const TFullModel& model,
         //shortcut
         return approx;
     } else {
+        CHROMIUM_TRACE_SCOPE("PrepareEval");
         return PrepareEval(predictionType, approx, &executor);
     }
 }
 
+TVector<TVector<double>> ApplyModelMulti(const TFullModel& model,
+                                         const TPool& pool,
+                                         const EPredictionType predictionType,
+                                         int begin, /*= 0*/
+                                         int end,   /*= 0*/
+                                         NPar::TLocalExecutor& executor) {
+    const int threadCount = executor.GetThreadCount() + 1; //one for current thread
+    return ApplyModelMultiImpl(model, pool, predictionType, begin, end, threadCount, executor);
+}
+
 
 TVector<TVector<double>> ApplyModelMulti(const TFullModel& model,
                                          const TPool& pool,
@@ -67,17 +133,9 @@ TVector<TVector<double>> ApplyModelMulti(const TFullModel& model,
                                          int begin,
                                          int end,
                                          int threadCount) {
-    if (verbose) {
-        SetVerboseLogingMode();
-    } else {
-        SetSilentLogingMode();
-    }
-
-    NPar::TLocalExecutor executor;
-    executor.RunAdditionalThreads(threadCount - 1);
-    TVector<TVector<double>> result = ApplyModelMulti(model, pool, predictionType, begin, end, executor);
-    SetSilentLogingMode();
-    return result;
+    TThreadLoggingLevelGuard loggingLevelGuard(verbose ? ELoggingLevel::Debug : ELoggingLevel::Silent);
+    threadCount = Max(threadCount, 1);
+    return ApplyModelMultiImpl(model, pool, predictionType, begin, end, threadCount, GetApplyExecutor(threadCount));
 }
 
 TVector<double> ApplyModel(const TFullModel& model,
@@ -91,6 +149,40 @@ TVector<double> ApplyModel(const TFullModel& model,
 }
 
 
+TModelCalcerOnPool::TModelCalcerOnPool(const TFullModel& model,
+                                       const TPool& pool,
+                                       NPar::TLocalExecutor& executor,
+                                       int threadCount)
+        : Model(model)
+        , Pool(pool)
+        , Executor(executor)
+        , ThreadCount(Max(threadCount, 1))
+        , ChunkParams(0, pool.Docs.GetDocCount()) {
+    CB_ENSURE(pool.Docs.GetDocCount() != 0, "Pool should not be empty");
+    const size_t poolCatFeaturesCount = pool.CatFeatures.size();
+    CB_ENSURE(poolCatFeaturesCount >= model.ObliviousTrees.GetNumCatFeatures(), "Insufficient categorical features count. Model has " << model.ObliviousTrees.GetNumCatFeatures() << " and dataset has " << poolCatFeaturesCount << " categorical features");
+    CB_ENSURE((pool.Docs.Factors.size() - poolCatFeaturesCount) >= model.GetNumFloatFeatures(), "Insufficient float features count " << (pool.Docs.Factors.size() - poolCatFeaturesCount) << "<" << model.GetNumFloatFeatures());
+
+    ChunkParams = GetApplyChunkParams(pool.Docs.GetDocCount(), ThreadCount);
+    ChunkCalcers.resize(ChunkParams.GetBlockCount());
+
+    ExecApplyChunks(ChunkParams, ThreadCount, &executor, [&](int chunkId, int chunkFirstId, int chunkLastId) {
+        TVector<TConstArrayRef<float>> repackedFeatures;
+        for (int i = 0; i < pool.Docs.GetEffectiveFactorCount(); ++i) {
+            repackedFeatures.emplace_back(MakeArrayRef(pool.Docs.Factors[i].data() + chunkFirstId, chunkLastId - chunkFirstId));
+        }
+        auto floatAccessor = [&repackedFeatures](const TFloatFeature& floatFeature, size_t index) -> float {
+            return repackedFeatures[floatFeature.FlatFeatureIndex][index];
+        };
+
+        auto catAccessor = [&repackedFeatures](const TCatFeature& catFeature, size_t index) -> int {
+            return ConvertFloatCatFeatureToIntHash(repackedFeatures[catFeature.FlatFeatureIndex][index]);
+        };
+        ui64 docCount = repackedFeatures[0].Size();
+        ChunkCalcers[chunkId] = MakeHolder<TFeatureCachedTreeEvaluator>(Model, floatAccessor, catAccessor, docCount);
+    });
+}
+
 void TModelCalcerOnPool::ApplyModelMulti(const EPredictionType predictionType, int begin, int end, TVector<double>* flatApproxBuffer, TVector<TVector<double>>* approx) {
 
     const int docCount = Pool.Docs.GetDocCount();
@@ -104,13 +196,12 @@ void TModelCalcerOnPool::ApplyModelMulti(const EPredictionType predictionType, i
         end = Min<int>(end, Model.GetTreeCount());
     }
 
-    Executor.ExecRange([&](int blockId) {
-        auto& calcer = *ThreadCalcers[blockId];
-        const int blockFirstId = BlockParams.FirstId + blockId * BlockParams.GetBlockSize();
-        const int blockLastId = Min(BlockParams.LastId, blockFirstId + BlockParams.GetBlockSize());
-        TArrayRef<double> resultRef(approxFlat.data() + blockFirstId * approxDimension, (blockLastId - blockFirstId) * approxDimension);
+    ExecApplyChunks(ChunkParams, ThreadCount, &Executor, [&](int chunkId, int chunkFirstId, int chunkLastId) {
+        CHROMIUM_TRACE_SCOPE("Apply block");
+        auto& calcer = *ChunkCalcers[chunkId];
+        TArrayRef<double> resultRef(approxFlat.data() + chunkFirstId * approxDimension, (chunkLastId - chunkFirstId) * approxDimension);
         calcer.Calc(begin, end, resultRef);
-    }, 0, BlockParams.GetBlockCount(), NPar::TLocalExecutor::WAIT_COMPLETE);
+    });
 
     approx->resize(approxDimension);
 
@@ -136,3 +227,72 @@ void TModelCalcerOnPool::ApplyModelMulti(const EPredictionType predictionType, i
     }
     flatApproxBuffer->clear();
 }
+
+void TModelCalcerOnPool::AddFlatApprox(int begin, int end, TVector<double>* flatApprox) {
+    const int approxDimension = Model.ObliviousTrees.ApproxDimension;
+    Y_ASSERT(flatApprox->ysize() == Pool.Docs.GetDocCount() * approxDimension);
+    ExecApplyChunks(ChunkParams, ThreadCount, &Executor, [&](int chunkId, int chunkFirstId, int chunkLastId) {
+        CHROMIUM_TRACE_SCOPE("Apply block");
+        TVector<double> chunkApprox((chunkLastId - chunkFirstId) * approxDimension);
+        ChunkCalcers[chunkId]->Calc(begin, end, chunkApprox);
+        double* chunkResult = flatApprox->data() + chunkFirstId * approxDimension;
+        for (int i = 0; i < chunkApprox.ysize(); ++i) {
+            chunkResult[i] += chunkApprox[i];
+        }
+    });
+}
+
+TStagedModelCalcer::TStagedModelCalcer(const TFullModel& model,
+                                       const TPool& pool,
+                                       int begin,
+                                       int end,
+                                       int evalPeriod,
+                                       NPar::TLocalExecutor& executor)
+        : ModelCalcer(model, pool, executor)
+        , Executor(executor)
+        , ApproxDimension(model.ObliviousTrees.ApproxDimension)
+        , StageBegin(begin)
+        , End(end == 0 ? model.GetTreeCount() : Min<int>(end, model.GetTreeCount()))
+        , EvalPeriod(evalPeriod)
+        , FlatApprox(pool.Docs.GetDocCount() * ApproxDimension) {
+    CB_ENSURE(EvalPeriod > 0, "Eval period should be positive");
+}
+
+TStagedModelCalcer::TStagedModelCalcer(const TFullModel& model,
+                                       const TPool& pool,
+                                       int begin,
+                                       int end,
+                                       int evalPeriod,
+                                       int threadCount)
+        : ModelCalcer(model, pool, threadCount)
+        , Executor(GetApplyExecutor(threadCount))
+        , ApproxDimension(model.ObliviousTrees.ApproxDimension)
+        , StageBegin(begin)
+        , End(end == 0 ? model.GetTreeCount() : Min<int>(end, model.GetTreeCount()))
+        , EvalPeriod(evalPeriod)
+        , FlatApprox(pool.Docs.GetDocCount() * ApproxDimension) {
+    CB_ENSURE(EvalPeriod > 0, "Eval period should be positive");
+}
+
+bool TStagedModelCalcer::Next(const EPredictionType predictionType, TVector<TVector<double>>* prediction) {
+    if (StageBegin >= End) {
+        return false;
+    }
+    const int stageEnd = Min(StageBegin + EvalPeriod, End);
+    ModelCalcer.AddFlatApprox(StageBegin, stageEnd, &FlatApprox);
+    StageBegin = stageEnd;
+
+    const int docCount = FlatApprox.ysize() / ApproxDimension;
+    prediction->resize(ApproxDimension);
+    for (int dim = 0; dim < ApproxDimension; ++dim) {
+        auto& approxProjection = (*prediction)[dim];
+        approxProjection.yresize(docCount);
+        for (int doc = 0; doc < docCount; ++doc) {
+            approxProjection[doc] = FlatApprox[ApproxDimension * doc + dim];
+        }
+    }
+    if (predictionType != EPredictionType::RawFormulaVal) {
+        *prediction = PrepareEval(predictionType, *prediction, &Executor);
+    }
+    return true;
+}
@@ -8,6 +8,9 @@
 
 #include <util/generic/vector.h>
 
+// Process-wide executor shared by model application calls, it has at least threadCount - 1 threads
+NPar::TLocalExecutor& GetApplyExecutor(int threadCount);
+
 TVector<TVector<double>> ApplyModelMulti(const TFullModel& model,
                                          const TPool& pool,
                                          const EPredictionType predictionType,
@@ -42,37 +45,14 @@ public:
     TModelCalcerOnPool(const TFullModel& model,
                        const TPool& pool,
                        NPar::TLocalExecutor& executor)
-            : Model(model)
-            , Pool(pool)
-            , Executor(executor)
-            , BlockParams(0, pool.Docs.GetDocCount()) {
-        CB_ENSURE(pool.Docs.GetDocCount() != 0, "Pool should not be empty");
-        const size_t poolCatFeaturesCount = pool.CatFeatures.size();
-        CB_ENSURE(poolCatFeaturesCount >= model.ObliviousTrees.GetNumCatFeatures(), "Insufficient categorical features count. Model has " << model.ObliviousTrees.GetNumCatFeatures() << " and dataset has " << poolCatFeaturesCount << " categorical features");
-        CB_ENSURE((pool.Docs.Factors.size() - poolCatFeaturesCount) >= model.GetNumFloatFeatures(), "Insufficient float features count " << (pool.Docs.Factors.size() - poolCatFeaturesCount) << "<" << model.GetNumFloatFeatures());
-
-        const int threadCount = executor.GetThreadCount() + 1; //one for current thread
-        BlockParams.SetBlockCount(threadCount);
-        ThreadCalcers.resize(BlockParams.GetBlockCount());
-
-        executor.ExecRange([&](int blockId) {
-            TVector<TConstArrayRef<float>> repackedFeatures;
-            const int blockFirstId = BlockParams.FirstId + blockId * BlockParams.GetBlockSize();
-            const int blockLastId = Min(BlockParams.LastId, blockFirstId + BlockParams.GetBlockSize());
-            for (int i = 0; i < pool.Docs.GetEffectiveFactorCount(); ++i) {
-                repackedFeatures.emplace_back(MakeArrayRef(pool.Docs.Factors[i].data() + blockFirstId, blockLastId - blockFirstId));
-            }
-            auto floatAccessor = [&repackedFeatures](const TFloatFeature& floatFeature, size_t index) -> float {
-                return repackedFeatures[floatFeature.FlatFeatureIndex][index];
-            };
-
-            auto catAccessor = [&repackedFeatures](const TCatFeature& catFeature, size_t index) -> int {
-                return ConvertFloatCatFeatureToIntHash(repackedFeatures[catFeature.FlatFeatureIndex][index]);
-            };
-            ui64 docCount = repackedFeatures[0].Size();
-            ThreadCalcers[blockId] = MakeHolder<TFeatureCachedTreeEvaluator>(Model, floatAccessor, catAccessor, docCount);
-        }, 0, BlockParams.GetBlockCount(), NPar::TLocalExecutor::WAIT_COMPLETE);
+            : TModelCalcerOnPool(model, pool, executor, executor.GetThreadCount() + 1) {
+    }
 
+    // uses shared apply executor
+    TModelCalcerOnPool(const TFullModel& model,
+                       const TPool& pool,
+                       int threadCount)
+            : TModelCalcerOnPool(model, pool, GetApplyExecutor(threadCount), threadCount) {
     }
 
     void ApplyModelMulti(const EPredictionType predictionType,
@@ -80,10 +60,56 @@ public:
                          int end,
                          TVector<double>* flatApproxBuffer,
                          TVector<TVector<double>>* approx);
+
+    // Adds approx of trees [begin, end) to flatApprox of size docCount * approxDimension
+    void AddFlatApprox(int begin, int end, TVector<double>* flatApprox);
+
+private:
+    TModelCalcerOnPool(const TFullModel& model,
+                       const TPool& pool,
+                       NPar::TLocalExecutor& executor,
+                       int threadCount);
+
 private:
     const TFullModel& Model;
     const TPool& Pool;
     NPar::TLocalExecutor& Executor;
-    NPar::TLocalExecutor::TExecRangeParams BlockParams;
-    TVector<THolder<TFeatureCachedTreeEvaluator>> ThreadCalcers;
+    int ThreadCount;
+    NPar::TLocalExecutor::TExecRangeParams ChunkParams;
+    TVector<THolder<TFeatureCachedTreeEvaluator>> ChunkCalcers;
+};
+
+/*
+ * Staged model application: every call of Next returns prediction of trees [begin, stageEnd),
+ * stages end every evalPeriod trees. Pool is binarized once and approx is accumulated between stages,
+ * so a stage costs only its own trees and memory doesn't depend on the number of stages.
+ */
+class TStagedModelCalcer {
+public:
+    TStagedModelCalcer(const TFullModel& model,
+                       const TPool& pool,
+                       int begin,
+                       int end,
+                       int evalPeriod,
+                       NPar::TLocalExecutor& executor);
+
+    // uses shared apply executor
+    TStagedModelCalcer(const TFullModel& model,
+                       const TPool& pool,
+                       int begin,
+                       int end,
+                       int evalPeriod,
+                       int threadCount);
+
+    // Returns false if all stages are already evaluated
+    bool Next(const EPredictionType predictionType, TVector<TVector<double>>* prediction);
+
+private:
+    TModelCalcerOnPool ModelCalcer;
+    NPar::TLocalExecutor& Executor;
+    int ApproxDimension;
+    int StageBegin;
+    int End;
+    int EvalPeriod;
+    TVector<double> FlatApprox; // [docCount * approxDimension]
 };
@@ -123,6 +123,7 @@ void CalcApproxDersRange(
     int iteration,
     ELeavesEstimation estimationMethod,
     NPar::TLocalExecutor* localExecutor,
+    TScratchArena* scratch,
     TVector<TSum>* buckets,
     TVector<TDers>* weightedDers
 ) {
@@ -130,13 +131,16 @@ void CalcApproxDersRange(
     blockParams.SetBlockCount(CB_THREAD_LIMIT);
 
     const int leafCount = buckets->ysize();
-    TVector<TVector<TDers>> blockBucketDers(blockParams.GetBlockCount(), TVector<TDers>(leafCount, TDers{/*Der1*/0.0, /*Der2*/0.0, /*Der3*/0.0}));
-    TVector<TDers>* blockBucketDersData = blockBucketDers.data();
+    // [blockId][leafId]
+    TScratchVector<TDers> blockBucketDers(scratch);
+    blockBucketDers->assign(blockParams.GetBlockCount() * leafCount, TDers{/*Der1*/0.0, /*Der2*/0.0, /*Der3*/0.0});
+    TDers* blockBucketDersData = blockBucketDers->data();
     // TODO(espetrov): Do not calculate sumWeights for Newton.
     // TODO(espetrov): Calculate sumWeights only on first iteration for Gradient, because on next iteration it is the same.
     // Check speedup on flights dataset.
-    TVector<TVector<double>> blockBucketSumWeights(blockParams.GetBlockCount(), TVector<double>(leafCount, 0));
-    TVector<double>* blockBucketSumWeightsData = blockBucketSumWeights.data();
+    TScratchVector<double> blockBucketSumWeights(scratch);
+    blockBucketSumWeights->assign(blockParams.GetBlockCount() * leafCount, 0);
+    double* blockBucketSumWeightsData = blockBucketSumWeights->data();
     const TIndexType* indicesData = indices.data();
     const float* targetsData = targets.data();
     const float* weightsData = weights.data();
@@ -150,8 +154,8 @@ void CalcApproxDersRange(
         const int blockStart = blockId * blockParams.GetBlockSize();
         const int nextBlockStart = Min(sampleCount, blockStart + blockParams.GetBlockSize());
 
-        TDers* bucketDers = blockBucketDersData[blockId].data();
-        double* bucketSumWeights = blockBucketSumWeightsData[blockId].data();
+        TDers* bucketDers = blockBucketDersData + blockId * leafCount;
+        double* bucketSumWeights = blockBucketSumWeightsData + blockId * leafCount;
 
         for (int innerBlockStart = blockStart; innerBlockStart < nextBlockStart; innerBlockStart += innerBlockSize) {
             const int nextInnerBlockStart = Min(nextBlockStart, innerBlockStart + innerBlockSize);
@@ -186,10 +190,10 @@ void CalcApproxDersRange(
     if (estimationMethod == ELeavesEstimation::Newton) {
         for (int leafId = 0; leafId < leafCount; ++leafId) {
             for (int blockId = 0; blockId < blockParams.GetBlockCount(); ++blockId) {
-                if (blockBucketSumWeights[blockId][leafId] > FLT_EPSILON) {
+                if (blockBucketSumWeightsData[blockId * leafCount + leafId] > FLT_EPSILON) {
                     UpdateBucket<ELeavesEstimation::Newton>(
-                        blockBucketDers[blockId][leafId],
-                        blockBucketSumWeights[blockId][leafId],
+                        blockBucketDersData[blockId * leafCount + leafId],
+                        blockBucketSumWeightsData[blockId * leafCount + leafId],
                         iteration,
                         &(*buckets)[leafId]
                     );
@@ -200,10 +204,10 @@ void CalcApproxDersRange(
         Y_ASSERT(estimationMethod == ELeavesEstimation::Gradient);
         for (int leafId = 0; leafId < leafCount; ++leafId) {
             for (int blockId = 0; blockId < blockParams.GetBlockCount(); ++blockId) {
-                if (blockBucketSumWeights[blockId][leafId] > FLT_EPSILON) {
+                if (blockBucketSumWeightsData[blockId * leafCount + leafId] > FLT_EPSILON) {
                     UpdateBucket<ELeavesEstimation::Gradient>(
-                        blockBucketDers[blockId][leafId],
-                        blockBucketSumWeights[blockId][leafId],
+                        blockBucketDersData[blockId * leafCount + leafId],
+                        blockBucketSumWeightsData[blockId * leafCount + leafId],
                         iteration,
                         &(*buckets)[leafId]
                     );
@@ -228,6 +232,7 @@ void UpdateBucketsSimple(
     const NCatboostOptions::TCatBoostOptions& params,
     ui64 randomSeed,
     NPar::TLocalExecutor* localExecutor,
+    TScratchArena* scratch,
     TVector<TSum>* buckets,
     TArray2D<double>* pairwiseBuckets,
     TVector<TDers>* scratchDers
@@ -244,6 +249,7 @@ void UpdateBucketsSimple(
             iteration,
             estimationMethod,
             localExecutor,
+            scratch,
             buckets,
             scratchDers
         );
@@ -423,14 +429,15 @@ void CalcApproxDeltaSimple(
             error.GetErrorType() == EErrorType::PerObjectError ? APPROX_BLOCK_SIZE * CB_THREAD_LIMIT : bt.BodyFinish
         );
 
-        TVector<TDers> weightedDers;
-        weightedDers.yresize(scratchSize); // iteration scratch space
+        TScratchArena* scratch = ctx->ScratchArenas.GetThreadArena();
+        TScratchVector<TDers> weightedDers(scratch);
+        weightedDers->yresize(scratchSize); // iteration scratch space
         TVector<TSum> buckets(leafCount, TSum(gradientIterations)); // iteration scratch space
         TArray2D<double> pairwiseBuckets; // iteration scratch space
         TVector<double> curLeafValues; // iteration scratch space
 
         for (int it = 0; it < gradientIterations; ++it) {
-            UpdateBucketsSimple(indices, ff, bt, bt.Approx[0], resArr[0], error, bt.BodyFinish, bodyQueryFinish, it, estimationMethod, ctx->Params, randomSeeds[bodyTailId], &localExecutor, &buckets, &pairwiseBuckets, &weightedDers);
+            UpdateBucketsSimple(indices, ff, bt, bt.Approx[0], resArr[0], error, bt.BodyFinish, bodyQueryFinish, it, estimationMethod, ctx->Params, randomSeeds[bodyTailId], &localExecutor, scratch, &buckets, &pairwiseBuckets, weightedDers.Get());
             CalcMixedModelSimple(buckets, pairwiseBuckets, it, ctx->Params, bt.BodySumWeight, bt.BodyFinish, &curLeafValues);
 
             if (!ctx->Params.BoostingOptions->ApproxOnFullHistory) {
@@ -438,7 +445,7 @@ void CalcApproxDeltaSimple(
             } else {
                 Y_ASSERT(!IsPairwiseScoring(ctx->Params.LossFunctionDescription->GetLossFunction()));
                 UpdateApproxDeltas<TError::StoreExpApprox>(indices, bt.BodyFinish, &localExecutor, &curLeafValues, &resArr[0]);
-                CalcTailModelSimple(indices, ff, bt, error, it, l2Regularizer, ctx->Params, randomSeeds[bodyTailId], &localExecutor, ctx, &buckets, &resArr[0], &weightedDers);
+                CalcTailModelSimple(indices, ff, bt, error, it, l2Regularizer, ctx->Params, randomSeeds[bodyTailId], &localExecutor, ctx, &buckets, &resArr[0], weightedDers.Get());
             }
         }
     }, 0, ff.BodyTailArr.ysize(), NPar::TLocalExecutor::WAIT_COMPLETE);
@@ -456,7 +463,9 @@ void CalcLeafValuesSimple(
     const int scratchSize = error.GetErrorType() == EErrorType::PerObjectError
         ? APPROX_BLOCK_SIZE * CB_THREAD_LIMIT
         : ff.GetLearnSampleCount();
-    TVector<TDers> weightedDers(scratchSize);
+    TScratchArena* scratch = ctx->ScratchArenas.GetThreadArena();
+    TScratchVector<TDers> weightedDers(scratch);
+    weightedDers->assign(scratchSize, TDers());
 
     const int queryCount = ff.LearnQueriesInfo.ysize();
     const auto& learnerOptions = ctx->Params.ObliviousTreeOptions.Get();
@@ -472,7 +481,7 @@ void CalcLeafValuesSimple(
 
     leafValues->assign(1, TVector<double>(leafCount));
     for (int it = 0; it < gradientIterations; ++it) {
-        UpdateBucketsSimple(indices, ff, bt, approxes, /*approxDeltas*/ {}, error, ff.GetLearnSampleCount(), queryCount, it, estimationMethod, ctx->Params, ctx->Rand.GenRand(), &localExecutor, &buckets, &pairwiseBuckets, &weightedDers);
+        UpdateBucketsSimple(indices, ff, bt, approxes, /*approxDeltas*/ {}, error, ff.GetLearnSampleCount(), queryCount, it, estimationMethod, ctx->Params, ctx->Rand.GenRand(), &localExecutor, scratch, &buckets, &pairwiseBuckets, weightedDers.Get());
         CalcMixedModelSimple(buckets, pairwiseBuckets, it, ctx->Params, ff.GetSumWeight(), ff.GetLearnSampleCount(), &curLeafValues);
         for (int leaf = 0; leaf < leafCount; ++leaf) {
             (*leafValues)[0][leaf] += curLeafValues[leaf];
@@ -492,7 +501,7 @@ void CalcLeafValues(
     TVector<TVector<double>>* leafValues,
     TVector<TIndexType>* indices
 ) {
-    *indices = BuildIndices(fold, tree, learnData, testDataPtrs, &ctx->LocalExecutor);
+    BuildIndices(fold, tree, learnData, testDataPtrs, &ctx->LocalExecutor, indices);
     const int approxDimension = ctx->LearnProgress.AveragingFold.GetApproxDimension();
     Y_VERIFY(fold.GetLearnSampleCount() == (int)learnData.GetSampleCount());
     const int leafCount = tree.GetLeafCount();
@@ -515,12 +524,13 @@ void CalcApproxForLeafStruct(
     TLearnContext* ctx,
     TVector<TVector<TVector<double>>>* approxesDelta // [bodyTailId][approxDim][docIdxInPermuted]
 ) {
-    const TVector<TIndexType> indices = BuildIndices(fold, tree, learnData, testDataPtrs, &ctx->LocalExecutor);
+    TScratchVector<TIndexType> indices(ctx->ScratchArenas.GetThreadArena());
+    BuildIndices(fold, tree, learnData, testDataPtrs, &ctx->LocalExecutor, indices.Get());
     const int approxDimension = fold.GetApproxDimension();
     const int leafCount = tree.GetLeafCount();
     if (approxDimension == 1) {
-        CalcApproxDeltaSimple(fold, leafCount, error, indices, randomSeed, ctx, approxesDelta);
+        CalcApproxDeltaSimple(fold, leafCount, error, *indices, randomSeed, ctx, approxesDelta);
     } else {
-        CalcApproxDeltaMulti(fold, leafCount, error, indices, ctx, approxesDelta);
+        CalcApproxDeltaMulti(fold, leafCount, error, *indices, ctx, approxesDelta);
     }
 }
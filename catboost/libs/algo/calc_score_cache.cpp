@@ -6,7 +6,7 @@ bool IsSamplingPerTree(const NCatboostOptions::TObliviousTreeLearnerOptions& fit
     return fitParams.SamplingFrequency.Get() == ESamplingFrequency::PerTree;
 }
 
-TVector<TBucketStats, TPoolAllocator>& TBucketStatsCache::GetStats(const TSplitCandidate& split, int statsCount, bool* areStatsDirty) {
+TVector<TBucketStats, TPoolAllocator>& TBucketStatsCache::GetStorage(const TSplitCandidate& split, size_t storageCount, bool* areStatsDirty) {
     TVector<TBucketStats, TPoolAllocator>* splitStats;
     with_lock(Lock) {
         if (Stats.has(split) && Stats[split] != nullptr) {
@@ -14,7 +14,7 @@ TVector<TBucketStats, TPoolAllocator>& TBucketStatsCache::GetStats(const TSplitC
             *areStatsDirty = false;
         } else {
             splitStats = new TVector<TBucketStats, TPoolAllocator>(MemoryPool.Get());
-            splitStats->yresize(statsCount);
+            splitStats->yresize(storageCount);
             Stats[split] = splitStats;
             *areStatsDirty = true;
         }
@@ -77,8 +77,8 @@ static int GetMaxTailFinish(const TVector<TFold>& folds, int bodyTailIdx) {
 }
 
 void TCalcScoreFold::Create(const TVector<TFold>& folds, bool isPairwiseScoring, float sampleRate) {
-    BernoulliSampleRate = sampleRate;
-    Y_ASSERT(BernoulliSampleRate > 0.0f && BernoulliSampleRate <= 1.0f);
+    SampleRate = sampleRate;
+    Y_ASSERT(SampleRate > 0.0f && SampleRate <= 1.0f);
     DocCount = folds[0].LearnPermutation.ysize();
     Y_ASSERT(DocCount > 0);
     Indices.yresize(DocCount);
@@ -194,7 +194,7 @@ void TCalcScoreFold::SelectSmallestSplitSide(int curDepth, const TCalcScoreFold&
     PermutationBlockSize = FoldPermutationBlockSizeNotSet;
 }
 
-void TCalcScoreFold::Sample(const TFold& fold, const TVector<TIndexType>& indices, TRestorableFastRng64* rand, NPar::TLocalExecutor* localExecutor) {
+void TCalcScoreFold::Sample(const TFold& fold, const TVector<TIndexType>& indices, bool isSampledByWeights, TRestorableFastRng64* rand, NPar::TLocalExecutor* localExecutor) {
     NPar::TLocalExecutor::TExecRangeParams blockParams(0, indices.ysize());
     blockParams.SetBlockSize(2000);
     const int blockCount = blockParams.GetBlockCount();
@@ -202,7 +202,11 @@ void TCalcScoreFold::Sample(const TFold& fold, const TVector<TIndexType>& indice
     srcBlocks.Create(blockParams);
 
     TVectorSlicing dstBlocks;
-    SetSampledControl(indices.ysize(), rand);
+    if (isSampledByWeights) {
+        SetSampledByWeightsControl(indices.ysize(), fold.SampleWeights, localExecutor);
+    } else {
+        SetSampledControl(indices.ysize(), rand);
+    }
     dstBlocks.CreateByControl(blockParams, Control, localExecutor);
 
     DocCount = dstBlocks.Total;
@@ -218,7 +222,7 @@ void TCalcScoreFold::Sample(const TFold& fold, const TVector<TIndexType>& indice
         SetElements(srcControlRef, srcBlock.GetConstRef(TVector<size_t>()), [=](const size_t*, size_t j) { return srcBlock.Offset + j; }, dstBlock.GetRef(IndexInFold), &ignored);
         SelectBlockFromFold(fold, srcBlock, dstBlock);
     }, 0, blockCount, NPar::TLocalExecutor::WAIT_COMPLETE);
-    PermutationBlockSize = (BernoulliSampleRate == 1.0f || IsPairwiseScoring) ? fold.PermutationBlockSize : FoldPermutationBlockSizeNotSet;
+    PermutationBlockSize = (SampleRate == 1.0f || IsPairwiseScoring) ? fold.PermutationBlockSize : FoldPermutationBlockSizeNotSet;
 }
 
 void TCalcScoreFold::UpdateIndices(const TVector<TIndexType>& indices, NPar::TLocalExecutor* localExecutor) {
@@ -229,7 +233,7 @@ void TCalcScoreFold::UpdateIndices(const TVector<TIndexType>& indices, NPar::TLo
     srcBlocks.Create(blockParams);
 
     TVectorSlicing dstBlocks;
-    if (BernoulliSampleRate < 1.0f && !IsPairwiseScoring) {
+    if (SampleRate < 1.0f && !IsPairwiseScoring) {
         dstBlocks.CreateByControl(blockParams, Control, localExecutor);
     } else {
         dstBlocks = srcBlocks;
@@ -294,11 +298,23 @@ void TCalcScoreFold::SetSmallestSideControl(int curDepth, int docCount, const TU
 }
 
 void TCalcScoreFold::SetSampledControl(int docCount, TRestorableFastRng64* rand) {
-    if (BernoulliSampleRate == 1.0f || IsPairwiseScoring) {
+    if (SampleRate == 1.0f || IsPairwiseScoring) {
         Fill(Control.begin(), Control.end(), true);
         return;
     }
     for (int docIdx = 0; docIdx < docCount; ++docIdx) {
-        Control[docIdx] = rand->GenRandReal1() < BernoulliSampleRate;
+        Control[docIdx] = rand->GenRandReal1() < SampleRate;
+    }
+}
+
+void TCalcScoreFold::SetSampledByWeightsControl(int docCount, const TVector<float>& sampleWeights, NPar::TLocalExecutor* localExecutor) {
+    if (SampleRate == 1.0f || IsPairwiseScoring) {
+        Fill(Control.begin(), Control.end(), true);
+        return;
     }
+    const float* sampleWeightsData = GetDataPtr(sampleWeights);
+    bool* controlData = GetDataPtr(Control);
+    localExecutor->ExecRange([=](int docIdx) {
+        controlData[docIdx] = sampleWeightsData[docIdx] != 0.0f;
+    }, NPar::TLocalExecutor::TExecRangeParams(0, docCount).SetBlockSize(4000), NPar::TLocalExecutor::WAIT_COMPLETE);
 }
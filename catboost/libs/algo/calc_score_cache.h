@@ -23,11 +23,18 @@ static inline const TData* GetDataPtr(const TVector<TData, TAlloc>& data, size_t
     return data.empty() ? nullptr : data.data() + offset;
 }
 
-static inline float GetBernoulliSampleRate(const NCatboostOptions::TOption<NCatboostOptions::TBootstrapConfig>& samplingConfig) {
-    if (samplingConfig->GetBootstrapType() == EBootstrapType::Bernoulli) {
-        return samplingConfig->GetTakenFraction();
+// Expected fraction of documents taken into TCalcScoreFold by Sample
+static inline float GetSampleRate(const NCatboostOptions::TOption<NCatboostOptions::TBootstrapConfig>& samplingConfig) {
+    switch (samplingConfig->GetBootstrapType()) {
+        case EBootstrapType::Bernoulli:
+            return samplingConfig->GetTakenFraction();
+        case EBootstrapType::GOSS: {
+            const float topFraction = samplingConfig->GetTopFraction();
+            return Min(topFraction + (1.0f - topFraction) * samplingConfig->GetTakenFraction(), 1.0f);
+        }
+        default:
+            return 1.0f;
     }
-    return 1.0f;
 }
 
 static inline int GetMaxBodyTailCount(const TVector<TFold>& folds) {
@@ -38,20 +45,25 @@ static inline int GetMaxBodyTailCount(const TVector<TFold>& folds) {
     return maxBodyTailCount;
 }
 
-struct TBucketStats {
-    double SumWeightedDelta;
-    double SumWeight;
-    double SumDelta;
-    double Count;
+template <typename TValue>
+struct TBasicBucketStats {
+    using TSum = TBasicBucketStats<double>;
+
+    TValue SumWeightedDelta;
+    TValue SumWeight;
+    TValue SumDelta;
+    TValue Count;
 
-    inline void Add(const TBucketStats& other) {
+    template <typename TOtherValue>
+    inline void Add(const TBasicBucketStats<TOtherValue>& other) {
         SumWeightedDelta += other.SumWeightedDelta;
         SumDelta += other.SumDelta;
         SumWeight += other.SumWeight;
         Count += other.Count;
     }
 
-    inline void Remove(const TBucketStats& other) {
+    template <typename TOtherValue>
+    inline void Remove(const TBasicBucketStats<TOtherValue>& other) {
         SumWeightedDelta -= other.SumWeightedDelta;
         SumDelta -= other.SumDelta;
         SumWeight -= other.SumWeight;
@@ -60,8 +72,54 @@ struct TBucketStats {
     SAVELOAD(SumWeightedDelta, SumWeight, SumDelta, Count);
 };
 
+using TBucketStats = TBasicBucketStats<double>;
+
 static_assert(std::is_pod<TBucketStats>::value, "TBucketStats must be pod to avoid memory initialization in yresize");
 
+// Plain boosting uses only bootstrapped sums, so its buckets are half the size
+template <typename TValue>
+struct TPlainBucketStats {
+    using TSum = TPlainBucketStats<double>;
+
+    TValue SumWeightedDelta;
+    TValue SumWeight;
+
+    template <typename TOtherValue>
+    inline void Add(const TPlainBucketStats<TOtherValue>& other) {
+        SumWeightedDelta += other.SumWeightedDelta;
+        SumWeight += other.SumWeight;
+    }
+
+    template <typename TOtherValue>
+    inline void Remove(const TPlainBucketStats<TOtherValue>& other) {
+        SumWeightedDelta -= other.SumWeightedDelta;
+        SumWeight -= other.SumWeight;
+    }
+};
+
+static_assert(std::is_pod<TPlainBucketStats<float>>::value, "TPlainBucketStats must be pod to avoid memory initialization in yresize");
+
+// Call func with values of the bucket statistics type used by CPU score calculation and of the type of partial sums.
+// In mixed precision partial sums over blocks of documents are accumulated in float and added to double statistics,
+// otherwise statistics are accumulated directly and both types are the same.
+template <typename TFunc>
+inline decltype(auto) SelectBucketStatsType(bool isPlainMode, EScoreStatsPrecision precision, TFunc&& func) {
+    if (isPlainMode) {
+        if (precision == EScoreStatsPrecision::Mixed) {
+            return func(TPlainBucketStats<double>(), TPlainBucketStats<float>());
+        }
+        return func(TPlainBucketStats<double>(), TPlainBucketStats<double>());
+    }
+    if (precision == EScoreStatsPrecision::Mixed) {
+        return func(TBucketStats(), TBasicBucketStats<float>());
+    }
+    return func(TBucketStats(), TBucketStats());
+}
+
+inline size_t GetBucketStatsSize(bool isPlainMode, EScoreStatsPrecision precision) {
+    return SelectBucketStatsType(isPlainMode, precision, [] (auto stats, auto /*partialStats*/) { return sizeof(stats); });
+}
+
 inline static int CountNonCtrBuckets(const TVector<int>& splitCounts, const TVector<TVector<int>>& oneHotValues) {
     int nonCtrBucketCount = 0;
     for (int splitCount : splitCounts) {
@@ -75,16 +133,23 @@ inline static int CountNonCtrBuckets(const TVector<int>& splitCounts, const TVec
 
 struct TBucketStatsCache {
     THashMap<TSplitCandidate, THolder<TVector<TBucketStats, TPoolAllocator>>> Stats;
-    inline void Create(const TVector<TFold>& folds, int bucketCount, int depth) {
+    inline void Create(const TVector<TFold>& folds, int bucketCount, int depth, size_t statsSize = sizeof(TBucketStats)) {
         int approxDimension = folds[0].GetApproxDimension();
         int bodyTailCount = GetMaxBodyTailCount(folds);
-        InitialSize = sizeof(TBucketStats) * bucketCount * (1U << depth) * approxDimension * bodyTailCount;
+        InitialSize = statsSize * bucketCount * (1U << depth) * approxDimension * bodyTailCount;
         Y_ASSERT(InitialSize > 0);
         MemoryPool = new TMemoryPool(InitialSize);
     }
-    TVector<TBucketStats, TPoolAllocator>& GetStats(const TSplitCandidate& split, int statsCount, bool* areStatsDirty);
+    template <typename TStats>
+    TStats* GetStats(const TSplitCandidate& split, int statsCount, bool* areStatsDirty) {
+        static_assert(std::is_pod<TStats>::value && alignof(TStats) <= alignof(TBucketStats), "TStats must fit into TBucketStats storage");
+        const size_t storageCount = (statsCount * sizeof(TStats) + sizeof(TBucketStats) - 1) / sizeof(TBucketStats);
+        return reinterpret_cast<TStats*>(GetDataPtr(GetStorage(split, storageCount, areStatsDirty)));
+    }
     void GarbageCollect();
 private:
+    TVector<TBucketStats, TPoolAllocator>& GetStorage(const TSplitCandidate& split, size_t storageCount, bool* areStatsDirty);
+
     THolder<TMemoryPool> MemoryPool;
     TAdaptiveLock Lock;
     size_t InitialSize;
@@ -146,7 +211,8 @@ struct TCalcScoreFold {
 
     void Create(const TVector<TFold>& folds, bool isPairwiseScoring, float sampleRate = 1.0f);
     void SelectSmallestSplitSide(int curDepth, const TCalcScoreFold& fold, NPar::TLocalExecutor* localExecutor);
-    void Sample(const TFold& fold, const TVector<TIndexType>& indices, TRestorableFastRng64* rand, NPar::TLocalExecutor* localExecutor);
+    // if isSampledByWeights, documents with zero sample weight are dropped, otherwise documents are sampled with SampleRate
+    void Sample(const TFold& fold, const TVector<TIndexType>& indices, bool isSampledByWeights, TRestorableFastRng64* rand, NPar::TLocalExecutor* localExecutor);
     void UpdateIndices(const TVector<TIndexType>& indices, NPar::TLocalExecutor* localExecutor);
     int GetDocCount() const;
     int GetBodyTailCount() const;
@@ -164,11 +230,12 @@ private:
     void SelectBlockFromFold(const TFoldType& fold, TSlice srcBlock, TSlice dstBlock);
     void SetSmallestSideControl(int curDepth, int docCount, const TUnsizedVector<TIndexType>& indices, NPar::TLocalExecutor* localExecutor);
     void SetSampledControl(int docCount, TRestorableFastRng64* rand);
+    void SetSampledByWeightsControl(int docCount, const TVector<float>& sampleWeights, NPar::TLocalExecutor* localExecutor);
     TUnsizedVector<bool> Control;
     int DocCount;
     int BodyTailCount;
     int ApproxDimension;
-    float BernoulliSampleRate;
+    float SampleRate;
     bool HasPairwiseWeights;
     bool IsPairwiseScoring;
 };
@@ -226,6 +226,22 @@ TFold TFold::BuildPlainFold(
 }
 
 
+size_t TFold::GetOnlineCtrMemoryUsage() const {
+    size_t memoryUsage = 0;
+    for (const auto* ctrs : {&OnlineSingleCtrs, &OnlineCTR}) {
+        for (const auto& projCtr : *ctrs) {
+            for (const auto& ctrIdxFeature : projCtr.second.Feature) {
+                for (size_t border = 0; border < ctrIdxFeature.GetYSize(); ++border) {
+                    for (size_t prior = 0; prior < ctrIdxFeature.GetXSize(); ++prior) {
+                        memoryUsage += ctrIdxFeature[border][prior].GetMemoryUsage();
+                    }
+                }
+            }
+        }
+    }
+    return memoryUsage;
+}
+
 void TFold::DropEmptyCTRs() {
     TVector<TProjection> emptyProjections;
     for (auto& projCtr : OnlineSingleCtrs) {
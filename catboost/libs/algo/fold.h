@@ -13,6 +13,7 @@
 #include <catboost/libs/options/defaults_helper.h>
 
 #include <util/generic/vector.h>
+#include <util/generic/hash.h>
 #include <util/random/shuffle.h>
 #include <util/generic/ymath.h>
 
@@ -58,6 +59,9 @@ struct TFold {
     TVector<TVector<int>> LearnTargetClass;
     TVector<int> TargetClassesCount;
     int PermutationBlockSize = FoldPermutationBlockSizeNotSet;
+    // Online ctr hashes (see CalcOnlineCtrHashes) of base projections of the tree being built,
+    // tree ctrs extending one of them by a single cat feature are hashed in one pass
+    THashMap<TProjection, TVector<ui64>> TreeCtrBaseHashes;
 
     TOnlineCTRHash& GetCtrs(const TProjection& proj) {
         return proj.HasSingleFeature() ? OnlineSingleCtrs : OnlineCTR;
@@ -77,6 +81,8 @@ struct TFold {
 
     void DropEmptyCTRs();
 
+    size_t GetOnlineCtrMemoryUsage() const;
+
     const std::tuple<const TOnlineCTRHash&, const TOnlineCTRHash&> GetAllCtrs() const {
         return std::tie(OnlineSingleCtrs, OnlineCTR);
     }
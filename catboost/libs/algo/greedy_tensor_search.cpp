@@ -9,11 +9,15 @@
 #include <catboost/libs/logging/profile_info.h>
 #include <catboost/libs/helpers/interrupt.h>
 
+#include <library/chromium_trace/interface.h>
 #include <library/fast_log/fast_log.h>
 
+#include <util/generic/algorithm.h>
 #include <util/string/builder.h>
 #include <util/system/mem_info.h>
 
+#include <numeric>
+
 constexpr size_t MAX_ONLINE_CTR_FEATURES = 50;
 
 void TrimOnlineCTRcache(const TVector<TFold*>& folds) {
@@ -135,7 +139,43 @@ static void AddSimpleCtrs(const TDataset& learnData,
     }
 }
 
+// Cache hashes of tree ctr base projections which are extended by several not yet computed candidates
+static void UpdateTreeCtrBaseHashes(const TDataset& learnData,
+                                    const TDatasetPtrs& testDataPtrs,
+                                    const THashSet<TProjection>& baseProjs,
+                                    const THashMap<TProjection, int>& notComputedChildCount,
+                                    TFold* fold,
+                                    TLearnContext* ctx) {
+    auto& baseHashes = fold->TreeCtrBaseHashes;
+    TVector<TProjection> outdatedProjs;
+    for (const auto& projHashes : baseHashes) {
+        if (!baseProjs.has(projHashes.first)) {
+            outdatedProjs.emplace_back(projHashes.first);
+        }
+    }
+    for (const auto& proj : outdatedProjs) {
+        baseHashes.erase(proj);
+    }
+
+    const size_t neededMemory = (fold->GetLearnSampleCount() + GetSampleCount(testDataPtrs)) * sizeof(ui64);
+    const size_t memoryLimit = ParseMemorySizeDescription(ctx->Params.SystemOptions->CpuUsedRamLimit);
+    size_t memoryUsage = NMemInfo::GetMemInfo().RSS;
+    TVector<TProjection> newProjs;
+    for (const auto& projCount : notComputedChildCount) {
+        if (projCount.second < 2 || baseHashes.has(projCount.first) || memoryUsage + neededMemory > memoryLimit) {
+            continue;
+        }
+        memoryUsage += neededMemory;
+        newProjs.emplace_back(projCount.first);
+        baseHashes[projCount.first];
+    }
+    ctx->LocalExecutor.ExecRange([&](int projIdx) {
+        CalcOnlineCtrHashes(learnData, testDataPtrs, *fold, newProjs[projIdx], &ctx->LocalExecutor, &baseHashes.at(newProjs[projIdx]));
+    }, 0, newProjs.ysize(), NPar::TLocalExecutor::WAIT_COMPLETE);
+}
+
 static void AddTreeCtrs(const TDataset& learnData,
+                        const TDatasetPtrs& testDataPtrs,
                         const TSplitTree& currentTree,
                         TFold* fold,
                         TLearnContext* ctx,
@@ -155,6 +195,7 @@ static void AddTreeCtrs(const TDataset& learnData,
     }
 
     TSeenProjHash addedProjHash;
+    THashMap<TProjection, int> notComputedChildCount;
     for (const auto& baseProj : seenProj) {
         if (baseProj.IsEmpty()) {
             continue;
@@ -180,9 +221,14 @@ static void AddTreeCtrs(const TDataset& learnData,
             addedProjHash.insert(proj);
 
             AddCtrsToCandList(*fold, *ctx, proj, candList);
-            fold->GetCtrRef(proj);
+            if (fold->GetCtrRef(proj).Feature.empty()) {
+                ++notComputedChildCount[baseProj];
+            }
         }
     }
+    if (ctx->Params.SystemOptions->IsSingleHost()) {
+        UpdateTreeCtrBaseHashes(learnData, testDataPtrs, seenProj, notComputedChildCount, fold, ctx);
+    }
     THashSet<TSplitCandidate> candidatesToErase;
     for (auto& splitCandidate : statsFromPrevTree->Stats) {
         if (splitCandidate.first.Type == ESplitType::OnlineCtr) {
@@ -196,9 +242,20 @@ static void AddTreeCtrs(const TDataset& learnData,
     }
 }
 
+// Memory for ctr values of all candidates of the list, see TOnlineCtrValues
+static size_t EstimateCtrMemoryUsage(const TCandidatesInfoList& candSubList, int sampleCount, const TLearnContext& ctx) {
+    const auto& ctrInfo = ctx.CtrsHelper.GetCtrInfo(candSubList.Candidates[0].SplitCandidate.Ctr.Projection);
+    size_t memoryUsage = 0;
+    for (const auto& candidate : candSubList.Candidates) {
+        memoryUsage += TOnlineCtrValues::GetMemoryUsage(sampleCount, ctrInfo[candidate.SplitCandidate.Ctr.CtrIdx].BorderCount);
+    }
+    return memoryUsage;
+}
+
 static void SelectCtrsToDropAfterCalc(size_t memoryLimit,
                                       int sampleCount,
                                       int threadCount,
+                                      const TLearnContext& ctx,
                                       const std::function<bool(const TProjection&)>& IsInCache,
                                       TCandidateList* candList) {
     size_t maxMemoryForOneCtr = 0;
@@ -209,7 +266,7 @@ static void SelectCtrsToDropAfterCalc(size_t memoryLimit,
             candSubList.ShouldDropCtrAfterCalc = false;
             continue;
         }
-        const size_t neededMem = sampleCount * candSubList.Candidates.size();
+        const size_t neededMem = EstimateCtrMemoryUsage(candSubList, sampleCount, ctx);
         maxMemoryForOneCtr = Max<size_t>(neededMem, maxMemoryForOneCtr);
         fullNeededMemoryForCtrs += neededMem;
     }
@@ -228,7 +285,7 @@ static void SelectCtrsToDropAfterCalc(size_t memoryLimit,
                 continue;
             }
             candSubList.ShouldDropCtrAfterCalc = true;
-            const size_t neededMem = sampleCount * candSubList.Candidates.size();
+            const size_t neededMem = EstimateCtrMemoryUsage(candSubList, sampleCount, ctx);
             if (currentNonDroppableMemory + neededMem + maxMemForOtherThreadsApprox <= memoryLimit) {
                 candSubList.ShouldDropCtrAfterCalc = false;
                 currentNonDroppableMemory += neededMem;
@@ -237,6 +294,43 @@ static void SelectCtrsToDropAfterCalc(size_t memoryLimit,
     }
 }
 
+// Estimated cost of candidate evaluation in passes over all documents
+static double EstimateCandidateCost(const TCandidatesInfoList& candidate, TFold* fold) {
+    const auto& firstSubCandidate = candidate.Candidates[0].SplitCandidate;
+    // every sub-candidate score calculation goes over all sampled documents
+    double cost = candidate.Candidates.size();
+    if (firstSubCandidate.Type == ESplitType::OnlineCtr) {
+        const auto& proj = firstSubCandidate.Ctr.Projection;
+        if (fold->GetCtrRef(proj).Feature.empty()) {
+            // hashing of every projection component and filling of every ctr value
+            cost += proj.GetFullProjectionLength() + candidate.Candidates.size();
+        }
+    }
+    return cost;
+}
+
+/* Candidates are started in order of decreasing estimated cost, so that expensive ctr candidates
+ * are not left for the end of the level, and cheap float ones fill the idle threads at the tail.
+ * Results don't depend on the order: everything is stored and seeded by candidate index.
+ * A single thread evaluates candidates one by one, so they are left in index order.
+ */
+static TVector<int> GetCandidatesEvaluationOrder(const TCandidateList& candList, int threadCount, TFold* fold) {
+    TVector<int> order(candList.ysize());
+    std::iota(order.begin(), order.end(), 0);
+    if (threadCount == 1) {
+        return order;
+    }
+    TVector<double> costs;
+    costs.yresize(candList.ysize());
+    for (int id = 0; id < candList.ysize(); ++id) {
+        costs[id] = EstimateCandidateCost(candList[id], fold);
+    }
+    StableSort(order.begin(), order.end(), [&costs](int lhs, int rhs) {
+        return costs[lhs] > costs[rhs];
+    });
+    return order;
+}
+
 static void CalcBestScore(const TDataset& learnData,
         const TDatasetPtrs& testDataPtrs,
         const TVector<int>& splitCounts,
@@ -249,26 +343,32 @@ static void CalcBestScore(const TDataset& learnData,
     CB_ENSURE(static_cast<ui32>(ctx->LocalExecutor.GetThreadCount()) == ctx->Params.SystemOptions->NumThreads - 1);
 
     TCandidateList& candList = *candidateList;
-    ctx->LocalExecutor.ExecRange([&](int id) {
+    const TVector<int> evaluationOrder = GetCandidatesEvaluationOrder(candList, ctx->Params.SystemOptions->NumThreads, fold);
+    ctx->LocalExecutor.ExecRange([&](int taskIdx) {
+        const int id = evaluationOrder[taskIdx];
         auto& candidate = candList[id];
         if (candidate.Candidates[0].SplitCandidate.Type == ESplitType::OnlineCtr) {
             const auto& proj = candidate.Candidates[0].SplitCandidate.Ctr.Projection;
             if (fold->GetCtrRef(proj).Feature.empty()) {
+                CHROMIUM_TRACE_SCOPE("ComputeOnlineCTRs");
                 ComputeOnlineCTRs(learnData,
                                   testDataPtrs,
                                   *fold,
                                   proj,
                                   ctx,
+                                  &ctx->LocalExecutor,
                                   &fold->GetCtrRef(proj));
             }
         }
-        TVector<TVector<double>> allScores(candidate.Candidates.size());
+        TScratchVector<TVector<double>> allScores(ctx->ScratchArenas.GetThreadArena());
+        allScores->resize(candidate.Candidates.size());
         ctx->LocalExecutor.ExecRange([&](int oneCandidate) {
+            CHROMIUM_TRACE_SCOPE("CalcScore");
             if (candidate.Candidates[oneCandidate].SplitCandidate.Type == ESplitType::OnlineCtr) {
                 const auto& proj = candidate.Candidates[oneCandidate].SplitCandidate.Ctr.Projection;
                 Y_ASSERT(!fold->GetCtrRef(proj).Feature.empty());
             }
-            allScores[oneCandidate] = GetScores(CalcScore(learnData.AllFeatures,
+            GetScores(CalcScore(learnData.AllFeatures,
                                         splitCounts,
                                         fold->GetAllCtrs(),
                                         ctx->SampledDocs,
@@ -277,13 +377,15 @@ static void CalcBestScore(const TDataset& learnData,
                                         ctx->Params,
                                         candidate.Candidates[oneCandidate].SplitCandidate,
                                         currentDepth,
-                                        &ctx->PrevTreeLevelStats));
+                                        &ctx->PrevTreeLevelStats,
+                                        ctx->ScratchArenas.GetThreadArena()),
+                      &(*allScores)[oneCandidate]);
         }, NPar::TLocalExecutor::TExecRangeParams(0, candidate.Candidates.ysize())
          , NPar::TLocalExecutor::WAIT_COMPLETE);
         if (candidate.Candidates[0].SplitCandidate.Type == ESplitType::OnlineCtr && candidate.ShouldDropCtrAfterCalc) {
             fold->GetCtrRef(candidate.Candidates[0].SplitCandidate.Ctr.Projection).Feature.clear();
         }
-        SetBestScore(randSeed + id, allScores, scoreStDev, &candidate.Candidates);
+        SetBestScore(randSeed + id, *allScores, scoreStDev, &candidate.Candidates);
     }, 0, candList.ysize(), NPar::TLocalExecutor::WAIT_COMPLETE);
 }
 
@@ -319,14 +421,17 @@ void GreedyTensorSearch(const TDataset& learnData,
 
     for (ui32 curDepth = 0; curDepth < ctx->Params.ObliviousTreeOptions->MaxDepth; ++curDepth) {
         TCandidateList candList;
-        AddFloatFeatures(learnData, ctx, &ctx->PrevTreeLevelStats, &candList);
-        AddOneHotFeatures(learnData, ctx, &ctx->PrevTreeLevelStats, &candList);
-        AddSimpleCtrs(learnData, fold, ctx, &ctx->PrevTreeLevelStats, &candList);
-        AddTreeCtrs(learnData, currentSplitTree, fold, ctx, &ctx->PrevTreeLevelStats, &candList);
-
-        auto IsInCache = [&fold](const TProjection& proj) -> bool {return fold->GetCtrRef(proj).Feature.empty();};
-        auto cpuUsedRamLimit = ParseMemorySizeDescription(ctx->Params.SystemOptions->CpuUsedRamLimit);
-        SelectCtrsToDropAfterCalc(cpuUsedRamLimit, learnSampleCount + testSampleCount, ctx->Params.SystemOptions->NumThreads, IsInCache, &candList);
+        {
+            CHROMIUM_TRACE_SCOPE("Candidate generation");
+            AddFloatFeatures(learnData, ctx, &ctx->PrevTreeLevelStats, &candList);
+            AddOneHotFeatures(learnData, ctx, &ctx->PrevTreeLevelStats, &candList);
+            AddSimpleCtrs(learnData, fold, ctx, &ctx->PrevTreeLevelStats, &candList);
+            AddTreeCtrs(learnData, testDataPtrs, currentSplitTree, fold, ctx, &ctx->PrevTreeLevelStats, &candList);
+
+            auto IsInCache = [&fold](const TProjection& proj) -> bool {return fold->GetCtrRef(proj).Feature.empty();};
+            auto cpuUsedRamLimit = ParseMemorySizeDescription(ctx->Params.SystemOptions->CpuUsedRamLimit);
+            SelectCtrsToDropAfterCalc(cpuUsedRamLimit, learnSampleCount + testSampleCount, ctx->Params.SystemOptions->NumThreads, *ctx, IsInCache, &candList);
+        }
 
         CheckInterrupted(); // check after long-lasting operation
         if (!isSamplingPerTree) {
@@ -395,11 +500,13 @@ void GreedyTensorSearch(const TDataset& learnData,
         if (bestSplit.Type == ESplitType::OnlineCtr) {
             const auto& proj = bestSplit.Ctr.Projection;
             if (fold->GetCtrRef(proj).Feature.empty()) {
+                CHROMIUM_TRACE_SCOPE("ComputeOnlineCTRs");
                 ComputeOnlineCTRs(learnData,
                                   testDataPtrs,
                                   *fold,
                                   proj,
                                   ctx,
+                                  &ctx->LocalExecutor,
                                   &fold->GetCtrRef(proj));
                 DropStatsForProjection(*fold, *ctx, proj, &ctx->PrevTreeLevelStats);
             }
@@ -437,5 +544,6 @@ void GreedyTensorSearch(const TDataset& learnData,
             break;
         }
     }
+    fold->TreeCtrBaseHashes.clear();
     *resSplitTree = std::move(currentSplitTree);
 }
@@ -3,6 +3,7 @@
 #include <catboost/libs/helpers/exception.h>
 #include <catboost/libs/logging/logging.h>
 
+#include <library/chromium_trace/interface.h>
 #include <library/malloc/api/malloc.h>
 
 #include <util/generic/algorithm.h>
@@ -136,49 +137,81 @@ void CalcErrors(
     const TDatasetPtrs& testDataPtrs,
     const TVector<THolder<IMetric>>& errors,
     bool calcMetrics,
-    TLearnContext* ctx
+    const TVector<TVector<double>>& learnApprox,
+    const TVector<TVector<TVector<double>>>& testApprox,
+    NPar::TLocalExecutor* localExecutor,
+    TVector<double>* learnErrors,
+    TVector<TVector<double>>* testErrors
 ) {
-    if (learnData.GetSampleCount() > 0) {
+    if (learnErrors != nullptr) {
         TVector<bool> skipMetricOnTrain = GetSkipMetricOnTrain(errors);
         const auto& data = learnData;
-        ctx->LearnProgress.MetricsAndTimeHistory.LearnMetricsHistory.emplace_back();
         for (int i = 0; i < errors.ysize(); ++i) {
-            const TMap<TString, TString> hints = errors[i]->GetHints();
             if (calcMetrics && !skipMetricOnTrain[i]) {
-                ctx->LearnProgress.MetricsAndTimeHistory.LearnMetricsHistory.back().push_back(EvalErrors(
-                    ctx->LearnProgress.AvrgApprox,
+                CHROMIUM_TRACE_SCOPE("Eval learn metric");
+                learnErrors->push_back(EvalErrors(
+                    learnApprox,
                     data.Target,
                     data.Weights,
                     data.QueryInfo,
                     errors[i],
-                    &ctx->LocalExecutor
+                    localExecutor
                 ));
             }
         }
     }
 
-    if (GetSampleCount(testDataPtrs) > 0) {
-        ctx->LearnProgress.MetricsAndTimeHistory.TestMetricsHistory.emplace_back(); // new [iter]
-        auto& testMetricErrors = ctx->LearnProgress.MetricsAndTimeHistory.TestMetricsHistory.back();
+    if (testErrors != nullptr) {
         for (size_t testIdx = 0; testIdx < testDataPtrs.size(); ++testIdx) {
-            testMetricErrors.emplace_back();
+            testErrors->emplace_back();
             if (testDataPtrs[testIdx] == nullptr || testDataPtrs[testIdx]->GetSampleCount() == 0) {
                 continue;
             }
-            const auto& testApprox = ctx->LearnProgress.TestApprox[testIdx];
             const auto& data = *testDataPtrs[testIdx];
             for (int i = 0; i < errors.ysize(); ++i) {
                 if (i == 0 || calcMetrics) { // TODO(smirnovpavel): Decide what to do with eval_metric if metric_period != 1. Decide what to do with custom objectives when no metric is present.
-                    testMetricErrors.back().push_back(EvalErrors(
-                        testApprox,
+                    CHROMIUM_TRACE_SCOPE("Eval test metric");
+                    testErrors->back().push_back(EvalErrors(
+                        testApprox[testIdx],
                         data.Target,
                         data.Weights,
                         data.QueryInfo,
                         errors[i],
-                        &ctx->LocalExecutor
+                        localExecutor
                     ));
                 }
             }
         }
     }
 }
+
+void CalcErrors(
+    const TDataset& learnData,
+    const TDatasetPtrs& testDataPtrs,
+    const TVector<THolder<IMetric>>& errors,
+    bool calcMetrics,
+    TLearnContext* ctx
+) {
+    auto& history = ctx->LearnProgress.MetricsAndTimeHistory;
+    TVector<double>* learnErrors = nullptr;
+    if (learnData.GetSampleCount() > 0) {
+        history.LearnMetricsHistory.emplace_back();
+        learnErrors = &history.LearnMetricsHistory.back();
+    }
+    TVector<TVector<double>>* testErrors = nullptr;
+    if (GetSampleCount(testDataPtrs) > 0) {
+        history.TestMetricsHistory.emplace_back(); // new [iter]
+        testErrors = &history.TestMetricsHistory.back();
+    }
+    CalcErrors(
+        learnData,
+        testDataPtrs,
+        errors,
+        calcMetrics,
+        ctx->LearnProgress.AvrgApprox,
+        ctx->LearnProgress.TestApprox,
+        &ctx->LocalExecutor,
+        learnErrors,
+        testErrors
+    );
+}
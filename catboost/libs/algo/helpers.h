@@ -20,3 +20,16 @@ void CalcErrors(
     bool calcMetrics, // bool value for each error
     TLearnContext* ctx
 );
+
+// Doesn't use learn context, so it may run concurrently with training on snapshots of approxes
+void CalcErrors(
+    const TDataset& learnData,
+    const TDatasetPtrs& testDataPtrs,
+    const TVector<THolder<IMetric>>& errors,
+    bool calcMetrics,
+    const TVector<TVector<double>>& learnApprox, // [dim][doc]
+    const TVector<TVector<TVector<double>>>& testApprox, // [test][dim][doc]
+    NPar::TLocalExecutor* localExecutor,
+    TVector<double>* learnErrors, // [metric], learn metrics are not calculated if nullptr
+    TVector<TVector<double>>* testErrors // [test][metric], test metrics are not calculated if nullptr
+);
@@ -224,25 +224,35 @@ static void BuildIndicesForTest(const TSplitTree& tree,
     localExecutor->ExecRange(updateTailIndex, 0, tailBlockParams.GetBlockCount(), NPar::TLocalExecutor::WAIT_COMPLETE);
 }
 
-TVector<TIndexType> BuildIndices(const TFold& fold,
-                                 const TSplitTree& tree,
-                                 const TDataset& learnData,
-                                 const TDatasetPtrs& testDataPtrs,
-                                 NPar::TLocalExecutor* localExecutor) {
+void BuildIndices(const TFold& fold,
+                  const TSplitTree& tree,
+                  const TDataset& learnData,
+                  const TDatasetPtrs& testDataPtrs,
+                  NPar::TLocalExecutor* localExecutor,
+                  TVector<TIndexType>* indices) {
     int learnSampleCount = learnData.GetSampleCount();
     int tailSampleCount = GetSampleCount(testDataPtrs);
 
     const TVector<const TOnlineCTR*>& onlineCtrs = GetOnlineCtrs(fold, tree);
 
-    TVector<TIndexType> indices(learnSampleCount + tailSampleCount);
+    indices->assign(learnSampleCount + tailSampleCount, 0);
 
-    BuildIndicesForLearn(tree, learnData, learnSampleCount, onlineCtrs, fold, localExecutor, indices.begin());
+    BuildIndicesForLearn(tree, learnData, learnSampleCount, onlineCtrs, fold, localExecutor, indices->begin());
     int docOffset = learnSampleCount;
     for (int testIdx = 0; testIdx < testDataPtrs.ysize(); ++testIdx) {
         const TDataset* testData = testDataPtrs[testIdx];
-        BuildIndicesForTest(tree, *testData, testData->GetSampleCount(), onlineCtrs, docOffset, localExecutor, indices.begin() + docOffset);
+        BuildIndicesForTest(tree, *testData, testData->GetSampleCount(), onlineCtrs, docOffset, localExecutor, indices->begin() + docOffset);
         docOffset += testData->GetSampleCount();
     }
+}
+
+TVector<TIndexType> BuildIndices(const TFold& fold,
+                                 const TSplitTree& tree,
+                                 const TDataset& learnData,
+                                 const TDatasetPtrs& testDataPtrs,
+                                 NPar::TLocalExecutor* localExecutor) {
+    TVector<TIndexType> indices;
+    BuildIndices(fold, tree, learnData, testDataPtrs, localExecutor, &indices);
     return indices;
 }
 
@@ -277,9 +287,57 @@ TVector<TIndexType> BuildIndicesForBinTree(const TFullModel& model, const TVecto
 
     auto docCount = binarizedFeatures.size() / model.ObliviousTrees.GetEffectiveBinaryFeaturesBucketsCount();
     TVector<TIndexType> indexesVec(docCount);
+    BuildIndicesForBinTree(model, binarizedFeatures, treeId, indexesVec.data());
+    return indexesVec;
+}
+
+void BuildIndicesForBinTree(const TFullModel& model, const TVector<ui8>& binarizedFeatures, size_t treeId, TIndexType* indices) {
+    if (model.ObliviousTrees.GetEffectiveBinaryFeaturesBucketsCount() == 0) {
+        return;
+    }
+
+    auto docCount = binarizedFeatures.size() / model.ObliviousTrees.GetEffectiveBinaryFeaturesBucketsCount();
+    Fill(indices, indices + docCount, 0);
     const auto* treeSplitsCurPtr =
         model.ObliviousTrees.GetRepackedBins().data() +
         model.ObliviousTrees.TreeStartOffsets[treeId];
-    CalcIndexes(!model.ObliviousTrees.OneHotFeatures.empty(), binarizedFeatures.data(), docCount, indexesVec.data(), treeSplitsCurPtr, model.ObliviousTrees.TreeSizes[treeId]);
-    return indexesVec;
+    CalcIndexes(!model.ObliviousTrees.OneHotFeatures.empty(), binarizedFeatures.data(), docCount, indices, treeSplitsCurPtr, model.ObliviousTrees.TreeSizes[treeId]);
+}
+
+void BinarizeFeaturesByBlocks(const TFullModel& model,
+                              const TPool& pool,
+                              NPar::TLocalExecutor* localExecutor,
+                              const TBinarizedBlockConsumer& consumer) {
+    // binarized block takes about 4Mb
+    constexpr size_t binarizedBlockBytes = 1 << 22;
+    const size_t bucketCount = Max<size_t>(1, model.ObliviousTrees.GetEffectiveBinaryFeaturesBucketsCount());
+    const size_t blockSize = Max<size_t>(FORMULA_EVALUATION_BLOCK_SIZE, binarizedBlockBytes / bucketCount);
+    const size_t docCount = pool.Docs.GetDocCount();
+    const size_t batchBlockCount = localExecutor->GetThreadCount() + 1;
+
+    TVector<TVector<ui8>> binarizedBlocks(batchBlockCount);
+    for (size_t batchStart = 0; batchStart < docCount; batchStart += blockSize * batchBlockCount) {
+        const size_t blockCount = Min(batchBlockCount, (docCount - batchStart + blockSize - 1) / blockSize);
+        localExecutor->ExecRange([&](int blockIdx) {
+            const size_t blockStart = batchStart + blockIdx * blockSize;
+            binarizedBlocks[blockIdx] = BinarizeFeatures(model, pool, blockStart, Min(blockStart + blockSize, docCount));
+        }, 0, blockCount, NPar::TLocalExecutor::WAIT_COMPLETE);
+        for (size_t blockIdx = 0; blockIdx < blockCount; ++blockIdx) {
+            const size_t blockStart = batchStart + blockIdx * blockSize;
+            consumer(blockStart, Min(blockStart + blockSize, docCount), binarizedBlocks[blockIdx]);
+        }
+    }
+}
+
+TVector<TVector<TIndexType>> BuildIndicesForBinTrees(const TFullModel& model,
+                                                     const TPool& pool,
+                                                     NPar::TLocalExecutor* localExecutor) {
+    const size_t treeCount = model.ObliviousTrees.GetTreeCount();
+    TVector<TVector<TIndexType>> indices(treeCount, TVector<TIndexType>(pool.Docs.GetDocCount()));
+    BinarizeFeaturesByBlocks(model, pool, localExecutor, [&](size_t blockStart, size_t /*blockEnd*/, const TVector<ui8>& binarizedBlock) {
+        localExecutor->ExecRange([&](int treeId) {
+            BuildIndicesForBinTree(model, binarizedBlock, treeId, indices[treeId].data() + blockStart);
+        }, 0, treeCount, NPar::TLocalExecutor::WAIT_COMPLETE);
+    });
+    return indices;
 }
@@ -6,6 +6,8 @@
 
 #include <util/generic/vector.h>
 
+#include <functional>
+
 void SetPermutedIndices(const TSplit& split,
                         const TAllFeatures& features,
                         int curDepth,
@@ -23,6 +25,14 @@ TVector<TIndexType> BuildIndices(const TFold& fold,
                                  const TDatasetPtrs& testDataPtrs,
                                  NPar::TLocalExecutor* localExecutor);
 
+// Same, reuses memory of indices
+void BuildIndices(const TFold& fold,
+                  const TSplitTree& tree,
+                  const TDataset& learnData,
+                  const TDatasetPtrs& testDataPtrs,
+                  NPar::TLocalExecutor* localExecutor,
+                  TVector<TIndexType>* indices);
+
 struct TFullModel;
 
 TVector<ui8> BinarizeFeatures(const TFullModel& model,
@@ -35,3 +45,25 @@ TVector<ui8> BinarizeFeatures(const TFullModel& model, const TPool& pool);
 TVector<TIndexType> BuildIndicesForBinTree(const TFullModel& model,
                                            const TVector<ui8>& binarizedFeatures,
                                            size_t treeId);
+
+// Same, writes indices of all documents of binarizedFeatures to indices
+void BuildIndicesForBinTree(const TFullModel& model,
+                            const TVector<ui8>& binarizedFeatures,
+                            size_t treeId,
+                            TIndexType* indices);
+
+using TBinarizedBlockConsumer = std::function<void(size_t blockStart, size_t blockEnd, const TVector<ui8>& binarizedBlock)>;
+
+/* Binarizes pool by blocks of documents, so binarized features of the whole pool are never in memory.
+ * Several blocks are binarized in parallel, consumer gets them one by one in document order
+ * and may use localExecutor itself.
+ */
+void BinarizeFeaturesByBlocks(const TFullModel& model,
+                              const TPool& pool,
+                              NPar::TLocalExecutor* localExecutor,
+                              const TBinarizedBlockConsumer& consumer);
+
+// Leaf indices of all documents of the pool for all trees, [treeId][docId]
+TVector<TVector<TIndexType>> BuildIndicesForBinTrees(const TFullModel& model,
+                                                     const TPool& pool,
+                                                     NPar::TLocalExecutor* localExecutor);
@@ -1,81 +1,134 @@
 #include "index_hash_calcer.h"
 
-/// Compute reindexHash and reindex hash values in range [begin,end).
-size_t ComputeReindexHash(ui64 topSize,
-                          TDenseHash<ui64, ui32>* reindexHashPtr,
-                          ui64* begin,
-                          ui64* end) {
+#include <util/generic/algorithm.h>
+
+static const int MinReindexBlockSize = 10000;
+
+// Blocks for parallel reindexing, there is a single block if localExecutor is not given
+static NPar::TLocalExecutor::TExecRangeParams GetReindexBlockParams(int docCount, NPar::TLocalExecutor* localExecutor) {
+    NPar::TLocalExecutor::TExecRangeParams blockParams(0, docCount);
+    int blockSize = docCount;
+    if (localExecutor != nullptr) {
+        const int threadCount = localExecutor->GetThreadCount() + 1;
+        blockSize = Max(MinReindexBlockSize, (docCount + threadCount - 1) / threadCount);
+    }
+    blockParams.SetBlockSize(Max(blockSize, 1));
+    return blockParams;
+}
+
+template <typename TBody>
+static void ReindexInBlocks(int docCount, NPar::TLocalExecutor* localExecutor, const TBody& body) {
+    const auto blockParams = GetReindexBlockParams(docCount, localExecutor);
+    const auto blockBody = NPar::TLocalExecutor::BlockedLoopBody(blockParams, body);
+    if (blockParams.GetBlockCount() > 1) {
+        localExecutor->ExecRange(blockBody, 0, blockParams.GetBlockCount(), NPar::TLocalExecutor::WAIT_COMPLETE);
+    } else if (blockParams.GetBlockCount() == 1) {
+        blockBody(0);
+    }
+}
+
+// Replace hash values in range [begin,end) by their reindexed values, all of them are present in reindexHash
+static void ApplyReindexHash(const TDenseHash<ui64, ui32>& reindexHash, ui64* begin, ui64* end, NPar::TLocalExecutor* localExecutor) {
+    ReindexInBlocks(end - begin, localExecutor, [&](int i) {
+        begin[i] = reindexHash.Get(begin[i]);
+    });
+}
+
+// Add hash values from range [begin,end) missing in reindexHash in order of their first occurrence,
+// and reindex the range
+static void ReindexByFirstOccurrence(TDenseHash<ui64, ui32>* reindexHashPtr, ui64* begin, ui64* end, NPar::TLocalExecutor* localExecutor) {
     auto& reindexHash = *reindexHashPtr;
-    auto* hashArr = begin;
-    size_t learnSize = end - begin;
-    ui32 counter = 0;
-    if (topSize > learnSize) {
-        bool isInserted = false;
-        for (size_t i = 0; i < learnSize; ++i) {
-            auto& v = reindexHash.GetMutable(hashArr[i], &isInserted);
+    ui32 counter = reindexHash.Size();
+    const auto blockParams = GetReindexBlockParams(end - begin, localExecutor);
+    if (blockParams.GetBlockCount() <= 1) {
+        for (ui64* hash = begin; hash != end; ++hash) {
+            bool isInserted = false;
+            auto& hashVal = reindexHash.GetMutable(*hash, &isInserted);
             if (isInserted) {
-                v = counter++;
+                hashVal = counter;
+                ++counter;
             }
-            hashArr[i] = v;
-        }
-    } else {
-        for (size_t i = 0; i < learnSize; ++i) {
-            ++reindexHash.GetMutable(hashArr[i]);
+            *hash = hashVal;
         }
+        return;
+    }
 
-        if (reindexHash.Size() <= topSize) {
-            for (auto& it : reindexHash) {
-                it.Value() = counter;
-                ++counter;
+    // collect new hash values of every block in order of their first occurrence in parallel,
+    // then merge them block by block so that the numbering is the same as for sequential processing
+    TVector<TVector<ui64>> newHashesByBlock(blockParams.GetBlockCount());
+    localExecutor->ExecRange([&](int blockIdx) {
+        TDenseHashSet<ui64> seenHashes;
+        auto& newHashes = newHashesByBlock[blockIdx];
+        NPar::TLocalExecutor::BlockedLoopBody(blockParams, [&](int i) {
+            if (!reindexHash.Has(begin[i]) && seenHashes.Insert(begin[i])) {
+                newHashes.push_back(begin[i]);
             }
-            for (size_t i = 0; i < learnSize; ++i) {
-                hashArr[i] = reindexHash.Get(hashArr[i]);
+        })(blockIdx);
+    }, 0, blockParams.GetBlockCount(), NPar::TLocalExecutor::WAIT_COMPLETE);
+    for (const auto& newHashes : newHashesByBlock) {
+        for (ui64 hash : newHashes) {
+            bool isInserted = false;
+            auto& hashVal = reindexHash.GetMutable(hash, &isInserted);
+            if (isInserted) {
+                hashVal = counter;
+                ++counter;
             }
-        } else {
-            // Limit reindexHash to topSize buckets
-            using TFreqPair = std::pair<ui64, ui32>;
-            TVector<TFreqPair> freqValList;
+        }
+    }
+    ApplyReindexHash(reindexHash, begin, end, localExecutor);
+}
 
-            freqValList.reserve(reindexHash.Size());
-            for (const auto& it : reindexHash) {
-                freqValList.emplace_back(it.Key(), it.Value());
-            }
-            std::nth_element(freqValList.begin(), freqValList.begin() + topSize, freqValList.end(),
-                         [](const TFreqPair& a, const TFreqPair& b) {
-                             return a.second > b.second;
+/// Compute reindexHash and reindex hash values in range [begin,end).
+size_t ComputeReindexHash(ui64 topSize,
+                          TDenseHash<ui64, ui32>* reindexHashPtr,
+                          ui64* begin,
+                          ui64* end,
+                          NPar::TLocalExecutor* localExecutor) {
+    auto& reindexHash = *reindexHashPtr;
+    auto* hashArr = begin;
+    const size_t learnSize = end - begin;
+    ReindexByFirstOccurrence(&reindexHash, begin, end, localExecutor);
+    if (topSize <= learnSize && reindexHash.Size() > topSize) {
+        // Limit reindexHash to topSize most frequent buckets, ties are broken by the first occurrence,
+        // so the result depends only on how documents are split into buckets and not on hash values
+        TVector<ui32> bucketSizes(reindexHash.Size(), 0);
+        for (size_t i = 0; i < learnSize; ++i) {
+            ++bucketSizes[hashArr[i]];
+        }
+        TVector<ui32> buckets(reindexHash.Size());
+        Iota(buckets.begin(), buckets.end(), 0);
+        std::nth_element(buckets.begin(), buckets.begin() + topSize, buckets.end(),
+                         [&](ui32 a, ui32 b) {
+                             return bucketSizes[a] > bucketSizes[b] || (bucketSizes[a] == bucketSizes[b] && a < b);
                          });
+        Sort(buckets.begin(), buckets.begin() + topSize);
 
-            reindexHash.MakeEmpty();
-            for (ui32 i = 0; i < topSize; ++i) {
-                reindexHash.GetMutable(freqValList[i].first) = i;
-            }
-            for (ui64* hash = begin; hash != end; ++hash) {
-               auto it = reindexHash.Find(*hash);
-               if (it != reindexHash.end()) {
-                   *hash = it.Value();
-               } else {
-                   *hash = reindexHash.Size() - 1;
-               }
+        constexpr ui32 DroppedBucket = Max<ui32>();
+        TVector<ui32> limitedBuckets(reindexHash.Size(), DroppedBucket);
+        for (ui32 i = 0; i < topSize; ++i) {
+            limitedBuckets[buckets[i]] = i;
+        }
+        TVector<std::pair<ui64, ui32>> keptHashes;
+        keptHashes.reserve(topSize);
+        for (const auto& it : reindexHash) {
+            if (limitedBuckets[it.Value()] != DroppedBucket) {
+                keptHashes.emplace_back(it.Key(), limitedBuckets[it.Value()]);
             }
         }
+        reindexHash.MakeEmpty();
+        for (const auto& hashBucket : keptHashes) {
+            reindexHash.GetMutable(hashBucket.first) = hashBucket.second;
+        }
+        ReindexInBlocks(learnSize, localExecutor, [&](int i) {
+            const ui32 bucket = limitedBuckets[hashArr[i]];
+            hashArr[i] = bucket != DroppedBucket ? bucket : reindexHash.Size() - 1;
+        });
     }
     return reindexHash.Size();
 }
 
 /// Update reindexHash and reindex hash values in range [begin,end).
-size_t UpdateReindexHash(TDenseHash<ui64, ui32>* reindexHashPtr, ui64* begin, ui64* end) {
-    auto& reindexHash = *reindexHashPtr;
-    ui32 counter = reindexHash.Size();
-    for (ui64* hash = begin; hash != end; ++hash) {
-        bool isInserted = false;
-        auto& hashVal = reindexHash.GetMutable(*hash, &isInserted);
-        if (isInserted) {
-            hashVal = counter;
-            *hash = counter;
-            ++counter;
-        } else {
-            *hash = hashVal;
-        }
-    }
-    return reindexHash.Size();
+size_t UpdateReindexHash(TDenseHash<ui64, ui32>* reindexHashPtr, ui64* begin, ui64* end, NPar::TLocalExecutor* localExecutor) {
+    ReindexByFirstOccurrence(reindexHashPtr, begin, end, localExecutor);
+    return reindexHashPtr->Size();
 }
@@ -6,11 +6,12 @@
 #include <catboost/libs/helpers/clear_array.h>
 
 #include <library/containers/dense_hash/dense_hash.h>
+#include <library/threading/local_executor/local_executor.h>
 
 /// Calculate document hashes into range [begin,end) for CTR bucket identification.
 /// @param proj - Projection delivering the feature ids to hash
 /// @param allFeatures - Values of features to hash
-/// @param offset - Begin from this offset when accessing `allFeatures`
+/// @param offset - Begin from this offset when accessing `allFeatures` (or `learnPermutation` if it is given)
 /// @param learnPermutation - Use this permutation when accessing `allFeatures`
 /// @param calculateExactCatHashes - Hash original cat features (true) or one-hot-encoded (false)
 /// @param begin, @param end - Result range
@@ -25,38 +26,35 @@ inline void CalcHashes(const TProjection& proj,
     if (sampleCount == 0) {
         return;
     }
+    // with permutation, `offset` is applied to the permutation instead of feature values
+    const size_t* perm = nullptr;
+    size_t featureOffset = offset;
     if (learnPermutation != nullptr) {
-        Y_VERIFY(offset == 0);
-        Y_VERIFY(sampleCount == learnPermutation->size());
+        Y_VERIFY(offset + sampleCount <= learnPermutation->size());
+        perm = learnPermutation->data() + offset;
+        featureOffset = 0;
     }
 
     ui64* hashArr = begin;
     if (calculateExactCatHashes) {
-        TVector<int> exactValues;
         for (const int featureIdx : proj.CatFeatures) {
-            const int* featureValues = offset + allFeatures.CatFeaturesRemapped[featureIdx].data();
+            const int* featureValues = featureOffset + allFeatures.CatFeaturesRemapped[featureIdx].data();
             // Calculate hashes for model CTR table
-            exactValues.resize(sampleCount);
-            auto& ohv = allFeatures.OneHotValues[featureIdx];
-            for (size_t i = 0; i < sampleCount; ++i) {
-                exactValues[i] = ohv[featureValues[i]];
-            }
-            if (learnPermutation != nullptr) {
-                const auto& perm = *learnPermutation;
+            const auto& ohv = allFeatures.OneHotValues[featureIdx];
+            if (perm != nullptr) {
                 for (size_t i = 0; i < sampleCount; ++i) {
-                    hashArr[i] = CalcHash(hashArr[i], (ui64)exactValues[perm[i]]);
+                    hashArr[i] = CalcHash(hashArr[i], (ui64)ohv[featureValues[perm[i]]]);
                 }
             } else {
                 for (size_t i = 0; i < sampleCount; ++i) {
-                    hashArr[i] = CalcHash(hashArr[i], (ui64)exactValues[i]);
+                    hashArr[i] = CalcHash(hashArr[i], (ui64)ohv[featureValues[i]]);
                 }
             }
         }
     } else {
         for (const int featureIdx : proj.CatFeatures) {
-            const int* featureValues = offset + allFeatures.CatFeaturesRemapped[featureIdx].data();
-            if (learnPermutation != nullptr) {
-                const auto& perm = *learnPermutation;
+            const int* featureValues = featureOffset + allFeatures.CatFeaturesRemapped[featureIdx].data();
+            if (perm != nullptr) {
                 for (size_t i = 0; i < sampleCount; ++i) {
                     hashArr[i] = CalcHash(hashArr[i], (ui64)featureValues[perm[i]] + 1);
                 }
@@ -69,9 +67,8 @@ inline void CalcHashes(const TProjection& proj,
     }
 
     for (const TBinFeature& feature : proj.BinFeatures) {
-        const ui8* featureValues = offset + allFeatures.FloatHistograms[feature.FloatFeature].data();
-        if (learnPermutation != nullptr) {
-            const auto& perm = *learnPermutation;
+        const ui8* featureValues = featureOffset + allFeatures.FloatHistograms[feature.FloatFeature].data();
+        if (perm != nullptr) {
             for (size_t i = 0; i < sampleCount; ++i) {
                 const bool isTrueFeature = IsTrueHistogram(featureValues[perm[i]], feature.SplitIdx);
                 hashArr[i] = CalcHash(hashArr[i], (ui64)isTrueFeature);
@@ -85,9 +82,8 @@ inline void CalcHashes(const TProjection& proj,
     }
 
     for (const TOneHotSplit& feature : proj.OneHotFeatures) {
-        const int* featureValues = offset + allFeatures.CatFeaturesRemapped[feature.CatFeatureIdx].data();
-        if (learnPermutation != nullptr) {
-            const auto& perm = *learnPermutation;
+        const int* featureValues = featureOffset + allFeatures.CatFeaturesRemapped[feature.CatFeatureIdx].data();
+        if (perm != nullptr) {
             for (size_t i = 0; i < sampleCount; ++i) {
                 const bool isTrueFeature = IsTrueOneHotFeature(featureValues[perm[i]], feature.Value);
                 hashArr[i] = CalcHash(hashArr[i], (ui64)isTrueFeature);
@@ -103,12 +99,23 @@ inline void CalcHashes(const TProjection& proj,
 
 /// Compute reindexHash and reindex hash values in range [begin,end).
 /// After reindex, hash values belong to [0, reindexHash.Size()].
+/// Hash values are numbered in order of their first occurrence.
 /// If reindexHash would become larger than topSize, keep only topSize most
-/// frequent mappings and map other hash values to value reindexHash.Size().
+/// frequent mappings (the earliest ones among equally frequent) and map other hash values to value reindexHash.Size().
+/// The result does not depend on hash values, only on which documents have equal hashes.
+/// If localExecutor is given, large ranges are processed in parallel with the same result.
 /// @return the size of reindexHash.
-size_t ComputeReindexHash(ui64 topSize, TDenseHash<ui64, ui32>* reindexHashPtr, ui64* begin, ui64* end);
+size_t ComputeReindexHash(ui64 topSize,
+                          TDenseHash<ui64, ui32>* reindexHashPtr,
+                          ui64* begin,
+                          ui64* end,
+                          NPar::TLocalExecutor* localExecutor = nullptr);
 
 /// Update reindexHash and reindex hash values in range [begin,end).
 /// If a hash value is not present in reindexHash, then update reindexHash for that value.
+/// If localExecutor is given, large ranges are processed in parallel with the same result.
 /// @return the size of updated reindexHash.
-size_t UpdateReindexHash(TDenseHash<ui64, ui32>* reindexHashPtr, ui64* begin, ui64* end);
+size_t UpdateReindexHash(TDenseHash<ui64, ui32>* reindexHashPtr,
+                         ui64* begin,
+                         ui64* end,
+                         NPar::TLocalExecutor* localExecutor = nullptr);
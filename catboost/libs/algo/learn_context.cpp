@@ -161,7 +161,8 @@ void TLearnContext::SaveProgress() {
     if (!OutputOptions.SaveSnapshot()) {
         return;
     }
-    TProgressHelper(ToString(ETaskType::CPU)).Write(Files.SnapshotFile, [&](IOutputStream* out) {
+    // only in-memory serialization happens here, compression and disk io are done in background
+    SnapshotWriter->Write([&](IOutputStream* out) {
         ::SaveMany(out, Rand, LearnProgress, Profile.DumpProfileInfo());
     });
 }
@@ -197,7 +198,7 @@ bool TLearnContext::TryLoadProgress() {
         return false;
     }
     try {
-        TProgressHelper(ToString(ETaskType::CPU)).CheckedLoad(Files.SnapshotFile, [&](TIFStream* in)
+        TProgressHelper(ToString(ETaskType::CPU)).CheckedLoad(Files.SnapshotFile, [&](IInputStream* in)
         {
             TLearnProgress LearnProgressRestored = LearnProgress; // use progress copy to avoid partial deserialization of corrupted progress file
             TProfileInfoData ProfileRestored;
@@ -6,12 +6,14 @@
 #include "ctr_helper.h"
 #include "split.h"
 #include "calc_score_cache.h"
+#include "scratch_arena.h"
 
 #include <catboost/libs/metrics/metric.h>
 #include <catboost/libs/logging/logging.h>
 #include <catboost/libs/logging/profile_info.h>
 #include <catboost/libs/options/catboost_options.h>
 #include <catboost/libs/helpers/multiclass_label_helpers/label_converter.h>
+#include <catboost/libs/helpers/progress_helper.h>
 #include <catboost/libs/helpers/restorable_rng.h>
 
 #include <library/json/json_reader.h>
@@ -104,10 +106,14 @@ public:
         , Files(outputOptions, fileNamesPrefix)
         , RootEnvironment(nullptr)
         , SharedTrainData(nullptr)
-        , Profile((int)Params.BoostingOptions->IterationCount) {
+        , Profile((int)Params.BoostingOptions->IterationCount)
+        , ScratchArenas(LocalExecutor) {
         LearnProgress.SerializedTrainParams = ToString(Params);
         ETaskType taskType = Params.GetTaskType();
         CB_ENSURE(taskType == ETaskType::CPU, "Error: except learn on CPU task type, got " << taskType);
+        if (OutputOptions.SaveSnapshot()) {
+            SnapshotWriter = MakeHolder<TAsyncProgressWriter>(ToString(ETaskType::CPU), Files.SnapshotFile, OutputOptions.GetSnapshotCodec());
+        }
     }
     ~TLearnContext();
 
@@ -128,5 +134,9 @@ public:
     TObj<NPar::IRootEnvironment> RootEnvironment;
     TObj<NPar::IEnvironment> SharedTrainData;
     TProfileInfo Profile;
+    TScratchArenas ScratchArenas;
+
+private:
+    THolder<TAsyncProgressWriter> SnapshotWriter;
 };
 
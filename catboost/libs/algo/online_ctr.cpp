@@ -97,6 +97,55 @@ namespace {
     };
 }
 
+static const int MinParallelDocBlockSize = 10000;
+
+// Call calcRange(rangeStart, rangeEnd) for consecutive ranges covering [0, docCount) in parallel,
+// the whole range is processed in the calling thread if localExecutor is not given
+template <typename TCalcRange>
+static void ParallelCalcRanges(int docCount, NPar::TLocalExecutor* localExecutor, const TCalcRange& calcRange) {
+    if (localExecutor == nullptr) {
+        calcRange(0, docCount);
+        return;
+    }
+    const int threadCount = localExecutor->GetThreadCount() + 1;
+    NPar::TLocalExecutor::TExecRangeParams blockParams(0, docCount);
+    blockParams.SetBlockSize(Max(MinParallelDocBlockSize, (docCount + threadCount - 1) / threadCount));
+    localExecutor->ExecRange([&](int blockIdx) {
+        const int rangeStart = blockIdx * blockParams.GetBlockSize();
+        calcRange(rangeStart, Min(docCount, rangeStart + blockParams.GetBlockSize()));
+    }, 0, blockParams.GetBlockCount(), NPar::TLocalExecutor::WAIT_COMPLETE);
+}
+
+void TOnlineCtrValues::Pack(NPar::TLocalExecutor* localExecutor) {
+    Y_ASSERT(!IsPackedFlag);
+    TVector<ui8> packedValues;
+    packedValues.yresize((DocCount + 1) / 2);
+    const ui8* values = Values.data();
+    ui8* packedValuesData = packedValues.data();
+    const size_t docCount = DocCount;
+    ParallelCalcRanges(packedValues.ysize(), localExecutor, [=](int rangeStart, int rangeEnd) {
+        for (int i = rangeStart; i < rangeEnd; ++i) {
+            const ui8 lowValue = values[2 * i];
+            const ui8 highValue = static_cast<size_t>(2 * i + 1) < docCount ? values[2 * i + 1] : 0;
+            Y_ASSERT(lowValue <= MaxPackedValue && highValue <= MaxPackedValue);
+            packedValuesData[i] = lowValue | (highValue << 4);
+        }
+    });
+    Values.swap(packedValues);
+    IsPackedFlag = true;
+}
+
+// Learn documents update ctr statistics in permutation order and are processed sequentially,
+// test documents only read final statistics and are processed in parallel
+template <typename TCalcDocs>
+static void CalcLearnAndTestCtrs(const TVector<size_t>& testOffsets, NPar::TLocalExecutor* localExecutor, const TCalcDocs& calcDocs) {
+    const int learnSampleCount = testOffsets[0];
+    calcDocs(0, learnSampleCount);
+    ParallelCalcRanges(testOffsets.back() - learnSampleCount, localExecutor, [&](int rangeStart, int rangeEnd) {
+        calcDocs(learnSampleCount + rangeStart, rangeEnd - rangeStart);
+    });
+}
+
 static void CalcOnlineCTRClasses(const TVector<size_t>& testOffsets,
                                  const TVector<ui64>& enumeratedCatFeatures,
                                  size_t leafCount,
@@ -105,58 +154,58 @@ static void CalcOnlineCTRClasses(const TVector<size_t>& testOffsets,
                                  const TVector<float>& priors,
                                  int ctrBorderCount,
                                  ECtrType ctrType,
-                                 TArray2D<TVector<ui8>>* feature) {
+                                 NPar::TLocalExecutor* localExecutor,
+                                 TArray2D<TOnlineCtrValues>* feature) {
     TVector<float> shift;
     TVector<float> norm;
     CalcNormalization(priors, &shift, &norm);
 
     const int blockSize = (1000 + targetBorderCount - 1) / targetBorderCount + 100; // ensure blocks have reasonable size
-    TVector<int> totalCountByDoc(blockSize);
-    TVector<TVector<int>> goodCountByBorderByDoc(targetBorderCount, TVector<int>(blockSize));
+    const int learnSampleCount = testOffsets[0];
     TBucketsView bv(leafCount, targetClassesCount);
 
-    auto calcGoodCounts = [&](int blockStart, int nextBlockStart, int docOffset) {
-        for (int docId = blockStart; docId < nextBlockStart; ++docId) {
-            const auto elemId = enumeratedCatFeatures[docOffset + docId];
+    auto calcDocs = [&](int firstDoc, int docCount) {
+        TVector<int> totalCountByDoc(blockSize);
+        TVector<TVector<int>> goodCountByBorderByDoc(targetBorderCount, TVector<int>(blockSize));
 
-            int goodCount = totalCountByDoc[docId - blockStart] = bv.GetTotal(elemId);
-            auto bordersData = bv.GetBorders(elemId);
-            for (int border = 0; border < targetBorderCount; ++border) {
-                UpdateGoodCount(bordersData[border], ctrType, &goodCount);
-                goodCountByBorderByDoc[border][docId - blockStart] = goodCount;
-            }
+        auto calcGoodCounts = [&](int blockStart, int nextBlockStart, int docOffset) {
+            for (int docId = blockStart; docId < nextBlockStart; ++docId) {
+                const auto elemId = enumeratedCatFeatures[docOffset + docId];
 
-            if (docOffset == 0) {
-                ++bordersData[permutedTargetClass[docId]];
-                ++bv.GetTotal(elemId);
+                int goodCount = totalCountByDoc[docId - blockStart] = bv.GetTotal(elemId);
+                auto bordersData = bv.GetBorders(elemId);
+                for (int border = 0; border < targetBorderCount; ++border) {
+                    UpdateGoodCount(bordersData[border], ctrType, &goodCount);
+                    goodCountByBorderByDoc[border][docId - blockStart] = goodCount;
+                }
+
+                if (docOffset + docId < learnSampleCount) {
+                    ++bordersData[permutedTargetClass[docId]];
+                    ++bv.GetTotal(elemId);
+                }
             }
-        }
-    };
+        };
 
-    auto calcCTRs = [&](int blockStart, int nextBlockStart, int docOffset) {
-        for (int border = 0; border < targetBorderCount; ++border) {
-            for (int prior = 0; prior < priors.ysize(); ++prior) {
-                const float priorX = priors[prior];
-                const float shiftX = shift[prior];
-                const float normX = norm[prior];
-                const int* goodCountData = goodCountByBorderByDoc[border].data();
-                ui8* featureData = docOffset + (*feature)[border][prior].data();
-                for (int docId = blockStart; docId < nextBlockStart; ++docId) {
-                    featureData[docId] = CalcCTR(goodCountData[docId - blockStart], totalCountByDoc[docId - blockStart],
-                                                 priorX, shiftX, normX, ctrBorderCount);
+        auto calcCTRs = [&](int blockStart, int nextBlockStart, int docOffset) {
+            for (int border = 0; border < targetBorderCount; ++border) {
+                for (int prior = 0; prior < priors.ysize(); ++prior) {
+                    const float priorX = priors[prior];
+                    const float shiftX = shift[prior];
+                    const float normX = norm[prior];
+                    const int* goodCountData = goodCountByBorderByDoc[border].data();
+                    ui8* featureData = docOffset + (*feature)[border][prior].GetData();
+                    for (int docId = blockStart; docId < nextBlockStart; ++docId) {
+                        featureData[docId] = CalcCTR(goodCountData[docId - blockStart], totalCountByDoc[docId - blockStart],
+                                                     priorX, shiftX, normX, ctrBorderCount);
+                    }
                 }
             }
-        }
-    };
+        };
 
-    TBlockedCalcer calcer(blockSize);
-    const size_t learnSampleCount = testOffsets[0];
-    calcer.Calc(calcGoodCounts, calcCTRs, 0, learnSampleCount);
-    for (size_t docOffset = learnSampleCount, testIdx = 0; testIdx < testOffsets.size() - 1; ++testIdx) {
-        const size_t testSampleCount = testOffsets[testIdx + 1] - testOffsets[testIdx];
-        calcer.Calc(calcGoodCounts, calcCTRs, docOffset, testSampleCount);
-        docOffset += testSampleCount;
-    }
+        TBlockedCalcer calcer(blockSize);
+        calcer.Calc(calcGoodCounts, calcCTRs, firstDoc, docCount);
+    };
+    CalcLearnAndTestCtrs(testOffsets, localExecutor, calcDocs);
 }
 
 static void CalcOnlineCTRSimple(const TVector<size_t>& testOffsets,
@@ -165,48 +214,48 @@ static void CalcOnlineCTRSimple(const TVector<size_t>& testOffsets,
                                 const TVector<int>& permutedTargetClass,
                                 const TVector<float>& priors,
                                 int ctrBorderCount,
-                                TArray2D<TVector<ui8>>* feature) {
+                                NPar::TLocalExecutor* localExecutor,
+                                TArray2D<TOnlineCtrValues>* feature) {
     TVector<float> shift;
     TVector<float> norm;
     CalcNormalization(priors, &shift, &norm);
 
     const int blockSize = 1000;
-    auto ctrArrSimple = TCtrCalcer::GetCtrHistoryArr(leafCount + blockSize);
-    auto totalCount = reinterpret_cast<int*>(ctrArrSimple.data() + leafCount);
-    auto goodCount = totalCount + blockSize;
-
-    auto calcGoodCount = [&](int blockStart, int nextBlockStart, int docOffset) {
-        for (int docId = blockStart; docId < nextBlockStart; ++docId) {
-            TCtrHistory& elem = ctrArrSimple[enumeratedCatFeatures[docOffset + docId]];
-            goodCount[docId - blockStart] = elem.N[1];
-            totalCount[docId - blockStart] = elem.N[0] + elem.N[1];
-            if (docOffset == 0) {
-                ++elem.N[permutedTargetClass[docId]];
-            }
-        }
-    };
+    const int learnSampleCount = testOffsets[0];
+    auto ctrArrSimple = TCtrCalcer::GetCtrHistoryArr(leafCount);
 
-    auto calcCTRs = [&](int blockStart, int nextBlockStart, int docOffset) {
-        for (int prior = 0; prior < priors.ysize(); ++prior) {
-            const float priorX = priors[prior];
-            const float shiftX = shift[prior];
-            const float normX = norm[prior];
-            ui8* featureData = docOffset + (*feature)[0][prior].data();
+    auto calcDocs = [&](int firstDoc, int docCount) {
+        TVector<int> totalCount(blockSize);
+        TVector<int> goodCount(blockSize);
+
+        auto calcGoodCount = [&](int blockStart, int nextBlockStart, int docOffset) {
             for (int docId = blockStart; docId < nextBlockStart; ++docId) {
-                featureData[docId] = CalcCTR(goodCount[docId - blockStart], totalCount[docId - blockStart],
-                                             priorX, shiftX, normX, ctrBorderCount);
+                TCtrHistory& elem = ctrArrSimple[enumeratedCatFeatures[docOffset + docId]];
+                goodCount[docId - blockStart] = elem.N[1];
+                totalCount[docId - blockStart] = elem.N[0] + elem.N[1];
+                if (docOffset + docId < learnSampleCount) {
+                    ++elem.N[permutedTargetClass[docId]];
+                }
             }
-        }
-    };
+        };
 
-    TBlockedCalcer calcer(blockSize);
-    const size_t learnSampleCount = testOffsets[0];
-    calcer.Calc(calcGoodCount, calcCTRs, 0, learnSampleCount);
-    for (size_t docOffset = learnSampleCount, testIdx = 0; testIdx < testOffsets.size() - 1; ++testIdx) {
-        const size_t testSampleCount = testOffsets[testIdx + 1] - testOffsets[testIdx];
-        calcer.Calc(calcGoodCount, calcCTRs, docOffset, testSampleCount);
-        docOffset += testSampleCount;
-    }
+        auto calcCTRs = [&](int blockStart, int nextBlockStart, int docOffset) {
+            for (int prior = 0; prior < priors.ysize(); ++prior) {
+                const float priorX = priors[prior];
+                const float shiftX = shift[prior];
+                const float normX = norm[prior];
+                ui8* featureData = docOffset + (*feature)[0][prior].GetData();
+                for (int docId = blockStart; docId < nextBlockStart; ++docId) {
+                    featureData[docId] = CalcCTR(goodCount[docId - blockStart], totalCount[docId - blockStart],
+                                                 priorX, shiftX, normX, ctrBorderCount);
+                }
+            }
+        };
+
+        TBlockedCalcer calcer(blockSize);
+        calcer.Calc(calcGoodCount, calcCTRs, firstDoc, docCount);
+    };
+    CalcLearnAndTestCtrs(testOffsets, localExecutor, calcDocs);
 }
 
 static void CalcOnlineCTRMean(const TVector<size_t>& testOffsets,
@@ -216,48 +265,48 @@ static void CalcOnlineCTRMean(const TVector<size_t>& testOffsets,
                               int targetBorderCount,
                               const TVector<float>& priors,
                               int ctrBorderCount,
-                              TArray2D<TVector<ui8>>* feature) {
+                              NPar::TLocalExecutor* localExecutor,
+                              TArray2D<TOnlineCtrValues>* feature) {
     TVector<float> shift;
     TVector<float> norm;
     CalcNormalization(priors, &shift, &norm);
 
     const int blockSize = 1000;
-    TVector<float> sum(blockSize);
-    TVector<int> count(blockSize);
+    const int learnSampleCount = testOffsets[0];
     auto ctrArrMean = TCtrCalcer::GetCtrMeanHistoryArr(leafCount);
 
-    auto calcCount = [&](int blockStart, int nextBlockStart, int docOffset) {
-        for (int docId = blockStart; docId < nextBlockStart; ++docId) {
-            TCtrMeanHistory& elem = ctrArrMean[enumeratedCatFeatures[docOffset + docId]];
-            sum[docId - blockStart] = elem.Sum;
-            count[docId - blockStart] = elem.Count;
-            if (docOffset == 0) {
-                elem.Add(static_cast<float>(permutedTargetClass[docId]) / targetBorderCount);
-            }
-        }
-    };
+    auto calcDocs = [&](int firstDoc, int docCount) {
+        TVector<float> sum(blockSize);
+        TVector<int> count(blockSize);
 
-    auto calcCTRs = [&](int blockStart, int nextBlockStart, int docOffset) {
-        for (int prior = 0; prior < priors.ysize(); ++prior) {
-            const float priorX = priors[prior];
-            const float shiftX = shift[prior];
-            const float normX = norm[prior];
-            ui8* featureData = docOffset + (*feature)[0][prior].data();
+        auto calcCount = [&](int blockStart, int nextBlockStart, int docOffset) {
             for (int docId = blockStart; docId < nextBlockStart; ++docId) {
-                featureData[docId] = CalcCTR(sum[docId - blockStart], count[docId - blockStart],
-                                             priorX, shiftX, normX, ctrBorderCount);
+                TCtrMeanHistory& elem = ctrArrMean[enumeratedCatFeatures[docOffset + docId]];
+                sum[docId - blockStart] = elem.Sum;
+                count[docId - blockStart] = elem.Count;
+                if (docOffset + docId < learnSampleCount) {
+                    elem.Add(static_cast<float>(permutedTargetClass[docId]) / targetBorderCount);
+                }
             }
-        }
-    };
+        };
 
-    TBlockedCalcer calcer(blockSize);
-    const size_t learnSampleCount = testOffsets[0];
-    calcer.Calc(calcCount, calcCTRs, 0, learnSampleCount);
-    for (size_t docOffset = learnSampleCount, testIdx = 0; testIdx < testOffsets.size() - 1; ++testIdx) {
-        const size_t testSampleCount = testOffsets[testIdx + 1] - testOffsets[testIdx];
-        calcer.Calc(calcCount, calcCTRs, docOffset, testSampleCount);
-        docOffset += testSampleCount;
-    }
+        auto calcCTRs = [&](int blockStart, int nextBlockStart, int docOffset) {
+            for (int prior = 0; prior < priors.ysize(); ++prior) {
+                const float priorX = priors[prior];
+                const float shiftX = shift[prior];
+                const float normX = norm[prior];
+                ui8* featureData = docOffset + (*feature)[0][prior].GetData();
+                for (int docId = blockStart; docId < nextBlockStart; ++docId) {
+                    featureData[docId] = CalcCTR(sum[docId - blockStart], count[docId - blockStart],
+                                                 priorX, shiftX, normX, ctrBorderCount);
+                }
+            }
+        };
+
+        TBlockedCalcer calcer(blockSize);
+        calcer.Calc(calcCount, calcCTRs, firstDoc, docCount);
+    };
+    CalcLearnAndTestCtrs(testOffsets, localExecutor, calcDocs);
 }
 
 static void CalcOnlineCTRCounter(const TVector<size_t>& testOffsets,
@@ -266,46 +315,141 @@ static void CalcOnlineCTRCounter(const TVector<size_t>& testOffsets,
                                  int denominator,
                                  const TVector<float>& priors,
                                  int ctrBorderCount,
-                                 TArray2D<TVector<ui8>>* feature) {
+                                 NPar::TLocalExecutor* localExecutor,
+                                 TArray2D<TOnlineCtrValues>* feature) {
     TVector<float> shift;
     TVector<float> norm;
     CalcNormalization(priors, &shift, &norm);
 
+    // counter ctrs don't depend on learn order, so all documents are processed in parallel
     const int blockSize = 1000;
-    auto ctrTotal = TCtrCalcer::GetCtrArrTotal(blockSize);
-    auto calcTotal = [&](int blockStart, int nextBlockStart, int docOffset) {
-        for (int docId = blockStart; docId < nextBlockStart; ++docId) {
-            const auto elemId = enumeratedCatFeatures[docOffset + docId];
-            ctrTotal[docId - blockStart] = counterCTRTotal[elemId];
-        }
-    };
-
-    auto calcCTRs = [&](int blockStart, int nextBlockStart, int docOffset) {
-        for (int prior = 0; prior < priors.ysize(); ++prior) {
-            const float priorX = priors[prior];
-            const float shiftX = shift[prior];
-            const float normX = norm[prior];
-            ui8* featureData = docOffset + (*feature)[0][prior].data();
+    ParallelCalcRanges(testOffsets.back(), localExecutor, [&](int rangeStart, int rangeEnd) {
+        TVector<int> ctrTotal(blockSize);
+        auto calcTotal = [&](int blockStart, int nextBlockStart, int docOffset) {
             for (int docId = blockStart; docId < nextBlockStart; ++docId) {
-                featureData[docId] = CalcCTR(ctrTotal[docId - blockStart], denominator, priorX, shiftX, normX, ctrBorderCount);
+                const auto elemId = enumeratedCatFeatures[docOffset + docId];
+                ctrTotal[docId - blockStart] = counterCTRTotal[elemId];
             }
+        };
+
+        auto calcCTRs = [&](int blockStart, int nextBlockStart, int docOffset) {
+            for (int prior = 0; prior < priors.ysize(); ++prior) {
+                const float priorX = priors[prior];
+                const float shiftX = shift[prior];
+                const float normX = norm[prior];
+                ui8* featureData = docOffset + (*feature)[0][prior].GetData();
+                for (int docId = blockStart; docId < nextBlockStart; ++docId) {
+                    featureData[docId] = CalcCTR(ctrTotal[docId - blockStart], denominator, priorX, shiftX, normX, ctrBorderCount);
+                }
+            }
+        };
+
+        TBlockedCalcer calcer(blockSize);
+        calcer.Calc(calcTotal, calcCTRs, rangeStart, rangeEnd - rangeStart);
+    });
+}
+
+static void CountOnlineCTRTotal(const TVector<ui64>& hashArr,
+                                int sampleCount,
+                                NPar::TLocalExecutor* localExecutor,
+                                TVector<int>* counterCTRTotal) {
+    const int leafCount = counterCTRTotal->ysize();
+    const int threadCount = localExecutor->GetThreadCount() + 1;
+    // per block counters are worth it only when they take less memory than the hashes
+    if (threadCount == 1 || sampleCount < MinParallelDocBlockSize || (size_t)leafCount * threadCount > (size_t)sampleCount) {
+        for (int sampleIdx = 0; sampleIdx < sampleCount; ++sampleIdx) {
+            const auto elemId = hashArr[sampleIdx];
+            ++(*counterCTRTotal)[elemId];
         }
-    };
+        return;
+    }
+    NPar::TLocalExecutor::TExecRangeParams blockParams(0, sampleCount);
+    blockParams.SetBlockCount(threadCount);
+    TVector<TVector<int>> blockCounters(blockParams.GetBlockCount(), TVector<int>(leafCount));
+    localExecutor->ExecRange([&](int blockIdx) {
+        int* counters = blockCounters[blockIdx].data();
+        NPar::TLocalExecutor::BlockedLoopBody(blockParams, [&](int sampleIdx) {
+            ++counters[hashArr[sampleIdx]];
+        })(blockIdx);
+    }, 0, blockParams.GetBlockCount(), NPar::TLocalExecutor::WAIT_COMPLETE);
+    for (const auto& counters : blockCounters) {
+        for (int elemId = 0; elemId < leafCount; ++elemId) {
+            (*counterCTRTotal)[elemId] += counters[elemId];
+        }
+    }
+}
 
-    TBlockedCalcer calcer(blockSize);
-    const size_t learnSampleCount = testOffsets[0];
-    calcer.Calc(calcTotal, calcCTRs, 0, learnSampleCount);
-    for (size_t docOffset = learnSampleCount, testIdx = 0; testIdx < testOffsets.size() - 1; ++testIdx) {
-        const size_t testSampleCount = testOffsets[testIdx + 1] - testOffsets[testIdx];
-        calcer.Calc(calcTotal, calcCTRs, docOffset, testSampleCount);
+void CalcOnlineCtrHashes(const TDataset& learnData,
+                         const TDatasetPtrs& testDataPtrs,
+                         const TFold& fold,
+                         const TProjection& proj,
+                         NPar::TLocalExecutor* localExecutor,
+                         TVector<ui64>* hashArr) {
+    const size_t learnSampleCount = fold.LearnPermutation.size();
+    const size_t totalSampleCount = learnSampleCount + GetSampleCount(testDataPtrs);
+    Clear(hashArr, totalSampleCount);
+    ui64* hashes = hashArr->data();
+    ParallelCalcRanges(learnSampleCount, localExecutor, [&](int rangeStart, int rangeEnd) {
+        CalcHashes(proj, learnData.AllFeatures, rangeStart, &fold.LearnPermutation, false, hashes + rangeStart, hashes + rangeEnd);
+    });
+    for (size_t docOffset = learnSampleCount, testIdx = 0; docOffset < totalSampleCount && testIdx < testDataPtrs.size(); ++testIdx) {
+        const size_t testSampleCount = testDataPtrs[testIdx]->GetSampleCount();
+        ui64* testHashes = hashes + docOffset;
+        ParallelCalcRanges(testSampleCount, localExecutor, [&](int rangeStart, int rangeEnd) {
+            CalcHashes(proj, testDataPtrs[testIdx]->AllFeatures, rangeStart, nullptr, false, testHashes + rangeStart, testHashes + rangeEnd);
+        });
         docOffset += testSampleCount;
     }
 }
 
-static inline void CountOnlineCTRTotal(const TVector<ui64>& hashArr, int sampleCount, TVector<int>* counterCTRTotal) {
-    for (int sampleIdx = 0; sampleIdx < sampleCount; ++sampleIdx) {
-        const auto elemId = hashArr[sampleIdx];
-        ++(*counterCTRTotal)[elemId];
+// Find cached hashes of a tree ctr base projection, which gives proj when extended by one cat feature
+static const TVector<ui64>* FindTreeCtrBaseHashes(const TFold& fold, const TProjection& proj, int* addedCatFeature) {
+    if (fold.TreeCtrBaseHashes.empty()) {
+        return nullptr;
+    }
+    for (int catFeature : proj.CatFeatures) {
+        TProjection baseProj = proj;
+        baseProj.CatFeatures.erase(Find(baseProj.CatFeatures.begin(), baseProj.CatFeatures.end(), catFeature));
+        const auto baseHashes = fold.TreeCtrBaseHashes.find(baseProj);
+        if (baseHashes != fold.TreeCtrBaseHashes.end()) {
+            *addedCatFeature = catFeature;
+            return &baseHashes->second;
+        }
+    }
+    return nullptr;
+}
+
+// Combine base projection hashes with values of the added cat feature,
+// learn values are taken in fold permutation order
+static void CombineOnlineCtrHashes(const TDataset& learnData,
+                                   const TDatasetPtrs& testDataPtrs,
+                                   const TFold& fold,
+                                   const ui64* initialHashes,
+                                   int catFeature,
+                                   NPar::TLocalExecutor* localExecutor,
+                                   TVector<ui64>* hashArr) {
+    const size_t learnSampleCount = fold.LearnPermutation.size();
+    const size_t totalSampleCount = learnSampleCount + GetSampleCount(testDataPtrs);
+    hashArr->yresize(totalSampleCount);
+    ui64* hashes = hashArr->data();
+    {
+        const int* featureValues = learnData.AllFeatures.CatFeaturesRemapped[catFeature].data();
+        const auto* permutation = fold.LearnPermutation.data();
+        ParallelCalcRanges(learnSampleCount, localExecutor, [=](int rangeStart, int rangeEnd) {
+            for (int i = rangeStart; i < rangeEnd; ++i) {
+                hashes[i] = CalcHash(initialHashes[i], (ui64)featureValues[permutation[i]] + 1);
+            }
+        });
+    }
+    for (size_t docOffset = learnSampleCount, testIdx = 0; docOffset < totalSampleCount && testIdx < testDataPtrs.size(); ++testIdx) {
+        const size_t testSampleCount = testDataPtrs[testIdx]->GetSampleCount();
+        const int* featureValues = testDataPtrs[testIdx]->AllFeatures.CatFeaturesRemapped[catFeature].data();
+        ParallelCalcRanges(testSampleCount, localExecutor, [=](int rangeStart, int rangeEnd) {
+            for (int i = rangeStart; i < rangeEnd; ++i) {
+                hashes[docOffset + i] = CalcHash(initialHashes[docOffset + i], (ui64)featureValues[i] + 1);
+            }
+        });
+        docOffset += testSampleCount;
     }
 }
 
@@ -314,6 +458,7 @@ void ComputeOnlineCTRs(const TDataset& learnData,
                        const TFold& fold,
                        const TProjection& proj,
                        const TLearnContext* ctx,
+                       NPar::TLocalExecutor* localExecutor,
                        TOnlineCTR* dst) {
     const TCtrHelper& ctrHelper = ctx->CtrsHelper;
     const auto& ctrInfo = ctrHelper.GetCtrInfo(proj);
@@ -330,30 +475,38 @@ void ComputeOnlineCTRs(const TDataset& learnData,
     TVector<ui64>& hashArr = tlsHashArr.Get();
     if (proj.IsSingleCatFeature()) {
         // Shortcut for simple ctrs
-        Clear(&hashArr, totalSampleCount);
-        if (learnSampleCount > 0) {
+        hashArr.yresize(totalSampleCount);
+        ui64* hashes = hashArr.data();
+        {
             const int* featureValues = learnData.AllFeatures.CatFeaturesRemapped[proj.CatFeatures[0]].data();
             const auto* permutation = fold.LearnPermutation.data();
-            for (size_t i = 0; i < learnSampleCount; ++i) {
-                hashArr[i] = ((ui64)featureValues[permutation[i]]) + 1;
-            }
+            ParallelCalcRanges(learnSampleCount, localExecutor, [=](int rangeStart, int rangeEnd) {
+                for (int i = rangeStart; i < rangeEnd; ++i) {
+                    hashes[i] = ((ui64)featureValues[permutation[i]]) + 1;
+                }
+            });
         }
         for (size_t docOffset = learnSampleCount, testIdx = 0; docOffset < totalSampleCount && testIdx < testDataPtrs.size(); ++testIdx) {
             const size_t testSampleCount = testDataPtrs[testIdx]->GetSampleCount();
             const int* featureValues = testDataPtrs[testIdx]->AllFeatures.CatFeaturesRemapped[proj.CatFeatures[0]].data();
-            for (size_t i = 0; i < testSampleCount; ++i) {
-                hashArr[docOffset + i] = ((ui64)featureValues[i]) + 1;
-            }
+            ParallelCalcRanges(testSampleCount, localExecutor, [=](int rangeStart, int rangeEnd) {
+                for (int i = rangeStart; i < rangeEnd; ++i) {
+                    hashes[docOffset + i] = ((ui64)featureValues[i]) + 1;
+                }
+            });
             docOffset += testSampleCount;
         }
         rehashHashTlsVal.Get().MakeEmpty(learnData.AllFeatures.OneHotValues[proj.CatFeatures[0]].size());
     } else {
-        Clear(&hashArr, totalSampleCount);
-        CalcHashes(proj, learnData.AllFeatures, 0, &fold.LearnPermutation, false, hashArr.begin(), hashArr.begin() + learnSampleCount);
-        for (size_t docOffset = learnSampleCount, testIdx = 0; docOffset < totalSampleCount && testIdx < testDataPtrs.size(); ++testIdx) {
-            const size_t testSampleCount = testDataPtrs[testIdx]->GetSampleCount();
-            CalcHashes(proj, testDataPtrs[testIdx]->AllFeatures, 0, nullptr, false, hashArr.begin() + docOffset, hashArr.begin() + docOffset + testSampleCount);
-            docOffset += testSampleCount;
+        int addedCatFeature = 0;
+        const TVector<ui64>* baseHashes = FindTreeCtrBaseHashes(fold, proj, &addedCatFeature);
+        if (baseHashes != nullptr) {
+            // hash values differ from the ones of CalcOnlineCtrHashes, but split documents into the same buckets,
+            // and reindexing depends only on the split, so ctr values are the same as for the recomputed hashes
+            Y_ASSERT(baseHashes->size() == totalSampleCount);
+            CombineOnlineCtrHashes(learnData, testDataPtrs, fold, baseHashes->data(), addedCatFeature, localExecutor, &hashArr);
+        } else {
+            CalcOnlineCtrHashes(learnData, testDataPtrs, fold, proj, localExecutor, &hashArr);
         }
         size_t approxBucketsCount = 1;
         for (auto cf : proj.CatFeatures) {
@@ -368,10 +521,10 @@ void ComputeOnlineCTRs(const TDataset& learnData,
     if (proj.IsSingleCatFeature() && ctx->Params.CatFeatureParams->StoreAllSimpleCtrs) {
         topSize = Max<ui64>();
     }
-    auto leafCount = ComputeReindexHash(topSize, rehashHashTlsVal.GetPtr(), hashArr.begin(), hashArr.begin() + learnSampleCount);
+    auto leafCount = ComputeReindexHash(topSize, rehashHashTlsVal.GetPtr(), hashArr.begin(), hashArr.begin() + learnSampleCount, localExecutor);
     for (size_t docOffset = learnSampleCount, testIdx = 0; docOffset < totalSampleCount && testIdx < testDataPtrs.size(); ++testIdx) {
         const size_t testSampleCount = testDataPtrs[testIdx]->GetSampleCount();
-        leafCount = UpdateReindexHash(rehashHashTlsVal.GetPtr(), hashArr.begin() + docOffset, hashArr.begin() + docOffset + testSampleCount);
+        leafCount = UpdateReindexHash(rehashHashTlsVal.GetPtr(), hashArr.begin() + docOffset, hashArr.begin() + docOffset + testSampleCount, localExecutor);
         docOffset += testSampleCount;
     }
     dst->FeatureValueCount = leafCount;
@@ -381,11 +534,12 @@ void ComputeOnlineCTRs(const TDataset& learnData,
     if (AnyOf(ctrInfo.begin(), ctrInfo.begin() + dst->Feature.ysize(), [] (const auto& info) { return info.Type == ECtrType::Counter; })) {
         counterCTRTotal.resize(leafCount);
         const int sampleCount = ctx->Params.CatFeatureParams->CounterCalcMethod == ECounterCalc::Full ? hashArr.ysize() : learnSampleCount;
-        CountOnlineCTRTotal(hashArr, sampleCount, &counterCTRTotal);
+        CountOnlineCTRTotal(hashArr, sampleCount, localExecutor, &counterCTRTotal);
         counterCTRDenominator = *MaxElement(counterCTRTotal.begin(), counterCTRTotal.end());
     }
 
-    for (int ctrIdx = 0; ctrIdx < dst->Feature.ysize(); ++ctrIdx) {
+    // ctrs of different types and target classifiers are independent
+    localExecutor->ExecRange([&](int ctrIdx) {
         const ECtrType ctrType = ctrInfo[ctrIdx].Type;
         const ui32 classifierId = ctrInfo[ctrIdx].TargetClassifierIdx;
         int targetClassesCount = fold.TargetClassesCount[classifierId];
@@ -397,7 +551,7 @@ void ComputeOnlineCTRs(const TDataset& learnData,
 
         for (ui32 border = 0; border < targetBorderCount; ++border) {
             for (int prior = 0; prior < priors.ysize(); ++prior) {
-                Clear(&dst->Feature[ctrIdx][border][prior], totalSampleCount);
+                dst->Feature[ctrIdx][border][prior].Reset(totalSampleCount);
             }
         }
 
@@ -409,6 +563,7 @@ void ComputeOnlineCTRs(const TDataset& learnData,
                 fold.LearnTargetClass[classifierId],
                 priors,
                 ctrBorderCount,
+                localExecutor,
                 &dst->Feature[ctrIdx]);
 
         } else if (ctrType == ECtrType::BinarizedTargetMeanValue) {
@@ -420,6 +575,7 @@ void ComputeOnlineCTRs(const TDataset& learnData,
                 targetClassesCount - 1,
                 priors,
                 ctrBorderCount,
+                localExecutor,
                 &dst->Feature[ctrIdx]);
 
         } else if (ctrType == ECtrType::Buckets ||
@@ -434,6 +590,7 @@ void ComputeOnlineCTRs(const TDataset& learnData,
                 priors,
                 ctrBorderCount,
                 ctrType,
+                localExecutor,
                 &dst->Feature[ctrIdx]);
         } else {
             Y_ASSERT(ctrType == ECtrType::Counter);
@@ -444,9 +601,52 @@ void ComputeOnlineCTRs(const TDataset& learnData,
                 counterCTRDenominator,
                 priors,
                 ctrBorderCount,
+                localExecutor,
                 &dst->Feature[ctrIdx]);
         }
+
+        if (TOnlineCtrValues::CanPack(ctrBorderCount)) {
+            for (ui32 border = 0; border < targetBorderCount; ++border) {
+                for (int prior = 0; prior < priors.ysize(); ++prior) {
+                    dst->Feature[ctrIdx][border][prior].Pack(localExecutor);
+                }
+            }
+        }
+    }, 0, dst->Feature.ysize(), NPar::TLocalExecutor::WAIT_COMPLETE);
+}
+
+// Call update(docIdx, elemId) for learn documents. Documents are scattered by ranges of elemId in parallel,
+// then every range is updated in document order, so the result is exactly the same as for a sequential pass.
+template <typename TUpdate>
+static void UpdateFinalCtrs(const ui64* hashArr,
+                            int sampleCount,
+                            size_t leafCount,
+                            NPar::TLocalExecutor* localExecutor,
+                            const TUpdate& update) {
+    const int threadCount = localExecutor != nullptr ? localExecutor->GetThreadCount() + 1 : 1;
+    if (threadCount == 1 || sampleCount < MinParallelDocBlockSize) {
+        for (int z = 0; z < sampleCount; ++z) {
+            update(z, hashArr[z]);
+        }
+        return;
     }
+    const size_t leafRangeSize = (leafCount + threadCount - 1) / threadCount;
+    NPar::TLocalExecutor::TExecRangeParams blockParams(0, sampleCount);
+    blockParams.SetBlockCount(threadCount);
+    TVector<TVector<TVector<ui32>>> docsByBlockByRange(blockParams.GetBlockCount(), TVector<TVector<ui32>>(threadCount));
+    localExecutor->ExecRange([&](int blockIdx) {
+        auto& docsByRange = docsByBlockByRange[blockIdx];
+        NPar::TLocalExecutor::BlockedLoopBody(blockParams, [&](int z) {
+            docsByRange[hashArr[z] / leafRangeSize].push_back(z);
+        })(blockIdx);
+    }, 0, blockParams.GetBlockCount(), NPar::TLocalExecutor::WAIT_COMPLETE);
+    localExecutor->ExecRange([&](int rangeIdx) {
+        for (const auto& docsByRange : docsByBlockByRange) {
+            for (ui32 z : docsByRange[rangeIdx]) {
+                update(z, hashArr[z]);
+            }
+        }
+    }, 0, threadCount, NPar::TLocalExecutor::WAIT_COMPLETE);
 }
 
 void CalcFinalCtrsImpl(
@@ -456,16 +656,21 @@ void CalcFinalCtrsImpl(
     const TVector<float>& permutedTargets,
     const ui64 learnSampleCount,
     int targetClassesCount,
+    NPar::TLocalExecutor* localExecutor,
     TVector<ui64>* hashArr,
     TCtrValueTable* result
 ) {
     TDenseHash<ui64, ui32> tmpHash;
-    ComputeReindexHash(ctrLeafCountLimit, &tmpHash, hashArr->begin(), hashArr->begin() + learnSampleCount);
-    auto leafCount = UpdateReindexHash(&tmpHash, hashArr->begin() + learnSampleCount, hashArr->end());
+    ComputeReindexHash(ctrLeafCountLimit, &tmpHash, hashArr->begin(), hashArr->begin() + learnSampleCount, localExecutor);
+    auto leafCount = UpdateReindexHash(&tmpHash, hashArr->begin() + learnSampleCount, hashArr->end(), localExecutor);
     auto hashIndexBuilder = result->GetIndexHashBuilder(leafCount);
+    // the same bucket layout with and without localExecutor
+    TVector<std::pair<ui64, ui32>> hashIndices;
+    hashIndices.reserve(tmpHash.Size());
     for (const auto& kv : tmpHash) {
-        hashIndexBuilder.SetIndex(kv.Key(), kv.Value());
+        hashIndices.emplace_back(kv.Key(), kv.Value());
     }
+    hashIndexBuilder.SetIndices(hashIndices, localExecutor);
     TArrayRef<int> ctrIntArray;
     TArrayRef<TCtrMeanHistory> ctrMean;
     if (ctrType == ECtrType::BinarizedTargetMeanValue || ctrType == ECtrType::FloatTargetMeanValue) {
@@ -480,9 +685,7 @@ void CalcFinalCtrsImpl(
 
     Y_ASSERT(hashArr->size() == learnSampleCount);
     int targetBorderCount = targetClassesCount - 1;
-    auto hashArrPtr = hashArr->data();
-    for (ui32 z = 0; z < learnSampleCount; ++z) {
-        const ui64 elemId = hashArrPtr[z];
+    UpdateFinalCtrs(hashArr->data(), static_cast<int>(learnSampleCount), leafCount, localExecutor, [&](int z, ui64 elemId) {
         if (ctrType == ECtrType::BinarizedTargetMeanValue) {
             TCtrMeanHistory& elem = ctrMean[elemId];
             elem.Add(static_cast<float>(permutedTargetClass[z]) / targetBorderCount);
@@ -495,7 +698,7 @@ void CalcFinalCtrsImpl(
             TArrayRef<int> elem = MakeArrayRef(ctrIntArray.data() + targetClassesCount * elemId, targetClassesCount);
             ++elem[permutedTargetClass[z]];
         }
-    }
+    });
 
     if (ctrType == ECtrType::Counter) {
         result->CounterDenominator = *MaxElement(ctrIntArray.begin(), ctrIntArray.end());
@@ -515,6 +718,7 @@ void CalcFinalCtrs(const ECtrType ctrType,
                    ui64 ctrLeafCountLimit,
                    bool storeAllSimpleCtr,
                    ECounterCalc counterCalcMethod,
+                   NPar::TLocalExecutor* localExecutor,
                    TCtrValueTable* result) {
     ui64 learnSampleCount = learnData.GetSampleCount();
     ui64 totalSampleCount = learnSampleCount;
@@ -522,13 +726,18 @@ void CalcFinalCtrs(const ECtrType ctrType,
         totalSampleCount += GetSampleCount(testDataPtrs);
     }
     TVector<ui64> hashArr(totalSampleCount);
-    CalcHashes(projection, learnData.AllFeatures, 0, &learnPermutation, true, hashArr.begin(), hashArr.begin() + learnSampleCount);
+    ui64* hashes = hashArr.data();
+    ParallelCalcRanges(learnSampleCount, localExecutor, [&](int rangeStart, int rangeEnd) {
+        CalcHashes(projection, learnData.AllFeatures, rangeStart, &learnPermutation, true, hashes + rangeStart, hashes + rangeEnd);
+    });
     if (totalSampleCount > learnSampleCount) {
-        ui64* testHashBegin = hashArr.begin() + learnSampleCount;
+        ui64* testHashBegin = hashes + learnSampleCount;
         for (size_t testIdx = 0; testIdx < testDataPtrs.size(); ++testIdx) {
-            ui64* testHashEnd = testHashBegin + testDataPtrs[testIdx]->GetSampleCount();
-            CalcHashes(projection, testDataPtrs[testIdx]->AllFeatures, 0, nullptr, true, testHashBegin, testHashEnd);
-            testHashBegin = testHashEnd;
+            const int testSampleCount = testDataPtrs[testIdx]->GetSampleCount();
+            ParallelCalcRanges(testSampleCount, localExecutor, [&](int rangeStart, int rangeEnd) {
+                CalcHashes(projection, testDataPtrs[testIdx]->AllFeatures, rangeStart, nullptr, true, testHashBegin + rangeStart, testHashBegin + rangeEnd);
+            });
+            testHashBegin += testSampleCount;
         }
     }
 
@@ -542,6 +751,7 @@ void CalcFinalCtrs(const ECtrType ctrType,
         TVector<float>(),
         totalSampleCount,
         targetClassesCount,
+        localExecutor,
         &hashArr,
         result);
 }
@@ -581,5 +791,5 @@ void CalcFinalCtrs(const ECtrType ctrType,
     if (projection.IsSingleCatFeature() && storeAllSimpleCtr) {
         ctrLeafCountLimit = Max<ui64>();
     }
-    CalcFinalCtrsImpl(ctrType, ctrLeafCountLimit, permutedTargetClass, permutedTargets, sampleCount, targetClassesCount, &hashArr, result);
+    CalcFinalCtrsImpl(ctrType, ctrLeafCountLimit, permutedTargetClass, permutedTargets, sampleCount, targetClassesCount, nullptr, &hashArr, result);
 }
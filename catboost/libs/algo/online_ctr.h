@@ -5,14 +5,84 @@
 #include "target_classifier.h"
 #include "dataset.h"
 
+#include <catboost/libs/helpers/clear_array.h>
+
+#include <library/threading/local_executor/local_executor.h>
+
 
 struct TFold;
 
 const int SIMPLE_CLASSES_COUNT = 2;
 
+// Binarized ctr values of learn and test documents.
+// Values are calculated one per byte and packed two per byte afterwards if ctr border count allows.
+class TOnlineCtrValues {
+public:
+    static constexpr int MaxPackedValue = 15;
+
+    static bool CanPack(int ctrBorderCount) {
+        return ctrBorderCount <= MaxPackedValue;
+    }
+
+    static size_t GetMemoryUsage(size_t docCount, int ctrBorderCount) {
+        return CanPack(ctrBorderCount) ? (docCount + 1) / 2 : docCount;
+    }
+
+    static ui8 GetPackedValue(const ui8* packedValues, size_t docIdx) {
+        return (packedValues[docIdx / 2] >> (docIdx % 2 * 4)) & MaxPackedValue;
+    }
+
+    // Zero-filled unpacked values to be calculated
+    ui8* Reset(size_t docCount) {
+        Clear(&Values, docCount);
+        DocCount = docCount;
+        IsPackedFlag = false;
+        return Values.data();
+    }
+
+    void Pack(NPar::TLocalExecutor* localExecutor);
+
+    ui8 operator[](size_t docIdx) const {
+        return IsPackedFlag ? GetPackedValue(Values.data(), docIdx) : Values[docIdx];
+    }
+
+    bool IsPacked() const {
+        return IsPackedFlag;
+    }
+
+    ui8* GetData() {
+        return Values.data();
+    }
+
+    const ui8* GetData() const {
+        return Values.data();
+    }
+
+    size_t GetDocCount() const {
+        return DocCount;
+    }
+
+    size_t GetMemoryUsage() const {
+        return Values.capacity();
+    }
+
+private:
+    TVector<ui8> Values;
+    size_t DocCount = 0;
+    bool IsPackedFlag = false;
+};
+
+// Indexing of packed ctr values for hot loops, where the packing is known in advance
+struct TPackedOnlineCtrValuesRef {
+    const ui8* PackedValues;
+
+    ui8 operator[](size_t docIdx) const {
+        return TOnlineCtrValues::GetPackedValue(PackedValues, docIdx);
+    }
+};
 
 struct TOnlineCTR {
-    TVector<TArray2D<TVector<ui8>>> Feature; // Feature[ctrIdx][classIdx][priorIdx][docIdx]
+    TVector<TArray2D<TOnlineCtrValues>> Feature; // Feature[ctrIdx][classIdx][priorIdx][docIdx]
     size_t FeatureValueCount = 0;
 };
 
@@ -28,11 +98,21 @@ void CalcNormalization(const TVector<float>& priors, TVector<float>* shift, TVec
 class TLearnContext;
 class TDataset;
 
+/// Calculate per-document hashes of projection values for online ctr bucket identification:
+/// learn documents in fold permutation order followed by documents of all test datasets.
+void CalcOnlineCtrHashes(const TDataset& learnData,
+                         const TDatasetPtrs& testDataPtrs,
+                         const TFold& fold,
+                         const TProjection& proj,
+                         NPar::TLocalExecutor* localExecutor,
+                         TVector<ui64>* hashArr);
+
 void ComputeOnlineCTRs(const TDataset& learnData,
                        const TDatasetPtrs& testDataPtrs,
                        const TFold& fold,
                        const TProjection& proj,
                        const TLearnContext* ctx,
+                       NPar::TLocalExecutor* localExecutor,
                        TOnlineCTR* dst);
 
 class TCtrValueTable;
@@ -48,6 +128,7 @@ void CalcFinalCtrs(
     ui64 ctrLeafCountLimit,
     bool storeAllSimpleCtr,
     ECounterCalc counterCalcMethod,
+    NPar::TLocalExecutor* localExecutor,
     TCtrValueTable* result);
 
 void CalcFinalCtrs(
@@ -6,6 +6,96 @@
 
 #include <library/threading/local_executor/local_executor.h>
 
+#include <util/memory/blob.h>
+#include <util/system/file.h>
+
+TString TApproxSnapshots::CreateFileName(ui32 snapshotIdx) {
+    if (!NFs::Exists(TmpDir)) {
+        NFs::MakeDirectory(TmpDir);
+        TmpDirCreated = true;
+    }
+    TString name = TStringBuilder() << CreateGuidAsString() << "_approx_" << snapshotIdx << ".tmp";
+    auto path = JoinFsPaths(TmpDir, name);
+    if (NFs::Exists(path)) {
+        MATRIXNET_INFO_LOG << "Path already exists " << path << ". Will overwrite file" << Endl;
+        NFs::Remove(path);
+    }
+    return path;
+}
+
+static void AppendToFile(const TString& fileName, const TVector<double>& data) {
+    TFile file(fileName, EOpenModeFlag::ForAppend | EOpenModeFlag::OpenAlways);
+    file.Write(data.data(), data.size() * sizeof(double));
+}
+
+void TApproxSnapshots::Spill(ui32 snapshotIdx) {
+    TSnapshot& snapshot = Snapshots[snapshotIdx];
+    snapshot.FileName = CreateFileName(snapshotIdx);
+    AppendToFile(snapshot.FileName, snapshot.Data);
+    UsedMemory -= snapshot.Data.size() * sizeof(double);
+    TVector<double>().swap(snapshot.Data);
+}
+
+void TApproxSnapshots::Append(ui32 snapshotIdx, const TVector<TVector<double>>& approx) {
+    if (Snapshots.size() <= snapshotIdx) {
+        Snapshots.resize(snapshotIdx + 1);
+    }
+    TSnapshot& snapshot = Snapshots[snapshotIdx];
+    const ui32 docCount = approx[0].size();
+    const ui64 appendedSize = static_cast<ui64>(docCount) * ApproxDimension;
+    if (snapshot.FileName.empty() && UsedMemory + appendedSize * sizeof(double) > MemoryBudget) {
+        Spill(snapshotIdx);
+    }
+
+    const bool isSpilled = !snapshot.FileName.empty();
+    TVector<double> spilledData;
+    TVector<double>& data = isSpilled ? spilledData : snapshot.Data;
+    const size_t offset = data.size();
+    data.yresize(offset + appendedSize);
+    for (ui32 dim = 0; dim < ApproxDimension; ++dim) {
+        for (ui32 docId = 0; docId < docCount; ++docId) {
+            data[offset + docId * ApproxDimension + dim] = approx[dim][docId];
+        }
+    }
+    if (isSpilled) {
+        AppendToFile(snapshot.FileName, spilledData);
+    } else {
+        UsedMemory += appendedSize * sizeof(double);
+    }
+    snapshot.DocCount += docCount;
+}
+
+void TApproxSnapshots::Load(ui32 snapshotIdx, ui32 docOffset, TVector<TVector<double>>* approx) const {
+    const TSnapshot& snapshot = Snapshots[snapshotIdx];
+    const ui32 docCount = (*approx)[0].size();
+    Y_ASSERT(docOffset + docCount <= snapshot.DocCount);
+
+    TBlob mappedFile;
+    const double* data = snapshot.Data.data();
+    if (!snapshot.FileName.empty()) {
+        mappedFile = TBlob::FromFile(snapshot.FileName);
+        data = reinterpret_cast<const double*>(mappedFile.Data());
+    }
+    data += static_cast<ui64>(docOffset) * ApproxDimension;
+    for (ui32 dim = 0; dim < ApproxDimension; ++dim) {
+        for (ui32 docId = 0; docId < docCount; ++docId) {
+            (*approx)[dim][docId] = data[docId * ApproxDimension + dim];
+        }
+    }
+}
+
+void TApproxSnapshots::Delete(ui32 snapshotIdx) {
+    if (snapshotIdx >= Snapshots.size()) {
+        return;
+    }
+    TSnapshot& snapshot = Snapshots[snapshotIdx];
+    if (!snapshot.FileName.empty()) {
+        NFs::Remove(snapshot.FileName);
+    }
+    UsedMemory -= snapshot.Data.size() * sizeof(double);
+    snapshot = TSnapshot();
+}
+
 TMetricsPlotCalcer::TMetricsPlotCalcer(
     const TFullModel& model,
     const TVector<THolder<IMetric>>& metrics,
@@ -23,6 +113,7 @@ TMetricsPlotCalcer::TMetricsPlotCalcer(
     , TmpDir(tmpDir)
     , ProcessedIterationsCount(0)
     , ProcessedIterationsStep(processIterationStep)
+    , ApproxSnapshots(model.ObliviousTrees.ApproxDimension, tmpDir)
 {
     EnsureCorrectParams();
     for (ui32 iteration = First; iteration < Last; iteration += Step) {
@@ -155,24 +246,13 @@ TMetricsPlotCalcer& TMetricsPlotCalcer::FinishProceedDataSetForNonAdditiveMetric
     ui32 end = Min<ui32>(ProcessedIterationsCount + ProcessedIterationsStep, Iterations.size());
     ComputeNonAdditiveMetrics(begin, end);
     ProcessedIterationsCount = end;
+    LastApproxDocOffset = 0;
     if (AreAllIterationsProcessed()) {
-        DeleteApprox(end - 1);
-    } else {
-        LastApproxes = MakeHolder<TIFStream>(GetApproxFileName(end - 1));
+        ApproxSnapshots.Delete(end - 1);
     }
     return *this;
 }
 
-static void Load(ui32 docCount, IInputStream* input, TVector<TVector<double>>* output) {
-    TVector<double> line;
-    for (ui32 i = 0; i < docCount; ++i) {
-        ::Load(input, line);
-        for (ui32 dim = 0; dim < output->size(); ++dim) {
-            (*output)[dim][i] = line[dim];
-        }
-    }
-}
-
 static void ResizeApproxBuffer(int approxDimension, int docCount, TVector<TVector<double>>* approxMatrix) {
     approxMatrix->resize(approxDimension);
     for (auto& approx : *approxMatrix) {
@@ -210,8 +290,9 @@ TMetricsPlotCalcer& TMetricsPlotCalcer::ProceedDataSet(
     if (beginIterationIndex == 0) {
         begin = 0;
     } else {
-        begin = Iterations[beginIterationIndex];
-        Load(docCount, LastApproxes.Get(), &CurApproxBuffer);
+        begin = Iterations[beginIterationIndex - 1] + 1;
+        ApproxSnapshots.Load(beginIterationIndex - 1, LastApproxDocOffset, &CurApproxBuffer);
+        LastApproxDocOffset += docCount;
     }
 
     for (ui32 iterationIndex = beginIterationIndex; iterationIndex < endIterationIndex; ++iterationIndex) {
@@ -221,7 +302,7 @@ TMetricsPlotCalcer& TMetricsPlotCalcer::ProceedDataSet(
         if (isAdditiveMetrics) {
             ComputeAdditiveMetric(CurApproxBuffer, pool.Docs.Target, pool.Docs.Weight, queriesInfo, iterationIndex);
         } else {
-            SaveApproxToFile(iterationIndex, CurApproxBuffer);
+            ApproxSnapshots.Append(iterationIndex, CurApproxBuffer);
         }
         begin = end;
     }
@@ -231,16 +312,45 @@ TMetricsPlotCalcer& TMetricsPlotCalcer::ProceedDataSet(
     return *this;
 }
 
+ui32 TMetricsPlotCalcer::GetParallelPlotLineCount(ui32 docCount) const {
+    const ui64 approxSize = static_cast<ui64>(docCount) * Model.ObliviousTrees.ApproxDimension * sizeof(double);
+    const ui64 threadCount = Executor.GetThreadCount() + 1;
+    const ui64 fittingCount = approxSize == 0 ? threadCount : ApproxMemoryBudget / approxSize;
+    return Max<ui64>(1, Min(threadCount, fittingCount));
+}
+
+void TMetricsPlotCalcer::EvalNonAdditiveMetrics(
+    const TVector<TVector<TVector<double>>>& approxes,
+    const TVector<float>& target,
+    const TVector<float>& weights,
+    ui32 firstPlotLineIndex
+) {
+    const ui32 metricCount = NonAdditiveMetrics.size();
+    NPar::ParallelFor(Executor, 0, approxes.size() * metricCount, [&](int taskIdx) {
+        const ui32 approxIdx = taskIdx / metricCount;
+        const ui32 metricId = taskIdx % metricCount;
+        NonAdditiveMetricPlots[metricId][firstPlotLineIndex + approxIdx] = NonAdditiveMetrics[metricId]->Eval(approxes[approxIdx], target, weights, {}, 0, target.size(), Executor);
+    });
+}
+
 void TMetricsPlotCalcer::ComputeNonAdditiveMetrics(ui32 begin, ui32 end) {
     const auto& target = NonAdditiveMetricsData.Target;
     const auto& weights = NonAdditiveMetricsData.Weights;
-    for (ui32 idx = begin; idx < end; ++idx) {
-        auto approx = LoadApprox(idx);
-        for (ui32 metricId = 0; metricId < NonAdditiveMetrics.size(); ++metricId) {
-            NonAdditiveMetricPlots[metricId][idx] = NonAdditiveMetrics[metricId]->Eval(approx, target, weights, {}, 0, target.size(), Executor);
-        }
-        if (idx != 0) {
-            DeleteApprox(idx - 1);
+    const ui32 parallelPlotLineCount = GetParallelPlotLineCount(target.size());
+    TVector<TVector<TVector<double>>> approxes;
+    for (ui32 blockBegin = begin; blockBegin < end; blockBegin += parallelPlotLineCount) {
+        const ui32 blockEnd = Min(end, blockBegin + parallelPlotLineCount);
+        approxes.resize(blockEnd - blockBegin);
+        NPar::ParallelFor(Executor, blockBegin, blockEnd, [&](int idx) {
+            auto& approx = approxes[idx - blockBegin];
+            ResizeApproxBuffer(Model.ObliviousTrees.ApproxDimension, target.size(), &approx);
+            ApproxSnapshots.Load(idx, 0, &approx);
+        });
+        EvalNonAdditiveMetrics(approxes, target, weights, blockBegin);
+        for (ui32 idx = blockBegin; idx < blockEnd; ++idx) {
+            if (idx != 0) {
+                ApproxSnapshots.Delete(idx - 1);
+            }
         }
     }
 }
@@ -296,6 +406,8 @@ void TMetricsPlotCalcer::ComputeNonAdditiveMetrics(const TVector<TPool>& dataset
     }
 
     auto startDocIdx = GetStartDocIdx(datasetParts);
+    const ui32 parallelPlotLineCount = GetParallelPlotLineCount(allTargets.size());
+    TVector<TVector<TVector<double>>> approxes;
     for (ui32 iterationIndex = 0; iterationIndex < Iterations.size(); ++iterationIndex) {
         int end = Iterations[iterationIndex] + 1;
         for (int poolPartIdx = 0; poolPartIdx < modelCalcers.ysize(); ++poolPartIdx) {
@@ -304,62 +416,15 @@ void TMetricsPlotCalcer::ComputeNonAdditiveMetrics(const TVector<TPool>& dataset
             Append(NextApproxBuffer, &curApprox, startDocIdx[poolPartIdx]);
         }
 
-        for (ui32 metricId = 0; metricId < NonAdditiveMetrics.size(); ++metricId) {
-            NonAdditiveMetricPlots[metricId][iterationIndex] = NonAdditiveMetrics[metricId]->Eval(curApprox, allTargets, allWeights, {}, 0, allTargets.size(), Executor);
+        approxes.push_back(curApprox);
+        if (approxes.size() == parallelPlotLineCount || iterationIndex + 1 == Iterations.size()) {
+            EvalNonAdditiveMetrics(approxes, allTargets, allWeights, iterationIndex + 1 - approxes.size());
+            approxes.clear();
         }
         begin = end;
     }
 }
 
-TString TMetricsPlotCalcer::GetApproxFileName(ui32 plotLineIndex) {
-    const ui32 plotSize = plotLineIndex + 1;
-    if (NonAdditiveMetricsData.ApproxFiles.size() < plotSize) {
-        NonAdditiveMetricsData.ApproxFiles.resize(plotSize);
-    }
-    if (NonAdditiveMetricsData.ApproxFiles[plotLineIndex].Empty()) {
-        if (!NFs::Exists(TmpDir)) {
-            NFs::MakeDirectory(TmpDir);
-            DeleteTmpDirOnExitFlag = true;
-        }
-        TString name = TStringBuilder() << CreateGuidAsString() << "_approx_" << plotLineIndex << ".tmp";
-        auto path = JoinFsPaths(TmpDir, name);
-        if (NFs::Exists(path)) {
-            MATRIXNET_INFO_LOG << "Path already exists " << path << ". Will overwrite file" << Endl;
-            NFs::Remove(path);
-        }
-        NonAdditiveMetricsData.ApproxFiles[plotLineIndex] = path;
-    }
-    return NonAdditiveMetricsData.ApproxFiles[plotLineIndex];
-}
-
-void TMetricsPlotCalcer::SaveApproxToFile(ui32 plotLineIndex,
-                                          const TVector<TVector<double>>& approx) {
-    auto fileName = GetApproxFileName(plotLineIndex);
-    ui32 docCount = approx[0].size();
-    TFile file(fileName, EOpenModeFlag::ForAppend | EOpenModeFlag::OpenAlways);
-    TOFStream out(file);
-    TVector<double> line(approx.size());
-
-    for (ui32 i = 0; i < docCount; ++i) {
-        for (ui32 dim = 0; dim < approx.size(); ++dim) {
-            line[dim] = approx[dim][i];
-        }
-        ::Save(&out, line);
-    }
-}
-
-TVector<TVector<double>> TMetricsPlotCalcer::LoadApprox(ui32 plotLineIndex) {
-    TIFStream input(GetApproxFileName(plotLineIndex));
-    ui32 docCount = NonAdditiveMetricsData.Target.size();
-    TVector<TVector<double>> result(Model.ObliviousTrees.ApproxDimension, TVector<double>(docCount));
-    Load(docCount, &input, &result);
-    return result;
-}
-
-void TMetricsPlotCalcer::DeleteApprox(ui32 plotLineIndex) {
-    NFs::Remove(GetApproxFileName(plotLineIndex));
-}
-
 TMetricsPlotCalcer CreateMetricCalcer(
     const TFullModel& model,
     int begin,
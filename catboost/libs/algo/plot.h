@@ -12,6 +12,49 @@
 #include <util/generic/guid.h>
 #include <util/system/fs.h>
 
+// Approxes of plot points for non-additive metrics.
+// Snapshots are kept in memory while they fit into the memory budget, the rest are spilled to files in tmpDir.
+class TApproxSnapshots {
+public:
+    TApproxSnapshots(ui32 approxDimension, const TString& tmpDir)
+        : ApproxDimension(approxDimension)
+        , TmpDir(tmpDir)
+    {
+    }
+
+    void SetMemoryBudget(ui64 memoryBudget) {
+        MemoryBudget = memoryBudget;
+    }
+
+    bool IsTmpDirCreated() const {
+        return TmpDirCreated;
+    }
+
+    // Appends approxes of the next docs to the snapshot.
+    void Append(ui32 snapshotIdx, const TVector<TVector<double>>& approx);
+    // Loads approxes of docs [docOffset, docOffset + approx[0].size()) from the snapshot.
+    void Load(ui32 snapshotIdx, ui32 docOffset, TVector<TVector<double>>* approx) const;
+    void Delete(ui32 snapshotIdx);
+
+private:
+    struct TSnapshot {
+        TVector<double> Data; // [docCount][approxDimension], empty if the snapshot is spilled
+        TString FileName; // not empty if the snapshot is spilled
+        ui64 DocCount = 0;
+    };
+
+    TString CreateFileName(ui32 snapshotIdx);
+    void Spill(ui32 snapshotIdx);
+
+private:
+    ui32 ApproxDimension;
+    TString TmpDir;
+    bool TmpDirCreated = false;
+    ui64 MemoryBudget = 1 << 30;
+    ui64 UsedMemory = 0;
+    TVector<TSnapshot> Snapshots;
+};
+
 class TMetricsPlotCalcer {
 public:
     TMetricsPlotCalcer(
@@ -28,6 +71,12 @@ public:
         DeleteTmpDirOnExitFlag = flag;
     }
 
+    // Approxes of plot points for non-additive metrics beyond this budget are spilled to tmpDir.
+    void SetApproxMemoryBudget(ui64 memoryBudget) {
+        ApproxMemoryBudget = memoryBudget;
+        ApproxSnapshots.SetMemoryBudget(memoryBudget);
+    }
+
     bool HasAdditiveMetric() const {
         return !AdditiveMetrics.empty();
     }
@@ -51,7 +100,7 @@ public:
     TVector<TVector<double>> GetMetricsScore();
 
     void ClearTempFiles() {
-        if (DeleteTmpDirOnExitFlag) {
+        if (DeleteTmpDirOnExitFlag || ApproxSnapshots.IsTmpDirCreated()) {
             NFs::RemoveRecursive(TmpDir);
         }
     }
@@ -99,6 +148,17 @@ private:
 
     void ComputeNonAdditiveMetrics(ui32 begin, ui32 end);
 
+    // Plot points [firstPlotLineIndex, firstPlotLineIndex + approxes.size()) are evaluated in parallel.
+    void EvalNonAdditiveMetrics(
+        const TVector<TVector<TVector<double>>>& approxes,
+        const TVector<float>& target,
+        const TVector<float>& weights,
+        ui32 firstPlotLineIndex
+    );
+
+    // The number of plot points which approxes are kept in memory at once for parallel evaluation.
+    ui32 GetParallelPlotLineCount(ui32 docCount) const;
+
     void ComputeAdditiveMetric(
         const TVector<TVector<double>>& approx,
         const TVector<float>& target,
@@ -145,18 +205,10 @@ private:
 private:
 
     struct TNonAdditiveMetricData {
-        TVector<TString> ApproxFiles;
         TVector<float> Target;
         TVector<float> Weights;
     };
 
-    TString GetApproxFileName(ui32 plotLineIndex);
-
-    void SaveApproxToFile(ui32 plotLineIndex, const TVector<TVector<double>>& approx);
-
-    TVector<TVector<double>> LoadApprox(ui32 plotLineIndex);
-    void DeleteApprox(ui32 plotLineIndex);
-
 private:
     const TFullModel& Model;
     NPar::TLocalExecutor& Executor;
@@ -166,6 +218,7 @@ private:
     ui32 Step;
     TString TmpDir;
     bool DeleteTmpDirOnExitFlag = false;
+    ui64 ApproxMemoryBudget = 1 << 30;
 
     TVector<const IMetric*> AdditiveMetrics;
     TVector<const IMetric*> NonAdditiveMetrics;
@@ -177,9 +230,10 @@ private:
 
     ui32 ProcessedIterationsCount;
     ui32 ProcessedIterationsStep;
-    THolder<IInputStream> LastApproxes;
+    ui32 LastApproxDocOffset = 0;
 
     TNonAdditiveMetricData NonAdditiveMetricsData;
+    TApproxSnapshots ApproxSnapshots;
 
     TPool LastGroupPool;
 
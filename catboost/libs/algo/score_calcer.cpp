@@ -21,7 +21,7 @@ int GetSplitCount(const TVector<int>& splitsCount,
     }
 }
 
-template<typename TFullIndexType, typename TIsCaching>
+template<typename TFullIndexType, typename TIsCaching, typename TStats, typename TPartialStats>
 static TVector<TScoreBin> CalcScoreImpl(const TIsCaching& isCaching,
         const TVector<TFullIndexType>& singleIdx,
         const TCalcScoreFold& fold,
@@ -34,7 +34,8 @@ static TVector<TScoreBin> CalcScoreImpl(const TIsCaching& isCaching,
         const TStatsIndexer& indexer,
         int depth,
         int splitStatsCount,
-        TBucketStats* splitStats) {
+        TPartialStats* partialStats,
+        TStats* splitStats) {
     Y_ASSERT(!isCaching || depth > 0);
     const int approxDimension = fold.GetApproxDimension();
     const int leafCount = 1 << depth;
@@ -58,8 +59,8 @@ static TVector<TScoreBin> CalcScoreImpl(const TIsCaching& isCaching,
                     &scoreBins
                 );
             } else {
-                TBucketStats* stats = splitStats + (bodyTailIdx * approxDimension + dim) * splitStatsCount;
-                CalcStatsKernel(isCaching, singleIdx, fold, isPlainMode, indexer, depth, bt, dim, stats);
+                TStats* stats = splitStats + (bodyTailIdx * approxDimension + dim) * splitStatsCount;
+                CalcStatsKernel(isCaching, singleIdx, fold, isPlainMode, indexer, depth, bt, dim, partialStats, stats);
                 if (isPlainMode) {
                     UpdateScoreBin(stats, leafCount, indexer, splitType, l2Regularizer, /*isPlainMode=*/std::true_type(), sumAllWeights, docCount, &scoreBins);
                 } else {
@@ -80,50 +81,59 @@ TVector<TScoreBin> CalcScore(const TAllFeatures& af,
                           const NCatboostOptions::TCatBoostOptions& fitParams,
                           const TSplitCandidate& split,
                           int depth,
-                          TBucketStatsCache* statsFromPrevTree) {
+                          TBucketStatsCache* statsFromPrevTree,
+                          TScratchArena* scratch) {
     const int bucketCount = GetSplitCount(splitsCount, af.OneHotValues, split) + 1;
     const TStatsIndexer indexer(bucketCount);
     const int bucketIndexBits = GetValueBitCount(bucketCount) + depth + 1;
     const bool isPairwiseScoring = IsPairwiseScoring(fitParams.LossFunctionDescription->GetLossFunction());
+    const bool isPlainMode = IsPlainMode(fitParams.BoostingOptions->BoostingType);
 
-    decltype(auto) SelectCalcScoreImpl = [&] (auto isCaching, const TCalcScoreFold& fold, int splitStatsCount, auto* splitStats) {
-        const bool isPlainMode = IsPlainMode(fitParams.BoostingOptions->BoostingType);
+    decltype(auto) SelectCalcScoreImpl = [&] (auto isCaching, const TCalcScoreFold& fold, int splitStatsCount, auto* partialStats, auto* splitStats) {
         const float l2Regularizer = static_cast<const float>(fitParams.ObliviousTreeOptions->L2Reg);
         const float pairwiseBucketWeightPriorReg = static_cast<const float>(fitParams.ObliviousTreeOptions->PairwiseNonDiagReg);
         if (bucketIndexBits <= 8) {
-            TVector<ui8> singleIdx;
-            BuildSingleIndex(fold, af, allCtrs, split, indexer, &singleIdx);
-            return CalcScoreImpl(isCaching, singleIdx, fold, initialFold, isPlainMode, isPairwiseScoring, l2Regularizer, pairwiseBucketWeightPriorReg, split.Type, indexer, depth, splitStatsCount, GetDataPtr(*splitStats));
+            TScratchVector<ui8> singleIdx(scratch);
+            BuildSingleIndex(fold, af, allCtrs, split, indexer, singleIdx.Get());
+            return CalcScoreImpl(isCaching, *singleIdx, fold, initialFold, isPlainMode, isPairwiseScoring, l2Regularizer, pairwiseBucketWeightPriorReg, split.Type, indexer, depth, splitStatsCount, partialStats, splitStats);
         } else if (bucketIndexBits <= 16) {
-            TVector<ui16> singleIdx;
-            BuildSingleIndex(fold, af, allCtrs, split, indexer, &singleIdx);
-            return CalcScoreImpl(isCaching, singleIdx, fold, initialFold, isPlainMode, isPairwiseScoring, l2Regularizer, pairwiseBucketWeightPriorReg, split.Type, indexer, depth, splitStatsCount, GetDataPtr(*splitStats));
+            TScratchVector<ui16> singleIdx(scratch);
+            BuildSingleIndex(fold, af, allCtrs, split, indexer, singleIdx.Get());
+            return CalcScoreImpl(isCaching, *singleIdx, fold, initialFold, isPlainMode, isPairwiseScoring, l2Regularizer, pairwiseBucketWeightPriorReg, split.Type, indexer, depth, splitStatsCount, partialStats, splitStats);
         } else if (bucketIndexBits <= 32) {
-            TVector<ui32> singleIdx;
-            BuildSingleIndex(fold, af, allCtrs, split, indexer, &singleIdx);
-            return CalcScoreImpl(isCaching, singleIdx, fold, initialFold, isPlainMode, isPairwiseScoring, l2Regularizer, pairwiseBucketWeightPriorReg, split.Type, indexer, depth, splitStatsCount, GetDataPtr(*splitStats));
+            TScratchVector<ui32> singleIdx(scratch);
+            BuildSingleIndex(fold, af, allCtrs, split, indexer, singleIdx.Get());
+            return CalcScoreImpl(isCaching, *singleIdx, fold, initialFold, isPlainMode, isPairwiseScoring, l2Regularizer, pairwiseBucketWeightPriorReg, split.Type, indexer, depth, splitStatsCount, partialStats, splitStats);
         }
         CB_ENSURE(false, "too deep or too much splitsCount for score calculation");
     };
     const auto& treeOptions = fitParams.ObliviousTreeOptions.Get();
 
-    // Pairwise scoring doesn't use statistics from previous tree level
-    if (!IsSamplingPerTree(treeOptions) || isPairwiseScoring) {
-        TVector<TBucketStats> scratchSplitStats;
-        const int splitStatsCount = indexer.CalcSize(depth);
-        const int statsCount = splitStatsCount;
-        scratchSplitStats.yresize(statsCount);
-        return SelectCalcScoreImpl(/*isCaching*/ std::false_type(), fold, /*splitStatsCount*/ 0, &scratchSplitStats);
-    } else {
-        const int splitStatsCount = indexer.CalcSize(treeOptions.MaxDepth);
-        const int statsCount = fold.GetBodyTailCount() * fold.GetApproxDimension() * splitStatsCount;
-        bool areStatsDirty;
-        TVector<TBucketStats, TPoolAllocator>& splitStats = statsFromPrevTree->GetStats(split, statsCount, &areStatsDirty); // thread-safe access
-        if (depth == 0 || areStatsDirty) {
-            return SelectCalcScoreImpl(/*isCaching*/ std::false_type(), fold, splitStatsCount, &splitStats);
+    return SelectBucketStatsType(isPlainMode, treeOptions.ScoreStatsPrecision.Get(), [&] (auto statsType, auto partialStatsType) {
+        using TStats = decltype(statsType);
+        using TPartialStats = decltype(partialStatsType);
+        TScratchVector<TPartialStats> scratchPartialStats(scratch);
+        if (!std::is_same<TStats, TPartialStats>::value) {
+            scratchPartialStats->yresize(indexer.CalcSize(depth));
+        }
+        TPartialStats* partialStats = GetDataPtr(*scratchPartialStats);
+        // Pairwise scoring doesn't use statistics from previous tree level
+        if (!IsSamplingPerTree(treeOptions) || isPairwiseScoring) {
+            TScratchVector<TStats> scratchSplitStats(scratch);
+            const int splitStatsCount = indexer.CalcSize(depth);
+            const int statsCount = splitStatsCount;
+            scratchSplitStats->yresize(statsCount);
+            return SelectCalcScoreImpl(/*isCaching*/ std::false_type(), fold, /*splitStatsCount*/ 0, partialStats, GetDataPtr(*scratchSplitStats));
         } else {
-            return SelectCalcScoreImpl(/*isCaching*/ std::true_type(), prevLevelData, splitStatsCount, &splitStats);
+            const int splitStatsCount = indexer.CalcSize(treeOptions.MaxDepth);
+            const int statsCount = fold.GetBodyTailCount() * fold.GetApproxDimension() * splitStatsCount;
+            bool areStatsDirty;
+            TStats* splitStats = statsFromPrevTree->GetStats<TStats>(split, statsCount, &areStatsDirty); // thread-safe access
+            if (depth == 0 || areStatsDirty) {
+                return SelectCalcScoreImpl(/*isCaching*/ std::false_type(), fold, splitStatsCount, partialStats, splitStats);
+            } else {
+                return SelectCalcScoreImpl(/*isCaching*/ std::true_type(), prevLevelData, splitStatsCount, partialStats, splitStats);
+            }
         }
-    }
-    CB_ENSURE(false, "too deep or too much splitsCount for score calculation");
+    });
 }
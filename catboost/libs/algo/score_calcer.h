@@ -7,6 +7,7 @@
 #include "split.h"
 #include "error_functions.h"
 #include "calc_score_cache.h"
+#include "scratch_arena.h"
 
 #include <library/threading/local_executor/local_executor.h>
 
@@ -40,17 +41,23 @@ struct TScoreBin {
 };
 
 // Helper function that calculates deterministic scores given bins with statistics for each split.
-inline TVector<double> GetScores(const TVector<TScoreBin>& scoreBin) {
+inline void GetScores(const TVector<TScoreBin>& scoreBin, TVector<double>* scores) {
     const int splitCount = scoreBin.ysize() - 1;
-    TVector<double> scores(splitCount);
+    scores->yresize(splitCount);
     for (int splitIdx = 0; splitIdx < splitCount; ++splitIdx) {
-        scores[splitIdx] = scoreBin[splitIdx].GetScore();
+        (*scores)[splitIdx] = scoreBin[splitIdx].GetScore();
     }
+}
+
+inline TVector<double> GetScores(const TVector<TScoreBin>& scoreBin) {
+    TVector<double> scores;
+    GetScores(scoreBin, &scores);
     return scores;
 }
 
 // Function that calculates score statistics for each split of a split candidate (candidate is a feature == all splits of this feature).
 // This function does all the work - it calculates sums in buckets, gets real sums for splits and builds TScoreBin-s from that.
+// Scratch buffers are taken from scratch arena if it is given.
 TVector<TScoreBin> CalcScore(
     const TAllFeatures& af,
     const TVector<int>& splitsCount,
@@ -62,7 +69,8 @@ TVector<TScoreBin> CalcScore(
     const NCatboostOptions::TCatBoostOptions& fitParams,
     const TSplitCandidate& split,
     int depth,
-    TBucketStatsCache* statsFromPrevTree);
+    TBucketStatsCache* statsFromPrevTree,
+    TScratchArena* scratch = nullptr);
 
 // Statistics (sums for score calculation) are stored in an array. This class helps navigating in this array.
 struct TStatsIndexer {
@@ -87,10 +95,10 @@ inline const TOnlineCTR& GetCtr(const std::tuple<const TOnlineCTRHash&, const TO
 
 // Helper function for calculating index of leaf for each document given a new split.
 // Calculates indices when a permutation is given.
-template<typename TBucketIndexType, typename TFullIndexType>
+template<typename TBucketIndex, typename TFullIndexType>
 inline void SetSingleIndex(const TCalcScoreFold& fold,
                            const TStatsIndexer& indexer,
-                           const TVector<TBucketIndexType>& bucketIndex,
+                           const TBucketIndex& bucketIndex,
                            const size_t* docPermutation,
                            TVector<TFullIndexType>* singleIdx) {
     const size_t docCount = fold.GetDocCount();
@@ -135,7 +143,12 @@ inline void BuildSingleIndex(const TCalcScoreFold& fold,
     if (split.Type == ESplitType::OnlineCtr) {
         const TCtr& ctr = split.Ctr;
         const size_t* docSubset = GetDataPtr(fold.IndexInFold);
-        SetSingleIndex(fold, indexer, GetCtr(allCtrs, ctr.Projection).Feature[ctr.CtrIdx][ctr.TargetBorderIdx][ctr.PriorIdx], docSubset, singleIdx);
+        const TOnlineCtrValues& ctrValues = GetCtr(allCtrs, ctr.Projection).Feature[ctr.CtrIdx][ctr.TargetBorderIdx][ctr.PriorIdx];
+        if (ctrValues.IsPacked()) {
+            SetSingleIndex(fold, indexer, TPackedOnlineCtrValuesRef{ctrValues.GetData()}, docSubset, singleIdx);
+        } else {
+            SetSingleIndex(fold, indexer, ctrValues.GetData(), docSubset, singleIdx);
+        }
     } else if (split.Type == ESplitType::FloatFeature) {
         const size_t* learnPermutation = GetDataPtr(fold.LearnPermutation);
         SetSingleIndex(fold, indexer, af.FloatHistograms[split.FeatureIdx], learnPermutation, singleIdx);
@@ -147,27 +160,27 @@ inline void BuildSingleIndex(const TCalcScoreFold& fold,
 }
 
 // Update bootstraped sums on [docBegin, docEnd) in a bucket
-template<typename TFullIndexType>
-inline void UpdateWeighted(const TVector<TFullIndexType>& singleIdx, const double* weightedDer, const float* sampleWeights, int docBegin, int docEnd, TBucketStats* stats) {
+template<typename TFullIndexType, typename TStats>
+inline void UpdateWeighted(const TVector<TFullIndexType>& singleIdx, const double* weightedDer, const float* sampleWeights, int docBegin, int docEnd, TStats* stats) {
     for (int doc = docBegin; doc < docEnd; ++doc) {
-        TBucketStats& leafStats = stats[singleIdx[doc]];
+        TStats& leafStats = stats[singleIdx[doc]];
         leafStats.SumWeightedDelta += weightedDer[doc];
         leafStats.SumWeight += sampleWeights[doc];
     }
 }
 
 // Update not bootstraped sums on [docBegin, docEnd) in a bucket
-template<typename TFullIndexType>
-inline void UpdateDeltaCount(const TVector<TFullIndexType>& singleIdx, const double* derivatives, const float* learnWeights, int docCount, TBucketStats* stats) {
+template<typename TFullIndexType, typename TValue>
+inline void UpdateDeltaCount(const TVector<TFullIndexType>& singleIdx, const double* derivatives, const float* learnWeights, int docBegin, int docEnd, TBasicBucketStats<TValue>* stats) {
     if (learnWeights == nullptr) {
-        for (int doc = 0; doc < docCount; ++doc) {
-            TBucketStats& leafStats = stats[singleIdx[doc]];
+        for (int doc = docBegin; doc < docEnd; ++doc) {
+            TBasicBucketStats<TValue>& leafStats = stats[singleIdx[doc]];
             leafStats.SumDelta += derivatives[doc];
             leafStats.Count += 1;
         }
     } else {
-        for (int doc = 0; doc < docCount; ++doc) {
-            TBucketStats& leafStats = stats[singleIdx[doc]];
+        for (int doc = docBegin; doc < docEnd; ++doc) {
+            TBasicBucketStats<TValue>& leafStats = stats[singleIdx[doc]];
             leafStats.SumDelta += derivatives[doc];
             leafStats.Count += learnWeights[doc];
         }
@@ -175,19 +188,36 @@ inline void UpdateDeltaCount(const TVector<TFullIndexType>& singleIdx, const dou
 }
 
 // Calculate score numerator summand
-inline double CountDp(double avrg, const TBucketStats& leafStats) {
+template<typename TStats>
+inline double CountDp(double avrg, const TStats& leafStats) {
     return avrg * leafStats.SumWeightedDelta;
 }
 
 // Calculate score denominator summand
-inline double CountD2(double avrg, const TBucketStats& leafStats) {
+template<typename TStats>
+inline double CountD2(double avrg, const TStats& leafStats) {
     return avrg * avrg * leafStats.SumWeight;
 }
 
-// This function calculates resulting sums for each split given statistics that are calculated for each bucket of the histogram.
+// Calculate leaf value of a split side, plain mode uses bootstraped sums
+template<typename TIsPlainMode>
+inline double CalcSplitAverage(const TBucketStats& stats, TIsPlainMode isPlainMode, float l2Regularizer, double sumAllWeights, int allDocCount) {
+    if (isPlainMode) {
+        return CalcAverage(stats.SumWeightedDelta, stats.SumWeight, l2Regularizer, sumAllWeights, allDocCount);
+    }
+    return CalcAverage(stats.SumDelta, stats.Count, l2Regularizer, sumAllWeights, allDocCount);
+}
+
 template<typename TIsPlainMode>
+inline double CalcSplitAverage(const TPlainBucketStats<double>& stats, TIsPlainMode isPlainMode, float l2Regularizer, double sumAllWeights, int allDocCount) {
+    Y_ASSERT(isPlainMode);
+    return CalcAverage(stats.SumWeightedDelta, stats.SumWeight, l2Regularizer, sumAllWeights, allDocCount);
+}
+
+// This function calculates resulting sums for each split given statistics that are calculated for each bucket of the histogram.
+template<typename TStats, typename TIsPlainMode>
 inline void UpdateScoreBin(
-    const TBucketStats* stats,
+    const TStats* stats,
     int leafCount,
     const TStatsIndexer& indexer,
     ESplitType splitType,
@@ -197,27 +227,22 @@ inline void UpdateScoreBin(
     int allDocCount,
     TVector<TScoreBin>* scoreBin) {
 
+    using TSumStats = typename TStats::TSum;
     for (int leaf = 0; leaf < leafCount; ++leaf) {
-        TBucketStats allStats{0, 0, 0, 0};
+        TSumStats allStats{};
         for (int bucket = 0; bucket < indexer.BucketCount; ++bucket) {
-            const TBucketStats& leafStats = stats[indexer.GetIndex(leaf, bucket)];
+            const TStats& leafStats = stats[indexer.GetIndex(leaf, bucket)];
             allStats.Add(leafStats);
         }
-        TBucketStats trueStats{0, 0, 0, 0};
-        TBucketStats falseStats{0, 0, 0, 0};
+        TSumStats trueStats{};
+        TSumStats falseStats{};
         if (splitType == ESplitType::OnlineCtr || splitType == ESplitType::FloatFeature) {
             trueStats = allStats;
             for (int splitIdx = 0; splitIdx < indexer.BucketCount - 1; ++splitIdx) {
                 falseStats.Add(stats[indexer.GetIndex(leaf, splitIdx)]);
                 trueStats.Remove(stats[indexer.GetIndex(leaf, splitIdx)]);
-                double trueAvrg, falseAvrg;
-                if (isPlainMode) {
-                    trueAvrg = CalcAverage(trueStats.SumWeightedDelta, trueStats.SumWeight, l2Regularizer, sumAllWeights, allDocCount);
-                    falseAvrg = CalcAverage(falseStats.SumWeightedDelta, falseStats.SumWeight, l2Regularizer, sumAllWeights, allDocCount);
-                } else {
-                    trueAvrg = CalcAverage(trueStats.SumDelta, trueStats.Count, l2Regularizer, sumAllWeights, allDocCount);
-                    falseAvrg = CalcAverage(falseStats.SumDelta, falseStats.Count, l2Regularizer, sumAllWeights, allDocCount);
-                }
+                const double trueAvrg = CalcSplitAverage(trueStats, isPlainMode, l2Regularizer, sumAllWeights, allDocCount);
+                const double falseAvrg = CalcSplitAverage(falseStats, isPlainMode, l2Regularizer, sumAllWeights, allDocCount);
                 (*scoreBin)[splitIdx].DP += CountDp(trueAvrg, trueStats) + CountDp(falseAvrg, falseStats);
                 (*scoreBin)[splitIdx].D2 += CountD2(trueAvrg, trueStats) + CountD2(falseAvrg, falseStats);
             }
@@ -229,15 +254,10 @@ inline void UpdateScoreBin(
                     falseStats.Add(stats[indexer.GetIndex(leaf, splitIdx - 1)]);
                 }
                 falseStats.Remove(stats[indexer.GetIndex(leaf, splitIdx)]);
-                trueStats = stats[indexer.GetIndex(leaf, splitIdx)];
-                double trueAvrg, falseAvrg;
-                if (isPlainMode) {
-                    trueAvrg = CalcAverage(trueStats.SumWeightedDelta, trueStats.SumWeight, l2Regularizer, sumAllWeights, allDocCount);
-                    falseAvrg = CalcAverage(falseStats.SumWeightedDelta, falseStats.SumWeight, l2Regularizer, sumAllWeights, allDocCount);
-                } else {
-                    trueAvrg = CalcAverage(trueStats.SumDelta, trueStats.Count, l2Regularizer, sumAllWeights, allDocCount);
-                    falseAvrg = CalcAverage(falseStats.SumDelta, falseStats.Count, l2Regularizer, sumAllWeights, allDocCount);
-                }
+                trueStats = TSumStats{};
+                trueStats.Add(stats[indexer.GetIndex(leaf, splitIdx)]);
+                const double trueAvrg = CalcSplitAverage(trueStats, isPlainMode, l2Regularizer, sumAllWeights, allDocCount);
+                const double falseAvrg = CalcSplitAverage(falseStats, isPlainMode, l2Regularizer, sumAllWeights, allDocCount);
                 (*scoreBin)[splitIdx].DP += CountDp(trueAvrg, trueStats) + CountDp(falseAvrg, falseStats);
                 (*scoreBin)[splitIdx].D2 += CountD2(trueAvrg, trueStats) + CountD2(falseAvrg, falseStats);
             }
@@ -250,7 +270,8 @@ int GetSplitCount(const TVector<int>& splitsCount,
                   const TVector<TVector<int>>& oneHotValues,
                   const TSplitCandidate& split);
 
-inline void FixUpStats(int depth, const TStatsIndexer& indexer, bool selectedSplitValue, TBucketStats* stats) {
+template<typename TStats>
+inline void FixUpStats(int depth, const TStatsIndexer& indexer, bool selectedSplitValue, TStats* stats) {
     const int halfOfStats = indexer.CalcSize(depth - 1);
     if (selectedSplitValue == true) {
         for (int statIdx = 0; statIdx < halfOfStats; ++statIdx) {
@@ -264,7 +285,85 @@ inline void FixUpStats(int depth, const TStatsIndexer& indexer, bool selectedSpl
     }
 }
 
-template<typename TFullIndexType, typename TIsCaching>
+// Update sums of documents in [docBegin, docEnd)
+template<typename TFullIndexType, typename TValue>
+inline void UpdateStats(const TVector<TFullIndexType>& singleIdx,
+                        const TCalcScoreFold& fold,
+                        bool isPlainMode,
+                        const TCalcScoreFold::TBodyTail& bt,
+                        int dim,
+                        int docBegin,
+                        int docEnd,
+                        TBasicBucketStats<TValue>* stats) {
+    const bool hasPairwiseWeights = !bt.PairwiseWeights.empty();
+    const float* weightsData = hasPairwiseWeights ? GetDataPtr(bt.PairwiseWeights) : GetDataPtr(fold.LearnWeights);
+    const float* sampleWeightsData = hasPairwiseWeights ? GetDataPtr(bt.SamplePairwiseWeights) : GetDataPtr(fold.SampleWeights);
+    if (isPlainMode) {
+        UpdateWeighted(singleIdx, GetDataPtr(bt.SampleWeightedDerivatives[dim]), sampleWeightsData, docBegin, docEnd, stats);
+    } else {
+        const int bodyFinish = bt.BodyFinish;
+        UpdateDeltaCount(singleIdx, GetDataPtr(bt.WeightedDerivatives[dim]), weightsData, docBegin, Min(docEnd, bodyFinish), stats);
+        UpdateWeighted(singleIdx, GetDataPtr(bt.SampleWeightedDerivatives[dim]), sampleWeightsData, Max(docBegin, bodyFinish), docEnd, stats);
+    }
+}
+
+template<typename TFullIndexType, typename TValue>
+inline void UpdateStats(const TVector<TFullIndexType>& singleIdx,
+                        const TCalcScoreFold& fold,
+                        bool isPlainMode,
+                        const TCalcScoreFold::TBodyTail& bt,
+                        int dim,
+                        int docBegin,
+                        int docEnd,
+                        TPlainBucketStats<TValue>* stats) {
+    Y_ASSERT(isPlainMode);
+    const float* sampleWeightsData = !bt.PairwiseWeights.empty() ? GetDataPtr(bt.SamplePairwiseWeights) : GetDataPtr(fold.SampleWeights);
+    UpdateWeighted(singleIdx, GetDataPtr(bt.SampleWeightedDerivatives[dim]), sampleWeightsData, docBegin, docEnd, stats);
+}
+
+// Documents per block of float partial sums in mixed precision, bounds the float rounding error of a bucket
+constexpr int MixedPrecisionDocBlockSize = 1 << 14;
+
+// Update sums of all documents of the body tail in buckets [statsBegin, statsEnd), partial sums are not used
+template<typename TFullIndexType, typename TStats>
+inline void AccumulateStats(const TVector<TFullIndexType>& singleIdx,
+                            const TCalcScoreFold& fold,
+                            bool isPlainMode,
+                            const TCalcScoreFold::TBodyTail& bt,
+                            int dim,
+                            int /*statsBegin*/,
+                            int /*statsEnd*/,
+                            TStats* /*partialStats*/,
+                            TStats* stats) {
+    UpdateStats(singleIdx, fold, isPlainMode, bt, dim, 0, bt.TailFinish, stats);
+}
+
+// Mixed precision: sums over a block of documents are accumulated in partialStats of a smaller type
+// and then added to stats, so rounding errors don't grow with the document count
+template<typename TFullIndexType, typename TStats, typename TPartialStats>
+inline void AccumulateStats(const TVector<TFullIndexType>& singleIdx,
+                            const TCalcScoreFold& fold,
+                            bool isPlainMode,
+                            const TCalcScoreFold::TBodyTail& bt,
+                            int dim,
+                            int statsBegin,
+                            int statsEnd,
+                            TPartialStats* partialStats,
+                            TStats* stats) {
+    // flushing costs a pass over the buckets, so a block has at least as many documents as buckets
+    const int blockSize = Max(MixedPrecisionDocBlockSize, statsEnd - statsBegin);
+    const int tailFinish = bt.TailFinish;
+    for (int blockBegin = 0; blockBegin < tailFinish; blockBegin += blockSize) {
+        Fill(partialStats + statsBegin, partialStats + statsEnd, TPartialStats{});
+        UpdateStats(singleIdx, fold, isPlainMode, bt, dim, blockBegin, Min(blockBegin + blockSize, tailFinish), partialStats);
+        for (int statIdx = statsBegin; statIdx < statsEnd; ++statIdx) {
+            stats[statIdx].Add(partialStats[statIdx]);
+        }
+    }
+}
+
+// partialStats has indexer.CalcSize(depth) elements if its type differs from TStats, otherwise it is not used
+template<typename TFullIndexType, typename TIsCaching, typename TStats, typename TPartialStats>
 inline void CalcStatsKernel(const TIsCaching& isCaching,
                             const TVector<TFullIndexType>& singleIdx,
                             const TCalcScoreFold& fold,
@@ -273,23 +372,14 @@ inline void CalcStatsKernel(const TIsCaching& isCaching,
                             int depth,
                             const TCalcScoreFold::TBodyTail& bt,
                             int dim,
-                            TBucketStats* stats) {
+                            TPartialStats* partialStats,
+                            TStats* stats) {
     Y_ASSERT(!isCaching || depth > 0);
-    if (isCaching) {
-        Fill(stats + indexer.CalcSize(depth - 1), stats + indexer.CalcSize(depth), TBucketStats{0, 0, 0, 0});
-    } else {
-        Fill(stats, stats + indexer.CalcSize(depth), TBucketStats{0, 0, 0, 0});
-    }
+    const int statsBegin = isCaching ? indexer.CalcSize(depth - 1) : 0;
+    const int statsEnd = indexer.CalcSize(depth);
+    Fill(stats + statsBegin, stats + statsEnd, TStats{});
 
-    const bool hasPairwiseWeights = !bt.PairwiseWeights.empty();
-    const float* weightsData = hasPairwiseWeights ? GetDataPtr(bt.PairwiseWeights) : GetDataPtr(fold.LearnWeights);
-    const float* sampleWeightsData = hasPairwiseWeights ? GetDataPtr(bt.SamplePairwiseWeights) : GetDataPtr(fold.SampleWeights);
-    if (isPlainMode) {
-        UpdateWeighted(singleIdx, GetDataPtr(bt.SampleWeightedDerivatives[dim]), sampleWeightsData, 0, bt.TailFinish, stats);
-    } else {
-        UpdateDeltaCount(singleIdx, GetDataPtr(bt.WeightedDerivatives[dim]), weightsData, bt.BodyFinish, stats);
-        UpdateWeighted(singleIdx, GetDataPtr(bt.SampleWeightedDerivatives[dim]), sampleWeightsData, bt.BodyFinish, bt.TailFinish, stats);
-    }
+    AccumulateStats(singleIdx, fold, isPlainMode, bt, dim, statsBegin, statsEnd, partialStats, stats);
     if (isCaching) {
         FixUpStats(depth, indexer, fold.SmallestSplitSideValue, stats);
     }
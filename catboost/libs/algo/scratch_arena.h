@@ -0,0 +1,177 @@
+#pragma once
+
+#include <library/threading/local_executor/local_executor.h>
+
+#include <util/generic/hash.h>
+#include <util/generic/noncopyable.h>
+#include <util/generic/ptr.h>
+#include <util/generic/vector.h>
+#include <util/system/guard.h>
+#include <util/system/spinlock.h>
+#include <util/system/thread.h>
+
+#include <typeindex>
+
+// Scratch buffers of one thread, taken vectors keep their capacity when they are returned,
+// so hot training paths don't allocate after the first iterations.
+class TScratchArena : public TNonCopyable {
+public:
+    // Drop buffers which were not needed since the previous reset and return the number of buffer allocations since it.
+    // All vectors must be returned to the arena.
+    ui64 Reset() {
+        for (auto& typeAndFreeList : FreeLists) {
+            typeAndFreeList.second->Trim();
+        }
+        const ui64 allocationCount = AllocationCount;
+        AllocationCount = 0;
+        return allocationCount;
+    }
+
+private:
+    template <typename T>
+    friend class TScratchVector;
+
+    struct IFreeList {
+        virtual ~IFreeList() = default;
+        virtual void Trim() = 0;
+    };
+
+    template <typename T>
+    struct TFreeList : public IFreeList {
+        TVector<THolder<TVector<T>>> Vectors;
+        size_t TakenCount = 0;
+        size_t PeakTakenCount = 0;
+
+        TVector<T>* Take() {
+            ++TakenCount;
+            PeakTakenCount = Max(PeakTakenCount, TakenCount);
+            if (Vectors.empty()) {
+                return new TVector<T>();
+            }
+            TVector<T>* vector = Vectors.back().Release();
+            Vectors.pop_back();
+            return vector;
+        }
+
+        void Return(TVector<T>* vector) {
+            Y_ASSERT(TakenCount > 0);
+            --TakenCount;
+            Vectors.emplace_back(vector);
+        }
+
+        void Trim() override {
+            Y_ASSERT(TakenCount == 0);
+            if (Vectors.size() > PeakTakenCount) {
+                Vectors.resize(PeakTakenCount);
+            }
+            PeakTakenCount = 0;
+        }
+    };
+
+    template <typename T>
+    TFreeList<T>& GetFreeList() {
+        auto& freeList = FreeLists[std::type_index(typeid(T))];
+        if (!freeList) {
+            freeList.Reset(new TFreeList<T>());
+        }
+        return static_cast<TFreeList<T>&>(*freeList);
+    }
+
+private:
+    THashMap<std::type_index, THolder<IFreeList>, std::hash<std::type_index>> FreeLists;
+    ui64 AllocationCount = 0;
+};
+
+// Vector taken from a scratch arena for the lifetime of the holder, contents are not preserved between holders.
+// Without arena the holder owns an ordinary vector.
+template <typename T>
+class TScratchVector : public TNonCopyable {
+public:
+    explicit TScratchVector(TScratchArena* arena)
+        : Arena(arena)
+    {
+        if (Arena != nullptr) {
+            Vector = Arena->GetFreeList<T>().Take();
+            Capacity = Vector->capacity();
+        } else {
+            Vector = &OwnVector;
+        }
+    }
+
+    ~TScratchVector() {
+        if (Arena != nullptr) {
+            if (Vector->capacity() > Capacity) {
+                ++Arena->AllocationCount;
+            }
+            Arena->GetFreeList<T>().Return(Vector);
+        }
+    }
+
+    TVector<T>& operator*() {
+        return *Vector;
+    }
+
+    TVector<T>* operator->() {
+        return Vector;
+    }
+
+    TVector<T>* Get() {
+        return Vector;
+    }
+
+private:
+    TScratchArena* Arena;
+    TVector<T>* Vector;
+    size_t Capacity = 0;
+    TVector<T> OwnVector;
+};
+
+// Scratch arenas of the threads of a local executor.
+// Worker threads use their own arenas, the first arena belongs to the thread which created TScratchArenas.
+// Other threads (e.g. ones which call the executor on their own or don't use it) get arenas by thread id.
+class TScratchArenas : public TNonCopyable {
+public:
+    explicit TScratchArenas(const NPar::TLocalExecutor& localExecutor)
+        : LocalExecutor(localExecutor)
+        , OwnerThreadId(TThread::CurrentThreadId())
+        , Arenas(localExecutor.GetThreadCount() + 1)
+    {
+    }
+
+    TScratchArena* GetThreadArena() {
+        // GetWorkerThreadId is zero for all threads which are not workers of the executor
+        const int arenaIdx = LocalExecutor.GetWorkerThreadId();
+        Y_ASSERT(arenaIdx >= 0 && arenaIdx < Arenas.ysize());
+        if (arenaIdx > 0 || TThread::CurrentThreadId() == OwnerThreadId) {
+            return &Arenas[arenaIdx];
+        }
+        with_lock(ForeignArenasLock) {
+            auto& arena = ForeignArenas[TThread::CurrentThreadId()];
+            if (!arena) {
+                arena.Reset(new TScratchArena());
+            }
+            return arena.Get();
+        }
+    }
+
+    // Should be called when no thread uses the arenas, e.g. at the end of an iteration
+    ui64 Reset() {
+        ui64 allocationCount = 0;
+        for (auto& arena : Arenas) {
+            allocationCount += arena.Reset();
+        }
+        with_lock(ForeignArenasLock) {
+            for (auto& threadAndArena : ForeignArenas) {
+                allocationCount += threadAndArena.second->Reset();
+            }
+        }
+        return allocationCount;
+    }
+
+private:
+    const NPar::TLocalExecutor& LocalExecutor;
+    const TThread::TId OwnerThreadId;
+    TVector<TScratchArena> Arenas;
+    TAdaptiveLock ForeignArenasLock;
+    THashMap<TThread::TId, THolder<TScratchArena>> ForeignArenas;
+};
@@ -2,6 +2,9 @@
 
 #include <catboost/libs/helpers/restorable_rng.h>
 
+#include <util/generic/algorithm.h>
+#include <util/generic/ymath.h>
+
 static void GenerateRandomWeights(
     int learnSampleCount,
     float baggingTemperature,
@@ -83,6 +86,51 @@ static void GenerateBernoulliWeightsForPairs(
     }, 0, blockParams.GetBlockCount(), NPar::TLocalExecutor::WAIT_COMPLETE);
 }
 
+void GenerateGossWeights(
+    const TVector<TVector<double>>& weightedDerivatives,
+    float topFraction,
+    float otherFraction,
+    NPar::TLocalExecutor* localExecutor,
+    TRestorableFastRng64* rand,
+    TArrayRef<float> sampleWeights
+) {
+    const int learnSampleCount = sampleWeights.size();
+    const int approxDimension = weightedDerivatives.ysize();
+    TVector<double> squaredGradients;
+    squaredGradients.yresize(learnSampleCount);
+    localExecutor->ExecRange([&](int docIdx) {
+        double squaredGradient = 0;
+        for (int dim = 0; dim < approxDimension; ++dim) {
+            squaredGradient += Sqr(weightedDerivatives[dim][docIdx]);
+        }
+        squaredGradients[docIdx] = squaredGradient;
+    }, NPar::TLocalExecutor::TExecRangeParams(0, learnSampleCount).SetBlockSize(4000), NPar::TLocalExecutor::WAIT_COMPLETE);
+
+    const ui64 randSeed = rand->GenRand();
+    const float otherWeight = 1.0f / otherFraction;
+    NPar::TLocalExecutor::TExecRangeParams blockParams(0, learnSampleCount);
+    blockParams.SetBlockSize(1000);
+    localExecutor->ExecRange([&](int blockIdx) {
+        TRestorableFastRng64 rand(randSeed + blockIdx);
+        rand.Advance(10); // reduce correlation between RNGs in different threads
+        float* sampleWeightsData = sampleWeights.data();
+        NPar::TLocalExecutor::BlockedLoopBody(blockParams, [=,&rand](int i) {
+            sampleWeightsData[i] = rand.GenRandReal1() < otherFraction ? otherWeight : 0.0f;
+        })(blockIdx);
+    }, 0, blockParams.GetBlockCount(), NPar::TLocalExecutor::WAIT_COMPLETE);
+
+    const int topCount = Min<int>(learnSampleCount, ceil(topFraction * learnSampleCount));
+    TVector<int> docIndices;
+    docIndices.yresize(learnSampleCount);
+    Iota(docIndices.begin(), docIndices.end(), 0);
+    NthElement(docIndices.begin(), docIndices.begin() + topCount, docIndices.end(), [&](int lhs, int rhs) {
+        return squaredGradients[lhs] > squaredGradients[rhs];
+    });
+    for (int topIdx = 0; topIdx < topCount; ++topIdx) {
+        sampleWeights[docIndices[topIdx]] = 1.0f;
+    }
+}
+
 static void CalcWeightedData(
     int learnSampleCount,
     EBoostingType boostingType,
@@ -153,6 +201,17 @@ void Bootstrap(
                 GenerateRandomWeights(learnSampleCount, baggingTemperature, localExecutor, rand, fold);
             }
             break;
+        case EBootstrapType::GOSS:
+            CB_ENSURE(!isPairwiseScoring, "GOSS bootstrap is not supported for pairwise scoring");
+            Y_ASSERT(fold->BodyTailArr.back().TailFinish == learnSampleCount);
+            GenerateGossWeights(
+                fold->BodyTailArr.back().WeightedDerivatives,
+                params.ObliviousTreeOptions->BootstrapConfig->GetTopFraction(),
+                takenFraction,
+                localExecutor,
+                rand,
+                MakeArrayRef(fold->SampleWeights.data(), learnSampleCount));
+            break;
         case EBootstrapType::No:
             if (!isPairwiseScoring) {
                 Fill(fold->SampleWeights.begin(), fold->SampleWeights.end(), 1);
@@ -164,7 +223,7 @@ void Bootstrap(
     if (!isPairwiseScoring) {
         CalcWeightedData(learnSampleCount, params.BoostingOptions->BoostingType.Get(), localExecutor, fold);
     }
-    sampledDocs->Sample(*fold, indices, rand, localExecutor);
+    sampledDocs->Sample(*fold, indices, /*isSampledByWeights*/ bootstrapType == EBootstrapType::GOSS, rand, localExecutor);
 }
 
 void SetBestScore(
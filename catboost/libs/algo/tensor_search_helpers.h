@@ -10,6 +10,7 @@
 
 #include <catboost/libs/options/enums.h>
 
+#include <util/generic/array_ref.h>
 #include <util/generic/vector.h>
 
 #include <library/binsaver/bin_saver.h>
@@ -64,6 +65,16 @@ void Bootstrap(const NCatboostOptions::TCatBoostOptions& params,
                NPar::TLocalExecutor* localExecutor,
                TRestorableFastRng64* rand);
 
+// GOSS sample weights: 1 for topFraction of documents with largest gradient norm,
+// 1 / otherFraction for otherFraction of the rest and 0 otherwise
+void GenerateGossWeights(
+    const TVector<TVector<double>>& weightedDerivatives,
+    float topFraction,
+    float otherFraction,
+    NPar::TLocalExecutor* localExecutor,
+    TRestorableFastRng64* rand,
+    TArrayRef<float> sampleWeights);
+
 template <typename TError>
 TError BuildError(const NCatboostOptions::TCatBoostOptions& params, const TMaybe<TCustomObjectiveDescriptor>&) {
     return TError(IsStoreExpApprox(params.LossFunctionDescription->GetLossFunction()));
@@ -10,6 +10,9 @@
 #include <catboost/libs/distributed/master.h>
 #include <catboost/libs/helpers/interrupt.h>
 #include <catboost/libs/logging/profile_info.h>
+#include <catboost/libs/logging/trace_session.h>
+
+#include <library/chromium_trace/interface.h>
 
 struct TCompetitor;
 
@@ -45,6 +48,7 @@ void UpdateLearningFold(
     TFold* fold,
     TLearnContext* ctx
 ) {
+    CHROMIUM_TRACE_FUNCTION();
     TVector<TVector<TVector<double>>> approxDelta;
 
     CalcApproxForLeafStruct(
@@ -71,7 +75,8 @@ void UpdateAveragingFold(
     TVector<TVector<double>>* treeValues
 ) {
     TProfileInfo& profile = ctx->Profile;
-    TVector<TIndexType> indices;
+    TScratchVector<TIndexType> indicesScratch(ctx->ScratchArenas.GetThreadArena());
+    TVector<TIndexType>& indices = *indicesScratch;
 
     CalcLeafValues(
         learnData,
@@ -214,7 +219,8 @@ void TrainOneIter(const TDataset& learnData, const TDatasetPtrs& testDataPtrs, T
                 TFold* Fold;
                 TOnlineCTR* Ctr;
                 void DoTask(TLearnContext* ctx) {
-                    ComputeOnlineCTRs(*LearnData, TestDatas, *Fold, Projection, ctx, Ctr);
+                    CHROMIUM_TRACE_SCOPE("ComputeOnlineCTRs");
+                    ComputeOnlineCTRs(*LearnData, TestDatas, *Fold, Projection, ctx, &ctx->LocalExecutor, Ctr);
                 }
             };
 
@@ -243,6 +249,17 @@ void TrainOneIter(const TDataset& learnData, const TDatasetPtrs& testDataPtrs, T
 
         }
         profile.AddOperation("ComputeOnlineCTRs for tree struct (train folds and test fold)");
+        if (IsTraceSessionActive()) {
+            size_t onlineCtrMemoryUsage = ctx->LearnProgress.AveragingFold.GetOnlineCtrMemoryUsage();
+            for (const auto* fold : trainFolds) {
+                onlineCtrMemoryUsage += fold->GetOnlineCtrMemoryUsage();
+            }
+            NChromiumTrace::GetGlobalTracer()->AddCounterNow(
+                AsStringBuf("Online CTR cache"),
+                AsStringBuf("memory"),
+                NChromiumTrace::TEventArgs().Add(AsStringBuf("bytes"), static_cast<i64>(onlineCtrMemoryUsage))
+            );
+        }
         CheckInterrupted(); // check after long-lasting operation
 
         if (ctx->Params.SystemOptions->IsSingleHost()) {
@@ -266,4 +283,5 @@ void TrainOneIter(const TDataset& learnData, const TDatasetPtrs& testDataPtrs, T
         profile.AddOperation("Update final approxes");
         CheckInterrupted(); // check after long-lasting operation
     }
+    profile.AddScratchAllocations(ctx->ScratchArenas.Reset());
 }
@@ -0,0 +1,55 @@
+#include <library/unittest/registar.h>
+#include <catboost/libs/algo/tensor_search_helpers.h>
+
+#include <util/generic/algorithm.h>
+#include <util/generic/ymath.h>
+#include <util/random/fast.h>
+
+Y_UNIT_TEST_SUITE(BootstrapTest) {
+    Y_UNIT_TEST(GossKeepsTopGradientsAndReweightsTheRest) {
+        const int docCount = 10000;
+        const float topFraction = 0.2f;
+        const float otherFraction = 0.25f;
+        TReallyFastRng32 gradientRng(123);
+        TVector<TVector<double>> weightedDerivatives(2, TVector<double>(docCount));
+        TVector<double> squaredGradients(docCount);
+        for (int doc = 0; doc < docCount; ++doc) {
+            for (auto& derivatives : weightedDerivatives) {
+                derivatives[doc] = gradientRng.GenRandReal1() - 0.5;
+                squaredGradients[doc] += Sqr(derivatives[doc]);
+            }
+        }
+        TVector<double> sortedSquaredGradients = squaredGradients;
+        Sort(sortedSquaredGradients.begin(), sortedSquaredGradients.end(), TGreater<double>());
+        const int topCount = ceil(topFraction * docCount);
+        const double topThreshold = sortedSquaredGradients[topCount - 1];
+
+        NPar::TLocalExecutor localExecutor;
+        localExecutor.RunAdditionalThreads(3);
+        TRestorableFastRng64 rand(0);
+        TVector<float> sampleWeights(docCount);
+        GenerateGossWeights(weightedDerivatives, topFraction, otherFraction, &localExecutor, &rand, sampleWeights);
+
+        // (1 - a) / b of the original formulation, b being the sampled fraction of all documents
+        const float otherWeight = 1.0f / otherFraction;
+        int keptTopCount = 0;
+        int sampledOtherCount = 0;
+        for (int doc = 0; doc < docCount; ++doc) {
+            if (squaredGradients[doc] >= topThreshold) {
+                UNIT_ASSERT_VALUES_EQUAL(sampleWeights[doc], 1.0f);
+                ++keptTopCount;
+            } else if (sampleWeights[doc] != 0.0f) {
+                UNIT_ASSERT_VALUES_EQUAL(sampleWeights[doc], otherWeight);
+                ++sampledOtherCount;
+            }
+        }
+        UNIT_ASSERT_VALUES_EQUAL(keptTopCount, topCount);
+        const double expectedOtherCount = otherFraction * (docCount - topCount);
+        UNIT_ASSERT_DOUBLES_EQUAL(sampledOtherCount, expectedOtherCount, 0.1 * expectedOtherCount);
+
+        TRestorableFastRng64 sameRand(0);
+        TVector<float> sameSeedSampleWeights(docCount);
+        GenerateGossWeights(weightedDerivatives, topFraction, otherFraction, &localExecutor, &sameRand, sameSeedSampleWeights);
+        UNIT_ASSERT_EQUAL(sampleWeights, sameSeedSampleWeights);
+    }
+}
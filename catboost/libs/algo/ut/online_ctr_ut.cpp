@@ -0,0 +1,108 @@
+#include <library/unittest/registar.h>
+#include <catboost/libs/algo/online_ctr.h>
+#include <catboost/libs/algo/index_hash_calcer.h>
+#include <catboost/libs/helpers/dense_hash_view.h>
+
+#include <util/generic/hash_set.h>
+#include <util/random/fast.h>
+
+Y_UNIT_TEST_SUITE(TOnlineCtrValuesTest) {
+    Y_UNIT_TEST(TestPack) {
+        NPar::TLocalExecutor localExecutor;
+        localExecutor.RunAdditionalThreads(3);
+        for (size_t docCount : {0, 1, 2, 7, 100001}) {
+            for (NPar::TLocalExecutor* executor : {&localExecutor, (NPar::TLocalExecutor*)nullptr}) {
+                TOnlineCtrValues ctrValues;
+                ui8* values = ctrValues.Reset(docCount);
+                for (size_t doc = 0; doc < docCount; ++doc) {
+                    values[doc] = (doc * 7) % (TOnlineCtrValues::MaxPackedValue + 1);
+                }
+                ctrValues.Pack(executor);
+                UNIT_ASSERT(ctrValues.IsPacked());
+                UNIT_ASSERT_VALUES_EQUAL(ctrValues.GetDocCount(), docCount);
+                UNIT_ASSERT_VALUES_EQUAL(ctrValues.GetMemoryUsage(), TOnlineCtrValues::GetMemoryUsage(docCount, TOnlineCtrValues::MaxPackedValue));
+                const TPackedOnlineCtrValuesRef packedValues{ctrValues.GetData()};
+                for (size_t doc = 0; doc < docCount; ++doc) {
+                    const ui8 expectedValue = (doc * 7) % (TOnlineCtrValues::MaxPackedValue + 1);
+                    UNIT_ASSERT_VALUES_EQUAL(ctrValues[doc], expectedValue);
+                    UNIT_ASSERT_VALUES_EQUAL(packedValues[doc], ctrValues[doc]);
+                }
+            }
+        }
+    }
+}
+
+Y_UNIT_TEST_SUITE(TReindexHashTest) {
+    Y_UNIT_TEST(TestReindexDependsOnlyOnSplit) {
+        NPar::TLocalExecutor localExecutor;
+        localExecutor.RunAdditionalThreads(3);
+        TReallyFastRng32 rng(1);
+        const size_t docCount = 50000;
+        TVector<ui64> bucketOfDoc(docCount);
+        for (auto& bucket : bucketOfDoc) {
+            bucket = rng.Uniform(100);
+        }
+        for (ui64 topSize : {Max<ui64>(), ui64(docCount), ui64(30), ui64(1)}) {
+            TVector<ui64> reindexed;
+            for (ui64 salt : {1, 7919}) {
+                TVector<ui64> hashes(docCount);
+                for (size_t doc = 0; doc < docCount; ++doc) {
+                    hashes[doc] = CalcHash(salt, bucketOfDoc[doc]);
+                }
+                TDenseHash<ui64, ui32> reindexHash;
+                const size_t bucketCount = ComputeReindexHash(topSize, &reindexHash, hashes.data(), hashes.data() + docCount, &localExecutor);
+                UNIT_ASSERT_VALUES_EQUAL(bucketCount, Min<ui64>(topSize, 100));
+                if (reindexed.empty()) {
+                    reindexed = hashes;
+                } else {
+                    UNIT_ASSERT_EQUAL(hashes, reindexed);
+                }
+            }
+        }
+    }
+}
+
+Y_UNIT_TEST_SUITE(TDenseIndexHashBuilderTest) {
+    Y_UNIT_TEST(TestSetIndices) {
+        NPar::TLocalExecutor localExecutor;
+        localExecutor.RunAdditionalThreads(3);
+        TReallyFastRng32 rng(1);
+        for (size_t uniqueCount : {0, 1, 1000, 100000}) {
+            // half of hashes hit the last buckets of 1 << 16 bucket ranges to probe past range ends
+            TVector<std::pair<ui64, ui32>> hashIndices;
+            THashSet<ui64> seenHashes;
+            while (hashIndices.size() < uniqueCount) {
+                const ui64 hash = hashIndices.size() % 2 ? rng.GenRand64() : (rng.GenRand64() << 16) | (0xffff - rng.Uniform(8));
+                if (hash != NCatboost::TBucket::InvalidHashValue && seenHashes.insert(hash).second) {
+                    hashIndices.emplace_back(hash, hashIndices.size());
+                }
+            }
+            const size_t bucketCount = NCatboost::TDenseIndexHashBuilder::GetProperBucketsCount(uniqueCount);
+            TVector<NCatboost::TBucket> sequentialBuckets(bucketCount);
+            {
+                NCatboost::TDenseIndexHashBuilder builder(sequentialBuckets);
+                for (const auto& hashIndex : hashIndices) {
+                    builder.SetIndex(hashIndex.first, hashIndex.second);
+                }
+            }
+            TVector<NCatboost::TBucket> parallelBuckets(bucketCount);
+            NCatboost::TDenseIndexHashBuilder(parallelBuckets).SetIndices(hashIndices, &localExecutor);
+            TVector<NCatboost::TBucket> noExecutorBuckets(bucketCount);
+            NCatboost::TDenseIndexHashBuilder(noExecutorBuckets).SetIndices(hashIndices, nullptr);
+            UNIT_ASSERT_EQUAL(parallelBuckets, noExecutorBuckets);
+
+            const NCatboost::TDenseIndexHashView sequentialView(sequentialBuckets);
+            const NCatboost::TDenseIndexHashView parallelView(parallelBuckets);
+            for (const auto& hashIndex : hashIndices) {
+                UNIT_ASSERT_VALUES_EQUAL(sequentialView.GetIndex(hashIndex.first), hashIndex.second);
+                UNIT_ASSERT_VALUES_EQUAL(parallelView.GetIndex(hashIndex.first), hashIndex.second);
+            }
+            for (int i = 0; i < 1000; ++i) {
+                const ui64 hash = rng.GenRand64();
+                if (!seenHashes.has(hash)) {
+                    UNIT_ASSERT_VALUES_EQUAL(parallelView.GetIndex(hash), NCatboost::TDenseIndexHashView::NotFoundIndex);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,163 @@
+#include <library/unittest/registar.h>
+#include <catboost/libs/algo/score_calcer.h>
+
+#include <util/random/fast.h>
+
+template <typename TStats>
+static TVector<TScoreBin> CalcPlainScoreBins(
+    const TVector<ui16>& singleIdx,
+    const TVector<double>& weightedDer,
+    const TVector<float>& sampleWeights,
+    int leafCount,
+    const TStatsIndexer& indexer,
+    ESplitType splitType
+) {
+    TVector<TStats> stats(indexer.BucketCount * leafCount);
+    UpdateWeighted(singleIdx, weightedDer.data(), sampleWeights.data(), 0, singleIdx.ysize(), stats.data());
+    TVector<TScoreBin> scoreBins(indexer.BucketCount);
+    UpdateScoreBin(stats.data(), leafCount, indexer, splitType, /*l2Regularizer*/ 3.0f, /*isPlainMode=*/std::true_type(), /*sumAllWeights*/ singleIdx.ysize(), singleIdx.ysize(), &scoreBins);
+    return scoreBins;
+}
+
+// Fold with a single body tail, the first bodyFinish documents are the body
+static void CreateFold(const TVector<double>& derivatives, const TVector<float>& sampleWeights, int bodyFinish, TCalcScoreFold* fold) {
+    const int docCount = derivatives.ysize();
+    fold->SampleWeights.assign(sampleWeights.begin(), sampleWeights.end());
+    fold->BodyTailArr.resize(1);
+    auto& bt = fold->BodyTailArr[0];
+    bt.WeightedDerivatives.resize(1);
+    bt.WeightedDerivatives[0].assign(derivatives.begin(), derivatives.end());
+    bt.SampleWeightedDerivatives.resize(1);
+    bt.SampleWeightedDerivatives[0].yresize(docCount);
+    for (int doc = 0; doc < docCount; ++doc) {
+        bt.SampleWeightedDerivatives[0][doc] = derivatives[doc] * sampleWeights[doc];
+    }
+    bt.BodyFinish = bodyFinish;
+    bt.TailFinish = docCount;
+}
+
+// Scores of statistics calculated by CalcStatsKernel with partial sums of type TPartialStats,
+// with caching the statistics of the previous level are computed first and the documents of one split side are added
+template <typename TStats, typename TPartialStats, typename TIsPlainMode, typename TIsCaching>
+static TVector<double> CalcKernelScores(
+    TIsPlainMode isPlainMode,
+    TIsCaching isCaching,
+    const TVector<ui16>& bucketIdx,
+    const TVector<int>& leafIdx,
+    const TVector<double>& derivatives,
+    const TVector<float>& sampleWeights,
+    int bodyFinish,
+    const TStatsIndexer& indexer,
+    int depth
+) {
+    const int docCount = bucketIdx.ysize();
+    TVector<TStats> stats(indexer.CalcSize(depth));
+    TVector<TPartialStats> partialStats(std::is_same<TStats, TPartialStats>::value ? 0 : indexer.CalcSize(depth));
+    if (isCaching) {
+        TCalcScoreFold prevLevelFold;
+        CreateFold(derivatives, sampleWeights, bodyFinish, &prevLevelFold);
+        TVector<ui16> prevLevelIdx(docCount);
+        for (int doc = 0; doc < docCount; ++doc) {
+            prevLevelIdx[doc] = indexer.GetIndex(leafIdx[doc] % (1 << (depth - 1)), bucketIdx[doc]);
+        }
+        CalcStatsKernel(std::false_type(), prevLevelIdx, prevLevelFold, isPlainMode, indexer, depth - 1, prevLevelFold.BodyTailArr[0], /*dim*/ 0, partialStats.data(), stats.data());
+
+        // documents of the split side with the last depth bit set, the other side is obtained by FixUpStats
+        TVector<double> sideDerivatives;
+        TVector<float> sideWeights;
+        TVector<ui16> sideIdx;
+        int sideBodyFinish = 0;
+        for (int doc = 0; doc < docCount; ++doc) {
+            if (leafIdx[doc] >> (depth - 1)) {
+                sideDerivatives.push_back(derivatives[doc]);
+                sideWeights.push_back(sampleWeights[doc]);
+                sideIdx.push_back(indexer.GetIndex(leafIdx[doc], bucketIdx[doc]));
+                sideBodyFinish += doc < bodyFinish;
+            }
+        }
+        TCalcScoreFold sideFold;
+        CreateFold(sideDerivatives, sideWeights, sideBodyFinish, &sideFold);
+        sideFold.SmallestSplitSideValue = true;
+        CalcStatsKernel(isCaching, sideIdx, sideFold, isPlainMode, indexer, depth, sideFold.BodyTailArr[0], /*dim*/ 0, partialStats.data(), stats.data());
+    } else {
+        TCalcScoreFold fold;
+        CreateFold(derivatives, sampleWeights, bodyFinish, &fold);
+        TVector<ui16> singleIdx(docCount);
+        for (int doc = 0; doc < docCount; ++doc) {
+            singleIdx[doc] = indexer.GetIndex(leafIdx[doc], bucketIdx[doc]);
+        }
+        CalcStatsKernel(isCaching, singleIdx, fold, isPlainMode, indexer, depth, fold.BodyTailArr[0], /*dim*/ 0, partialStats.data(), stats.data());
+    }
+    TVector<TScoreBin> scoreBins(indexer.BucketCount);
+    UpdateScoreBin(stats.data(), 1 << depth, indexer, ESplitType::FloatFeature, /*l2Regularizer*/ 3.0f, isPlainMode, /*sumAllWeights*/ docCount, docCount, &scoreBins);
+    return GetScores(scoreBins);
+}
+
+static void AssertScoresClose(const TVector<double>& scores, const TVector<double>& expectedScores, double relativeError) {
+    UNIT_ASSERT_VALUES_EQUAL(scores.size(), expectedScores.size());
+    for (int splitIdx = 0; splitIdx < scores.ysize(); ++splitIdx) {
+        UNIT_ASSERT_DOUBLES_EQUAL(scores[splitIdx], expectedScores[splitIdx], relativeError * Abs(expectedScores[splitIdx]) + 1e-9);
+    }
+}
+
+Y_UNIT_TEST_SUITE(ScoreCalcerTest) {
+    Y_UNIT_TEST(PlainBucketStatsScoreParity) {
+        const int docCount = 100000;
+        const int leafCount = 8;
+        const TStatsIndexer indexer(/*bucketCount*/ 33);
+        TReallyFastRng32 rng(123);
+        TVector<ui16> singleIdx(docCount);
+        TVector<double> weightedDer(docCount);
+        TVector<float> sampleWeights(docCount);
+        for (int doc = 0; doc < docCount; ++doc) {
+            singleIdx[doc] = indexer.GetIndex(rng.Uniform(leafCount), rng.Uniform(indexer.BucketCount));
+            sampleWeights[doc] = rng.GenRandReal1() + 0.5;
+            weightedDer[doc] = (rng.GenRandReal1() - 0.3) * sampleWeights[doc];
+        }
+        for (ESplitType splitType : {ESplitType::FloatFeature, ESplitType::OneHotFeature}) {
+            const auto fullStatsScores = GetScores(CalcPlainScoreBins<TBucketStats>(singleIdx, weightedDer, sampleWeights, leafCount, indexer, splitType));
+            const auto plainStatsScores = GetScores(CalcPlainScoreBins<TPlainBucketStats<double>>(singleIdx, weightedDer, sampleWeights, leafCount, indexer, splitType));
+            for (int splitIdx = 0; splitIdx < fullStatsScores.ysize(); ++splitIdx) {
+                UNIT_ASSERT_VALUES_EQUAL(plainStatsScores[splitIdx], fullStatsScores[splitIdx]);
+            }
+        }
+    }
+
+    // float partial sums over document blocks against double accumulation, many documents per bucket,
+    // for plain and ordered modes, with and without statistics of the previous level
+    Y_UNIT_TEST(MixedPrecisionScoreParity) {
+        const int docCount = 1 << 21;
+        const int bodyFinish = docCount / 3;
+        const int depth = 2;
+        const TStatsIndexer indexer(/*bucketCount*/ 5);
+        TReallyFastRng32 rng(123);
+        TVector<ui16> bucketIdx(docCount);
+        TVector<int> leafIdx(docCount);
+        TVector<double> derivatives(docCount);
+        TVector<float> sampleWeights(docCount);
+        for (int doc = 0; doc < docCount; ++doc) {
+            bucketIdx[doc] = rng.Uniform(indexer.BucketCount);
+            leafIdx[doc] = rng.Uniform(1 << depth);
+            sampleWeights[doc] = rng.GenRandReal1() + 0.5;
+            derivatives[doc] = rng.GenRandReal1() - 0.3 + 0.01 * bucketIdx[doc];
+        }
+        const auto plainScores = CalcKernelScores<TPlainBucketStats<double>, TPlainBucketStats<double>>(
+            std::true_type(), std::false_type(), bucketIdx, leafIdx, derivatives, sampleWeights, bodyFinish, indexer, depth);
+        const auto orderedScores = CalcKernelScores<TBucketStats, TBucketStats>(
+            std::false_type(), std::false_type(), bucketIdx, leafIdx, derivatives, sampleWeights, bodyFinish, indexer, depth);
+
+        AssertScoresClose(CalcKernelScores<TPlainBucketStats<double>, TPlainBucketStats<double>>(
+            std::true_type(), std::true_type(), bucketIdx, leafIdx, derivatives, sampleWeights, bodyFinish, indexer, depth), plainScores, 1e-9);
+        AssertScoresClose(CalcKernelScores<TBucketStats, TBucketStats>(
+            std::false_type(), std::true_type(), bucketIdx, leafIdx, derivatives, sampleWeights, bodyFinish, indexer, depth), orderedScores, 1e-9);
+
+        AssertScoresClose(CalcKernelScores<TPlainBucketStats<double>, TPlainBucketStats<float>>(
+            std::true_type(), std::false_type(), bucketIdx, leafIdx, derivatives, sampleWeights, bodyFinish, indexer, depth), plainScores, 1e-5);
+        AssertScoresClose(CalcKernelScores<TPlainBucketStats<double>, TPlainBucketStats<float>>(
+            std::true_type(), std::true_type(), bucketIdx, leafIdx, derivatives, sampleWeights, bodyFinish, indexer, depth), plainScores, 1e-5);
+        AssertScoresClose(CalcKernelScores<TBucketStats, TBasicBucketStats<float>>(
+            std::false_type(), std::false_type(), bucketIdx, leafIdx, derivatives, sampleWeights, bodyFinish, indexer, depth), orderedScores, 1e-5);
+        AssertScoresClose(CalcKernelScores<TBucketStats, TBasicBucketStats<float>>(
+            std::false_type(), std::true_type(), bucketIdx, leafIdx, derivatives, sampleWeights, bodyFinish, indexer, depth), orderedScores, 1e-5);
+    }
+}
@@ -0,0 +1,48 @@
+#include <library/unittest/registar.h>
+#include <catboost/libs/algo/scratch_arena.h>
+
+#include <thread>
+
+Y_UNIT_TEST_SUITE(TScratchArenasTest) {
+    Y_UNIT_TEST(TestThreadArenas) {
+        NPar::TLocalExecutor localExecutor;
+        localExecutor.RunAdditionalThreads(3);
+        TScratchArenas arenas(localExecutor);
+        TScratchArena* ownerArena = arenas.GetThreadArena();
+        UNIT_ASSERT_EQUAL(arenas.GetThreadArena(), ownerArena);
+
+        // executor workers use their own arenas
+        TVector<TScratchArena*> workerArenas(localExecutor.GetThreadCount() + 1);
+        localExecutor.ExecRange([&](int idx) {
+            workerArenas[localExecutor.GetWorkerThreadId()] = arenas.GetThreadArena();
+            TScratchVector<int> vector(arenas.GetThreadArena());
+            vector->resize(idx + 1);
+        }, 0, 100, NPar::TLocalExecutor::WAIT_COMPLETE);
+        for (int workerIdx = 1; workerIdx < workerArenas.ysize(); ++workerIdx) {
+            UNIT_ASSERT_UNEQUAL(workerArenas[workerIdx], ownerArena);
+        }
+
+        // threads which are not executor workers have worker id 0, but must not share the owner arena
+        TScratchArena* otherThreadArenas[2] = {nullptr, nullptr};
+        auto getOtherThreadArena = [&](int threadIdx) {
+            return [&, threadIdx]() {
+                UNIT_ASSERT_VALUES_EQUAL(localExecutor.GetWorkerThreadId(), 0);
+                otherThreadArenas[threadIdx] = arenas.GetThreadArena();
+                UNIT_ASSERT_EQUAL(arenas.GetThreadArena(), otherThreadArenas[threadIdx]);
+                TScratchVector<int> vector(otherThreadArenas[threadIdx]);
+                vector->resize(10);
+            };
+        };
+        std::thread firstThread(getOtherThreadArena(0));
+        std::thread secondThread(getOtherThreadArena(1));
+        firstThread.join();
+        secondThread.join();
+        UNIT_ASSERT(otherThreadArenas[0] != nullptr && otherThreadArenas[1] != nullptr);
+        UNIT_ASSERT_UNEQUAL(otherThreadArenas[0], ownerArena);
+        UNIT_ASSERT_UNEQUAL(otherThreadArenas[1], ownerArena);
+        UNIT_ASSERT_UNEQUAL(otherThreadArenas[0], otherThreadArenas[1]);
+
+        UNIT_ASSERT(arenas.Reset() > 0);
+        UNIT_ASSERT_VALUES_EQUAL(arenas.Reset(), 0);
+    }
+}
@@ -1,12 +1,70 @@
 #include <catboost/libs/train_lib/train_model.h>
 #include <catboost/libs/algo/features_layout.h>
 #include <catboost/libs/options/plain_options_helper.h>
+#include <catboost/libs/cat_feature/cat_feature.h>
 
 #include <library/unittest/registar.h>
 #include <library/json/json_reader.h>
 
 #include <util/random/fast.h>
 #include <util/generic/vector.h>
+#include <util/string/cast.h>
+
+static TPool CreateCatFeaturesPool(size_t docCount) {
+    const size_t floatFeatureCount = 3;
+    const TVector<ui32> catFeatureValueCounts = {5, 13, 40};
+    TReallyFastRng32 rng(42);
+    TPool pool;
+    pool.Docs.Resize(docCount, floatFeatureCount + catFeatureValueCounts.size(), /*baseline dimension*/ 0, /*has queryId*/ false, /*has subgroupId*/ false);
+    for (size_t catFeatureIdx = 0; catFeatureIdx < catFeatureValueCounts.size(); ++catFeatureIdx) {
+        pool.CatFeatures.push_back(floatFeatureCount + catFeatureIdx);
+    }
+    for (size_t doc = 0; doc < docCount; ++doc) {
+        TVector<ui32> catValues;
+        for (size_t catFeatureIdx = 0; catFeatureIdx < catFeatureValueCounts.size(); ++catFeatureIdx) {
+            catValues.push_back(rng.Uniform(catFeatureValueCounts[catFeatureIdx]));
+            const TString catValue = ToString(catFeatureIdx) + "_" + ToString(catValues.back());
+            const int hash = CalcCatFeatureHash(catValue);
+            pool.Docs.Factors[floatFeatureCount + catFeatureIdx][doc] = ConvertCatFeatureHashToFloat(hash);
+            pool.CatFeaturesHashToString[hash] = catValue;
+        }
+        for (size_t featureIdx = 0; featureIdx < floatFeatureCount; ++featureIdx) {
+            pool.Docs.Factors[featureIdx][doc] = rng.GenRandReal2();
+        }
+        const bool catTarget = (catValues[0] + catValues[1] * catValues[2]) % 3 == 0;
+        pool.Docs.Target[doc] = (catTarget != (pool.Docs.Factors[0][doc] > 0.7)) ? 1.0f : 0.0f;
+    }
+    return pool;
+}
+
+static TFullModel TrainWithParams(const TPool& learnPool, const NJson::TJsonValue& extraFitParams, TVector<double>* approx) {
+    NJson::TJsonValue plainFitParams = extraFitParams;
+    plainFitParams.InsertValue("loss_function", "Logloss");
+    plainFitParams.InsertValue("random_seed", 5);
+    plainFitParams.InsertValue("iterations", 20);
+    plainFitParams.InsertValue("depth", 4);
+    plainFitParams.InsertValue("train_dir", ".");
+    TPool pool(learnPool);
+    TPool testPool(learnPool);
+    TEvalResult testApprox;
+    TFullModel model;
+    TrainModel(plainFitParams, Nothing(), Nothing(), pool, false, testPool, "", &model, &testApprox);
+    *approx = testApprox.GetRawValuesRef()[0][0];
+    return model;
+}
+
+static void AssertEqualTraining(const TPool& pool, const NJson::TJsonValue& fitParams, const NJson::TJsonValue& otherFitParams) {
+    TVector<double> approx;
+    TVector<double> otherApprox;
+    const TFullModel model = TrainWithParams(pool, fitParams, &approx);
+    const TFullModel otherModel = TrainWithParams(pool, otherFitParams, &otherApprox);
+    UNIT_ASSERT(!model.ObliviousTrees.GetUsedModelCtrs().empty());
+    UNIT_ASSERT_EQUAL(model, otherModel);
+    UNIT_ASSERT_VALUES_EQUAL(approx.size(), otherApprox.size());
+    for (size_t doc = 0; doc < approx.size(); ++doc) {
+        UNIT_ASSERT_VALUES_EQUAL(approx[doc], otherApprox[doc]);
+    }
+}
 
 Y_UNIT_TEST_SUITE(TTrainTest) {
     Y_UNIT_TEST(TestRepeatableTrain) {
@@ -52,6 +110,30 @@ Y_UNIT_TEST_SUITE(TTrainTest) {
             }
         }
     }
+    Y_UNIT_TEST(TestCandidatesEvaluationOrder) {
+        // one thread evaluates candidates in index order, several threads start expensive ctr candidates first
+        const TPool pool = CreateCatFeaturesPool(2000);
+        NJson::TJsonValue singleThreadParams;
+        singleThreadParams.InsertValue("thread_count", 1);
+        NJson::TJsonValue multiThreadParams;
+        multiThreadParams.InsertValue("thread_count", 4);
+        AssertEqualTraining(pool, singleThreadParams, multiThreadParams);
+    }
+    Y_UNIT_TEST(TestTreeCtrBaseHashesCache) {
+        // base projection hashes are cached only if memory usage allows it, the model must not depend on it
+        const TPool pool = CreateCatFeaturesPool(2000);
+        for (ui64 ctrLeafCountLimit : {0, 10}) {
+            NJson::TJsonValue cachedParams;
+            cachedParams.InsertValue("used_ram_limit", "unlimited");
+            NJson::TJsonValue notCachedParams;
+            notCachedParams.InsertValue("used_ram_limit", "1kb");
+            if (ctrLeafCountLimit != 0) {
+                cachedParams.InsertValue("ctr_leaf_count_limit", ctrLeafCountLimit);
+                notCachedParams.InsertValue("ctr_leaf_count_limit", ctrLeafCountLimit);
+            }
+            AssertEqualTraining(pool, cachedParams, notCachedParams);
+        }
+    }
     Y_UNIT_TEST(TestFeaturesLayout) {
         {
             std::vector<int> catFeatures = {1, 5, 9};
@@ -284,8 +284,17 @@ namespace NCB {
             features.yresize(PoolMetaInfo.FeatureCount);
 
             int tokenCount = 0;
-            TVector<TStringBuf> tokens = StringSplitter(line).Split(FieldDelimiter).ToList<TStringBuf>();
-            for (const auto& token : tokens) {
+            TStringBuf lineRest = line;
+            for (bool isLastToken = false; !isLastToken; ) {
+                // memchr-based search, no per-line token vector
+                const size_t delimiterPos = lineRest.find(FieldDelimiter);
+                isLastToken = delimiterPos == TStringBuf::npos;
+                const TStringBuf token = isLastToken ? lineRest : lineRest.Head(delimiterPos);
+                if (!isLastToken) {
+                    lineRest.Skip(delimiterPos + 1);
+                }
+                CB_ENSURE(tokenCount < columnsDescription.ysize(), "wrong columns number in pool line " <<
+                          AsyncRowProcessor.GetLinesProcessed() + lineIdx + 1 << ": expected " << columnsDescription.ysize() << ", found more");
                 switch (columnsDescription[tokenCount].Type) {
                     case EColumn::Categ: {
                         if (!FeatureIgnored[featureId]) {
@@ -183,8 +183,9 @@ namespace NCB {
         // call after ColumnDescription initialization
         void InitFeatureIds(const TMaybe<TString>& header);
 
+        // zero if the count is unknown without an extra pass over the data, pool builders grow storage then
         int GetDocCount() override {
-            return (int)LineDataReader->GetDataLineCount();
+            return LineDataReader->HasCheapDataLineCount() ? (int)LineDataReader->GetDataLineCount() : 0;
         }
 
         void StartBuilder(bool inBlock, int docCount, int offset, IPoolBuilder* poolBuilder) override;
@@ -0,0 +1,193 @@
+#include "doc_pool_data_provider.h"
+
+#include "load_data.h"
+
+#include <catboost/libs/data_types/groupid.h>
+#include <catboost/libs/helpers/exception.h>
+
+#include <util/generic/strbuf.h>
+#include <util/generic/vector.h>
+#include <util/string/cast.h>
+
+
+namespace NCB {
+
+    namespace {
+
+    /* Calls f(token) for every non-empty space-separated token of the line.
+     * libsvm lines look like "<label> [qid:<groupId>] <featureIdx>:<value> ...",
+     * feature indices are 1-based, trailing "# comment" is ignored.
+     */
+    template <class TFunc>
+    void ForEachLibSvmToken(TStringBuf line, TFunc&& f) {
+        line = line.Before('#');
+        while (!line.empty()) {
+            const TStringBuf token = line.NextTok(' ');
+            if (!token.empty()) {
+                f(token);
+            }
+        }
+    }
+
+    bool IsGroupIdToken(TStringBuf token) {
+        return token.StartsWith("qid:");
+    }
+
+    ui32 ParseFeatureIdx(TStringBuf idxToken, size_t lineIdx) {
+        ui32 featureIdx = 0;
+        CB_ENSURE(TryFromString<ui32>(idxToken, featureIdx) && featureIdx > 0,
+                  "Bad feature index '" << idxToken << "' in libsvm line " << lineIdx + 1
+                  << ", feature indices should be positive integers");
+        return featureIdx - 1;
+    }
+
+    /* Max feature index of the line plus one, only index tokens before ':' are parsed and values are skipped.
+     * Sets *hasGroupId if the line has qid.
+     */
+    ui32 GetLibSvmLineFeatureCount(TStringBuf line, size_t lineIdx, bool* hasGroupId) {
+        line = line.Before('#');
+        ui32 featureCount = 0;
+        for (size_t colonPos = line.find(':'); colonPos != TStringBuf::npos; colonPos = line.find(':', colonPos + 1)) {
+            const size_t spacePos = line.rfind(' ', colonPos);
+            const size_t idxBegin = spacePos == TStringBuf::npos ? 0 : spacePos + 1;
+            const TStringBuf idxToken = line.SubStr(idxBegin, colonPos - idxBegin);
+            if (idxToken == AsStringBuf("qid")) {
+                *hasGroupId = true;
+            } else {
+                featureCount = Max(featureCount, ParseFeatureIdx(idxToken, lineIdx) + 1);
+            }
+        }
+        return featureCount;
+    }
+
+
+    /* Sparse rows in libsvm format: only listed values are parsed and added, absent features are left zero by
+     * the pool builder, so parsing time scales with the number of nonzeros. Pool storage is still dense.
+     * Feature count is the max feature index found in a preliminary pass over the file which skips values.
+     */
+    class TLibSvmDataProvider : public IDocPoolDataProvider
+                              , protected TAsyncProcDataProviderBase<TString>
+    {
+    public:
+        using TBase = TAsyncProcDataProviderBase<TString>;
+
+    protected:
+        decltype(auto) GetReadFunc() {
+            return [this](TString* line) -> bool {
+                return LineDataReader->ReadLine(line);
+            };
+        }
+
+    public:
+        explicit TLibSvmDataProvider(TDocPoolDataProviderArgs&& args)
+            : TBase(std::move(args))
+            , ConvertTarget(Args.ClassNames)
+        {
+            CB_ENSURE(!Args.DsvPoolFormatParams.CdFilePath.Inited(),
+                      "Column description file is not supported for libsvm pools");
+            CB_ENSURE(!Args.DsvPoolFormatParams.Format.HasHeader, "libsvm pools can't have a header");
+
+            ScanPool();
+
+            auto& columnsDescription = PoolMetaInfo.ColumnsInfo.ConstructInPlace().Columns;
+            columnsDescription.assign(PoolMetaInfo.FeatureCount + 1, TColumn{EColumn::Num, TString()});
+            columnsDescription[0].Type = EColumn::Label;
+
+            const int featureCount = static_cast<int>(PoolMetaInfo.FeatureCount);
+            int ignoredFeatureCount = 0;
+            FeatureIgnored.resize(featureCount, false);
+            for (int featureId : Args.IgnoredFeatures) {
+                CB_ENSURE(0 <= featureId && featureId < featureCount, "Invalid ignored feature id: " << featureId);
+                ignoredFeatureCount += FeatureIgnored[featureId] == false;
+                FeatureIgnored[featureId] = true;
+            }
+            CB_ENSURE(featureCount - ignoredFeatureCount > 0, "All features are requested to be ignored");
+
+            LineDataReader = GetLineDataReader(Args.PoolPath, Args.DsvPoolFormatParams.Format);
+            AsyncRowProcessor.ReadBlockAsync(GetReadFunc());
+        }
+
+        void Do(IPoolBuilder* poolBuilder) override {
+            TBase::Do(GetReadFunc(), poolBuilder);
+        }
+
+        bool DoBlock(IPoolBuilder* poolBuilder) override {
+            return TBase::DoBlock(GetReadFunc(), poolBuilder);
+        }
+
+        int GetDocCount() override {
+            return DocCount;
+        }
+
+        void StartBuilder(bool /*inBlock*/, int docCount, int offset, IPoolBuilder* poolBuilder) override {
+            poolBuilder->Start(PoolMetaInfo, docCount, /*catFeatureIds*/ {});
+            poolBuilder->GenerateDocIds(offset);
+        }
+
+        void ProcessBlock(IPoolBuilder* poolBuilder) override {
+            poolBuilder->StartNextBlock(AsyncRowProcessor.GetParseBufferSize());
+
+            auto parseLine = [&](TString& line, int lineIdx) {
+                const size_t poolLineIdx = AsyncRowProcessor.GetLinesProcessed() + lineIdx;
+                bool isLabel = true;
+                ForEachLibSvmToken(line, [&](TStringBuf token) {
+                    if (isLabel) {
+                        poolBuilder->AddTarget(lineIdx, ConvertTarget(TString(token)));
+                        isLabel = false;
+                        return;
+                    }
+                    if (IsGroupIdToken(token)) {
+                        CB_ENSURE(PoolMetaInfo.HasGroupId, "libsvm line " << poolLineIdx + 1 << " has qid, but the first line has not");
+                        poolBuilder->AddQueryId(lineIdx, CalcGroupIdFor(token.After(':')));
+                        return;
+                    }
+                    TStringBuf idxToken, valueToken;
+                    CB_ENSURE(token.TrySplit(':', idxToken, valueToken),
+                              "Bad token '" << token << "' in libsvm line " << poolLineIdx + 1 << ", expected <index>:<value>");
+                    const ui32 featureId = ParseFeatureIdx(idxToken, poolLineIdx);
+                    Y_ASSERT(featureId < PoolMetaInfo.FeatureCount);
+                    if (FeatureIgnored[featureId]) {
+                        return;
+                    }
+                    float value;
+                    CB_ENSURE(TryFromString<float>(valueToken, value),
+                              "Feature " << featureId << " has value '" << valueToken << "' in libsvm line " << poolLineIdx + 1
+                              << " that cannot be parsed as float");
+                    poolBuilder->AddFloatFeature(lineIdx, featureId, value == 0.0f ? 0.0f : value); // remove negative zeros
+                });
+                CB_ENSURE(!isLabel, "Empty libsvm line " << poolLineIdx + 1);
+            };
+
+            AsyncRowProcessor.ProcessBlock(parseLine);
+        }
+
+    private:
+        // sets FeatureCount to max feature index, HasGroupId if the first line has qid and DocCount,
+        // so that compressed files are not decompressed once more just to count lines
+        void ScanPool() {
+            auto reader = GetLineDataReader(Args.PoolPath, Args.DsvPoolFormatParams.Format);
+            ui32 featureCount = 0;
+            size_t lineIdx = 0;
+            TString line;
+            for (; reader->ReadLine(&line); ++lineIdx) {
+                bool hasGroupId = false;
+                featureCount = Max(featureCount, GetLibSvmLineFeatureCount(line, lineIdx, &hasGroupId));
+                PoolMetaInfo.HasGroupId |= lineIdx == 0 && hasGroupId;
+            }
+            CB_ENSURE(lineIdx > 0, "TLibSvmDataProvider: no data rows in pool");
+            DocCount = static_cast<int>(lineIdx);
+            PoolMetaInfo.FeatureCount = featureCount;
+            CB_ENSURE(PoolMetaInfo.FeatureCount > 0, "Pool should have at least one factor");
+        }
+
+    private:
+        TVector<bool> FeatureIgnored;
+        int DocCount = 0;
+        TTargetConverter ConvertTarget;
+        THolder<ILineDataReader> LineDataReader;
+    };
+
+    TDocDataProviderObjectFactory::TRegistrator<TLibSvmDataProvider> LibSvmDataProviderReg("libsvm");
+
+    }
+}
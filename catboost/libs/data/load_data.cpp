@@ -7,6 +7,7 @@
 #include <library/threading/local_executor/local_executor.h>
 
 #include <util/generic/hash.h>
+#include <util/string/cast.h>
 
 
 namespace NCB {
@@ -26,8 +27,14 @@ namespace NCB {
                    const TVector<int>& catFeatureIds) override {
             Cursor = NotSet;
             NextCursor = 0;
+            IsGrown = false;
             FeatureCount = poolMetaInfo.FeatureCount;
             BaselineCount = poolMetaInfo.BaselineCount;
+            // features which are not added are zero, so values left from the previous block are dropped,
+            // a new pool gets zeroed storage from Resize without extra passes
+            for (auto& factor : Pool->Docs.Factors) {
+                factor.clear();
+            }
             Pool->Docs.Resize(docCount,
                               FeatureCount,
                               BaselineCount,
@@ -40,6 +47,9 @@ namespace NCB {
         void StartNextBlock(ui32 blockSize) override {
             Cursor = NextCursor;
             NextCursor = Cursor + blockSize;
+            if (NextCursor > Pool->Docs.GetDocCount()) {
+                GrowDocs(NextCursor);
+            }
         }
 
         float GetCatFeatureValue(const TStringBuf& feature) override {
@@ -121,6 +131,9 @@ namespace NCB {
         }
 
         void Finish() override {
+            if (IsGrown) {
+                ShrinkDocsToFit();
+            }
             if (Pool->Docs.GetDocCount() != 0) {
                 for (const auto& part : HashMapParts) {
                     Pool->CatFeaturesHashToString.insert(part.CatFeatureHashes.begin(), part.CatFeatureHashes.end());
@@ -131,6 +144,50 @@ namespace NCB {
             }
         }
 
+    private:
+        // doc count passed to Start is zero when it is unknown in advance (e.g. for compressed files),
+        // vectors grow geometrically on resize, so the total cost of growth is linear in doc count
+        void GrowDocs(ui32 docCount) {
+            auto& docs = Pool->Docs;
+            const ui32 prevDocCount = docs.GetDocCount();
+            for (auto& factor : docs.Factors) {
+                factor.resize(docCount);
+            }
+            for (auto& baseline : docs.Baseline) {
+                baseline.resize(docCount);
+            }
+            docs.Target.resize(docCount);
+            docs.Weight.resize(docCount, 1.0f);
+            docs.Id.resize(docCount);
+            for (ui32 doc = prevDocCount; doc < docCount; ++doc) {
+                docs.Id[doc] = ToString(doc);
+            }
+            if (Pool->MetaInfo.HasGroupId) {
+                docs.QueryId.resize(docCount);
+            }
+            if (Pool->MetaInfo.HasSubgroupIds) {
+                docs.SubgroupId.resize(docCount);
+            }
+            docs.Timestamp.resize(docCount);
+            IsGrown = true;
+        }
+
+        void ShrinkDocsToFit() {
+            auto& docs = Pool->Docs;
+            for (auto& factor : docs.Factors) {
+                factor.shrink_to_fit();
+            }
+            for (auto& baseline : docs.Baseline) {
+                baseline.shrink_to_fit();
+            }
+            docs.Target.shrink_to_fit();
+            docs.Weight.shrink_to_fit();
+            docs.Id.shrink_to_fit();
+            docs.QueryId.shrink_to_fit();
+            docs.SubgroupId.shrink_to_fit();
+            docs.Timestamp.shrink_to_fit();
+        }
+
     private:
         struct THashPart {
             THashMap<int, TString> CatFeatureHashes;
@@ -141,6 +198,7 @@ namespace NCB {
         ui32 NextCursor = 0;
         ui32 FeatureCount = 0;
         ui32 BaselineCount = 0;
+        bool IsGrown = false;
         std::array<THashPart, CB_THREAD_LIMIT> HashMapParts;
         const NPar::TLocalExecutor& LocalExecutor;
     };
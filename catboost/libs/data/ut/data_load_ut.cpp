@@ -1,13 +1,16 @@
 #include <catboost/libs/data/load_data.h>
+#include <catboost/libs/data_util/compressed_stream.h>
 
 #include <library/threading/local_executor/local_executor.h>
 
 #include <library/unittest/registar.h>
 #include <library/threading/local_executor/local_executor.h>
 
+#include <util/generic/algorithm.h>
 #include <util/random/fast.h>
 #include <util/generic/guid.h>
 #include <util/stream/file.h>
+#include <util/string/cast.h>
 
 using namespace std;
 using namespace NCB;
@@ -58,4 +61,109 @@ Y_UNIT_TEST_SUITE(TDataLoadTest) {
             }
         }
     }
+
+    // doc count of compressed pools is not known before parsing, pool storage grows with blocks
+    Y_UNIT_TEST(TestCompressedFileRead) {
+        const size_t TestDocCount = 25000;
+        const TString TestFileName = "sample_pool.tsv.zst";
+        {
+            auto writer = OpenFileOutput(TestFileName);
+            for (size_t docIdx = 0; docIdx < TestDocCount; ++docIdx) {
+                *writer << docIdx % 2 << "\t" << docIdx << "\t" << docIdx * 0.5 << Endl;
+            }
+        }
+        TPool pool;
+        ReadPool(TPathWithScheme(TestFileName, "dsv"),
+                 TPathWithScheme(),
+                 NCatboostOptions::TDsvPoolFormatParams(),
+                 /*ignoredFeatures*/ {},
+                 2,
+                 false,
+                 TVector<TString>(),
+                 &pool);
+
+        UNIT_ASSERT_VALUES_EQUAL(pool.Docs.GetDocCount(), TestDocCount);
+        UNIT_ASSERT_VALUES_EQUAL(pool.Docs.GetEffectiveFactorCount(), 2);
+        UNIT_ASSERT_VALUES_EQUAL(pool.Docs.Weight.size(), TestDocCount);
+        for (size_t docIdx = 0; docIdx < TestDocCount; ++docIdx) {
+            UNIT_ASSERT_VALUES_EQUAL(pool.Docs.Target[docIdx], docIdx % 2);
+            UNIT_ASSERT_VALUES_EQUAL(pool.Docs.Factors[0][docIdx], docIdx);
+            UNIT_ASSERT_VALUES_EQUAL(pool.Docs.Factors[1][docIdx], docIdx * 0.5f);
+            UNIT_ASSERT_VALUES_EQUAL(pool.Docs.Weight[docIdx], 1.0f);
+            UNIT_ASSERT_VALUES_EQUAL(pool.Docs.Id[docIdx], ToString(docIdx));
+        }
+
+        const TString LibSvmFileName = "sample_pool.libsvm.lz4";
+        {
+            auto writer = OpenFileOutput(LibSvmFileName);
+            *writer << "1 1:0.5 3:2\n";
+            *writer << "0 2:-1.5\n";
+        }
+        TPool libSvmPool;
+        ReadPool(TPathWithScheme(LibSvmFileName, "libsvm"),
+                 TPathWithScheme(),
+                 NCatboostOptions::TDsvPoolFormatParams(),
+                 /*ignoredFeatures*/ {},
+                 2,
+                 false,
+                 TVector<TString>(),
+                 &libSvmPool);
+        const TVector<TVector<float>> expectedFactors = {{0.5, 0}, {0, -1.5}, {2, 0}};
+        UNIT_ASSERT_EQUAL(libSvmPool.Docs.Factors, expectedFactors);
+    }
+
+    Y_UNIT_TEST(TestLibSvmRead) {
+        TString TestFileName = "sample_pool.libsvm";
+        {
+            TOFStream writer(TestFileName);
+            writer << "1 qid:1 1:0.5 3:2\n";
+            writer << "0 qid:1 2:-1.5 # comment\n";
+            writer << "1 qid:2\n";
+        }
+        TPool pool;
+        ReadPool(TPathWithScheme(TestFileName, "libsvm"),
+                 TPathWithScheme(),
+                 NCatboostOptions::TDsvPoolFormatParams(),
+                 /*ignoredFeatures*/ {},
+                 2,
+                 false,
+                 TVector<TString>(),
+                 &pool);
+
+        UNIT_ASSERT_VALUES_EQUAL(pool.Docs.GetDocCount(), 3);
+        UNIT_ASSERT_VALUES_EQUAL(pool.Docs.GetEffectiveFactorCount(), 3);
+        const TVector<float> expectedTarget = {1, 0, 1};
+        const TVector<TVector<float>> expectedFactors = {{0.5, 0, 0}, {0, -1.5, 0}, {2, 0, 0}};
+        UNIT_ASSERT_EQUAL(pool.Docs.Target, expectedTarget);
+        UNIT_ASSERT_EQUAL(pool.Docs.Factors, expectedFactors);
+        UNIT_ASSERT_EQUAL(pool.Docs.QueryId[0], pool.Docs.QueryId[1]);
+        UNIT_ASSERT_UNEQUAL(pool.Docs.QueryId[0], pool.Docs.QueryId[2]);
+
+        TPool poolWithIgnoredFeature;
+        ReadPool(TPathWithScheme(TestFileName, "libsvm"),
+                 TPathWithScheme(),
+                 NCatboostOptions::TDsvPoolFormatParams(),
+                 /*ignoredFeatures*/ {2},
+                 2,
+                 false,
+                 TVector<TString>(),
+                 &poolWithIgnoredFeature);
+
+        const TVector<TVector<float>> expectedFactorsWithIgnoredFeature = {{0.5, 0, 0}, {0, -1.5, 0}, {0, 0, 0}};
+        UNIT_ASSERT_EQUAL(poolWithIgnoredFeature.Docs.Factors, expectedFactorsWithIgnoredFeature);
+
+        // absent features are zero when the pool storage is reused
+        for (auto& factor : pool.Docs.Factors) {
+            Fill(factor.begin(), factor.end(), 7.0f);
+        }
+        ReadPool(TPathWithScheme(TestFileName, "libsvm"),
+                 TPathWithScheme(),
+                 NCatboostOptions::TDsvPoolFormatParams(),
+                 /*ignoredFeatures*/ {},
+                 2,
+                 false,
+                 TVector<TString>(),
+                 &pool);
+        UNIT_ASSERT_EQUAL(pool.Docs.Factors, expectedFactors);
+    }
 }
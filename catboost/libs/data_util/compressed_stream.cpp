@@ -0,0 +1,140 @@
+#include "compressed_stream.h"
+
+#include <catboost/libs/helpers/exception.h>
+
+#include <library/blockcodecs/codecs.h>
+#include <library/blockcodecs/stream.h>
+
+#include <util/stream/buffered.h>
+#include <util/stream/file.h>
+#include <util/stream/zlib.h>
+
+
+namespace NCB {
+
+    EFileCompression GetFileCompression(TStringBuf path) {
+        if (path.EndsWith(".gz")) {
+            return EFileCompression::GZip;
+        }
+        if (path.EndsWith(".zst")) {
+            return EFileCompression::Zstd;
+        }
+        if (path.EndsWith(".lz4")) {
+            return EFileCompression::Lz4;
+        }
+        return EFileCompression::None;
+    }
+
+
+    namespace {
+
+    // owns both the file and the codec stream on top of it
+    class TCompressedFileInput : public IInputStream {
+    public:
+        TCompressedFileInput(const TString& path, EFileCompression compression)
+            : File(path)
+        {
+            switch (compression) {
+                case EFileCompression::GZip:
+                    Decompress = MakeHolder<TZLibDecompress>(&File, ZLib::GZip);
+                    break;
+                case EFileCompression::Zstd:
+                case EFileCompression::Lz4:
+                    // codec is stored in every block header
+                    Decompress = MakeHolder<NBlockCodecs::TDecodedInput>(&File);
+                    break;
+                default:
+                    Y_UNREACHABLE();
+            }
+            Buffered = MakeHolder<TBufferedInput>(Decompress.Get(), 1 << 20);
+        }
+
+    private:
+        size_t DoRead(void* buf, size_t len) override {
+            return Buffered->Read(buf, len);
+        }
+
+        // ReadLine is byte-by-byte for unbuffered streams
+        size_t DoReadTo(TString& st, char ch) override {
+            return Buffered->ReadTo(st, ch);
+        }
+
+    private:
+        TIFStream File;
+        THolder<IInputStream> Decompress;
+        THolder<TBufferedInput> Buffered;
+    };
+
+
+    class TCompressedFileOutput : public IOutputStream {
+    public:
+        TCompressedFileOutput(const TString& path, EFileCompression compression)
+            : File(path)
+        {
+            switch (compression) {
+                case EFileCompression::GZip:
+                    Compress = MakeHolder<TZLibCompress>(&File, ZLib::GZip);
+                    break;
+                case EFileCompression::Zstd:
+                    Compress = MakeHolder<NBlockCodecs::TCodedOutput>(&File, NBlockCodecs::Codec("zstd08_3"), CodecBlockSize);
+                    break;
+                case EFileCompression::Lz4:
+                    Compress = MakeHolder<NBlockCodecs::TCodedOutput>(&File, NBlockCodecs::Codec("lz4"), CodecBlockSize);
+                    break;
+                default:
+                    Y_UNREACHABLE();
+            }
+        }
+
+        ~TCompressedFileOutput() override {
+            try {
+                Finish();
+            } catch (...) {
+            }
+        }
+
+    private:
+        void DoWrite(const void* buf, size_t len) override {
+            Compress->Write(buf, len);
+        }
+
+        void DoFlush() override {
+            Compress->Flush();
+        }
+
+        void DoFinish() override {
+            if (!IsFinished) {
+                IsFinished = true;
+                Compress->Finish();
+                File.Finish();
+            }
+        }
+
+    private:
+        static constexpr size_t CodecBlockSize = 1 << 20;
+
+        TOFStream File;
+        THolder<IOutputStream> Compress;
+        bool IsFinished = false;
+    };
+
+    }
+
+
+    THolder<IInputStream> OpenFileInput(const TString& path) {
+        const EFileCompression compression = GetFileCompression(path);
+        if (compression == EFileCompression::None) {
+            return MakeHolder<TIFStream>(path);
+        }
+        return MakeHolder<TCompressedFileInput>(path, compression);
+    }
+
+    THolder<IOutputStream> OpenFileOutput(const TString& path) {
+        const EFileCompression compression = GetFileCompression(path);
+        if (compression == EFileCompression::None) {
+            return MakeHolder<TOFStream>(path);
+        }
+        return MakeHolder<TCompressedFileOutput>(path, compression);
+    }
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <util/generic/ptr.h>
+#include <util/generic/strbuf.h>
+#include <util/generic/string.h>
+#include <util/stream/input.h>
+#include <util/stream/output.h>
+
+
+namespace NCB {
+
+    enum class EFileCompression {
+        None,
+        GZip, // .gz
+        Zstd, // .zst, library/blockcodecs stream, not readable by the zstd command line tool
+        Lz4   // .lz4, library/blockcodecs stream, not readable by the lz4 command line tool
+    };
+
+    // detected by file name extension
+    EFileCompression GetFileCompression(TStringBuf path);
+
+    /* Open local file for reading or writing,
+     * data is transparently (de)compressed if path has an extension of a known compression format
+     */
+    THolder<IInputStream> OpenFileInput(const TString& path);
+    THolder<IOutputStream> OpenFileOutput(const TString& path);
+
+}
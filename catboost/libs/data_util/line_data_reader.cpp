@@ -1,57 +1,145 @@
 #include "line_data_reader.h"
 
+#include "compressed_stream.h"
+
 #include <catboost/libs/helpers/exception.h>
 
-#include <util/stream/file.h>
+#include <util/generic/buffer.h>
+#include <util/system/filemap.h>
 #include <util/system/fs.h>
 
+#include <algorithm>
+#include <cstring>
 
-namespace NCB {
-
-    THolder<ILineDataReader> GetLineDataReader(const TPathWithScheme& pathWithScheme,
-                                               const TDsvFormatOptions& format)
-    {
-        return GetProcessor<ILineDataReader, TLineDataReaderArgs>(
-            pathWithScheme, TLineDataReaderArgs{pathWithScheme, format}
-        );
-    }
 
+namespace NCB {
 
     namespace {
 
-    template <class TStr>
-    inline int CountLines(const TStr& poolFile) {
-        CB_ENSURE(NFs::Exists(TString(poolFile)), "pool file '" << TString(poolFile) << "' is not found");
-        TIFStream reader(poolFile.c_str());
-        size_t count = 0;
-        TString buffer;
-        while (reader.ReadLine(buffer)) {
-            ++count;
-        }
-        return count;
+    const TString& CheckedFilePath(const TString& path) {
+        CB_ENSURE(NFs::Exists(path), "pool file '" << path << "' is not found");
+        return path;
     }
 
+
+    /* Maps the whole file into memory: lines are located with memchr and counted without copying,
+     * so GetDataLineCount does not allocate a string per line and the following reading pass is served
+     * from the page cache.
+     */
     class TFileLineDataReader : public ILineDataReader {
     public:
         TFileLineDataReader(const TLineDataReaderArgs& args)
             : Args(args)
-            , IFStream(args.PathWithScheme.Path)
+            , FileMap(CheckedFilePath(args.PathWithScheme.Path))
             , HeaderProcessed(!Args.Format.HasHeader)
-        {}
+        {
+            if (FileMap.Length() > 0) {
+                FileMap.Map(0, FileMap.Length());
+                FileMap.SetSequential();
+                Data = static_cast<const char*>(FileMap.Ptr());
+                Size = FileMap.MappedSize();
+            }
+        }
 
         ui64 GetDataLineCount() override {
-            ui64 nLines = (ui64)CountLines(Args.PathWithScheme.Path);
-            if (Args.Format.HasHeader) {
-                --nLines;
+            if (!LineCount.Defined()) {
+                ui64 nLines = std::count(Data, Data + Size, '\n');
+                if (Size > 0 && Data[Size - 1] != '\n') {
+                    ++nLines; // last line without line break
+                }
+                LineCount = nLines;
             }
-            return nLines;
+            return Args.Format.HasHeader ? *LineCount - 1 : *LineCount;
         }
 
         TMaybe<TString> GetHeader() override {
             if (Args.Format.HasHeader) {
                 CB_ENSURE(!HeaderProcessed, "TFileLineDataReader: multiple calls to GetHeader");
                 TString header;
-                CB_ENSURE(IFStream.ReadLine(header), "TFileLineDataReader: no header in file");
+                CB_ENSURE(NextLine(&header), "TFileLineDataReader: no header in file");
+                HeaderProcessed = true;
+                return header;
+            }
+
+            return {};
+        }
+
+        bool ReadLine(TString* line) override {
+            // skip header if it hasn't been read
+            if (!HeaderProcessed) {
+                GetHeader();
+            }
+            return NextLine(line);
+        }
+
+    private:
+        // same semantics as IInputStream::ReadLine: line breaks are '\n' or "\r\n"
+        bool NextLine(TString* line) {
+            if (Position >= Size) {
+                return false;
+            }
+            const char* lineBegin = Data + Position;
+            const char* lineEnd = static_cast<const char*>(memchr(lineBegin, '\n', Size - Position));
+            if (lineEnd == nullptr) {
+                lineEnd = Data + Size;
+                Position = Size;
+            } else {
+                Position = lineEnd - Data + 1;
+            }
+            if (lineEnd != lineBegin && *(lineEnd - 1) == '\r') {
+                --lineEnd;
+            }
+            line->assign(lineBegin, lineEnd - lineBegin);
+            return true;
+        }
+
+    private:
+        TLineDataReaderArgs Args;
+        TFileMap FileMap;
+        const char* Data = nullptr;
+        size_t Size = 0;
+        size_t Position = 0;
+        TMaybe<ui64> LineCount;
+        bool HeaderProcessed;
+    };
+
+
+    // Reads through a decompressing stream, line count costs an additional decompression pass
+    class TCompressedFileLineDataReader : public ILineDataReader {
+    public:
+        TCompressedFileLineDataReader(const TLineDataReaderArgs& args)
+            : Args(args)
+            , Input(OpenFileInput(CheckedFilePath(args.PathWithScheme.Path)))
+            , HeaderProcessed(!Args.Format.HasHeader)
+        {}
+
+        ui64 GetDataLineCount() override {
+            if (!LineCount.Defined()) {
+                auto input = OpenFileInput(Args.PathWithScheme.Path);
+                TBuffer buffer(1 << 20);
+                ui64 nLines = 0;
+                char lastChar = '\n';
+                while (const size_t readSize = input->Read(buffer.Data(), buffer.Capacity())) {
+                    nLines += std::count(buffer.Data(), buffer.Data() + readSize, '\n');
+                    lastChar = buffer.Data()[readSize - 1];
+                }
+                if (lastChar != '\n') {
+                    ++nLines; // last line without line break
+                }
+                LineCount = nLines;
+            }
+            return Args.Format.HasHeader ? *LineCount - 1 : *LineCount;
+        }
+
+        bool HasCheapDataLineCount() const override {
+            return false;
+        }
+
+        TMaybe<TString> GetHeader() override {
+            if (Args.Format.HasHeader) {
+                CB_ENSURE(!HeaderProcessed, "TCompressedFileLineDataReader: multiple calls to GetHeader");
+                TString header;
+                CB_ENSURE(Input->ReadLine(header), "TCompressedFileLineDataReader: no header in file");
                 HeaderProcessed = true;
                 return header;
             }
@@ -64,19 +152,39 @@ namespace NCB {
             if (!HeaderProcessed) {
                 GetHeader();
             }
-            return IFStream.ReadLine(*line) != 0;
+            return Input->ReadLine(*line) != 0;
         }
 
     private:
         TLineDataReaderArgs Args;
-        TIFStream IFStream;
+        THolder<IInputStream> Input;
+        TMaybe<ui64> LineCount;
         bool HeaderProcessed;
     };
 
 
+    bool IsLocalFileScheme(TStringBuf scheme) {
+        return scheme.empty() || scheme == "file" || scheme == "dsv" || scheme == "libsvm";
+    }
+
+
     TLineDataReaderFactory::TRegistrator<TFileLineDataReader> DefLineDataReaderReg("");
     TLineDataReaderFactory::TRegistrator<TFileLineDataReader> FileLineDataReaderReg("file");
     TLineDataReaderFactory::TRegistrator<TFileLineDataReader> DsvLineDataReaderReg("dsv");
+    TLineDataReaderFactory::TRegistrator<TFileLineDataReader> LibSvmLineDataReaderReg("libsvm");
+
+    }
 
+
+    THolder<ILineDataReader> GetLineDataReader(const TPathWithScheme& pathWithScheme,
+                                               const TDsvFormatOptions& format)
+    {
+        // compression is detected by file extension for local files
+        if (IsLocalFileScheme(pathWithScheme.Scheme) && GetFileCompression(pathWithScheme.Path) != EFileCompression::None) {
+            return MakeHolder<TCompressedFileLineDataReader>(TLineDataReaderArgs{pathWithScheme, format});
+        }
+        return GetProcessor<ILineDataReader, TLineDataReaderArgs>(
+            pathWithScheme, TLineDataReaderArgs{pathWithScheme, format}
+        );
     }
 }
@@ -28,6 +28,13 @@ namespace NCB {
         */
         virtual ui64 GetDataLineCount() = 0;
 
+        /* false if GetDataLineCount needs an extra pass over the data (e.g. for compressed files),
+           readers which need the count only to preallocate storage should not call it then
+        */
+        virtual bool HasCheapDataLineCount() const {
+            return true;
+        }
+
         /* call before any calls to NextLine if you need it
            it is an error to call GetHeader after any ReadLine calls
         */
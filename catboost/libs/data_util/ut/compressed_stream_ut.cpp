@@ -0,0 +1,44 @@
+#include <library/unittest/registar.h>
+
+#include <catboost/libs/data_util/compressed_stream.h>
+#include <catboost/libs/data_util/line_data_reader.h>
+
+#include <util/string/builder.h>
+
+
+using namespace NCB;
+
+
+Y_UNIT_TEST_SUITE(TCompressedStreamTest) {
+    Y_UNIT_TEST(TestGetFileCompression) {
+        UNIT_ASSERT_EQUAL(GetFileCompression("pool.tsv"), EFileCompression::None);
+        UNIT_ASSERT_EQUAL(GetFileCompression("pool.tsv.gz"), EFileCompression::GZip);
+        UNIT_ASSERT_EQUAL(GetFileCompression("pool.tsv.zst"), EFileCompression::Zstd);
+        UNIT_ASSERT_EQUAL(GetFileCompression("pool.tsv.lz4"), EFileCompression::Lz4);
+    }
+
+    Y_UNIT_TEST(TestReadWrite) {
+        TStringBuilder data;
+        for (int i = 0; i < 100000; ++i) {
+            data << i << "\t" << i * 0.5 << "\n";
+        }
+        data << "last line without line break";
+
+        for (const TString fileName : {"compressed_ut.tsv", "compressed_ut.tsv.gz", "compressed_ut.tsv.zst", "compressed_ut.tsv.lz4"}) {
+            {
+                auto output = OpenFileOutput(fileName);
+                output->Write(data.data(), data.size() / 2);
+                output->Flush();
+                output->Write(data.data() + data.size() / 2, data.size() - data.size() / 2);
+            }
+            UNIT_ASSERT_VALUES_EQUAL(OpenFileInput(fileName)->ReadAll(), data);
+
+            auto reader = GetLineDataReader(TPathWithScheme(fileName, "dsv"));
+            UNIT_ASSERT_EQUAL(reader->HasCheapDataLineCount(), GetFileCompression(fileName) == EFileCompression::None);
+            UNIT_ASSERT_VALUES_EQUAL(reader->GetDataLineCount(), 100001);
+            TString line;
+            UNIT_ASSERT(reader->ReadLine(&line));
+            UNIT_ASSERT_VALUES_EQUAL(line, "0\t0");
+        }
+    }
+}
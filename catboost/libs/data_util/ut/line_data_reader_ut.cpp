@@ -0,0 +1,67 @@
+#include <library/unittest/registar.h>
+
+#include <catboost/libs/data_util/line_data_reader.h>
+
+#include <util/stream/file.h>
+
+
+using namespace NCB;
+
+
+static void WriteFile(const TString& fileName, TStringBuf data) {
+    TOFStream out(fileName);
+    out << data;
+}
+
+static TVector<TString> ReadAllLines(ILineDataReader* reader) {
+    TVector<TString> lines;
+    TString line;
+    while (reader->ReadLine(&line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+Y_UNIT_TEST_SUITE(TLineDataReaderTest) {
+    Y_UNIT_TEST(TestReadLines) {
+        const TString fileName = "line_data_reader_ut.tsv";
+        WriteFile(fileName, "a\t1\r\nb\t2\n\nc\t3");
+
+        auto reader = GetLineDataReader(TPathWithScheme(fileName, "dsv"));
+        UNIT_ASSERT_VALUES_EQUAL(reader->GetDataLineCount(), 4);
+        UNIT_ASSERT(!reader->GetHeader().Defined());
+        const TVector<TString> expectedLines = {"a\t1", "b\t2", "", "c\t3"};
+        UNIT_ASSERT_EQUAL(ReadAllLines(reader.Get()), expectedLines);
+    }
+
+    Y_UNIT_TEST(TestReadHeader) {
+        const TString fileName = "line_data_reader_header_ut.tsv";
+        WriteFile(fileName, "x\ty\n1\t2\n3\t4\n");
+
+        TDsvFormatOptions format;
+        format.HasHeader = true;
+        {
+            auto reader = GetLineDataReader(TPathWithScheme(fileName, "dsv"), format);
+            UNIT_ASSERT_VALUES_EQUAL(reader->GetDataLineCount(), 2);
+            UNIT_ASSERT_VALUES_EQUAL(*reader->GetHeader(), "x\ty");
+            const TVector<TString> expectedLines = {"1\t2", "3\t4"};
+            UNIT_ASSERT_EQUAL(ReadAllLines(reader.Get()), expectedLines);
+        }
+        {
+            // header is skipped if not requested
+            auto reader = GetLineDataReader(TPathWithScheme(fileName, "dsv"), format);
+            const TVector<TString> expectedLines = {"1\t2", "3\t4"};
+            UNIT_ASSERT_EQUAL(ReadAllLines(reader.Get()), expectedLines);
+        }
+    }
+
+    Y_UNIT_TEST(TestEmptyFile) {
+        const TString fileName = "line_data_reader_empty_ut.tsv";
+        WriteFile(fileName, "");
+
+        auto reader = GetLineDataReader(TPathWithScheme(fileName, "dsv"));
+        UNIT_ASSERT_VALUES_EQUAL(reader->GetDataLineCount(), 0);
+        TString line;
+        UNIT_ASSERT(!reader->ReadLine(&line));
+    }
+}
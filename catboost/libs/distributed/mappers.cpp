@@ -26,7 +26,7 @@ void TPlainFoldBuilder::DoMap(NPar::IUserContext* ctx, int hostId, TInput* /*unu
         *localData.Rand);
     Y_ASSERT(plainFold.BodyTailArr.ysize() == 1);
     const bool isPairwiseScoring = IsPairwiseScoring(localData.Params.LossFunctionDescription->GetLossFunction());
-    localData.SampledDocs.Create({plainFold}, isPairwiseScoring, GetBernoulliSampleRate(localData.Params.ObliviousTreeOptions->BootstrapConfig));
+    localData.SampledDocs.Create({plainFold}, isPairwiseScoring, GetSampleRate(localData.Params.ObliviousTreeOptions->BootstrapConfig));
     localData.SmallestSplitSideDocs.Create({plainFold}, isPairwiseScoring);
     localData.PrevTreeLevelStats.Create({plainFold},
         CountNonCtrBuckets(trainData->SplitCounts, trainData->TrainData.AllFeatures.OneHotValues),
@@ -183,6 +183,7 @@ void TBucketSimpleUpdater<TError>::DoMap(NPar::IUserContext* /*ctx*/, int /*host
         localData.Params,
         localData.Rand->GenRand(),
         &NPar::LocalExecutor(),
+        /*scratch*/ nullptr,
         &localData.Buckets,
         /*pairwiseBuckets=*/nullptr,
         &weightedDers);
@@ -19,7 +19,7 @@ static void CalcStatsImpl(const TIsCaching& isCaching,
         for (int dim = 0; dim < approxDimension; ++dim) {
             TBucketStats* stats = splitStats + (bodyTailIdx * approxDimension + dim) * splitStatsCount;
             const bool isPlainMode = true;
-            CalcStatsKernel(isCaching, singleIdx, fold, isPlainMode, indexer, depth, bt, dim, stats);
+            CalcStatsKernel(isCaching, singleIdx, fold, isPlainMode, indexer, depth, bt, dim, /*partialStats*/ stats, stats);
         }
     }
 }
@@ -43,15 +43,15 @@ TStats3D CalcStats3D(const TAllFeatures& af,
         if (bucketIndexBits <= 8) {
             TVector<ui8> singleIdx;
             BuildSingleIndex(fold, af, allCtrs, split, indexer, &singleIdx);
-            CalcStatsImpl(isCaching, singleIdx, fold, indexer, depth, splitStatsCount, GetDataPtr(*splitStats));
+            CalcStatsImpl(isCaching, singleIdx, fold, indexer, depth, splitStatsCount, splitStats);
         } else if (bucketIndexBits <= 16) {
             TVector<ui16> singleIdx;
             BuildSingleIndex(fold, af, allCtrs, split, indexer, &singleIdx);
-            CalcStatsImpl(isCaching, singleIdx, fold, indexer, depth, splitStatsCount, GetDataPtr(*splitStats));
+            CalcStatsImpl(isCaching, singleIdx, fold, indexer, depth, splitStatsCount, splitStats);
         } else if (bucketIndexBits <= 32) {
             TVector<ui32> singleIdx;
             BuildSingleIndex(fold, af, allCtrs, split, indexer, &singleIdx);
-            CalcStatsImpl(isCaching, singleIdx, fold, indexer, depth, splitStatsCount, GetDataPtr(*splitStats));
+            CalcStatsImpl(isCaching, singleIdx, fold, indexer, depth, splitStatsCount, splitStats);
         } else {
             CB_ENSURE(false, "too deep or too much splitsCount for score calculation");
         }
@@ -62,19 +62,19 @@ TStats3D CalcStats3D(const TAllFeatures& af,
         const int splitStatsCount = indexer.CalcSize(depth);
         const int statsCount = fold.GetBodyTailCount() * fold.GetApproxDimension() * splitStatsCount;
         scratchSplitStats.yresize(statsCount);
-        SelectCalcStatsImpl(/*isCaching*/ std::false_type(), fold, splitStatsCount, &scratchSplitStats);
+        SelectCalcStatsImpl(/*isCaching*/ std::false_type(), fold, splitStatsCount, GetDataPtr(scratchSplitStats));
         return TStats3D(scratchSplitStats, bucketCount, 1U << depth);
     } else {
         const int splitStatsCount = indexer.CalcSize(treeOptions.MaxDepth);
         const int statsCount = fold.GetBodyTailCount() * fold.GetApproxDimension() * splitStatsCount;
         bool areStatsDirty;
-        TVector<TBucketStats, TPoolAllocator>& splitStats = statsFromPrevTree->GetStats(split, statsCount, &areStatsDirty); // thread-safe access
+        TBucketStats* splitStats = statsFromPrevTree->GetStats<TBucketStats>(split, statsCount, &areStatsDirty); // thread-safe access
         if (depth == 0 || areStatsDirty) {
-            SelectCalcStatsImpl(/*isCaching*/ std::false_type(), fold, splitStatsCount, &splitStats);
+            SelectCalcStatsImpl(/*isCaching*/ std::false_type(), fold, splitStatsCount, splitStats);
         } else {
-            SelectCalcStatsImpl(/*isCaching*/ std::true_type(), prevLevelData, splitStatsCount, &splitStats);
+            SelectCalcStatsImpl(/*isCaching*/ std::true_type(), prevLevelData, splitStatsCount, splitStats);
         }
-        return TStats3D(TVector<TBucketStats>(splitStats.begin(), splitStats.end()), bucketCount, 1U << treeOptions.MaxDepth);
+        return TStats3D(TVector<TBucketStats>(splitStats, splitStats + statsCount), bucketCount, 1U << treeOptions.MaxDepth);
     }
     CB_ENSURE(false, "too deep or too much splitsCount for score calculation");
 }
@@ -1,8 +1,12 @@
 #include "docs_importance.h"
 #include "enums.h"
 
+#include <library/threading/local_executor/local_executor.h>
+
 #include <util/generic/ymath.h>
 
+#include <algorithm>
+
 static TUpdateMethod ParseUpdateMethod(const TString& updateMethod) {
     TString errorMessage = "Incorrect update-method param value. Should be one of: SinglePoint, \
         TopKLeaves, AllPoints or TopKLeaves:top=2 to set the top size in TopKLeaves method.";
@@ -20,71 +24,112 @@ static TUpdateMethod ParseUpdateMethod(const TString& updateMethod) {
     return TUpdateMethod(updateType, topSize);
 }
 
+static bool IsMatchingSign(double value, EImportanceValuesSign importanceValuesSign) {
+    if (importanceValuesSign == EImportanceValuesSign::Positive) {
+        return value > 0;
+    } else if (importanceValuesSign == EImportanceValuesSign::Negative) {
+        return value < 0;
+    }
+    Y_ASSERT(importanceValuesSign == EImportanceValuesSign::All);
+    return true;
+}
+
+using TImportanceWithIndex = std::pair<double, ui32>;
+
+// Larger absolute importance goes first, ties are resolved by train doc index.
+static bool IsMoreImportant(const TImportanceWithIndex& first, const TImportanceWithIndex& second) {
+    return Abs(first.first) > Abs(second.first) || (Abs(first.first) == Abs(second.first) && first.second < second.second);
+}
+
+// The top is chosen before the filtration by sign, so less than topSize values may be returned.
+static void AddMatchingImportances(
+    const TVector<TImportanceWithIndex>& orderedImportances,
+    int topSize,
+    EImportanceValuesSign importanceValuesSign,
+    TVector<double>* scores,
+    TVector<ui32>* indices
+) {
+    const ui32 size = Min<ui32>(topSize, orderedImportances.size());
+    for (ui32 i = 0; i < size; ++i) {
+        if (IsMatchingSign(orderedImportances[i].first, importanceValuesSign)) {
+            scores->push_back(orderedImportances[i].first);
+            indices->push_back(orderedImportances[i].second);
+        }
+    }
+}
+
+// Keeps topSize most important train docs per test doc, so memory doesn't depend on the train doc count.
 static TDStrResult GetFinalDocumentImportances(
-    const TVector<TVector<double>>& rawImportances,
+    TDocumentImportancesEvaluator* evaluator,
+    const TPool& testPool,
+    ui32 trainDocCount,
     EDocumentStrengthType docImpMethod,
     int topSize,
-    EImportanceValuesSign importanceValuesSign
+    EImportanceValuesSign importanceValuesSign,
+    int threadCount
 ) {
-    const ui32 trainDocCount = rawImportances.size();
-    Y_ASSERT(rawImportances.size() != 0);
-    const ui32 testDocCount = rawImportances[0].size();
-    TVector<TVector<double>> preprocessedImportances;
+    const ui32 testDocCount = testPool.Docs.GetDocCount();
+    NPar::TLocalExecutor localExecutor;
+    localExecutor.RunAdditionalThreads(threadCount - 1);
+
     if (docImpMethod == EDocumentStrengthType::Average) {
-        preprocessedImportances = TVector<TVector<double>>(1, TVector<double>(trainDocCount));
-        for (ui32 trainDocId = 0; trainDocId < trainDocCount; ++trainDocId) {
-            for (ui32 testDocId = 0; testDocId < testDocCount; ++testDocId) {
-                preprocessedImportances[0][trainDocId] += rawImportances[trainDocId][testDocId];
+        TVector<double> importanceSums(trainDocCount);
+        evaluator->GetDocumentImportances(testPool, [&] (ui32 trainDocBegin, const TVector<TVector<double>>& importances) {
+            for (ui32 i = 0; i < importances.size(); ++i) {
+                for (double importance : importances[i]) {
+                    importanceSums[trainDocBegin + i] += importance;
+                }
             }
-        }
-        for (ui32 trainDocId = 0; trainDocId < trainDocCount; ++trainDocId) {
-            preprocessedImportances[0][trainDocId] /= testDocCount;
-        }
+        });
 
-    } else {
-        Y_ASSERT(docImpMethod == EDocumentStrengthType::PerObject || docImpMethod == EDocumentStrengthType::Raw);
-        preprocessedImportances = TVector<TVector<double>>(testDocCount, TVector<double>(trainDocCount));
+        TVector<TImportanceWithIndex> orderedImportances(trainDocCount);
         for (ui32 trainDocId = 0; trainDocId < trainDocCount; ++trainDocId) {
-            for (ui32 testDocId = 0; testDocId < testDocCount; ++testDocId) {
-                preprocessedImportances[testDocId][trainDocId] = rawImportances[trainDocId][testDocId];
-            }
+            orderedImportances[trainDocId] = {importanceSums[trainDocId] / testDocCount, trainDocId};
         }
-    }
+        Sort(orderedImportances.begin(), orderedImportances.end(), IsMoreImportant);
 
-    TDStrResult result(preprocessedImportances.size());
-    for (ui32 testDocId = 0; testDocId < preprocessedImportances.size(); ++testDocId) {
-        TVector<double>& preprocessedImportancesRef = preprocessedImportances[testDocId];
-
-        const ui32 docCount = preprocessedImportancesRef.size();
-        TVector<ui32> indices(docCount);
-        std::iota(indices.begin(), indices.end(), 0);
-        if (docImpMethod != EDocumentStrengthType::Raw) {
-            Sort(indices.begin(), indices.end(), [&](ui32 first, ui32 second) {
-                return Abs(preprocessedImportancesRef[first]) > Abs(preprocessedImportancesRef[second]);
-            });
-        }
+        TDStrResult result(1);
+        AddMatchingImportances(orderedImportances, topSize, importanceValuesSign, &result.Scores[0], &result.Indices[0]);
+        return result;
+    }
 
-        std::function<bool(double)> predicate;
-        if (importanceValuesSign == EImportanceValuesSign::Positive) {
-            predicate = [](double v){return v > 0;};
-        } else if (importanceValuesSign == EImportanceValuesSign::Negative) {
-            predicate = [](double v){return v < 0;};
-        } else {
-            Y_ASSERT(importanceValuesSign == EImportanceValuesSign::All);
-            predicate = [](double){return true;};
+    Y_ASSERT(docImpMethod == EDocumentStrengthType::PerObject || docImpMethod == EDocumentStrengthType::Raw);
+    // For Raw method the top consists of the first train docs, otherwise the heap of every test doc has the least important doc on its top.
+    TVector<TVector<TImportanceWithIndex>> topImportances(testDocCount); // [testDocCount][Min(TopSize, TrainDocCount)]
+    const ui32 heapSize = Min<ui32>(topSize, trainDocCount);
+    evaluator->GetDocumentImportances(testPool, [&] (ui32 trainDocBegin, const TVector<TVector<double>>& importances) {
+        const ui32 blockSize = importances.size();
+        if (heapSize == 0 || (docImpMethod == EDocumentStrengthType::Raw && trainDocBegin >= heapSize)) {
+            return;
         }
-
-        int currentSize = 0;
-        for (ui32 i = 0; i < docCount; ++i) {
-            if (currentSize == topSize) {
-                break;
-            }
-            if (predicate(preprocessedImportancesRef[indices[i]])) {
-                result.Scores[testDocId].push_back(preprocessedImportancesRef[indices[i]]);
-                result.Indices[testDocId].push_back(indices[i]);
+        NPar::ParallelFor(localExecutor, 0, testDocCount, [&] (int testDocId) {
+            TVector<TImportanceWithIndex>& heap = topImportances[testDocId];
+            for (ui32 i = 0; i < blockSize; ++i) {
+                const TImportanceWithIndex candidate(importances[i][testDocId], trainDocBegin + i);
+                if (heap.size() < heapSize) {
+                    heap.push_back(candidate);
+                    if (docImpMethod != EDocumentStrengthType::Raw) {
+                        std::push_heap(heap.begin(), heap.end(), IsMoreImportant);
+                    }
+                } else if (docImpMethod == EDocumentStrengthType::Raw) {
+                    break;
+                } else if (IsMoreImportant(candidate, heap.front())) {
+                    std::pop_heap(heap.begin(), heap.end(), IsMoreImportant);
+                    heap.back() = candidate;
+                    std::push_heap(heap.begin(), heap.end(), IsMoreImportant);
+                }
             }
-            ++currentSize;
+        });
+    });
+
+    TDStrResult result(testDocCount);
+    for (ui32 testDocId = 0; testDocId < testDocCount; ++testDocId) {
+        TVector<TImportanceWithIndex>& heap = topImportances[testDocId];
+        if (docImpMethod != EDocumentStrengthType::Raw) {
+            std::sort_heap(heap.begin(), heap.end(), IsMoreImportant);
         }
+        AddMatchingImportances(heap, topSize, importanceValuesSign, &result.Scores[testDocId], &result.Indices[testDocId]);
+        TVector<TImportanceWithIndex>().swap(heap);
     }
     return result;
 }
@@ -109,7 +154,14 @@ TDStrResult GetDocumentImportances(
     EDocumentStrengthType dstrType = FromString<EDocumentStrengthType>(dstrTypeStr);
     EImportanceValuesSign importanceValuesSign = FromString<EImportanceValuesSign>(importanceValuesSignStr);
     TDocumentImportancesEvaluator leafInfluenceEvaluator(model, trainPool, updateMethod, threadCount);
-    const TVector<TVector<double>> documentImportances = leafInfluenceEvaluator.GetDocumentImportances(testPool);
-    return GetFinalDocumentImportances(documentImportances, dstrType, topSize, importanceValuesSign);
+    return GetFinalDocumentImportances(
+        &leafInfluenceEvaluator,
+        testPool,
+        trainPool.Docs.GetDocCount(),
+        dstrType,
+        topSize,
+        importanceValuesSign,
+        threadCount
+    );
 }
 
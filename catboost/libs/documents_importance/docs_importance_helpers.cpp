@@ -3,26 +3,72 @@
 
 #include <catboost/libs/algo/index_calcer.h>
 
-TVector<TVector<double>> TDocumentImportancesEvaluator::GetDocumentImportances(const TPool& pool) {
+// Upper bound on the number of importances of one block of train documents.
+static const ui64 MaxImportancesBlockSize = 1 << 24;
+
+void TDocumentImportancesEvaluator::GetDocumentImportances(const TPool& pool, const TDocumentImportancesConsumer& consumer) {
     NPar::TLocalExecutor localExecutor;
     localExecutor.RunAdditionalThreads(ThreadCount - 1);
 
-    TVector<TVector<ui32>> leafIndices(TreeCount);
-    const TVector<ui8> binarizedFeatures = BinarizeFeatures(Model, pool);
-    localExecutor.ExecRange([&] (int treeId) {
-        leafIndices[treeId] = BuildIndicesForBinTree(Model, binarizedFeatures, treeId);
-    }, NPar::TLocalExecutor::TExecRangeParams(0, TreeCount), NPar::TLocalExecutor::WAIT_COMPLETE);
+    TVector<TVector<ui32>> leafIndices = BuildIndicesForBinTrees(Model, pool, &localExecutor);
 
     UpdateFinalFirstDerivatives(leafIndices, pool);
-    TVector<TVector<double>> documentImportances(DocCount, TVector<double>(pool.Docs.GetDocCount()));
-
-    localExecutor.ExecRange([&] (int docId) {
-        // The derivative of leaf values with respect to train doc weight.
-        TVector<TVector<TVector<double>>> leafDerivatives(TreeCount, TVector<TVector<double>>(LeavesEstimationIterations)); // [treeCount][LeavesEstimationIterationsCount][leafCount]
-        UpdateLeavesDerivatives(docId, &leafDerivatives);
-        GetDocumentImportancesForOneTrainDoc(leafDerivatives, leafIndices, &documentImportances[docId]);
-    }, NPar::TLocalExecutor::TExecRangeParams(0, DocCount), NPar::TLocalExecutor::WAIT_COMPLETE);
-    return documentImportances;
+
+    const auto& treeSizes = Model.ObliviousTrees.TreeSizes;
+    const bool fitsInByte = AllOf(treeSizes.begin(), treeSizes.end(), [](int treeSize) { return treeSize <= 8; });
+    if (fitsInByte) {
+        // Test leaf indices are read for every train doc, so keep them compact.
+        TVector<TVector<ui8>> compactLeafIndices(leafIndices.size());
+        for (ui32 treeId = 0; treeId < leafIndices.size(); ++treeId) {
+            compactLeafIndices[treeId].assign(leafIndices[treeId].begin(), leafIndices[treeId].end());
+            TVector<ui32>().swap(leafIndices[treeId]);
+        }
+        GetDocumentImportances(compactLeafIndices, pool.Docs.GetDocCount(), &localExecutor, consumer);
+    } else {
+        GetDocumentImportances(leafIndices, pool.Docs.GetDocCount(), &localExecutor, consumer);
+    }
+}
+
+template <typename TLeafIndex>
+void TDocumentImportancesEvaluator::GetDocumentImportances(
+    const TVector<TVector<TLeafIndex>>& leafIndices,
+    ui32 testDocCount,
+    NPar::TLocalExecutor* localExecutor,
+    const TDocumentImportancesConsumer& consumer
+) {
+    const int threadCount = localExecutor->GetThreadCount() + 1;
+    const ui32 blockSize = Max<ui32>(threadCount, MaxImportancesBlockSize / Max<ui32>(testDocCount, 1));
+    TVector<TTrainDocBuffers> buffers(threadCount);
+    TVector<TVector<double>> documentImportances;
+
+    for (ui32 blockBegin = 0; blockBegin < DocCount; blockBegin += blockSize) {
+        const ui32 blockEnd = Min(DocCount, blockBegin + blockSize);
+        documentImportances.resize(blockEnd - blockBegin);
+        for (auto& documentImportance : documentImportances) {
+            documentImportance.yresize(testDocCount);
+        }
+
+        NPar::TLocalExecutor::TExecRangeParams blockParams(blockBegin, blockEnd);
+        blockParams.SetBlockCount(threadCount);
+        localExecutor->ExecRange([&] (int blockId) {
+            TTrainDocBuffers& buffersRef = buffers[blockId];
+            // The derivative of leaf values with respect to train doc weight.
+            buffersRef.LeafDerivatives.resize(TreeCount, TVector<TVector<double>>(LeavesEstimationIterations));
+            const int blockFirstId = blockParams.FirstId + blockId * blockParams.GetBlockSize();
+            const int blockLastId = Min(blockParams.LastId, blockFirstId + blockParams.GetBlockSize());
+            for (int docId = blockFirstId; docId < blockLastId; ++docId) {
+                UpdateLeavesDerivatives(docId, &buffersRef.Jacobian, &buffersRef.LeafDerivatives);
+                GetDocumentImportancesForOneTrainDoc(
+                    buffersRef.LeafDerivatives,
+                    leafIndices,
+                    &buffersRef.PredictedDerivatives,
+                    &documentImportances[docId - blockBegin]
+                );
+            }
+        }, 0, blockParams.GetBlockCount(), NPar::TLocalExecutor::WAIT_COMPLETE);
+
+        consumer(blockBegin, documentImportances);
+    }
 }
 
 void TDocumentImportancesEvaluator::UpdateFinalFirstDerivatives(const TVector<TVector<ui32>>& leafIndices, const TPool& pool) {
@@ -72,8 +118,9 @@ TVector<ui32> TDocumentImportancesEvaluator::GetLeafIdToUpdate(ui32 treeId, cons
     return leafIdToUpdate;
 }
 
-void TDocumentImportancesEvaluator::UpdateLeavesDerivatives(ui32 removedDocId, TVector<TVector<TVector<double>>>* leafDerivatives) {
-    TVector<double> jacobian(DocCount);
+void TDocumentImportancesEvaluator::UpdateLeavesDerivatives(ui32 removedDocId, TVector<double>* jacobianBuffer, TVector<TVector<TVector<double>>>* leafDerivatives) {
+    TVector<double>& jacobian = *jacobianBuffer;
+    jacobian.assign(DocCount, 0);
     for (ui32 treeId = 0; treeId < TreeCount; ++treeId) {
         auto& treeStatistics = TreesStatistics[treeId];
         for (ui32 it = 0; it < LeavesEstimationIterations; ++it) {
@@ -106,16 +153,19 @@ void TDocumentImportancesEvaluator::UpdateLeavesDerivatives(ui32 removedDocId, T
     }
 }
 
+template <typename TLeafIndex>
 void TDocumentImportancesEvaluator::GetDocumentImportancesForOneTrainDoc(
     const TVector<TVector<TVector<double>>>& leafDerivatives,
-    const TVector<TVector<ui32>>& leafIndices,
+    const TVector<TVector<TLeafIndex>>& leafIndices,
+    TVector<double>* predictedDerivativesBuffer,
     TVector<double>* documentImportance
 ) {
     const ui32 docCount = documentImportance->size();
-    TVector<double> predictedDerivatives(docCount);
+    TVector<double>& predictedDerivatives = *predictedDerivativesBuffer;
+    predictedDerivatives.assign(docCount, 0);
 
     for (ui32 treeId = 0; treeId < TreeCount; ++treeId) {
-        const TVector<ui32>& leafIndicesRef = leafIndices[treeId];
+        const TVector<TLeafIndex>& leafIndicesRef = leafIndices[treeId];
         for (ui32 it = 0; it < LeavesEstimationIterations; ++it) {
             const TVector<double>& leafDerivativesRef = leafDerivatives[treeId][it];
             for (ui32 docId = 0; docId < docCount; ++docId) {
@@ -7,6 +7,8 @@
 #include <catboost/libs/data/pool.h>
 #include <catboost/libs/options/catboost_options.h>
 
+#include <functional>
+
 /*
  * This is the implementation of the LeafInfluence algorithm from the following paper:
  * https://arxiv.org/pdf/1802.06640.pdf
@@ -27,6 +29,10 @@ struct TUpdateMethod {
     int TopSize;
 };
 
+// Receives importances of train documents [trainDocBegin, trainDocBegin + importances.size()) for all objects from pool,
+// importances are indexed by [trainDocId - trainDocBegin][testDocId].
+using TDocumentImportancesConsumer = std::function<void(ui32 trainDocBegin, const TVector<TVector<double>>& importances)>;
+
 // The class for document importances evaluation.
 class TDocumentImportancesEvaluator {
 public:
@@ -56,23 +62,42 @@ public:
         Y_ASSERT(leavesEstimationMethod == ELeavesEstimation::Newton);
             treeStatisticsEvaluator = MakeHolder<TNewtonTreeStatisticsEvaluator>(DocCount);
         }
-        TreesStatistics = treeStatisticsEvaluator->EvaluateTreeStatistics(model, pool);
+        NPar::TLocalExecutor localExecutor;
+        localExecutor.RunAdditionalThreads(ThreadCount - 1);
+        TreesStatistics = treeStatisticsEvaluator->EvaluateTreeStatistics(model, pool, &localExecutor);
     }
 
     // Getting the importance of all train objects for all objects from pool.
-    TVector<TVector<double>> GetDocumentImportances(const TPool& pool);
+    // Train objects are processed by blocks, so only one block of importances is kept in memory.
+    void GetDocumentImportances(const TPool& pool, const TDocumentImportancesConsumer& consumer);
 
 private:
+    // Per-thread buffers reused between train documents.
+    struct TTrainDocBuffers {
+        TVector<TVector<TVector<double>>> LeafDerivatives; // [treeCount][LeavesEstimationIterationsCount][leafCount]
+        TVector<double> Jacobian; // [docCount]
+        TVector<double> PredictedDerivatives; // [testDocCount]
+    };
+
+    template <typename TLeafIndex>
+    void GetDocumentImportances(
+        const TVector<TVector<TLeafIndex>>& leafIndices,
+        ui32 testDocCount,
+        NPar::TLocalExecutor* localExecutor,
+        const TDocumentImportancesConsumer& consumer
+    );
     // Evaluate first derivatives at the final approxes
     void UpdateFinalFirstDerivatives(const TVector<TVector<ui32>>& leafIndices, const TPool& pool);
     // Leaves derivatives will be updated based on objects from these leaves.
     TVector<ui32> GetLeafIdToUpdate(ui32 treeId, const TVector<double>& jacobian);
     // Algorithm 4 from paper.
-    void UpdateLeavesDerivatives(ui32 removedDocId, TVector<TVector<TVector<double>>>* leafDerivatives);
+    void UpdateLeavesDerivatives(ui32 removedDocId, TVector<double>* jacobian, TVector<TVector<TVector<double>>>* leafDerivatives);
     // Getting the importance of one train object for all objects from pool.
+    template <typename TLeafIndex>
     void GetDocumentImportancesForOneTrainDoc(
         const TVector<TVector<TVector<double>>>& leafDerivatives,
-        const TVector<TVector<ui32>>& leafIndices,
+        const TVector<TVector<TLeafIndex>>& leafIndices,
+        TVector<double>* predictedDerivatives,
         TVector<double>* documentImportance
     );
     // Evaluate leaf derivatives at a given removedDocId weight (Equation (6) from paper).
@@ -7,7 +7,8 @@
 
 TVector<TTreeStatistics> ITreeStatisticsEvaluator::EvaluateTreeStatistics(
     const TFullModel& model,
-    const TPool& pool
+    const TPool& pool,
+    NPar::TLocalExecutor* localExecutor
 ) {
     NJson::TJsonValue paramsJson = ReadTJsonValue(model.ModelInfo.at("params"));
     const ELossFunction lossFunction = FromString<ELossFunction>(paramsJson["loss_function"]["type"].GetString());
@@ -17,13 +18,13 @@ TVector<TTreeStatistics> ITreeStatisticsEvaluator::EvaluateTreeStatistics(
     const float l2LeafReg = paramsJson["tree_learner_options"]["l2_leaf_reg"].GetDouble();
     const ui32 treeCount = model.ObliviousTrees.GetTreeCount();
 
-    const TVector<ui8> binarizedFeatures = BinarizeFeatures(model, pool);
+    TVector<TVector<ui32>> leafIndices = BuildIndicesForBinTrees(model, pool, localExecutor);
     TVector<TTreeStatistics> treeStatistics;
     treeStatistics.reserve(treeCount);
     TVector<double> approxes(DocCount);
     for (ui32 treeId = 0; treeId < treeCount; ++treeId) {
         LeafCount = 1 << model.ObliviousTrees.TreeSizes[treeId];
-        LeafIndices = BuildIndicesForBinTree(model, binarizedFeatures, treeId);
+        LeafIndices = std::move(leafIndices[treeId]);
 
         TVector<TVector<ui32>> leavesDocId(LeafCount);
         for (ui32 docId = 0; docId < DocCount; ++docId) {
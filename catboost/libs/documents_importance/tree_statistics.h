@@ -6,6 +6,8 @@
 #include <catboost/libs/data/pool.h>
 #include <catboost/libs/options/catboost_options.h>
 
+#include <library/threading/local_executor/local_executor.h>
+
 struct TTreeStatistics {
     TTreeStatistics() = default;
 
@@ -32,7 +34,8 @@ public:
 
     TVector<TTreeStatistics> EvaluateTreeStatistics(
         const TFullModel& model,
-        const TPool& pool
+        const TPool& pool,
+        NPar::TLocalExecutor* localExecutor
     );
 
 private:
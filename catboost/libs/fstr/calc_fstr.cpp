@@ -40,6 +40,7 @@ static TVector<TMxTree> BuildTrees(const THashMap<TFeature, int, TFeatureHash>&
                                    const TFullModel& model) {
     TVector<TMxTree> trees(model.ObliviousTrees.GetTreeCount());
     auto& binFeatures = model.ObliviousTrees.GetBinFeatures();
+    const TDoubleLeafValues leafValues(model.ObliviousTrees);
     for (int treeIdx = 0; treeIdx < trees.ysize(); ++treeIdx) {
         auto& tree = trees[treeIdx];
         const int leafCount = (1uLL << model.ObliviousTrees.TreeSizes[treeIdx]);
@@ -48,7 +49,7 @@ static TVector<TMxTree> BuildTrees(const THashMap<TFeature, int, TFeatureHash>&
         for (int leafIdx = 0; leafIdx < leafCount; ++leafIdx) {
             tree.Leaves[leafIdx].Vals.resize(model.ObliviousTrees.ApproxDimension);
         }
-        auto firstTreeLeafPtr = model.ObliviousTrees.GetFirstLeafPtrForTree(treeIdx);
+        auto firstTreeLeafPtr = leafValues.GetFirstLeafPtrForTree(treeIdx);
         for (int leafIdx = 0; leafIdx < leafCount; ++leafIdx) {
             for (int dim = 0; dim < model.ObliviousTrees.ApproxDimension; ++dim) {
                 tree.Leaves[leafIdx].Vals[dim] = firstTreeLeafPtr[leafIdx * model.ObliviousTrees.ApproxDimension + dim];
@@ -80,7 +81,7 @@ TVector<TMxTree> BuildMatrixnetTrees(const TFullModel& model, TVector<TFeature>*
     return BuildTrees(featureToIdx, model);
 }
 
-TVector<std::pair<double, TFeature>> CalcFeatureEffect(const TFullModel& model, const TPool* pool, int /*threadCount = 1*/) {
+TVector<std::pair<double, TFeature>> CalcFeatureEffect(const TFullModel& model, const TPool* pool, int threadCount/*= 1*/) {
     if (model.GetTreeCount() == 0) {
         return TVector<std::pair<double, TFeature>>();
     }
@@ -94,7 +95,9 @@ TVector<std::pair<double, TFeature>> CalcFeatureEffect(const TFullModel& model,
         CB_ENSURE(pool->Docs.GetDocCount() != 0, "no docs in pool");
         CB_ENSURE(pool->Docs.GetEffectiveFactorCount() > 0, "no features in pool");
 
-        leavesStatisticsOnPool = CollectLeavesStatistics(*pool, model);
+        NPar::TLocalExecutor localExecutor;
+        localExecutor.RunAdditionalThreads(threadCount - 1);
+        leavesStatisticsOnPool = CollectLeavesStatistics(*pool, model, &localExecutor);
     }
 
     TVector<TFeature> features;
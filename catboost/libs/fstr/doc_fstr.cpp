@@ -118,6 +118,7 @@ static bool ModelHasLeafWeightsStats(const TFullModel& model) {
 }
 
 static TVector<TVector<double>> CalcFeatureImportancesForDocuments(const TFullModel& model,
+                                                                   const TDoubleLeafValues& leafValues,
                                                                    const TVector<ui8>& binarizedFeatures,
                                                                    const TVector<TVector<TVector<double>>>& approx,
                                                                    const TFeaturesLayout& layout,
@@ -145,7 +146,7 @@ static TVector<TVector<double>> CalcFeatureImportancesForDocuments(const TFullMo
                                                            const TFeaturesLayout& layout,
                                                            TVector<TVector<double>>* resultPtr) { // [featureId][docId]
         TVector<TVector<double>>& result = *resultPtr;
-        auto treeFirstLeafPtr = model.ObliviousTrees.GetFirstLeafPtrForTree(treeIdx);
+        auto treeFirstLeafPtr = leafValues.GetFirstLeafPtrForTree(treeIdx);
         for (size_t featureId = 0; featureId < featureCount; ++featureId) {
             TVector<TVector<TIndexType>> indices = BuildIndicesWithoutFeature(model,
                                                                               treeIdx,
@@ -179,7 +180,7 @@ static TVector<TVector<double>> CalcFeatureImportancesForDocuments(const TFullMo
     return MapFunctionToTrees(model, binarizedFeatures, 0, 0, CalcFeatureImportanceForTree, featureCount, layout, threadCount);
 }
 
-static void CalcApproxForTree(const TFullModel& model, const TVector<ui8>& binarizedFeatures,
+static void CalcApproxForTree(const TFullModel& model, const TDoubleLeafValues& leafValues, const TVector<ui8>& binarizedFeatures,
         size_t treeIdx,
                        TVector<TVector<double>>* resultPtr) {
     TVector<TVector<double>>& approx = *resultPtr;
@@ -189,7 +190,7 @@ static void CalcApproxForTree(const TFullModel& model, const TVector<ui8>& binar
                                                binarizedFeatures,
                                                treeIdx);
     const int docCount = indices.ysize();
-    auto treeFirstLeafPtr = model.ObliviousTrees.GetFirstLeafPtrForTree(treeIdx);
+    auto treeFirstLeafPtr = leafValues.GetFirstLeafPtrForTree(treeIdx);
     for (int dim = 0; dim < approxDimension; ++dim) {
         for (int doc = 0; doc < docCount; ++doc) {
             approx[dim][doc] += treeFirstLeafPtr[indices[doc] * model.ObliviousTrees.ApproxDimension + dim];
@@ -213,10 +214,11 @@ TVector<TVector<double>> CalcFeatureImportancesForDocuments(const TFullModel& mo
     TVector<TVector<TVector<double>>> approx(treeCount,
                                              TVector<TVector<double>>(approxDimension, TVector<double>(docCount))); // [tree][dim][docIdx]
 
+    const TDoubleLeafValues leafValues(model.ObliviousTrees);
     for (size_t treeIdx = 0; treeIdx < treeCount; ++treeIdx) {
-        CalcApproxForTree(model, binarizedFeatures, treeIdx, &approx[treeIdx]);
+        CalcApproxForTree(model, leafValues, binarizedFeatures, treeIdx, &approx[treeIdx]);
     }
-    TVector<TVector<double>> result = CalcFeatureImportancesForDocuments(model, binarizedFeatures, approx, layout, threadCount);
+    TVector<TVector<double>> result = CalcFeatureImportancesForDocuments(model, leafValues, binarizedFeatures, approx, layout, threadCount);
 
     return result;
 }
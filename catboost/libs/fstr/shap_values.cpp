@@ -3,6 +3,7 @@
 
 #include <catboost/libs/algo/index_calcer.h>
 #include <catboost/libs/loggers/logger.h>
+#include <catboost/libs/model/formula_evaluator.h>
 #include <catboost/libs/logging/profile_info.h>
 
 #include <util/generic/algorithm.h>
@@ -104,6 +105,7 @@ static size_t CalcLeafToFallForDocument(const TObliviousTrees& forest, size_t tr
 
 static void CalcShapValuesForLeafRecursive(
     const TObliviousTrees& forest,
+    const TDoubleLeafValues& leafValues,
     const TVector<int>& binFeatureCombinationClass,
     const TVector<TVector<int>>& combinationClassFeatures,
     size_t documentLeafIdx,
@@ -119,7 +121,7 @@ static void CalcShapValuesForLeafRecursive(
     TVector<TShapValue>* shapValues
 ) {
     TVector<TFeaturePathElement> featurePath = ExtendFeaturePath(oldFeaturePath, zeroPathsFraction, onePathsFraction, feature);
-    auto firstLeafPtr = forest.GetFirstLeafPtrForTree(treeIdx);
+    auto firstLeafPtr = leafValues.GetFirstLeafPtrForTree(treeIdx);
     if (depth == forest.TreeSizes[treeIdx]) {
         for (size_t elementIdx = 1; elementIdx < featurePath.size(); ++elementIdx) {
             TVector<TFeaturePathElement> unwoundPath = UnwindFeaturePath(featurePath, elementIdx);
@@ -180,6 +182,7 @@ static void CalcShapValuesForLeafRecursive(
             double newZeroPathsFractionGoNode = newZeroPathsFraction * subtreeWeights[depth + 1][goNodeIdx] / subtreeWeights[depth][nodeIdx];
             CalcShapValuesForLeafRecursive(
                 forest,
+                leafValues,
                 binFeatureCombinationClass,
                 combinationClassFeatures,
                 documentLeafIdx,
@@ -199,6 +202,7 @@ static void CalcShapValuesForLeafRecursive(
             double newZeroPathsFractionSkipNode = newZeroPathsFraction * subtreeWeights[depth + 1][skipNodeIdx] / subtreeWeights[depth][nodeIdx];
             CalcShapValuesForLeafRecursive(
                 forest,
+                leafValues,
                 binFeatureCombinationClass,
                 combinationClassFeatures,
                 documentLeafIdx,
@@ -218,6 +222,7 @@ static void CalcShapValuesForLeafRecursive(
 
 static inline void CalcShapValuesForLeaf(
     const TObliviousTrees& forest,
+    const TDoubleLeafValues& leafValues,
     const TVector<int>& binFeatureCombinationClass,
     const TVector<TVector<int>>& combinationClassFeatures,
     size_t documentLeafIdx,
@@ -231,6 +236,7 @@ static inline void CalcShapValuesForLeaf(
     TVector<TFeaturePathElement> initialFeaturePath;
     CalcShapValuesForLeafRecursive(
         forest,
+        leafValues,
         binFeatureCombinationClass,
         combinationClassFeatures,
         documentLeafIdx,
@@ -248,12 +254,13 @@ static inline void CalcShapValuesForLeaf(
 
 static double CalcMeanValueForTree(
     const TObliviousTrees& forest,
+    const TDoubleLeafValues& leafValues,
     const TVector<TVector<double>>& subtreeWeights,
     size_t treeIdx,
     int dimension
 ) {
     double meanValue = 0.0;
-    auto firstLeafPtr = forest.GetFirstLeafPtrForTree(treeIdx);
+    auto firstLeafPtr = leafValues.GetFirstLeafPtrForTree(treeIdx);
     const size_t maxDepth = forest.TreeSizes[treeIdx];
 
     for (size_t leafIdx = 0; leafIdx < (size_t(1) << maxDepth); ++leafIdx) {
@@ -358,33 +365,40 @@ static void CalcShapValuesForDocumentBlock(
     const TObliviousTrees& forest = model.ObliviousTrees;
     const size_t documentCount = end - start;
 
-    TVector<ui8> binarizedFeaturesForDocumentBlock = BinarizeFeatures(model, pool, start, end);
-
     const int flatFeatureCount = pool.Docs.GetEffectiveFactorCount();
 
     const int oldShapValuesSize = shapValuesForAllDocuments->size();
     shapValuesForAllDocuments->resize(oldShapValuesSize + end - start);
 
+    // each thread binarizes only its own part of the block
     NPar::TLocalExecutor::TExecRangeParams blockParams(0, documentCount);
-    localExecutor.ExecRange([&] (size_t documentIdx) {
-        TVector<double>& shapValues = (*shapValuesForAllDocuments)[oldShapValuesSize + documentIdx];
-        shapValues.assign(flatFeatureCount + 1, 0.0);
-
-        TVector<ui8> binarizedFeatures = GetBinarizedFeaturesForDocument(binarizedFeaturesForDocumentBlock, documentCount, documentIdx);
-
-        const size_t treeCount = forest.GetTreeCount();
-        for (size_t treeIdx = 0; treeIdx < treeCount; ++treeIdx) {
-            size_t leafIdx = CalcLeafToFallForDocument(forest, treeIdx, binarizedFeatures);
-            for (const TShapValue& shapValue : shapValuesByLeafForAllTrees[treeIdx][leafIdx]) {
-                shapValues[shapValue.Feature] += shapValue.Value;
+    blockParams.SetBlockCount(localExecutor.GetThreadCount() + 1);
+    localExecutor.ExecRange([&] (int blockId) {
+        const size_t blockStart = blockId * blockParams.GetBlockSize();
+        const size_t blockEnd = Min<size_t>(blockStart + blockParams.GetBlockSize(), documentCount);
+        const TVector<ui8> binarizedFeaturesForBlock = BinarizeFeatures(model, pool, start + blockStart, start + blockEnd);
+
+        for (size_t documentIdx = blockStart; documentIdx < blockEnd; ++documentIdx) {
+            TVector<double>& shapValues = (*shapValuesForAllDocuments)[oldShapValuesSize + documentIdx];
+            shapValues.assign(flatFeatureCount + 1, 0.0);
+
+            TVector<ui8> binarizedFeatures = GetBinarizedFeaturesForDocument(binarizedFeaturesForBlock, blockEnd - blockStart, documentIdx - blockStart);
+
+            const size_t treeCount = forest.GetTreeCount();
+            for (size_t treeIdx = 0; treeIdx < treeCount; ++treeIdx) {
+                size_t leafIdx = CalcLeafToFallForDocument(forest, treeIdx, binarizedFeatures);
+                for (const TShapValue& shapValue : shapValuesByLeafForAllTrees[treeIdx][leafIdx]) {
+                    shapValues[shapValue.Feature] += shapValue.Value;
+                }
+                shapValues[flatFeatureCount] += meanValuesForAllTrees[treeIdx];
             }
-            shapValues[flatFeatureCount] += meanValuesForAllTrees[treeIdx];
         }
-    }, blockParams, NPar::TLocalExecutor::WAIT_COMPLETE);
+    }, 0, blockParams.GetBlockCount(), NPar::TLocalExecutor::WAIT_COMPLETE);
 }
 
 static void CalcShapValuesByLeafForTreeBlock(
     const TObliviousTrees& forest,
+    const TDoubleLeafValues& leafValues,
     const TVector<TVector<double>>& leafWeights,
     NPar::TLocalExecutor& localExecutor,
     int dimension,
@@ -408,6 +422,7 @@ static void CalcShapValuesByLeafForTreeBlock(
         for (size_t leafIdx = 0; leafIdx < leafCount; ++leafIdx) {
             CalcShapValuesForLeaf(
                 forest,
+                leafValues,
                 binFeatureCombinationClass,
                 combinationClassFeatures,
                 leafIdx,
@@ -416,7 +431,7 @@ static void CalcShapValuesByLeafForTreeBlock(
                 dimension,
                 &shapValuesByLeaf[leafIdx]);
 
-            (*meanValuesForAllTrees)[treeIdx] = CalcMeanValueForTree(forest, subtreeWeights, treeIdx, dimension);
+            (*meanValuesForAllTrees)[treeIdx] = CalcMeanValueForTree(forest, leafValues, subtreeWeights, treeIdx, dimension);
         }
     }, blockParams, NPar::TLocalExecutor::WAIT_COMPLETE);
 }
@@ -450,7 +465,7 @@ static void PrepareTrees(
     // use only if model.ObliviousTrees.LeafWeights is empty
     TVector<TVector<double>> leafWeights;
     if (model.ObliviousTrees.LeafWeights.empty()) {
-        leafWeights = CollectLeavesStatistics(pool, model);
+        leafWeights = CollectLeavesStatistics(pool, model, &localExecutor);
     }
 
     shapValuesByLeafForAllTrees->resize(treeCount);
@@ -458,6 +473,8 @@ static void PrepareTrees(
 
     TProfileInfo processTreesProfile(treeCount);
 
+    const TDoubleLeafValues leafValues(model.ObliviousTrees);
+
     for (size_t start = 0; start < treeCount; start += treeBlockSize) {
         size_t end = Min(start + treeBlockSize, treeCount);
 
@@ -465,6 +482,7 @@ static void PrepareTrees(
 
         CalcShapValuesByLeafForTreeBlock(
             model.ObliviousTrees,
+            leafValues,
             model.ObliviousTrees.LeafWeights.empty() ? leafWeights : model.ObliviousTrees.LeafWeights,
             localExecutor,
             dimension,
@@ -504,7 +522,7 @@ TVector<TVector<double>> CalcShapValues(
     );
 
     const size_t documentCount = pool.Docs.GetDocCount();
-    const size_t documentBlockSize = CB_THREAD_LIMIT; // least necessary for threading
+    const size_t documentBlockSize = (localExecutor.GetThreadCount() + 1) * FORMULA_EVALUATION_BLOCK_SIZE; // evaluation block per thread
 
     TFstrLogger documentsLogger(documentCount, "documents processed", "Processing documents...", logPeriod);
 
@@ -562,7 +580,7 @@ void CalcAndOutputShapValues(
     );
 
     const size_t documentCount = pool.Docs.GetDocCount();
-    const size_t documentBlockSize = CB_THREAD_LIMIT; // least necessary for threading
+    const size_t documentBlockSize = (localExecutor.GetThreadCount() + 1) * FORMULA_EVALUATION_BLOCK_SIZE; // evaluation block per thread
 
     TFstrLogger documentsLogger(documentCount, "documents processed", "Processing documents...", logPeriod);
 
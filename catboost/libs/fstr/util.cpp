@@ -3,38 +3,38 @@
 #include <catboost/libs/algo/index_calcer.h>
 
 
-TVector<TVector<double>> CollectLeavesStatistics(const TPool& pool, const TFullModel& model) {
+TVector<TVector<double>> CollectLeavesStatistics(const TPool& pool, const TFullModel& model, NPar::TLocalExecutor* localExecutor) {
     const size_t treeCount = model.ObliviousTrees.TreeSizes.size();
     TVector<TVector<double>> leavesStatistics(treeCount);
     for (size_t index = 0; index < treeCount; ++index) {
         leavesStatistics[index].resize(1 << model.ObliviousTrees.TreeSizes[index]);
     }
 
-    auto binFeatures = BinarizeFeatures(model, pool);
-
-    const auto documentsCount = pool.Docs.GetDocCount();
-    for (size_t treeIdx = 0; treeIdx < treeCount; ++treeIdx) {
-        TVector<TIndexType> indices = BuildIndicesForBinTree(
-            model,
-            binFeatures,
-            treeIdx);
-
-        if (indices.empty()) {
-            continue;
-        }
+    if (model.ObliviousTrees.GetEffectiveBinaryFeaturesBucketsCount() == 0) {
+        return leavesStatistics;
+    }
 
-        if (pool.Docs.Weight.empty()) {
-            for (size_t doc = 0; doc < documentsCount; ++doc) {
-                const TIndexType valueIndex = indices[doc];
-                leavesStatistics[treeIdx][valueIndex] += 1.0;
+    // each tree is updated by one thread in document order, so the result doesn't depend on thread count
+    BinarizeFeaturesByBlocks(model, pool, localExecutor, [&](size_t blockStart, size_t blockEnd, const TVector<ui8>& binarizedBlock) {
+        localExecutor->ExecRange([&](int treeIdx) {
+            TVector<TIndexType> indices = BuildIndicesForBinTree(
+                model,
+                binarizedBlock,
+                treeIdx);
+
+            TVector<double>& treeStatistics = leavesStatistics[treeIdx];
+            if (pool.Docs.Weight.empty()) {
+                for (size_t doc = blockStart; doc < blockEnd; ++doc) {
+                    const TIndexType valueIndex = indices[doc - blockStart];
+                    treeStatistics[valueIndex] += 1.0;
+                }
+            } else {
+                for (size_t doc = blockStart; doc < blockEnd; ++doc) {
+                    const TIndexType valueIndex = indices[doc - blockStart];
+                    treeStatistics[valueIndex] += pool.Docs.Weight[doc];
+                }
             }
-        } else {
-            for (size_t doc = 0; doc < documentsCount; ++doc) {
-                const TIndexType valueIndex = indices[doc];
-                leavesStatistics[treeIdx][valueIndex] += pool.Docs.Weight[doc];
-            }
-        }
-    }
+        }, 0, treeCount, NPar::TLocalExecutor::WAIT_COMPLETE);
+    });
     return leavesStatistics;
 }
-
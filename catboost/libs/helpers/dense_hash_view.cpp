@@ -1 +1,55 @@
 #include "dense_hash_view.h"
+
+#include <library/threading/local_executor/local_executor.h>
+
+#include <util/generic/vector.h>
+
+void NCatboost::TDenseIndexHashBuilder::SetIndices(TConstArrayRef<std::pair<ui64, ui32>> hashIndices, NPar::TLocalExecutor* localExecutor) {
+    const size_t bucketCount = HashMask + 1;
+    const size_t rangeBucketCount = Min<size_t>(bucketCount, 1 << 16);
+    const size_t rangeCount = bucketCount / rangeBucketCount;
+    if (rangeCount == 1) {
+        for (const auto& hashIndex : hashIndices) {
+            SetIndex(hashIndex.first, hashIndex.second);
+        }
+        return;
+    }
+
+    TVector<TVector<ui32>> pairsByRange(rangeCount);
+    for (ui32 pairIdx = 0; pairIdx < hashIndices.size(); ++pairIdx) {
+        pairsByRange[(hashIndices[pairIdx].first & HashMask) / rangeBucketCount].push_back(pairIdx);
+        BinCount = Max(BinCount, hashIndices[pairIdx].second);
+    }
+    // pairs which would probe past the end of their range are inserted after all ranges are filled
+    TVector<TVector<ui32>> deferredPairsByRange(rangeCount);
+    const auto fillRange = [&](int rangeIdx) {
+        const ui64 rangeEnd = (rangeIdx + 1) * rangeBucketCount;
+        for (ui32 pairIdx : pairsByRange[rangeIdx]) {
+            const ui64 hash = hashIndices[pairIdx].first;
+            ui64 zz = hash & HashMask;
+            while (zz < rangeEnd && Buckets[zz].Hash != TBucket::InvalidHashValue && Buckets[zz].Hash != hash) {
+                ++zz;
+            }
+            if (zz == rangeEnd) {
+                deferredPairsByRange[rangeIdx].push_back(pairIdx);
+            } else if (Buckets[zz].Hash == TBucket::InvalidHashValue) {
+                Buckets[zz].Hash = hash;
+                Buckets[zz].IndexValue = hashIndices[pairIdx].second;
+            } else {
+                Y_ASSERT(Buckets[zz].IndexValue == hashIndices[pairIdx].second);
+            }
+        }
+    };
+    if (localExecutor != nullptr) {
+        localExecutor->ExecRange(fillRange, 0, rangeCount, NPar::TLocalExecutor::WAIT_COMPLETE);
+    } else {
+        for (size_t rangeIdx = 0; rangeIdx < rangeCount; ++rangeIdx) {
+            fillRange(rangeIdx);
+        }
+    }
+    for (const auto& deferredPairs : deferredPairsByRange) {
+        for (ui32 pairIdx : deferredPairs) {
+            SetIndex(hashIndices[pairIdx].first, hashIndices[pairIdx].second);
+        }
+    }
+}
@@ -3,6 +3,12 @@
 #include <util/generic/array_ref.h>
 #include <util/digest/numeric.h>
 
+#include <utility>
+
+namespace NPar {
+    class TLocalExecutor;
+}
+
 namespace NCatboost {
 
 #pragma pack(push, 1)
@@ -87,6 +93,11 @@ namespace NCatboost {
             Buckets[zz].IndexValue = index;
             BinCount = Max(BinCount, index );
         }
+
+        // SetIndex for all pairs, independent ranges of buckets are filled in parallel.
+        // The resulting layout doesn't depend on the thread count, localExecutor can be nullptr.
+        void SetIndices(TConstArrayRef<std::pair<ui64, ui32>> hashIndices, NPar::TLocalExecutor* localExecutor);
+
         static size_t GetProperBucketsCount(size_t uniqueElementsCount, float loadFactor=0.5f) {
             if (uniqueElementsCount==0) {
                 return 2;
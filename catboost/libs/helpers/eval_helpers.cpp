@@ -637,7 +637,7 @@ void TEvalResult::OutputToFile(
             printer->OutputValue(outputStream, docId);
             delimiter = printer->GetAfterColumnDelimiter();
         }
-        *outputStream << Endl;
+        *outputStream << '\n'; // no flush per line, it is costly for compressed output
     }
 }
 
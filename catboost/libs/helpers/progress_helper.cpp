@@ -1,2 +1,54 @@
 #include "progress_helper.h"
 
+TAsyncProgressWriter::TAsyncProgressWriter(const TString& label, const TFsPath& path, const TString& codecName)
+    : ProgressHelper(label)
+    , Path(path) {
+    ProgressHelper.SetCodec(codecName);
+    WriterExecutor.RunAdditionalThreads(1);
+}
+
+TAsyncProgressWriter::~TAsyncProgressWriter() {
+    Finish();
+}
+
+void TAsyncProgressWriter::Enqueue(TBuffer&& buffer) {
+    with_lock(Lock) {
+        PendingBuffer.Swap(buffer);
+        HasPending = true;
+        if (IsWriting) {
+            return;
+        }
+        IsWriting = true;
+    }
+    WriterExecutor.Exec([this](int) { WritePending(); }, 0, NPar::TLocalExecutor::HIGH_PRIORITY);
+}
+
+void TAsyncProgressWriter::WritePending() {
+    TBuffer buffer;
+    while (true) {
+        with_lock(Lock) {
+            if (buffer.Capacity() > SpareBuffer.Capacity()) {
+                SpareBuffer.Swap(buffer);
+            }
+            if (!HasPending) {
+                IsWriting = false;
+                WriterIdle.BroadCast();
+                return;
+            }
+            buffer.Swap(PendingBuffer);
+            HasPending = false;
+        }
+        // TProgressHelper::Write reports errors to log and never throws
+        ProgressHelper.Write(Path, [&](IOutputStream* out) {
+            out->Write(buffer.Data(), buffer.Size());
+        });
+    }
+}
+
+void TAsyncProgressWriter::Finish() {
+    with_lock(Lock) {
+        while (IsWriting) {
+            WriterIdle.WaitI(Lock);
+        }
+    }
+}
@@ -4,14 +4,22 @@
 
 #include <catboost/libs/logging/logging.h>
 
+#include <util/stream/buffer.h>
 #include <util/stream/output.h>
 #include <util/stream/file.h>
 #include <util/folder/path.h>
+#include <util/generic/buffer.h>
 #include <util/generic/guid.h>
+#include <util/generic/noncopyable.h>
+#include <util/system/condvar.h>
 #include <util/system/fs.h>
+#include <util/system/mutex.h>
 #include <util/ysaveload.h>
 
+#include <library/blockcodecs/codecs.h>
+#include <library/blockcodecs/stream.h>
 #include <library/digest/md5/md5.h>
+#include <library/threading/local_executor/local_executor.h>
 
 namespace {
 
@@ -54,6 +62,11 @@ public:
             , CalcMd5(calcMd5) {
     }
 
+    // Compressed progress is stored as "<label>:<codec name>" label followed by blockcodecs stream
+    void SetCodec(const TString& codecName) {
+        Codec = codecName.empty() ? nullptr : NBlockCodecs::Codec(codecName);
+    }
+
     template <class TWriter>
     void Write(const TFsPath& path,
                TWriter&& writer) {
@@ -62,8 +75,15 @@ public:
             {
                 TOFStream out(tempName);
                 TMD5Output md5out(&out);
-                ::Save(&md5out, Label);
-                writer(&md5out);
+                if (Codec) {
+                    ::Save(&md5out, Label + CompressedLabelDelimiter + Codec->Name());
+                    NBlockCodecs::TCodedOutput codedOut(&md5out, Codec, CompressionBlockSize);
+                    writer(&codedOut);
+                    codedOut.Finish();
+                } else {
+                    ::Save(&md5out, Label);
+                    writer(&md5out);
+                }
                 char md5buf[33];
                 if (CalcMd5) {
                     MATRIXNET_INFO_LOG << SavedMessage << " (md5sum: " << md5out.Sum(md5buf) << " )" << Endl;
@@ -82,13 +102,68 @@ public:
         TString label;
         TIFStream input(path);
         ::Load(&input, label);
-        CB_ENSURE(Label == label, "Error: except " << Label << " progress. Got " << label);
-        reader(&input);
+        TStringBuf plainLabel;
+        TStringBuf codecName;
+        if (TStringBuf(label).TrySplit(CompressedLabelDelimiter, plainLabel, codecName)) {
+            CB_ENSURE(Label == plainLabel, "Error: except " << Label << " progress. Got " << plainLabel);
+            NBlockCodecs::TDecodedInput decodedInput(&input, NBlockCodecs::Codec(codecName));
+            reader(&decodedInput);
+        } else {
+            CB_ENSURE(Label == label, "Error: except " << Label << " progress. Got " << label);
+            reader(&input);
+        }
     }
 
 private:
+    static constexpr char CompressedLabelDelimiter = ':';
+    static constexpr size_t CompressionBlockSize = 1 << 20;
+
     TString Label;
     TString ExceptionMessage;
     TString SavedMessage;
     bool CalcMd5;
+    const NBlockCodecs::ICodec* Codec = nullptr;
+};
+
+/* Serializes progress into memory on the calling thread and writes it to disk in background.
+ * If a new progress arrives while the previous one is being written, only the latest one is kept.
+ */
+class TAsyncProgressWriter : public TNonCopyable {
+public:
+    TAsyncProgressWriter(const TString& label, const TFsPath& path, const TString& codecName = "");
+    ~TAsyncProgressWriter();
+
+    template <class TWriter>
+    void Write(TWriter&& writer) {
+        TBuffer buffer;
+        with_lock(Lock) {
+            buffer.Swap(SpareBuffer);
+        }
+        buffer.Clear();
+        {
+            TBufferOutput out(buffer);
+            writer(&out);
+        }
+        Enqueue(std::move(buffer));
+    }
+
+    // waits until all enqueued progress is on disk
+    void Finish();
+
+private:
+    void Enqueue(TBuffer&& buffer);
+    void WritePending();
+
+private:
+    TProgressHelper ProgressHelper;
+    TFsPath Path;
+
+    TMutex Lock;
+    TCondVar WriterIdle;
+    TBuffer PendingBuffer;
+    TBuffer SpareBuffer; // reused to avoid page faults on every snapshot
+    bool HasPending = false;
+    bool IsWriting = false;
+
+    NPar::TLocalExecutor WriterExecutor;
 };
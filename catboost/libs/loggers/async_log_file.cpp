@@ -0,0 +1,155 @@
+#include "async_log_file.h"
+
+#include <catboost/libs/logging/logging.h>
+
+#include <util/datetime/base.h>
+#include <util/generic/yexception.h>
+#include <util/generic/hash_set.h>
+#include <util/generic/singleton.h>
+#include <util/system/atomic.h>
+#include <util/system/event.h>
+#include <util/system/file.h>
+#include <util/system/guard.h>
+#include <util/system/mutex.h>
+#include <util/system/thread.h>
+#include <util/thread/lfqueue.h>
+
+#include <exception>
+
+static const TDuration AsyncLogFlushPeriod = TDuration::Seconds(1);
+
+struct TAsyncLogFile::TImpl {
+    struct TRecord {
+        size_t TailSize = 0;
+        TString Text;
+    };
+
+    explicit TImpl(const TString& fileName)
+        : File(fileName, CreateAlways | WrOnly)
+    {
+    }
+
+    // Called by both the background and the owning thread.
+    void WriteQueuedRecords() {
+        with_lock (Mutex) {
+            TString batch;
+            i64 tailToRewrite = 0;
+            TRecord record;
+            while (Records.Dequeue(&record)) {
+                if (record.TailSize <= batch.size()) {
+                    batch.resize(batch.size() - record.TailSize);
+                } else {
+                    tailToRewrite += record.TailSize - batch.size();
+                    batch.clear();
+                }
+                batch += record.Text;
+            }
+            if (tailToRewrite > 0) {
+                File.Seek(-tailToRewrite, sCur);
+            }
+            if (!batch.empty()) {
+                File.Write(batch.data(), batch.size());
+            }
+        }
+    }
+
+    void RethrowWriteError() const {
+        if (AtomicGet(HasWriteError)) {
+            std::rethrow_exception(WriteError);
+        }
+    }
+
+    TFile File;
+    TLockFreeQueue<TRecord> Records;
+    TMutex Mutex;
+    // The first error of the background thread, it is rethrown on the next write.
+    std::exception_ptr WriteError;
+    TAtomic HasWriteError = 0;
+};
+
+namespace {
+    class TAsyncLogWriter {
+    public:
+        TAsyncLogWriter()
+            : Thread(TThread::TParams(WriterThreadProc, this).SetName("AsyncLogWriter"))
+        {
+            Thread.Start();
+        }
+
+        ~TAsyncLogWriter() {
+            AtomicSet(Stopped, 1);
+            WakeUp.Signal();
+            Thread.Join();
+        }
+
+        void Register(TAsyncLogFile::TImpl* file) {
+            with_lock (Lock) {
+                Files.insert(file);
+            }
+        }
+
+        void Unregister(TAsyncLogFile::TImpl* file) {
+            with_lock (Lock) {
+                Files.erase(file);
+            }
+        }
+
+    private:
+        static void* WriterThreadProc(void* param) {
+            auto* writer = static_cast<TAsyncLogWriter*>(param);
+            while (!AtomicGet(writer->Stopped)) {
+                writer->WakeUp.WaitT(AsyncLogFlushPeriod);
+                with_lock (writer->Lock) {
+                    for (auto* file : writer->Files) {
+                        try {
+                            file->WriteQueuedRecords();
+                        } catch (...) {
+                            if (!AtomicGet(file->HasWriteError)) {
+                                file->WriteError = std::current_exception();
+                                AtomicSet(file->HasWriteError, 1);
+                            }
+                        }
+                    }
+                }
+            }
+            return nullptr;
+        }
+
+    private:
+        TAtomic Stopped = 0;
+        TAutoEvent WakeUp;
+        TMutex Lock;
+        THashSet<TAsyncLogFile::TImpl*> Files;
+        TThread Thread;
+    };
+}
+
+TAsyncLogFile::TAsyncLogFile(const TString& fileName)
+    : Impl(new TImpl(fileName))
+{
+    Singleton<TAsyncLogWriter>()->Register(Impl.Get());
+}
+
+TAsyncLogFile::~TAsyncLogFile() {
+    Singleton<TAsyncLogWriter>()->Unregister(Impl.Get());
+    // the destructor can't throw, so the error of the background thread or of the final write is logged
+    try {
+        Flush();
+    } catch (...) {
+        MATRIXNET_ERROR_LOG << "Can't write log file " << Impl->File.GetName() << ": " << CurrentExceptionMessage() << Endl;
+    }
+}
+
+void TAsyncLogFile::Write(TString record) {
+    RewriteTail(/*tailSize*/ 0, std::move(record));
+}
+
+void TAsyncLogFile::RewriteTail(size_t tailSize, TString record) {
+    Impl->RethrowWriteError();
+    Impl->Records.Enqueue(TImpl::TRecord{tailSize, std::move(record)});
+}
+
+void TAsyncLogFile::Flush() {
+    Impl->RethrowWriteError();
+    Impl->WriteQueuedRecords();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <util/generic/noncopyable.h>
+#include <util/generic/ptr.h>
+#include <util/generic/string.h>
+
+// File of a logging backend which is written by a background thread.
+// Records are put to a lock-free queue and written by batches every second and on destruction,
+// so the training thread doesn't wait for file I/O. The resulting file is the same as with synchronous writes.
+class TAsyncLogFile : public TNonCopyable {
+public:
+    explicit TAsyncLogFile(const TString& fileName);
+    // Waits until all records are written, write errors are logged.
+    ~TAsyncLogFile();
+
+    void Write(TString record);
+    // Replaces the last tailSize bytes of the file with the record.
+    void RewriteTail(size_t tailSize, TString record);
+    // Writes all queued records in the calling thread.
+    void Flush();
+
+public:
+    struct TImpl;
+
+private:
+    THolder<TImpl> Impl;
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "async_log_file.h"
 #include "tensorboard_logger.h"
 
 #include <catboost/libs/logging/logging.h>
@@ -8,6 +9,7 @@
 #include <util/stream/format.h>
 #include <util/generic/hash.h>
 #include <util/generic/ymath.h>
+#include <util/string/builder.h>
 
 #include <library/json/writer/json_value.h>
 
@@ -93,12 +95,11 @@ inline bool DoOutputIteration(int currentIteration, int iterationsCount, int wri
 class TJsonLoggingBackend : public ILoggingBackend {
 public:
     explicit TJsonLoggingBackend(const TString& fileName, const NJson::TJsonValue& metaJson, int writePeriod = 1)
-        : File(fileName, CreateAlways)
+        : File(fileName)
         , WritePeriod(writePeriod)
         , IterationsCount(metaJson["iteration_count"].GetInteger())
     {
-        TString metaString = "{\n\"meta\":" + ToString<NJson::TJsonValue>(metaJson) + ",\n\"iterations\":[\n]}";
-        File.Write(metaString.data(), metaString.length());
+        File.Write("{\n\"meta\":" + ToString<NJson::TJsonValue>(metaJson) + ",\n\"iterations\":[\n]}");
     }
 
     void OutputMetric(const TString& sourceName, const IMetricEvalResult& evalResult) {
@@ -126,15 +127,14 @@ public:
             }
             iterationInfo += "\n" + ToString<NJson::TJsonValue>(IterationJson) + "\n]}";
 
-            File.Seek(-3, sCur);
-            File.Write(iterationInfo.data(), iterationInfo.length());
+            File.RewriteTail(/*tailSize*/ 3, std::move(iterationInfo));
         }
         IterationJson = NJson::JSON_UNDEFINED;
     }
 
 private:
     bool IsFirstIteration = true;
-    TFile File;
+    TAsyncLogFile File;
     int WritePeriod;
     int IterationsCount;
     NJson::TJsonValue IterationJson;
@@ -162,6 +162,7 @@ public:
                 Stream << it.first << ": " << FloatToString(it.second, PREC_NDIGITS, 3) << " sec" << Endl;
             }
             Stream << "Passed: " << FloatToString(profileResults.CurrentTime, PREC_NDIGITS, 3) << " sec" << Endl;
+            Stream << "Scratch allocations: " << profileResults.ScratchAllocations << Endl;
         }
         if (profileResults.IsIterationGood) {
             Stream << "\ttotal: " << HumanReadable(TDuration::Seconds(profileResults.PassedTime));
@@ -186,7 +187,7 @@ private:
 class TProfileLoggingBackend : public ILoggingBackend {
 public:
     explicit TProfileLoggingBackend(const TString& fileName)
-        : File(new TOFStream(fileName))
+        : File(fileName)
     {
     }
 
@@ -196,6 +197,7 @@ public:
             Stream << it.first << ": " << FloatToString(it.second, PREC_NDIGITS, 3) << " sec" << Endl;
         }
         Stream << "Passed: " << FloatToString(profileResults.CurrentTime, PREC_NDIGITS, 3) << " sec" << Endl;
+        Stream << "Scratch allocations: " << profileResults.ScratchAllocations << Endl;
         if (profileResults.IsIterationGood) {
             Stream << "\ttotal: " << HumanReadable(TDuration::Seconds(profileResults.PassedTime));
             Stream << "\tremaining: " << HumanReadable(TDuration::Seconds(profileResults.RemainingTime));
@@ -205,7 +207,7 @@ public:
     }
 
     void Flush(const int currentIteration) {
-        *File << currentIteration << Stream.Str() << Endl;
+        File.Write(TStringBuilder() << currentIteration << Stream.Str() << '\n');
         Stream.Clear();
     }
 
@@ -215,9 +217,11 @@ public:
 
 private:
     void LogSummary() {
-        *File << Endl << "\nAverage times:" << Endl;
+        TStringStream summary;
+        summary << "\n\nAverage times:\n";
         if (PassedIterations == 0) {
-            *File << Endl << "No iterations recorded" << Endl;
+            summary << "\nNo iterations recorded\n";
+            File.Write(summary.Str());
             return;
         }
 
@@ -226,15 +230,16 @@ private:
             time += it.second;
         }
         time /= PassedIterations;
-        *File << "Iteration time: " << FloatToString(time, PREC_NDIGITS, 3) << " sec" << Endl;
+        summary << "Iteration time: " << FloatToString(time, PREC_NDIGITS, 3) << " sec\n";
 
         for (const auto& it : OperationToTimeInAllIterations) {
-            *File << it.first << ": "
-                << FloatToString(it.second / PassedIterations, PREC_NDIGITS, 3) << " sec" << Endl;
+            summary << it.first << ": "
+                << FloatToString(it.second / PassedIterations, PREC_NDIGITS, 3) << " sec\n";
         }
+        File.Write(summary.Str());
     }
 
-    THolder<TOFStream> File;
+    TAsyncLogFile File;
     TStringStream Stream;
     int PassedIterations;
     TMap<TString, double> OperationToTimeInAllIterations;
@@ -243,7 +248,7 @@ private:
 class TJsonProfileLoggingBackend : public ILoggingBackend {
 public:
     explicit TJsonProfileLoggingBackend(const TString& fileName)
-        : File(new TOFStream(fileName))
+        : File(fileName)
     {
     }
 
@@ -254,13 +259,14 @@ public:
         for (const auto& it : profileResults.OperationToTime) {
             times[it.first] = it.second;
         }
+        CurrentValue["scratch_allocations"] = profileResults.ScratchAllocations;
 
         PassedIterations = profileResults.PassedIterations;
         OperationToTimeInAllIterations = profileResults.OperationToTimeInAllIterations;
     }
 
     void Flush(const int ) {
-        *File << CurrentValue.GetStringRobust() << Endl;
+        File.Write(CurrentValue.GetStringRobust() + '\n');
     }
 
     ~TJsonProfileLoggingBackend() {
@@ -285,10 +291,10 @@ private:
         for (const auto& it : OperationToTimeInAllIterations) {
             times[it.first] = it.second / PassedIterations;
         }
-        *File << CurrentValue.GetStringRobust() << Endl;
+        File.Write(CurrentValue.GetStringRobust() + '\n');
     }
     NJson::TJsonValue CurrentValue;
-    THolder<TOFStream> File;
+    TAsyncLogFile File;
     int PassedIterations;
     TMap<TString, double> OperationToTimeInAllIterations;
 };
@@ -297,7 +303,7 @@ private:
 class TErrorFileLoggingBackend : public ILoggingBackend {
 public:
     explicit TErrorFileLoggingBackend(const TString& fileName)
-        : File(new TOFStream(fileName))
+        : File(fileName)
     {
     }
 
@@ -310,11 +316,11 @@ public:
 
     void Flush(const int currentIteration) {
         if (IsFirstIteration) {
-            *File << "iter" << TitleStream.Str() << Endl;
+            File.Write("iter" + TitleStream.Str() + '\n');
             IsFirstIteration = false;
         }
         if (!Stream.Empty()) {
-            *File << currentIteration << Stream.Str() << Endl;
+            File.Write(TStringBuilder() << currentIteration << Stream.Str() << '\n');
             Stream.Clear();
         }
     }
@@ -323,13 +329,13 @@ private:
     bool IsFirstIteration = true;
     TStringStream Stream;
     TStringStream TitleStream;
-    THolder<TOFStream> File;
+    TAsyncLogFile File;
 };
 
 class TTimeFileLoggingBackend : public ILoggingBackend {
 public:
     explicit TTimeFileLoggingBackend(const TString& fileName)
-        : File(new TOFStream(fileName))
+        : File(fileName)
     {
     }
 
@@ -343,10 +349,10 @@ public:
 
     void Flush(const int currentIteration) {
         if (IsFirstIteration) {
-            *File << "iter" << TitleStream.Str() << Endl;
+            File.Write("iter" + TitleStream.Str() + '\n');
             IsFirstIteration = false;
         }
-        *File << currentIteration << Stream.Str() << Endl;
+        File.Write(TStringBuilder() << currentIteration << Stream.Str() << '\n');
         Stream.Clear();
     }
 
@@ -354,7 +360,7 @@ private:
     bool IsFirstIteration = true;
     TStringStream Stream;
     TStringStream TitleStream;
-    THolder<TOFStream> File;
+    TAsyncLogFile File;
 };
 
 class TTensorBoardLoggingBackend : public ILoggingBackend {
@@ -11,11 +11,13 @@ int TTensorBoardLogger::Write(tensorboard::Event& event) {
     uint32_t lenCrc = Mask(Crc32c((char*)&bufLen, sizeof(uint64_t)));
     uint32_t dataCrc = Mask(Crc32c(buf.c_str(), buf.size()));
 
-    OutputStream->Write((char*)&bufLen, sizeof(uint64_t));
-    OutputStream->Write((char*)&lenCrc, sizeof(uint32_t));
-    OutputStream->Write(buf.c_str(), buf.size());
-    OutputStream->Write((char*)&dataCrc, sizeof(uint32_t));
-    OutputStream->Flush();
+    TString record;
+    record.reserve(sizeof(uint64_t) + 2 * sizeof(uint32_t) + buf.size());
+    record.append((char*)&bufLen, sizeof(uint64_t));
+    record.append((char*)&lenCrc, sizeof(uint32_t));
+    record.append(buf.c_str(), buf.size());
+    record.append((char*)&dataCrc, sizeof(uint32_t));
+    OutputFile->Write(std::move(record));
     return 0;
 }
 
@@ -35,7 +37,7 @@ TTensorBoardLogger::TTensorBoardLogger(const TString& logDir) {
         MakePathIfNotExist(logDir.c_str());
     }
     TString logFile = JoinFsPaths(logDir, "events.out.tfevents");
-    OutputStream = THolder<TOFStream>(new TOFStream(logFile));
+    OutputFile = MakeHolder<TAsyncLogFile>(logFile);
 }
 
 int TTensorBoardLogger::AddScalar(const TString& tag, int step, float value) {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "async_log_file.h"
+
 #include "contrib/libs/tensorboard/event.pb.h"
 
 #include <util/generic/string.h>
@@ -15,7 +17,7 @@
 
 class TTensorBoardLogger {
 private:
-    THolder<TOFStream> OutputStream;
+    THolder<TAsyncLogFile> OutputFile;
 
     int AddEvent(int64_t step, THolder<tensorboard::Summary>* summary);
     int Write(tensorboard::Event& event);
@@ -0,0 +1,68 @@
+#include <library/unittest/registar.h>
+
+#include <catboost/libs/loggers/async_log_file.h>
+
+#include <util/random/fast.h>
+#include <util/stream/file.h>
+#include <util/string/cast.h>
+#include <util/system/file.h>
+
+// Same operations as TAsyncLogFile::RewriteTail, but written synchronously
+static void RewriteTailSync(size_t tailSize, const TString& record, TFile* file) {
+    if (tailSize > 0) {
+        file->Seek(-static_cast<i64>(tailSize), sCur);
+    }
+    file->Write(record.data(), record.size());
+}
+
+Y_UNIT_TEST_SUITE(TAsyncLogFileTest) {
+    Y_UNIT_TEST(TestSameAsSyncWrites) {
+        const TString syncFileName = "sync_log.json";
+        const TString asyncFileName = "async_log.json";
+        TReallyFastRng32 rng(1);
+        {
+            TFile syncFile(syncFileName, CreateAlways | WrOnly);
+            TAsyncLogFile asyncFile(asyncFileName);
+            size_t fileSize = 0;
+            size_t lastRecordSize = 0;
+            for (int recordIdx = 0; recordIdx < 10000; ++recordIdx) {
+                const TString record = "{\"iteration\":" + ToString(recordIdx) + "}\n]}";
+                // like the json backend, replace the closing brackets of the previous record,
+                // sometimes the tail is longer than the previous record, so that it spans several flushed batches
+                size_t tailSize = 0;
+                if (recordIdx % 3 == 1) {
+                    tailSize = 3;
+                } else if (recordIdx % 17 == 5) {
+                    tailSize = Min(fileSize, lastRecordSize + rng.Uniform(1, 40));
+                }
+                RewriteTailSync(tailSize, record, &syncFile);
+                asyncFile.RewriteTail(tailSize, record);
+                fileSize = fileSize - tailSize + record.size();
+                lastRecordSize = record.size();
+                if (rng.Uniform(10) == 0) {
+                    asyncFile.Flush();
+                }
+            }
+        }
+        const TString syncLog = TIFStream(syncFileName).ReadAll();
+        const TString asyncLog = TIFStream(asyncFileName).ReadAll();
+        UNIT_ASSERT(!syncLog.empty());
+        UNIT_ASSERT_VALUES_EQUAL(syncLog.size(), asyncLog.size());
+        UNIT_ASSERT(syncLog == asyncLog);
+    }
+
+    Y_UNIT_TEST(TestRewriteFlushedTail) {
+        const TString fileName = "async_log.tsv";
+        {
+            TAsyncLogFile file(fileName);
+            file.Write("first\n");
+            file.Flush();
+            file.Write("second\n");
+            file.Flush();
+            file.Write("third");
+            // spans the unflushed record and both flushed batches
+            file.RewriteTail(/*tailSize*/ 5 + 7 + 2, "rewritten\n");
+        }
+        UNIT_ASSERT_VALUES_EQUAL(TIFStream(fileName).ReadAll(), "firsrewritten\n");
+    }
+}
@@ -2,10 +2,26 @@
 
 #include <library/logger/filter.h>
 
+#include <util/system/tls.h>
+
 namespace NMatrixnetLoggingImpl {
     TStringBuf StripFileName(TStringBuf string) {
         return string.RNextTok(LOCSLASH_C);
     }
+
+    // negative if the thread uses global settings
+    Y_POD_STATIC_THREAD(int)
+    ThreadLogPriority(-1);
+}
+
+TThreadLoggingLevelGuard::TThreadLoggingLevelGuard(ELoggingLevel level)
+    : PrevPriority(NMatrixnetLoggingImpl::ThreadLogPriority)
+{
+    NMatrixnetLoggingImpl::ThreadLogPriority = GetLogPriority(level);
+}
+
+TThreadLoggingLevelGuard::~TThreadLoggingLevelGuard() {
+    NMatrixnetLoggingImpl::ThreadLogPriority = PrevPriority;
 }
 
 class TCustomFuncLogger : public TLogBackend {
@@ -34,6 +50,10 @@ void RestoreOriginalLogger() {
 }
 
 bool TMatrixnetMessageFormater::CheckLoggingContext(TLog&, const TLogRecordContext& context) {
+    const int threadLogPriority = NMatrixnetLoggingImpl::ThreadLogPriority;
+    if (threadLogPriority >= 0) {
+        return context.Priority <= threadLogPriority;
+    }
     return context.Priority <= TMatrixnetLogSettings::GetRef().LogPriority;
 }
 
@@ -4,6 +4,7 @@
 
 #include <library/logger/global/global.h>
 
+#include <util/generic/noncopyable.h>
 #include <util/generic/singleton.h>
 
 class TMatrixnetLogSettings {
@@ -26,23 +27,19 @@ struct TMatrixnetMessageFormater {
     static TSimpleSharedPtr<TLogElement> StartRecord(TLog& logger, const TLogRecordContext& context, TSimpleSharedPtr<TLogElement> earlier);
 };
 
-inline void SetLogingLevel(ELoggingLevel level) {
+inline ELogPriority GetLogPriority(ELoggingLevel level) {
     switch (level) {
         case ELoggingLevel::Silent:{
-            TMatrixnetLogSettings::GetRef().LogPriority = TLOG_WARNING;
-            break;
+            return TLOG_WARNING;
         }
         case ELoggingLevel::Verbose: {
-            TMatrixnetLogSettings::GetRef().LogPriority = TLOG_NOTICE;
-            break;
+            return TLOG_NOTICE;
         }
         case ELoggingLevel::Info: {
-            TMatrixnetLogSettings::GetRef().LogPriority = TLOG_INFO;
-            break;
+            return TLOG_INFO;
         }
         case ELoggingLevel::Debug: {
-            TMatrixnetLogSettings::GetRef().LogPriority = TLOG_DEBUG;
-            break;
+            return TLOG_DEBUG;
         }
         default:{
             ythrow yexception() << "Unknown logging level " << level;
@@ -50,6 +47,10 @@ inline void SetLogingLevel(ELoggingLevel level) {
     }
 }
 
+inline void SetLogingLevel(ELoggingLevel level) {
+    TMatrixnetLogSettings::GetRef().LogPriority = GetLogPriority(level);
+}
+
 inline void SetSilentLogingMode() {
     SetLogingLevel(ELoggingLevel::Silent);
 }
@@ -58,6 +59,18 @@ inline void SetVerboseLogingMode() {
     SetLogingLevel(ELoggingLevel::Debug);
 }
 
+/* Overrides logging level for messages of the current thread while alive,
+ * so concurrent calls (e.g. model application) don't change global logging of each other.
+ */
+class TThreadLoggingLevelGuard : public TNonCopyable {
+public:
+    explicit TThreadLoggingLevelGuard(ELoggingLevel level);
+    ~TThreadLoggingLevelGuard();
+
+private:
+    int PrevPriority;
+};
+
 using TCustomLoggingFunction = void(*)(const char*, size_t len);
 
 void SetCustomLoggingFunction(TCustomLoggingFunction func);
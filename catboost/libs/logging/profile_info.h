@@ -2,6 +2,8 @@
 
 #include "logging.h"
 
+#include <library/chromium_trace/interface.h>
+
 #include <util/ysaveload.h>
 #include <util/generic/map.h>
 #include <util/stream/file.h>
@@ -16,7 +18,8 @@ struct TProfileResults {
         double currentTime = 0,
         int passedIterations = 0,
         TMap<TString, double> operationToTime = {},
-        TMap<TString, double> operationToTimeInAllIterations = {}
+        TMap<TString, double> operationToTimeInAllIterations = {},
+        ui64 scratchAllocations = 0
     )
         : PassedTime(passedTime)
         , RemainingTime(remainingTime)
@@ -25,6 +28,7 @@ struct TProfileResults {
         , PassedIterations(passedIterations)
         , OperationToTime(operationToTime)
         , OperationToTimeInAllIterations(operationToTimeInAllIterations)
+        , ScratchAllocations(scratchAllocations)
     {
     }
 
@@ -35,6 +39,8 @@ struct TProfileResults {
     int PassedIterations;
     TMap<TString, double> OperationToTime;
     TMap<TString, double> OperationToTimeInAllIterations;
+    // allocations of reusable scratch buffers in the iteration, should be zero after warm-up
+    ui64 ScratchAllocations;
 };
 
 struct TProfileInfoData {
@@ -90,6 +96,10 @@ public:
         CurrentTime = 0;
         Timer.Reset();
         OperationToTime.clear();
+        ScratchAllocations = 0;
+        // trace events are created only when trace output is set, see TGlobalJsonFileSink
+        IterationTraceEvent = NChromiumTrace::GetGlobalTracer()->BeginDurationCompleteNow(AsStringBuf("Iteration"), AsStringBuf("profile"));
+        OperationTraceEvent = IterationTraceEvent;
     }
 
     void StartNextIteration() {
@@ -100,10 +110,24 @@ public:
         double passedTime = Timer.PassedReset();
         CurrentTime += passedTime;
         OperationToTime[operation] += passedTime; // operations can be repeated in one iteration
+        if (OperationTraceEvent) {
+            OperationTraceEvent->Name = operation;
+            NChromiumTrace::GetGlobalTracer()->EndDurationCompleteNow(*OperationTraceEvent);
+            OperationTraceEvent->BeginTime = OperationTraceEvent->EndTime;
+        }
+    }
+
+    void AddScratchAllocations(ui64 count) {
+        ScratchAllocations += count;
     }
 
     void FinishIterationBlock(int blockSize) {
         CurrentTime += Timer.PassedReset();
+        if (IterationTraceEvent) {
+            NChromiumTrace::GetGlobalTracer()->EndDurationCompleteNow(*IterationTraceEvent);
+            IterationTraceEvent.Clear();
+            OperationTraceEvent.Clear();
+        }
         double averageTime = ProfileData.PassedIterations == InitIterations + ProfileData.BadIterations ?
                              std::numeric_limits<double>::max() :
                              ProfileData.PassedTime / (ProfileData.PassedIterations - InitIterations - ProfileData.BadIterations);
@@ -135,7 +159,8 @@ public:
             CurrentTime,
             ProfileData.PassedIterations,
             OperationToTime,
-            ProfileData.OperationToTimeInAllIterations
+            ProfileData.OperationToTimeInAllIterations,
+            ScratchAllocations
         };
     }
 
@@ -150,4 +175,7 @@ private:
     double RemainingTime;
     double LocalPassedTime;
     double CurrentTime;
+    ui64 ScratchAllocations = 0;
+    TMaybe<NChromiumTrace::TDurationCompleteEvent> IterationTraceEvent;
+    TMaybe<NChromiumTrace::TDurationCompleteEvent> OperationTraceEvent;
 };
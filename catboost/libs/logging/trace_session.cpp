@@ -0,0 +1,17 @@
+#include "trace_session.h"
+
+#include <util/system/atomic.h>
+
+static TAtomic ActiveTraceSessionCount = 0;
+
+bool IsTraceSessionActive() {
+    return AtomicGet(ActiveTraceSessionCount) > 0;
+}
+
+void TTraceSession::RegisterSession() {
+    AtomicIncrement(ActiveTraceSessionCount);
+}
+
+void TTraceSession::UnregisterSession() {
+    AtomicDecrement(ActiveTraceSessionCount);
+}
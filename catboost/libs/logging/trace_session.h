@@ -0,0 +1,40 @@
+#pragma once
+
+#include <library/chromium_trace/global.h>
+#include <library/chromium_trace/sampler.h>
+#include <library/chromium_trace/samplers.h>
+
+#include <util/datetime/base.h>
+#include <util/generic/noncopyable.h>
+#include <util/generic/string.h>
+
+// True while a trace session is alive, so trace arguments which are costly to compute can be skipped otherwise.
+bool IsTraceSessionActive();
+
+/* Writes chrome trace events (chrome://tracing compatible json) to traceFile while alive.
+ * Process memory is sampled once per second as a counter.
+ */
+class TTraceSession : public TNonCopyable {
+public:
+    explicit TTraceSession(const TString& traceFile)
+        : Sink(traceFile)
+        , Sampler(NChromiumTrace::GetGlobalTracer(), TDuration::Seconds(1))
+    {
+        NChromiumTrace::GetGlobalTracer()->AddCurrentProcessName(AsStringBuf("catboost"));
+        Sampler->AddSampler(NChromiumTrace::TMemInfoSampler());
+        Sampler->Start();
+        RegisterSession();
+    }
+
+    ~TTraceSession() {
+        UnregisterSession();
+    }
+
+private:
+    static void RegisterSession();
+    static void UnregisterSession();
+
+private:
+    NChromiumTrace::TGlobalJsonFileSink Sink;
+    NChromiumTrace::TSamplerHolder Sampler; // should be stopped before Sink is closed
+};
@@ -11,7 +11,8 @@ void NCatboost::NCoreML::ConfigureTrees(const TFullModel& model, TreeEnsemblePar
     CB_ENSURE(model.ObliviousTrees.CatFeatures.empty(), "model with only float features supported");
     auto& binFeatures = model.ObliviousTrees.GetBinFeatures();
     size_t currentSplitIndex = 0;
-    auto currentTreeFirstLeafPtr = model.ObliviousTrees.LeafValues.data();
+    const TDoubleLeafValues leafValues(model.ObliviousTrees);
+    auto currentTreeFirstLeafPtr = leafValues.GetLeafValues();
     for (size_t treeIdx = 0; treeIdx < model.ObliviousTrees.TreeSizes.size(); ++treeIdx) {
         const size_t leafCount = (1uLL << model.ObliviousTrees.TreeSizes[treeIdx]);
         size_t lastNodeId = 0;
@@ -5,8 +5,19 @@
 #include "features.h"
 #include "ctr_value_table.h"
 #include <util/generic/array_ref.h>
+#include <util/generic/ptr.h>
 
 
+/**
+ * Data prepared by a CTR provider for repeated CalcCtrs calls with the same needed ctrs, e.g. ctrs grouped
+ * by feature combinations. Models keep it in their metadata, see TFullModel::UpdateDynamicData.
+ */
+class ICtrCalcPlan : public TThrRefBase {
+public:
+    virtual ~ICtrCalcPlan() {
+    }
+};
+
 class ICtrProvider : public TThrRefBase {
 public:
     virtual ~ICtrProvider() {
@@ -19,7 +30,12 @@ public:
         const TConstArrayRef<ui8>& binarizedFeatures, // vector of binarized float & one hot features
         const TConstArrayRef<int>& hashedCatFeatures,
         size_t docCount,
-        TArrayRef<float> result) = 0;
+        TArrayRef<float> result,
+        const ICtrCalcPlan* ctrCalcPlan) = 0; // null or stale plan is ignored
+
+    virtual TIntrusivePtr<ICtrCalcPlan> CreateCtrCalcPlan(const TVector<TModelCtr>& /*neededCtrs*/) const {
+        return nullptr;
+    }
 
     virtual void SetupBinFeatureIndexes(
         const TVector<TFloatFeature>& floatFeatures,
@@ -69,6 +85,9 @@ struct TBinFeatureIndexValue {
         , CheckValueEqual(checkValueEqual)
         , Value(value)
     {}
+    bool operator==(const TBinFeatureIndexValue& other) const {
+        return std::tie(BinIndex, CheckValueEqual, Value) == std::tie(other.BinIndex, other.CheckValueEqual, other.Value);
+    }
 };
 
 inline void CalcHashes(
@@ -219,32 +219,75 @@ Y_FORCE_INLINE void CalcIndexesSse(
 #undef STORE_16_DOCS_RESULT
 }
 
-template<typename TIndexType>
-Y_FORCE_INLINE void CalculateLeafValues(const size_t docCountInBlock, const double* __restrict treeLeafPtr, const TIndexType* __restrict indexesPtr, double* __restrict writePtr) {
+template<typename TLeafValue>
+static inline const TLeafValue* GetLeafValuesPtr(const TObliviousTrees& trees);
+
+template<>
+inline const double* GetLeafValuesPtr<double>(const TObliviousTrees& trees) {
+    return trees.LeafValues.data();
+}
+
+template<>
+inline const float* GetLeafValuesPtr<float>(const TObliviousTrees& trees) {
+    return trees.FloatLeafValues.data();
+}
+
+template<>
+inline const i16* GetLeafValuesPtr<i16>(const TObliviousTrees& trees) {
+    return trees.Int16LeafValues.data();
+}
+
+template<typename TLeafValue>
+static inline double GetLeafValuesScale(const TObliviousTrees&, size_t) {
+    return 1.0;
+}
+
+template<>
+inline double GetLeafValuesScale<i16>(const TObliviousTrees& trees, size_t treeId) {
+    return trees.Int16LeafValueScales[treeId];
+}
+
+// double and float leaf values are added as is, int16 leaf values are multiplied by the scale of their tree
+Y_FORCE_INLINE double DecodeLeafValue(double leafValue, double) {
+    return leafValue;
+}
+
+Y_FORCE_INLINE double DecodeLeafValue(float leafValue, double) {
+    return leafValue;
+}
+
+Y_FORCE_INLINE double DecodeLeafValue(i16 leafValue, double scale) {
+    return leafValue * scale;
+}
+
+template<typename TLeafValue, typename TIndexType>
+Y_FORCE_INLINE void CalculateLeafValues(const size_t docCountInBlock, const TLeafValue* __restrict treeLeafPtr, const double scale, const TIndexType* __restrict indexesPtr, double* __restrict writePtr) {
     Y_PREFETCH_READ(treeLeafPtr, 3);
     Y_PREFETCH_READ(treeLeafPtr + 128, 3);
     const auto docCountInBlock4 = (docCountInBlock | 0x3) ^ 0x3;
     for (size_t docId = 0; docId < docCountInBlock4; docId += 4) {
-        writePtr[0] += treeLeafPtr[indexesPtr[0]];
-        writePtr[1] += treeLeafPtr[indexesPtr[1]];
-        writePtr[2] += treeLeafPtr[indexesPtr[2]];
-        writePtr[3] += treeLeafPtr[indexesPtr[3]];
+        writePtr[0] += DecodeLeafValue(treeLeafPtr[indexesPtr[0]], scale);
+        writePtr[1] += DecodeLeafValue(treeLeafPtr[indexesPtr[1]], scale);
+        writePtr[2] += DecodeLeafValue(treeLeafPtr[indexesPtr[2]], scale);
+        writePtr[3] += DecodeLeafValue(treeLeafPtr[indexesPtr[3]], scale);
         writePtr += 4;
         indexesPtr += 4;
     }
     for (size_t docId = docCountInBlock4; docId < docCountInBlock; ++docId) {
-        *writePtr += treeLeafPtr[*indexesPtr];
+        *writePtr += DecodeLeafValue(treeLeafPtr[*indexesPtr], scale);
         ++writePtr;
         ++indexesPtr;
     }
 }
 
-template<int SSEBlockCount>
-Y_FORCE_INLINE static void GatherAddLeafSSE(const double* __restrict treeLeafPtr, const ui8* __restrict indexesPtr, __m128d* __restrict writePtr) {
+template<int SSEBlockCount, typename TLeafValue>
+Y_FORCE_INLINE static void GatherAddLeafSSE(const TLeafValue* __restrict treeLeafPtr, const double scale, const ui8* __restrict indexesPtr, __m128d* __restrict writePtr) {
     _mm_prefetch((const char*)(treeLeafPtr + 64), _MM_HINT_T2);
 
     for (size_t blockId = 0; blockId < SSEBlockCount; ++blockId) {
-#define GATHER_LEAFS(subBlock) const __m128d additions##subBlock = _mm_set_pd(treeLeafPtr[indexesPtr[subBlock * 2 + 1]], treeLeafPtr[indexesPtr[subBlock * 2 + 0]]);
+#define GATHER_LEAFS(subBlock) const __m128d additions##subBlock = _mm_set_pd(\
+            DecodeLeafValue(treeLeafPtr[indexesPtr[subBlock * 2 + 1]], scale),\
+            DecodeLeafValue(treeLeafPtr[indexesPtr[subBlock * 2 + 0]], scale));
 #define ADD_LEAFS(subBlock) writePtr[subBlock] = _mm_add_pd(writePtr[subBlock], additions##subBlock);
 
         GATHER_LEAFS(0);
@@ -271,13 +314,14 @@ Y_FORCE_INLINE static void GatherAddLeafSSE(const double* __restrict treeLeafPtr
 #undef ADD_LEAFS
 }
 
-template<int SSEBlockCount>
+template<int SSEBlockCount, typename TLeafValue>
 Y_FORCE_INLINE void CalculateLeafValues4(
     const size_t docCountInBlock,
-    const double* __restrict treeLeafPtr0,
-    const double* __restrict treeLeafPtr1,
-    const double* __restrict treeLeafPtr2,
-    const double* __restrict treeLeafPtr3,
+    const TLeafValue* __restrict treeLeafPtr0,
+    const TLeafValue* __restrict treeLeafPtr1,
+    const TLeafValue* __restrict treeLeafPtr2,
+    const TLeafValue* __restrict treeLeafPtr3,
+    const double* __restrict scales,
     const ui8* __restrict indexesPtr0,
     const ui8* __restrict indexesPtr1,
     const ui8* __restrict indexesPtr2,
@@ -287,10 +331,10 @@ Y_FORCE_INLINE void CalculateLeafValues4(
     const auto docCountInBlock16 = SSEBlockCount * 16;
     if (SSEBlockCount > 0) {
         _mm_prefetch((const char*)(writePtr), _MM_HINT_T2);
-        GatherAddLeafSSE<SSEBlockCount>(treeLeafPtr0, indexesPtr0, (__m128d*)writePtr);
-        GatherAddLeafSSE<SSEBlockCount>(treeLeafPtr1, indexesPtr1, (__m128d*)writePtr);
-        GatherAddLeafSSE<SSEBlockCount>(treeLeafPtr2, indexesPtr2, (__m128d*)writePtr);
-        GatherAddLeafSSE<SSEBlockCount>(treeLeafPtr3, indexesPtr3, (__m128d*)writePtr);
+        GatherAddLeafSSE<SSEBlockCount>(treeLeafPtr0, scales[0], indexesPtr0, (__m128d*)writePtr);
+        GatherAddLeafSSE<SSEBlockCount>(treeLeafPtr1, scales[1], indexesPtr1, (__m128d*)writePtr);
+        GatherAddLeafSSE<SSEBlockCount>(treeLeafPtr2, scales[2], indexesPtr2, (__m128d*)writePtr);
+        GatherAddLeafSSE<SSEBlockCount>(treeLeafPtr3, scales[3], indexesPtr3, (__m128d*)writePtr);
     }
     if (SSEBlockCount != 8) {
         indexesPtr0 += SSE_BLOCK_SIZE * SSEBlockCount;
@@ -299,7 +343,11 @@ Y_FORCE_INLINE void CalculateLeafValues4(
         indexesPtr3 += SSE_BLOCK_SIZE * SSEBlockCount;
         writePtr += SSE_BLOCK_SIZE * SSEBlockCount;
         for (size_t docId = docCountInBlock16; docId < docCountInBlock; ++docId) {
-            *writePtr = *writePtr + treeLeafPtr0[*indexesPtr0] + treeLeafPtr1[*indexesPtr1] + treeLeafPtr2[*indexesPtr2] + treeLeafPtr3[*indexesPtr3];
+            *writePtr = *writePtr
+                + DecodeLeafValue(treeLeafPtr0[*indexesPtr0], scales[0])
+                + DecodeLeafValue(treeLeafPtr1[*indexesPtr1], scales[1])
+                + DecodeLeafValue(treeLeafPtr2[*indexesPtr2], scales[2])
+                + DecodeLeafValue(treeLeafPtr3[*indexesPtr3], scales[3]);
             ++writePtr;
             ++indexesPtr0;
             ++indexesPtr1;
@@ -309,18 +357,18 @@ Y_FORCE_INLINE void CalculateLeafValues4(
     }
 }
 
-template<typename TIndexType>
-Y_FORCE_INLINE void CalculateLeafValuesMulti(const size_t docCountInBlock, const double* __restrict leafPtr, const TIndexType* __restrict indexesVec, const int approxDimension, double* __restrict writePtr) {
+template<typename TLeafValue, typename TIndexType>
+Y_FORCE_INLINE void CalculateLeafValuesMulti(const size_t docCountInBlock, const TLeafValue* __restrict leafPtr, const double scale, const TIndexType* __restrict indexesVec, const int approxDimension, double* __restrict writePtr) {
     for (size_t docId = 0; docId < docCountInBlock; ++docId) {
         auto leafValuePtr = leafPtr + indexesVec[docId] * approxDimension;
         for (int classId = 0; classId < approxDimension; ++classId) {
-            writePtr[classId] += leafValuePtr[classId];
+            writePtr[classId] += DecodeLeafValue(leafValuePtr[classId], scale);
         }
         writePtr += approxDimension;
     }
 }
 
-template<bool IsSingleClassModel, bool NeedXorMask, int SSEBlockCount>
+template<bool IsSingleClassModel, bool NeedXorMask, typename TLeafValue, int SSEBlockCount>
 Y_FORCE_INLINE void CalcTreesBlockedImpl(
     const TFullModel& model,
     const ui8* __restrict binFeatures,
@@ -339,7 +387,7 @@ Y_FORCE_INLINE void CalcTreesBlockedImpl(
         [](int depth) { return depth <= 8; }
     );
     ui8* __restrict indexesVec = (ui8*)indexesVecUI32;
-    const auto treeLeafPtr = model.ObliviousTrees.LeafValues.data();
+    const TLeafValue* treeLeafPtr = GetLeafValuesPtr<TLeafValue>(model.ObliviousTrees);
     auto firstLeafOffsetsPtr = model.ObliviousTrees.GetFirstLeafOffsets().data();
     if (IsSingleClassModel && allTreesAreShallow) {
         auto alignedResultsPtr = resultsPtr;
@@ -366,12 +414,19 @@ Y_FORCE_INLINE void CalcTreesBlockedImpl(
             CalcIndexesSse<NeedXorMask, SSEBlockCount>(binFeatures, docCountInBlock, indexesVec + docCountInBlock * 3, treeSplitsCurPtr, model.ObliviousTrees.TreeSizes[treeId + 3]);
             treeSplitsCurPtr += model.ObliviousTrees.TreeSizes[treeId + 3];
 
+            const double scales[4] = {
+                GetLeafValuesScale<TLeafValue>(model.ObliviousTrees, treeId + 0),
+                GetLeafValuesScale<TLeafValue>(model.ObliviousTrees, treeId + 1),
+                GetLeafValuesScale<TLeafValue>(model.ObliviousTrees, treeId + 2),
+                GetLeafValuesScale<TLeafValue>(model.ObliviousTrees, treeId + 3)
+            };
             CalculateLeafValues4<SSEBlockCount>(
                 docCountInBlock,
                 treeLeafPtr + firstLeafOffsetsPtr[treeId + 0],
                 treeLeafPtr + firstLeafOffsetsPtr[treeId + 1],
                 treeLeafPtr + firstLeafOffsetsPtr[treeId + 2],
                 treeLeafPtr + firstLeafOffsetsPtr[treeId + 3],
+                scales,
                 indexesVec + docCountInBlock * 0,
                 indexesVec + docCountInBlock * 1,
                 indexesVec + docCountInBlock * 2,
@@ -386,27 +441,28 @@ Y_FORCE_INLINE void CalcTreesBlockedImpl(
     }
     for (size_t treeId = treeStart; treeId < treeEnd; ++treeId) {
         auto curTreeSize = model.ObliviousTrees.TreeSizes[treeId];
+        const double scale = GetLeafValuesScale<TLeafValue>(model.ObliviousTrees, treeId);
         memset(indexesVec, 0, sizeof(ui32) * docCountInBlock);
         if (curTreeSize <= 8) {
             CalcIndexesSse<NeedXorMask, SSEBlockCount>(binFeatures, docCountInBlock, indexesVec, treeSplitsCurPtr, curTreeSize);
             if (IsSingleClassModel) { // single class model
-                CalculateLeafValues(docCountInBlock, treeLeafPtr + firstLeafOffsetsPtr[treeId], indexesVec, resultsPtr);
+                CalculateLeafValues(docCountInBlock, treeLeafPtr + firstLeafOffsetsPtr[treeId], scale, indexesVec, resultsPtr);
             } else { // mutliclass model
-                CalculateLeafValuesMulti(docCountInBlock, treeLeafPtr + firstLeafOffsetsPtr[treeId], indexesVec, model.ObliviousTrees.ApproxDimension, resultsPtr);
+                CalculateLeafValuesMulti(docCountInBlock, treeLeafPtr + firstLeafOffsetsPtr[treeId], scale, indexesVec, model.ObliviousTrees.ApproxDimension, resultsPtr);
             }
         } else {
             CalcIndexesBasic<NeedXorMask, 0>(binFeatures, docCountInBlock, indexesVecUI32, treeSplitsCurPtr, curTreeSize);
             if (IsSingleClassModel) { // single class model
-                CalculateLeafValues(docCountInBlock, treeLeafPtr + firstLeafOffsetsPtr[treeId], indexesVecUI32, resultsPtr);
+                CalculateLeafValues(docCountInBlock, treeLeafPtr + firstLeafOffsetsPtr[treeId], scale, indexesVecUI32, resultsPtr);
             } else { // mutliclass model
-                CalculateLeafValuesMulti(docCountInBlock, treeLeafPtr + firstLeafOffsetsPtr[treeId], indexesVecUI32, model.ObliviousTrees.ApproxDimension, resultsPtr);
+                CalculateLeafValuesMulti(docCountInBlock, treeLeafPtr + firstLeafOffsetsPtr[treeId], scale, indexesVecUI32, model.ObliviousTrees.ApproxDimension, resultsPtr);
             }
         }
         treeSplitsCurPtr += curTreeSize;
     }
 }
 
-template<bool IsSingleClassModel, bool NeedXorMask>
+template<bool IsSingleClassModel, bool NeedXorMask, typename TLeafValue>
 inline void CalcTreesBlocked(
     const TFullModel& model,
     const ui8* __restrict binFeatures,
@@ -417,38 +473,38 @@ inline void CalcTreesBlocked(
     double* __restrict resultsPtr) {
     switch (docCountInBlock / SSE_BLOCK_SIZE) {
     case 0:
-        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, 0>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
+        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, TLeafValue, 0>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
         break;
     case 1:
-        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, 1>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
+        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, TLeafValue, 1>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
         break;
     case 2:
-        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, 2>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
+        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, TLeafValue, 2>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
         break;
     case 3:
-        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, 3>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
+        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, TLeafValue, 3>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
         break;
     case 4:
-        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, 4>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
+        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, TLeafValue, 4>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
         break;
     case 5:
-        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, 5>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
+        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, TLeafValue, 5>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
         break;
     case 6:
-        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, 6>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
+        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, TLeafValue, 6>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
         break;
     case 7:
-        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, 7>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
+        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, TLeafValue, 7>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
         break;
     case 8:
-        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, 8>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
+        CalcTreesBlockedImpl<IsSingleClassModel, NeedXorMask, TLeafValue, 8>(model, binFeatures, docCountInBlock, indexesVec, treeStart, treeEnd, resultsPtr);
         break;
     default:
         Y_UNREACHABLE();
     }
 }
 
-template<bool IsSingleClassModel, bool NeedXorMask>
+template<bool IsSingleClassModel, bool NeedXorMask, typename TLeafValue>
 inline void CalcTreesSingleDocImpl(
     const TFullModel& model,
     const ui8* __restrict binFeatures,
@@ -461,9 +517,10 @@ inline void CalcTreesSingleDocImpl(
     const TRepackedBin* treeSplitsCurPtr =
         model.ObliviousTrees.GetRepackedBins().data() + model.ObliviousTrees.TreeStartOffsets[treeStart];
     double result = 0.0;
-    const double* treeLeafPtr = model.ObliviousTrees.GetFirstLeafPtrForTree(treeStart);
+    const TLeafValue* treeLeafPtr = GetLeafValuesPtr<TLeafValue>(model.ObliviousTrees) + model.ObliviousTrees.GetFirstLeafOffsets()[treeStart];
     for (size_t treeId = treeStart; treeId < treeEnd; ++treeId) {
         const auto curTreeSize = model.ObliviousTrees.TreeSizes[treeId];
+        const double scale = GetLeafValuesScale<TLeafValue>(model.ObliviousTrees, treeId);
         TCalcerIndexType index = 0;
         for (int depth = 0; depth < curTreeSize; ++depth) {
             const ui8 borderVal = (ui8)(treeSplitsCurPtr[depth].SplitIdx);
@@ -476,11 +533,11 @@ inline void CalcTreesSingleDocImpl(
             }
         }
         if (IsSingleClassModel) { // single class model
-            result += treeLeafPtr[index];
+            result += DecodeLeafValue(treeLeafPtr[index], scale);
         } else { // mutliclass model
             auto leafValuePtr = treeLeafPtr + index * model.ObliviousTrees.ApproxDimension;
             for (int classId = 0; classId < model.ObliviousTrees.ApproxDimension; ++classId) {
-                results[classId] += leafValuePtr[classId];
+                results[classId] += DecodeLeafValue(leafValuePtr[classId], scale);
             }
         }
         treeLeafPtr += (1 << curTreeSize) * model.ObliviousTrees.ApproxDimension;
@@ -491,35 +548,47 @@ inline void CalcTreesSingleDocImpl(
     }
 }
 
-TTreeCalcFunction GetCalcTreesFunction(const TFullModel& model, size_t docCountInBlock) {
+template<typename TLeafValue>
+static TTreeCalcFunction GetCalcTreesFunctionImpl(const TFullModel& model, size_t docCountInBlock) {
     const bool hasOneHots = !model.ObliviousTrees.OneHotFeatures.empty();
     if (model.ObliviousTrees.ApproxDimension == 1) {
         if (docCountInBlock == 1) {
             if (hasOneHots) {
-                return CalcTreesSingleDocImpl<true, true>;
+                return CalcTreesSingleDocImpl<true, true, TLeafValue>;
             } else {
-                return CalcTreesSingleDocImpl<true, false>;
+                return CalcTreesSingleDocImpl<true, false, TLeafValue>;
             }
         } else {
             if (hasOneHots) {
-                return CalcTreesBlocked<true, true>;
+                return CalcTreesBlocked<true, true, TLeafValue>;
             } else {
-                return CalcTreesBlocked<true, false>;
+                return CalcTreesBlocked<true, false, TLeafValue>;
             }
         }
     } else {
         if (docCountInBlock == 1) {
             if (hasOneHots) {
-                return CalcTreesSingleDocImpl<false, true>;
+                return CalcTreesSingleDocImpl<false, true, TLeafValue>;
             } else {
-                return CalcTreesSingleDocImpl<false, false>;
+                return CalcTreesSingleDocImpl<false, false, TLeafValue>;
             }
         } else {
             if (hasOneHots) {
-                return CalcTreesBlocked<false, true>;
+                return CalcTreesBlocked<false, true, TLeafValue>;
             } else {
-                return CalcTreesBlocked<false, false>;
+                return CalcTreesBlocked<false, false, TLeafValue>;
             }
         }
     }
 }
+
+TTreeCalcFunction GetCalcTreesFunction(const TFullModel& model, size_t docCountInBlock) {
+    switch (model.ObliviousTrees.LeafValuesPrecision) {
+        case NCatBoostFbs::ELeafValuesPrecision_Float:
+            return GetCalcTreesFunctionImpl<float>(model, docCountInBlock);
+        case NCatBoostFbs::ELeafValuesPrecision_Int16:
+            return GetCalcTreesFunctionImpl<i16>(model, docCountInBlock);
+        default:
+            return GetCalcTreesFunctionImpl<double>(model, docCountInBlock);
+    }
+}
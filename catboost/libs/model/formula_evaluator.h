@@ -3,13 +3,14 @@
 #include "model.h"
 #include <catboost/libs/helpers/exception.h>
 #include <util/generic/ymath.h>
+#include <util/system/tls.h>
 #include <emmintrin.h>
 
 constexpr size_t FORMULA_EVALUATION_BLOCK_SIZE = 128;
 
 inline void OneHotBinsFromTransposedCatFeatures(
     const TVector<TOneHotFeature>& OneHotFeatures,
-    const THashMap<int, int> catFeaturePackedIndex,
+    const THashMap<int, int>& catFeaturePackedIndex,
     const size_t docCount,
     ui8*& result,
     TVector<int>& transposedHash) {
@@ -214,17 +215,14 @@ inline void BinarizeFeatures(
                 idx += docCount;
             }
         }
-        THashMap<int, int> catFeaturePackedIndexes;
-        for (int i = 0; i < model.ObliviousTrees.CatFeatures.ysize(); ++i) {
-            catFeaturePackedIndexes[model.ObliviousTrees.CatFeatures[i].FeatureIndex] = i;
-        }
-        OneHotBinsFromTransposedCatFeatures(model.ObliviousTrees.OneHotFeatures, catFeaturePackedIndexes, docCount, resultPtr, transposedHash);
+        OneHotBinsFromTransposedCatFeatures(model.ObliviousTrees.OneHotFeatures, model.ObliviousTrees.GetCatFeaturePackedIndexes(), docCount, resultPtr, transposedHash);
         model.CtrProvider->CalcCtrs(
             model.ObliviousTrees.GetUsedModelCtrs(),
             result,
             transposedHash,
             docCount,
-            ctrs
+            ctrs,
+            model.ObliviousTrees.GetCtrCalcPlan()
         );
         for (size_t i = 0; i < model.ObliviousTrees.CtrFeatures.size(); ++i) {
             const auto& ctr = model.ObliviousTrees.CtrFeatures[i];
@@ -292,8 +290,13 @@ inline void CalcGeneric(
     if (docCount == 1) {
         CB_ENSURE((int)results.size() == model.ObliviousTrees.ApproxDimension);
         std::fill(results.begin(), results.end(), 0.0);
-        TVector<int> transposedHash(model.ObliviousTrees.CatFeatures.size());
-        TVector<float> ctrs(model.ObliviousTrees.GetUsedModelCtrs().size());
+        // single documents are scored in a loop, so the buffers are reused between calls
+        Y_STATIC_THREAD(TVector<int>) transposedHashTls;
+        Y_STATIC_THREAD(TVector<float>) ctrsTls;
+        TVector<int>& transposedHash = transposedHashTls.Get();
+        TVector<float>& ctrs = ctrsTls.Get();
+        transposedHash.yresize(model.ObliviousTrees.CatFeatures.size());
+        ctrs.yresize(model.ObliviousTrees.GetUsedModelCtrs().size());
         BinarizeFeatures(
             model,
             floatFeatureAccessor,
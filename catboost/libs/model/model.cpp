@@ -15,11 +15,19 @@
 
 #include <library/json/json_reader.h>
 
+#include <util/generic/algorithm.h>
+#include <util/generic/ylimits.h>
+#include <util/generic/ymath.h>
 #include <util/string/builder.h>
+#include <util/string/cast.h>
+#include <util/string/iterator.h>
+#include <util/string/join.h>
 #include <util/stream/buffer.h>
 #include <util/stream/str.h>
 #include <util/stream/file.h>
 
+#include <cmath>
+
 static const char MODEL_FILE_DESCRIPTOR_CHARS[4] = {'C', 'B', 'M', '1'};
 
 ui32 GetModelFormatDescriptor() {
@@ -27,6 +35,8 @@ ui32 GetModelFormatDescriptor() {
 }
 
 static const char* CURRENT_CORE_FORMAT_STRING = "FlabuffersModel_v1";
+// compact models can't be read by older versions, so they have their own format string
+static const char* COMPACT_CORE_FORMAT_STRING = "FlabuffersModel_v1_compact";
 
 void OutputModel(const TFullModel& model, const TString& modelFile) {
     TOFStream f(modelFile);
@@ -144,10 +154,53 @@ namespace {
         vector->erase(vector->begin(), vector->begin() + begin);
         vector->erase(vector->begin() + (end - begin), vector->end());
     }
+
+    /* Least power of two scale with maxAbsValue <= Max<i16>() * scale, so int16 leaf values multiplied by it
+     * are exact in float and double, and the scale of already quantized leaves is the same or a lossless smaller one.
+     */
+    float GetInt16LeafValueScale(const double* leafValues, size_t leafValueCount) {
+        double maxAbsValue = 0;
+        for (size_t i = 0; i < leafValueCount; ++i) {
+            maxAbsValue = Max(maxAbsValue, Abs(leafValues[i]));
+        }
+        if (maxAbsValue == 0) {
+            return 1.0f;
+        }
+        int exponent = 0;
+        const double mantissa = std::frexp(maxAbsValue / Max<i16>(), &exponent);
+        if (mantissa == 0.5) {
+            --exponent; // the value is a power of two itself
+        }
+        return std::ldexp(1.0f, Max(exponent, -149));
+    }
+
+    i16 QuantizeToInt16(double value, float scale) {
+        return static_cast<i16>(ClampVal<double>(std::round(value / scale), -Max<i16>(), Max<i16>()));
+    }
+
+    template<typename TLeafValue>
+    void ReorderLeafValues(
+        const TVector<size_t>& treeOrder,
+        const TVector<int>& treeSizes,
+        const TVector<size_t>& treeFirstLeafOffsets,
+        int approxDimension,
+        TVector<TLeafValue>* leafValues
+    ) {
+        TVector<TLeafValue> reorderedLeafValues;
+        reorderedLeafValues.reserve(leafValues->size());
+        for (size_t treeIdx : treeOrder) {
+            const auto treeLeafValuesBegin = leafValues->begin() + treeFirstLeafOffsets[treeIdx];
+            reorderedLeafValues.insert(reorderedLeafValues.end(), treeLeafValuesBegin, treeLeafValuesBegin + (1 << treeSizes[treeIdx]) * approxDimension);
+        }
+        leafValues->swap(reorderedLeafValues);
+    }
 }
 
 void TObliviousTrees::Truncate(size_t begin, size_t end) {
     auto originalTreeCount = TreeSizes.size();
+    const size_t leafValueCount = GetLeafValueCount();
+    const size_t firstLeafIdx = (begin == originalTreeCount) ? leafValueCount : MetaData->TreeFirstLeafOffsets[begin];
+    const size_t lastLeafIdx = (end == originalTreeCount) ? leafValueCount : MetaData->TreeFirstLeafOffsets[end];
     auto treeBinStart = TreeSplits.begin() + TreeStartOffsets[begin];
     TreeSplits.erase(TreeSplits.begin(), treeBinStart);
     if (end != originalTreeCount) {
@@ -161,8 +214,62 @@ void TObliviousTrees::Truncate(size_t begin, size_t end) {
             TreeStartOffsets[i] = TreeStartOffsets[i - 1] + TreeSizes[i - 1];
         }
     }
-    size_t lastLeafIdx = (end == originalTreeCount) ? LeafValues.size() : MetaData->TreeFirstLeafOffsets[end];
-    TruncateVector(MetaData->TreeFirstLeafOffsets[begin], lastLeafIdx, &LeafValues);
+    switch (LeafValuesPrecision) {
+        case NCatBoostFbs::ELeafValuesPrecision_Double:
+            TruncateVector(firstLeafIdx, lastLeafIdx, &LeafValues);
+            break;
+        case NCatBoostFbs::ELeafValuesPrecision_Float:
+            TruncateVector(firstLeafIdx, lastLeafIdx, &FloatLeafValues);
+            break;
+        case NCatBoostFbs::ELeafValuesPrecision_Int16:
+            TruncateVector(firstLeafIdx, lastLeafIdx, &Int16LeafValues);
+            TruncateVector(begin, end, &Int16LeafValueScales);
+            break;
+    }
+    UpdateMetadata();
+}
+
+void TObliviousTrees::ReorderTrees(const TVector<size_t>& treeOrder) {
+    CB_ENSURE(treeOrder.size() == TreeSizes.size(), "Tree order should contain all trees");
+    TVector<bool> isTreeUsed(TreeSizes.size(), false);
+    TVector<int> treeSplits;
+    TVector<int> treeSizes;
+    TVector<float> int16LeafValueScales;
+    TVector<TVector<double>> leafWeights;
+    treeSplits.reserve(TreeSplits.size());
+    treeSizes.reserve(TreeSizes.size());
+    for (size_t treeIdx : treeOrder) {
+        CB_ENSURE(treeIdx < TreeSizes.size() && !isTreeUsed[treeIdx], "Tree order should be a permutation");
+        isTreeUsed[treeIdx] = true;
+        const auto treeSplitsBegin = TreeSplits.begin() + TreeStartOffsets[treeIdx];
+        treeSplits.insert(treeSplits.end(), treeSplitsBegin, treeSplitsBegin + TreeSizes[treeIdx]);
+        treeSizes.push_back(TreeSizes[treeIdx]);
+        if (!Int16LeafValueScales.empty()) {
+            int16LeafValueScales.push_back(Int16LeafValueScales[treeIdx]);
+        }
+        if (!LeafWeights.empty()) {
+            leafWeights.push_back(LeafWeights[treeIdx]);
+        }
+    }
+    const auto& treeFirstLeafOffsets = MetaData->TreeFirstLeafOffsets;
+    switch (LeafValuesPrecision) {
+        case NCatBoostFbs::ELeafValuesPrecision_Double:
+            ReorderLeafValues(treeOrder, TreeSizes, treeFirstLeafOffsets, ApproxDimension, &LeafValues);
+            break;
+        case NCatBoostFbs::ELeafValuesPrecision_Float:
+            ReorderLeafValues(treeOrder, TreeSizes, treeFirstLeafOffsets, ApproxDimension, &FloatLeafValues);
+            break;
+        case NCatBoostFbs::ELeafValuesPrecision_Int16:
+            ReorderLeafValues(treeOrder, TreeSizes, treeFirstLeafOffsets, ApproxDimension, &Int16LeafValues);
+            break;
+    }
+    TreeSplits.swap(treeSplits);
+    TreeSizes.swap(treeSizes);
+    Int16LeafValueScales.swap(int16LeafValueScales);
+    LeafWeights.swap(leafWeights);
+    for (size_t i = 0; i < TreeSizes.size(); ++i) {
+        TreeStartOffsets[i] = (i == 0) ? 0 : TreeStartOffsets[i - 1] + TreeSizes[i - 1];
+    }
     UpdateMetadata();
 }
 
@@ -192,21 +299,83 @@ TObliviousTrees::FBSerialize(TModelPartsCachingSerializer& serializer) const {
                 oneTreeLeafWeights.end()
         );
     }
+    const bool isCompact = LeafValuesPrecision != NCatBoostFbs::ELeafValuesPrecision_Double;
+    TVector<ui16> compactTreeSplits;
+    if (isCompact) {
+        CB_ENSURE(GetBinaryFeaturesFullCount() <= (size_t)Max<ui16>() + 1, "Too many binary features for compact model");
+        compactTreeSplits.assign(TreeSplits.begin(), TreeSplits.end());
+    }
+    const bool isInt16 = LeafValuesPrecision == NCatBoostFbs::ELeafValuesPrecision_Int16;
     return NCatBoostFbs::CreateTObliviousTreesDirect(
         serializer.FlatbufBuilder,
         ApproxDimension,
-        &TreeSplits,
+        isCompact ? nullptr : &TreeSplits,
         &TreeSizes,
         &TreeStartOffsets,
         &catFeaturesOffsets,
         &floatFeaturesOffsets,
         &oneHotFeaturesOffsets,
         &ctrFeaturesOffsets,
-        &LeafValues,
-        &flatLeafWeights
+        isCompact ? nullptr : &LeafValues,
+        &flatLeafWeights,
+        LeafValuesPrecision,
+        isCompact ? &compactTreeSplits : nullptr,
+        LeafValuesPrecision == NCatBoostFbs::ELeafValuesPrecision_Float ? &FloatLeafValues : nullptr,
+        isInt16 ? &Int16LeafValues : nullptr,
+        isInt16 ? &Int16LeafValueScales : nullptr
     );
 }
 
+size_t TObliviousTrees::GetLeafValueCount() const {
+    size_t leafValueCount = 0;
+    for (const auto treeSize : TreeSizes) {
+        leafValueCount += (1 << treeSize) * ApproxDimension;
+    }
+    return leafValueCount;
+}
+
+void TObliviousTrees::CheckLeafValuesSize() const {
+    const size_t leafValueCount = GetLeafValueCount();
+    switch (LeafValuesPrecision) {
+        case NCatBoostFbs::ELeafValuesPrecision_Double:
+            break;
+        case NCatBoostFbs::ELeafValuesPrecision_Float:
+            CB_ENSURE(FloatLeafValues.size() == leafValueCount, "Incorrect leaf values in compact model");
+            break;
+        case NCatBoostFbs::ELeafValuesPrecision_Int16:
+            CB_ENSURE(
+                Int16LeafValues.size() == leafValueCount && Int16LeafValueScales.size() == TreeSizes.size(),
+                "Incorrect leaf values in compact model"
+            );
+            break;
+        default:
+            CB_ENSURE(false, "Unsupported leaf values precision");
+    }
+}
+
+void TObliviousTrees::DecodeLeafValues(TVector<double>* leafValues) const {
+    switch (LeafValuesPrecision) {
+        case NCatBoostFbs::ELeafValuesPrecision_Double:
+            leafValues->assign(LeafValues.begin(), LeafValues.end());
+            break;
+        case NCatBoostFbs::ELeafValuesPrecision_Float:
+            leafValues->assign(FloatLeafValues.begin(), FloatLeafValues.end());
+            break;
+        case NCatBoostFbs::ELeafValuesPrecision_Int16: {
+            leafValues->yresize(Int16LeafValues.size());
+            size_t leafValueIdx = 0;
+            for (size_t treeIdx = 0; treeIdx < TreeSizes.size(); ++treeIdx) {
+                const double scale = Int16LeafValueScales[treeIdx];
+                const size_t treeLeafValueEnd = leafValueIdx + (1 << TreeSizes[treeIdx]) * ApproxDimension;
+                for (; leafValueIdx < treeLeafValueEnd; ++leafValueIdx) {
+                    (*leafValues)[leafValueIdx] = Int16LeafValues[leafValueIdx] * scale;
+                }
+            }
+            break;
+        }
+    }
+}
+
 void TObliviousTrees::UpdateMetadata() const {
     struct TFeatureSplitId {
         ui32 FeatureIdx = 0;
@@ -226,6 +395,9 @@ void TObliviousTrees::UpdateMetadata() const {
     for (const auto& ctrFeature : CtrFeatures) {
         ref.UsedModelCtrs.push_back(ctrFeature.Ctr);
     }
+    for (int i = 0; i < CatFeatures.ysize(); ++i) {
+        ref.CatFeaturePackedIndexes[CatFeatures[i].FeatureIndex] = i;
+    }
     ref.EffectiveBinFeaturesBucketCount = 0;
     for (size_t i = 0; i < FloatFeatures.size(); ++i) {
         const auto& feature = FloatFeatures[i];
@@ -478,9 +650,10 @@ void TFullModel::Save(IOutputStream* s) const {
     if (!!CtrProvider && CtrProvider->IsSerializable()) {
         modelPartIds.push_back(serializer.FlatbufBuilder.CreateString(CtrProvider->ModelPartIdentifier()));
     }
+    const bool isCompact = ObliviousTrees.LeafValuesPrecision != ELeafValuesPrecision_Double;
     auto coreOffset = CreateTModelCoreDirect(
         serializer.FlatbufBuilder,
-        CURRENT_CORE_FORMAT_STRING,
+        isCompact ? COMPACT_CORE_FORMAT_STRING : CURRENT_CORE_FORMAT_STRING,
         obliviousTreesOffset,
         infoMap.empty() ? nullptr : &infoMap,
         modelPartIds.empty() ? nullptr : &modelPartIds
@@ -509,7 +682,10 @@ void TFullModel::Load(IInputStream* s) {
     }
     auto fbModelCore = GetTModelCore(arrayHolder.Get());
     CB_ENSURE(
-        fbModelCore->FormatVersion() && fbModelCore->FormatVersion()->str() == CURRENT_CORE_FORMAT_STRING,
+        fbModelCore->FormatVersion() && (
+            fbModelCore->FormatVersion()->str() == CURRENT_CORE_FORMAT_STRING ||
+            fbModelCore->FormatVersion()->str() == COMPACT_CORE_FORMAT_STRING
+        ),
         "Unsupported model format: " << fbModelCore->FormatVersion()->str()
     );
     if (fbModelCore->ObliviousTrees()) {
@@ -536,6 +712,30 @@ void TFullModel::Load(IInputStream* s) {
     UpdateDynamicData();
 }
 
+void TFullModel::Truncate(size_t begin, size_t end) {
+    const size_t originalTreeCount = ObliviousTrees.GetTreeCount();
+    ObliviousTrees.Truncate(begin, end);
+    if (ModelInfo.has(ORIGINAL_TREE_ORDER_KEY)) {
+        const auto originalTreeOrder = StringSplitter(ModelInfo.at(ORIGINAL_TREE_ORDER_KEY)).Split(',').ToList<TString>();
+        if (originalTreeOrder.size() == originalTreeCount) {
+            ModelInfo[ORIGINAL_TREE_ORDER_KEY] = JoinRange(",", originalTreeOrder.begin() + begin, originalTreeOrder.begin() + end);
+        } else {
+            ModelInfo.erase(ORIGINAL_TREE_ORDER_KEY);
+        }
+    }
+    UpdateDynamicData();
+}
+
+void TFullModel::SetCtrValuesCacheSize(size_t cacheSize) {
+    if (ObliviousTrees.GetUsedModelCtrs().empty()) {
+        return;
+    }
+    auto* staticCtrProvider = dynamic_cast<TStaticCtrProvider*>(CtrProvider.Get());
+    CB_ENSURE(staticCtrProvider, "CTR values cache is supported only for models with static CTR provider");
+    staticCtrProvider->SetCtrValuesCacheSize(cacheSize);
+    UpdateDynamicData();
+}
+
 TVector<TString> GetModelUsedFeaturesNames(const TFullModel& model) {
     TVector<int> featuresIdxs;
     TVector<TString> featuresNames;
@@ -564,3 +764,58 @@ TVector<TString> GetModelUsedFeaturesNames(const TFullModel& model) {
     }
     return result;
 }
+
+void QuantizeLeafValues(NCatBoostFbs::ELeafValuesPrecision precision, TFullModel* model) {
+    auto& trees = model->ObliviousTrees;
+    TVector<double> leafValues;
+    trees.DecodeLeafValues(&leafValues);
+    TVector<double>().swap(trees.LeafValues);
+    TVector<float>().swap(trees.FloatLeafValues);
+    TVector<i16>().swap(trees.Int16LeafValues);
+    TVector<float>().swap(trees.Int16LeafValueScales);
+    trees.LeafValuesPrecision = precision;
+    if (precision == NCatBoostFbs::ELeafValuesPrecision_Double) {
+        trees.LeafValues.swap(leafValues);
+    } else {
+        const bool isInt16 = precision == NCatBoostFbs::ELeafValuesPrecision_Int16;
+        if (isInt16) {
+            trees.Int16LeafValues.yresize(leafValues.size());
+            trees.Int16LeafValueScales.yresize(trees.GetTreeCount());
+        } else {
+            trees.FloatLeafValues.yresize(leafValues.size());
+        }
+        // prediction error is bounded by the sum of max leaf errors of the trees
+        TVector<double> maxErrors(trees.ApproxDimension);
+        for (size_t treeIdx = 0; treeIdx < trees.GetTreeCount(); ++treeIdx) {
+            const size_t firstLeafIdx = trees.GetFirstLeafOffsets()[treeIdx];
+            const size_t leafValueCount = (1 << trees.TreeSizes[treeIdx]) * trees.ApproxDimension;
+            const float scale = isInt16 ? GetInt16LeafValueScale(leafValues.data() + firstLeafIdx, leafValueCount) : 1.0f;
+            if (isInt16) {
+                trees.Int16LeafValueScales[treeIdx] = scale;
+            }
+            TVector<double> treeMaxErrors(trees.ApproxDimension);
+            for (size_t leafValueIdx = firstLeafIdx; leafValueIdx < firstLeafIdx + leafValueCount; ++leafValueIdx) {
+                const double value = leafValues[leafValueIdx];
+                double quantizedValue;
+                if (isInt16) {
+                    trees.Int16LeafValues[leafValueIdx] = QuantizeToInt16(value, scale);
+                    quantizedValue = trees.Int16LeafValues[leafValueIdx] * static_cast<double>(scale);
+                } else {
+                    trees.FloatLeafValues[leafValueIdx] = static_cast<float>(value);
+                    quantizedValue = trees.FloatLeafValues[leafValueIdx];
+                }
+                auto& treeMaxError = treeMaxErrors[(leafValueIdx - firstLeafIdx) % trees.ApproxDimension];
+                treeMaxError = Max(treeMaxError, Abs(quantizedValue - value));
+            }
+            for (int dimension = 0; dimension < trees.ApproxDimension; ++dimension) {
+                maxErrors[dimension] += treeMaxErrors[dimension];
+            }
+        }
+        double maxError = maxErrors.empty() ? 0.0 : *MaxElement(maxErrors.begin(), maxErrors.end());
+        if (model->ModelInfo.has(LEAF_VALUES_MAX_ERROR_KEY)) {
+            maxError += FromString<double>(model->ModelInfo.at(LEAF_VALUES_MAX_ERROR_KEY));
+        }
+        model->ModelInfo[LEAF_VALUES_MAX_ERROR_KEY] = ToString(maxError);
+    }
+    model->UpdateDynamicData();
+}
@@ -18,6 +18,12 @@
 
 class TModelPartsCachingSerializer;
 
+//! ModelInfo key of the bound of prediction error of compact model, see QuantizeLeafValues
+constexpr const char* LEAF_VALUES_MAX_ERROR_KEY = "leaf_values_max_error";
+
+//! ModelInfo key of the comma separated original indexes of trees reordered by OptimizeTreeOrder
+constexpr const char* ORIGINAL_TREE_ORDER_KEY = "original_tree_order";
+
 /*!
     \brief Oblivious tree model structure
 
@@ -78,6 +84,12 @@ struct TObliviousTrees {
 
         //! Offset of first tree leaf in flat tree leafs array
         TVector<size_t> TreeFirstLeafOffsets;
+
+        //! Position of categorical feature in CatFeatures by its FeatureIndex
+        THashMap<int, int> CatFeaturePackedIndexes;
+
+        //! CTR provider data for UsedModelCtrs evaluation, set by TFullModel::UpdateDynamicData
+        TIntrusivePtr<ICtrCalcPlan> CtrCalcPlan;
     };
 
     //! Number of classes in model, in most cases equals to 1.
@@ -92,12 +104,27 @@ struct TObliviousTrees {
     //! Offset of first split in TreeSplits array
     TVector<int> TreeStartOffsets;
 
-    //! Leaf values layout: [treeIndex][leafId * ApproxDimension + dimension]
+    //! Leaf values layout: [treeIndex][leafId * ApproxDimension + dimension], empty in compact models
     TVector<double> LeafValues;
 
     //! Leaf weights layout: [treeIndex][leafId]
     TVector<TVector<double>> LeafWeights;
 
+    /**
+     * Precision of leaf values. Compact models keep float or int16 leaf values instead of LeafValues,
+     * they are serialized with ui16 tree splits. See QuantizeLeafValues.
+     */
+    NCatBoostFbs::ELeafValuesPrecision LeafValuesPrecision = NCatBoostFbs::ELeafValuesPrecision_Double;
+
+    //! Leaf values of float precision models, same layout as LeafValues
+    TVector<float> FloatLeafValues;
+
+    //! Leaf values of int16 precision models, same layout as LeafValues, multiplied by the power of two scale of their tree
+    TVector<i16> Int16LeafValues;
+
+    //! Leaf values scales of int16 precision models: [treeIndex]
+    TVector<float> Int16LeafValueScales;
+
     //! Categorical features, used in model in OneHot conditions or/and in CTR feature combinations
     TVector<TCatFeature> CatFeatures;
 
@@ -128,6 +155,9 @@ struct TObliviousTrees {
         if (fbObj->TreeSplits()) {
             TreeSplits.assign(fbObj->TreeSplits()->begin(), fbObj->TreeSplits()->end());
         }
+        if (fbObj->CompactTreeSplits()) {
+            TreeSplits.assign(fbObj->CompactTreeSplits()->begin(), fbObj->CompactTreeSplits()->end());
+        }
         if (fbObj->TreeSizes()) {
             TreeSizes.assign(fbObj->TreeSizes()->begin(), fbObj->TreeSizes()->end());
         }
@@ -138,6 +168,20 @@ struct TObliviousTrees {
         if (fbObj->LeafValues()) {
             LeafValues.assign(fbObj->LeafValues()->begin(), fbObj->LeafValues()->end());
         }
+        LeafValuesPrecision = fbObj->LeafValuesPrecision();
+        FloatLeafValues.clear();
+        Int16LeafValues.clear();
+        Int16LeafValueScales.clear();
+        if (fbObj->FloatLeafValues()) {
+            FloatLeafValues.assign(fbObj->FloatLeafValues()->begin(), fbObj->FloatLeafValues()->end());
+        }
+        if (fbObj->Int16LeafValues()) {
+            Int16LeafValues.assign(fbObj->Int16LeafValues()->begin(), fbObj->Int16LeafValues()->end());
+        }
+        if (fbObj->Int16LeafValueScales()) {
+            Int16LeafValueScales.assign(fbObj->Int16LeafValueScales()->begin(), fbObj->Int16LeafValueScales()->end());
+        }
+        CheckLeafValuesSize();
         if (fbObj->LeafWeights()) {
             LeafWeights.resize(TreeSizes.size());
             auto leafValIter = fbObj->LeafWeights()->begin();
@@ -182,6 +226,10 @@ struct TObliviousTrees {
                         TreeSizes,
                         TreeStartOffsets,
                         LeafValues,
+                        LeafValuesPrecision,
+                        FloatLeafValues,
+                        Int16LeafValues,
+                        Int16LeafValueScales,
                         CatFeatures,
                         FloatFeatures,
                         OneHotFeatures,
@@ -191,6 +239,10 @@ struct TObliviousTrees {
                        other.TreeSizes,
                        other.TreeStartOffsets,
                        other.LeafValues,
+                       other.LeafValuesPrecision,
+                       other.FloatLeafValues,
+                       other.Int16LeafValues,
+                       other.Int16LeafValueScales,
                        other.CatFeatures,
                        other.FloatFeatures,
                        other.OneHotFeatures,
@@ -208,6 +260,11 @@ struct TObliviousTrees {
      * @param end
      */
     void Truncate(size_t begin, size_t end);
+    /**
+     * Reorder trees, tree with index treeOrder[i] becomes i-th tree. Model predictions are not changed.
+     * @param treeOrder permutation of tree indexes
+     */
+    void ReorderTrees(const TVector<size_t>& treeOrder);
     /**
      * Internal usage only. Updates metadata UsedModelCtrs and BinFeatures vectors to contain all features currently used in model.
      * Should be called after any modifications.
@@ -240,11 +297,37 @@ struct TObliviousTrees {
         return MetaData->TreeFirstLeafOffsets;
     }
 
+    //! Only for double precision models, use TDoubleLeafValues to read leaf values of any model
     const double* GetFirstLeafPtrForTree(size_t treeIdx) const {
         Y_ENSURE(MetaData.Defined(), "metadata should be initialized");
+        Y_ENSURE(LeafValuesPrecision == NCatBoostFbs::ELeafValuesPrecision_Double, "leaf values of compact model should be decoded");
         return &LeafValues[MetaData->TreeFirstLeafOffsets[treeIdx]];
     }
 
+    //! Number of leaf values in all trees for any leaf values precision
+    size_t GetLeafValueCount() const;
+
+    /**
+     * Leaf values widened to double, same layout as LeafValues
+     * @param[out] leafValues
+     */
+    void DecodeLeafValues(TVector<double>* leafValues) const;
+
+    const ICtrCalcPlan* GetCtrCalcPlan() const {
+        Y_ENSURE(MetaData.Defined(), "metadata should be initialized");
+        return MetaData->CtrCalcPlan.Get();
+    }
+
+    void SetCtrCalcPlan(TIntrusivePtr<ICtrCalcPlan> ctrCalcPlan) const {
+        Y_ENSURE(MetaData.Defined(), "metadata should be initialized");
+        MetaData->CtrCalcPlan = std::move(ctrCalcPlan);
+    }
+
+    const THashMap<int, int>& GetCatFeaturePackedIndexes() const {
+        Y_ENSURE(MetaData.Defined(), "metadata should be initialized");
+        return MetaData->CatFeaturePackedIndexes;
+    }
+
     /**
      * List all unique CTR bases (feature combination + ctr type) in model
      * @return
@@ -285,10 +368,45 @@ struct TObliviousTrees {
     size_t GetFlatFeatureVectorExpectedSize() const {
         return GetNumFloatFeatures() + GetNumCatFeatures();
     }
+private:
+    void CheckLeafValuesSize() const;
+
 private:
     mutable TMaybe<TMetaData> MetaData;
 };
 
+/**
+ * Leaf values of oblivious trees in double precision for feature importances, SHAP values and model export.
+ * Leaf values of compact models are decoded to a buffer owned by this object, double leaf values are not copied.
+ */
+class TDoubleLeafValues {
+public:
+    explicit TDoubleLeafValues(const TObliviousTrees& trees)
+        : Trees(trees)
+    {
+        if (trees.LeafValuesPrecision == NCatBoostFbs::ELeafValuesPrecision_Double) {
+            LeafValues = trees.LeafValues.data();
+        } else {
+            trees.DecodeLeafValues(&DecodedLeafValues);
+            LeafValues = DecodedLeafValues.data();
+        }
+    }
+
+    const double* GetFirstLeafPtrForTree(size_t treeIdx) const {
+        return LeafValues + Trees.GetFirstLeafOffsets()[treeIdx];
+    }
+
+    //! All leaf values, layout is the same as in TObliviousTrees::LeafValues
+    const double* GetLeafValues() const {
+        return LeafValues;
+    }
+
+private:
+    const TObliviousTrees& Trees;
+    TVector<double> DecodedLeafValues;
+    const double* LeafValues = nullptr;
+};
+
 /*!
  * \brief Full model class - contains all the data for model evaluation
  *
@@ -503,10 +621,18 @@ struct TFullModel {
      */
     TFullModel CopyTreeRange(size_t begin, size_t end) const {
         TFullModel result = *this;
-        result.ObliviousTrees.Truncate(begin, end);
+        result.Truncate(begin, end);
         return result;
     }
 
+    /**
+     * Truncate model to contain only trees from [begin; end) interval.
+     * Original indexes of reordered trees in ModelInfo are kept only for the remaining trees.
+     * @param begin
+     * @param end
+     */
+    void Truncate(size_t begin, size_t end);
+
     /**
      * Internal usage only.
      * Updates indexes in CTR provider and recalculates metadata in Oblivious trees after model modifications.
@@ -518,8 +644,18 @@ struct TFullModel {
                 ObliviousTrees.FloatFeatures,
                 ObliviousTrees.OneHotFeatures,
                 ObliviousTrees.CatFeatures);
+            if (HasValidCtrProvider()) {
+                ObliviousTrees.SetCtrCalcPlan(CtrProvider->CreateCtrCalcPlan(ObliviousTrees.GetUsedModelCtrs()));
+            }
         }
     }
+
+    /**
+     * Enable cache of CTR values for single object evaluation, useful when the same categorical values
+     * come again and again. The cache is shared by all threads evaluating the model. Zero size disables it.
+     * @param cacheSize max count of cached feature combination values
+     */
+    void SetCtrValuesCacheSize(size_t cacheSize);
 };
 
 void OutputModel(const TFullModel& model, const TString& modelFile);
@@ -554,3 +690,12 @@ TString SerializeModel(const TFullModel& model);
 TFullModel DeserializeModel(const TString& serializeModelString);
 
 TVector<TString> GetModelUsedFeaturesNames(const TFullModel& model);
+
+/**
+ * Round leaf values to given precision to get compact model, leaves take 4 or 2 bytes instead of 8 in memory and in model file.
+ * Bound of prediction error for any document is accumulated in ModelInfo["leaf_values_max_error"].
+ * Double precision turns off compact encoding and widens leaf values to double.
+ * @param precision
+ * @param model
+ */
+void QuantizeLeafValues(NCatBoostFbs::ELeafValuesPrecision precision, TFullModel* model);
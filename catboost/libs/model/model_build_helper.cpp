@@ -1,4 +1,12 @@
 #include "model_build_helper.h"
+#include "static_ctr_provider.h"
+
+#include <util/generic/map.h>
+#include <util/generic/ymath.h>
+#include <util/string/cast.h>
+
+#include <functional>
+#include <tuple>
 
 TObliviousTreeBuilder::TObliviousTreeBuilder(const TVector<TFloatFeature>& allFloatFeatures, const TVector<TCatFeature>& allCategoricalFeatures, int approxDimension)
     : ApproxDimension(approxDimension)
@@ -102,3 +110,121 @@ TObliviousTrees TObliviousTreeBuilder::Build() {
     result.UpdateMetadata();
     return result;
 }
+
+template <class TFeature>
+static TVector<TFeature> UniteFeatures(
+    const TVector<const TFullModel*>& modelVector,
+    const TVector<TFeature>& (*getFeatures)(const TFullModel&),
+    const std::function<bool(const TFeature&, const TFeature&)>& isCompatible
+) {
+    TMap<int, TFeature> featureByIndex;
+    for (const auto* model : modelVector) {
+        for (const auto& feature : getFeatures(*model)) {
+            auto it = featureByIndex.find(feature.FeatureIndex);
+            if (it == featureByIndex.end()) {
+                featureByIndex.emplace(feature.FeatureIndex, feature);
+            } else {
+                CB_ENSURE(isCompatible(it->second, feature), "Feature " << feature.FeatureIndex << " is different in merged models");
+            }
+        }
+    }
+    TVector<TFeature> result;
+    for (const auto& indexAndFeature : featureByIndex) {
+        CB_ENSURE(indexAndFeature.first == result.ysize(), "Merged models don't describe feature " << result.ysize());
+        result.push_back(indexAndFeature.second);
+    }
+    return result;
+}
+
+TFullModel SumModels(const TVector<const TFullModel*>& modelVector, const TVector<double>& weights) {
+    CB_ENSURE(!modelVector.empty(), "Nothing to merge");
+    CB_ENSURE(modelVector.size() == weights.size(), "Each model should have a weight");
+    const int approxDimension = modelVector.front()->ObliviousTrees.ApproxDimension;
+    bool allModelsHaveLeafWeights = true;
+    for (const auto* model : modelVector) {
+        CB_ENSURE(model->ObliviousTrees.ApproxDimension == approxDimension, "Approx dimensions of merged models should be equal");
+        allModelsHaveLeafWeights &= !model->ObliviousTrees.LeafWeights.empty();
+    }
+
+    const auto floatFeatures = UniteFeatures<TFloatFeature>(
+        modelVector,
+        [](const TFullModel& model) -> const TVector<TFloatFeature>& { return model.ObliviousTrees.FloatFeatures; },
+        [](const TFloatFeature& lhs, const TFloatFeature& rhs) {
+            return std::tie(lhs.HasNans, lhs.FlatFeatureIndex, lhs.NanValueTreatment) == std::tie(rhs.HasNans, rhs.FlatFeatureIndex, rhs.NanValueTreatment);
+        }
+    );
+    const auto catFeatures = UniteFeatures<TCatFeature>(
+        modelVector,
+        [](const TFullModel& model) -> const TVector<TCatFeature>& { return model.ObliviousTrees.CatFeatures; },
+        [](const TCatFeature& lhs, const TCatFeature& rhs) {
+            return lhs.FlatFeatureIndex == rhs.FlatFeatureIndex;
+        }
+    );
+
+    // splits of all models are reindexed by the builder, so equal splits are binarized once
+    TObliviousTreeBuilder builder(floatFeatures, catFeatures, approxDimension);
+    for (size_t modelId = 0; modelId < modelVector.size(); ++modelId) {
+        const TObliviousTrees& trees = modelVector[modelId]->ObliviousTrees;
+        const auto& binFeatures = trees.GetBinFeatures();
+        const TDoubleLeafValues treesLeafValues(trees);
+        for (size_t treeIdx = 0; treeIdx < trees.GetTreeCount(); ++treeIdx) {
+            TVector<TModelSplit> modelSplits;
+            for (int splitIdx = 0; splitIdx < trees.TreeSizes[treeIdx]; ++splitIdx) {
+                modelSplits.push_back(binFeatures[trees.TreeSplits[trees.TreeStartOffsets[treeIdx] + splitIdx]]);
+            }
+            const size_t leafCount = 1 << trees.TreeSizes[treeIdx];
+            const double* firstLeafPtr = treesLeafValues.GetFirstLeafPtrForTree(treeIdx);
+            TVector<TVector<double>> leafValues(approxDimension, TVector<double>(leafCount));
+            for (size_t leafId = 0; leafId < leafCount; ++leafId) {
+                for (int dimension = 0; dimension < approxDimension; ++dimension) {
+                    leafValues[dimension][leafId] = weights[modelId] * firstLeafPtr[leafId * approxDimension + dimension];
+                }
+            }
+            builder.AddTree(modelSplits, leafValues, allModelsHaveLeafWeights ? trees.LeafWeights[treeIdx] : TVector<double>());
+        }
+    }
+
+    TFullModel result;
+    result.ObliviousTrees = builder.Build();
+    result.ModelInfo = modelVector.front()->ModelInfo;
+    // trees of all models are concatenated, so original indexes of single model trees are meaningless
+    result.ModelInfo.erase(ORIGINAL_TREE_ORDER_KEY);
+    double leafValuesMaxError = 0;
+    bool hasLeafValuesMaxError = false;
+    for (size_t modelId = 0; modelId < modelVector.size(); ++modelId) {
+        const auto& modelInfo = modelVector[modelId]->ModelInfo;
+        if (modelInfo.has(LEAF_VALUES_MAX_ERROR_KEY)) {
+            hasLeafValuesMaxError = true;
+            leafValuesMaxError += Abs(weights[modelId]) * FromString<double>(modelInfo.at(LEAF_VALUES_MAX_ERROR_KEY));
+        }
+    }
+    if (hasLeafValuesMaxError) {
+        result.ModelInfo[LEAF_VALUES_MAX_ERROR_KEY] = ToString(leafValuesMaxError);
+    } else {
+        result.ModelInfo.erase(LEAF_VALUES_MAX_ERROR_KEY);
+    }
+
+    TCtrData ctrData;
+    bool hasCtrs = false;
+    for (const auto* model : modelVector) {
+        if (model->ObliviousTrees.GetUsedModelCtrs().empty()) {
+            continue;
+        }
+        hasCtrs = true;
+        const auto* staticCtrProvider = dynamic_cast<const TStaticCtrProvider*>(model->CtrProvider.Get());
+        CB_ENSURE(staticCtrProvider, "Only models with static ctr provider can be merged");
+        for (const auto& ctrBaseAndTable : staticCtrProvider->CtrData.LearnCtrs) {
+            auto it = ctrData.LearnCtrs.find(ctrBaseAndTable.first);
+            if (it == ctrData.LearnCtrs.end()) {
+                ctrData.LearnCtrs.emplace(ctrBaseAndTable.first, ctrBaseAndTable.second);
+            } else {
+                CB_ENSURE(it->second == ctrBaseAndTable.second, "Merged models have different tables for the same CTR");
+            }
+        }
+    }
+    if (hasCtrs) {
+        result.CtrProvider = new TStaticCtrProvider(ctrData);
+    }
+    result.UpdateDynamicData();
+    return result;
+}
@@ -28,3 +28,13 @@ private:
     TVector<TFloatFeature> FloatFeatures;
     TVector<TCatFeature> CatFeatures;
 };
+
+/**
+ * Build one model which approx is the weighted sum of approxes of modelVector.
+ * Features and CTR tables of the models are unified, so the result needs one binarization pass.
+ * Models should have equal approx dimensions, consistent feature layouts and equal tables for equal CTRs.
+ * @param modelVector
+ * @param weights
+ * @return merged model, ModelInfo is copied from the first model
+ */
+TFullModel SumModels(const TVector<const TFullModel*>& modelVector, const TVector<double>& weights);
@@ -72,7 +72,7 @@ namespace NCatboost {
 
         Out << '\n';
         Out << "    /* Aggregated array of leaf values for trees. Each tree is represented by a separate line: */" << '\n';
-        Out << "    double LeafValues[" << model.ObliviousTrees.LeafValues.size() << "] = {" << OutputLeafValues(model, TIndent(1));
+        Out << "    double LeafValues[" << model.ObliviousTrees.GetLeafValueCount() << "] = {" << OutputLeafValues(model, TIndent(1));
         Out << "    };" << '\n';
         Out << "} CatboostModelStatic;" << '\n';
         Out << '\n';
@@ -286,7 +286,7 @@ namespace NCatboost {
 
         Out << '\n';
         Out << indent << "/* Aggregated array of leaf values for trees. Each tree is represented by a separate line: */" << '\n';
-        Out << indent << "double LeafValues[" << model.ObliviousTrees.LeafValues.size() << "] = {" << OutputLeafValues(model, indent);
+        Out << indent << "double LeafValues[" << model.ObliviousTrees.GetLeafValueCount() << "] = {" << OutputLeafValues(model, indent);
         Out << indent << "};" << '\n';
 
         WriteModelCTRs(Out, model, indent);
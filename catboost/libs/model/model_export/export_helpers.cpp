@@ -34,7 +34,8 @@ namespace NCatboostModelExportHelpers {
         TStringBuilder outString;
         TSequenceCommaSeparator commaOuter(model.ObliviousTrees.TreeSizes.size());
         ++indent;
-        auto currentTreeFirstLeafPtr = model.ObliviousTrees.LeafValues.data();
+        const TDoubleLeafValues leafValues(model.ObliviousTrees);
+        auto currentTreeFirstLeafPtr = leafValues.GetLeafValues();
         for (const auto& treeSize : model.ObliviousTrees.TreeSizes) {
             const auto treeLeafCount = (1uLL << treeSize) * model.ObliviousTrees.ApproxDimension;
             outString << '\n' << indent;
@@ -2,52 +2,182 @@
 
 #include <catboost/libs/helpers/exception.h>
 
-struct TCompressedModelCtr {
-    const TFeatureCombination* Projection;
-    TVector<const TModelCtr*> ModelCtrs;
+#include <util/generic/algorithm.h>
+#include <util/system/spinlock.h>
+#include <util/system/tls.h>
+
+namespace {
+    // Direct mapped cache of CTR values of feature combinations for single documents.
+    // Shards are taken by try-lock, so a busy shard is a cache miss and threads never wait for each other.
+    class TCtrValuesCache {
+    public:
+        TCtrValuesCache(size_t slotCount, size_t valuesPerSlot)
+            : Shards(Min<size_t>(slotCount, 64))
+            , SlotsPerShard((slotCount + Shards.size() - 1) / Shards.size())
+            , ValuesPerSlot(valuesPerSlot)
+        {
+            for (auto& shard : Shards) {
+                shard.Hashes.resize(SlotsPerShard);
+                shard.ProjectionIds.resize(SlotsPerShard, 0);
+                shard.Values.resize(SlotsPerShard * ValuesPerSlot);
+            }
+        }
+
+        bool Get(ui32 projectionIdx, ui64 hash, TArrayRef<float> values) {
+            size_t slotIdx;
+            auto& shard = GetShard(projectionIdx, hash, &slotIdx);
+            if (!shard.Lock.TryAcquire()) {
+                return false;
+            }
+            const bool isFound = shard.ProjectionIds[slotIdx] == projectionIdx + 1 && shard.Hashes[slotIdx] == hash;
+            if (isFound) {
+                Copy(shard.Values.begin() + slotIdx * ValuesPerSlot, shard.Values.begin() + slotIdx * ValuesPerSlot + values.size(), values.begin());
+            }
+            shard.Lock.Release();
+            return isFound;
+        }
+
+        void Put(ui32 projectionIdx, ui64 hash, TConstArrayRef<float> values) {
+            Y_ASSERT(values.size() <= ValuesPerSlot);
+            size_t slotIdx;
+            auto& shard = GetShard(projectionIdx, hash, &slotIdx);
+            if (!shard.Lock.TryAcquire()) {
+                return;
+            }
+            shard.ProjectionIds[slotIdx] = projectionIdx + 1;
+            shard.Hashes[slotIdx] = hash;
+            Copy(values.begin(), values.end(), shard.Values.begin() + slotIdx * ValuesPerSlot);
+            shard.Lock.Release();
+        }
+
+    private:
+        struct TShard {
+            TAdaptiveLock Lock;
+            TVector<ui64> Hashes;
+            TVector<ui32> ProjectionIds; // projection index + 1, zero for empty slots
+            TVector<float> Values;
+        };
+
+        TShard& GetShard(ui32 projectionIdx, ui64 hash, size_t* slotIdx) {
+            const ui64 key = CalcHash(hash, (ui64)projectionIdx);
+            *slotIdx = (key / Shards.size()) % SlotsPerShard;
+            return Shards[key % Shards.size()];
+        }
+
+    private:
+        TVector<TShard> Shards;
+        size_t SlotsPerShard;
+        size_t ValuesPerSlot;
+    };
+}
+
+struct TStaticCtrProvider::TCtrCalcPlan : public ICtrCalcPlan {
+    struct TProjection {
+        TVector<int> TransposedCatFeatureIndexes;
+        TVector<TBinFeatureIndexValue> BinarizedIndexes;
+        TVector<TModelCtr> ModelCtrs;
+        TVector<const TCtrValueTable*> LearnCtrs;
+    };
+
+    // plan is valid while the provider generation is unchanged
+    TIntrusiveConstPtr<TStaticCtrProvider> Provider;
+    TAtomicBase Generation = 0;
+    size_t NeededCtrCount = 0;
+    TVector<TProjection> Projections;
+    THolder<TCtrValuesCache> ValuesCache;
 };
 
+TStaticCtrProvider::TStaticCtrProvider() = default;
+
+TStaticCtrProvider::TStaticCtrProvider(TCtrData& ctrData)
+    : CtrData(ctrData)
+{
+}
+
+TStaticCtrProvider::~TStaticCtrProvider() = default;
+
+void TStaticCtrProvider::SetCtrValuesCacheSize(size_t cacheSize) {
+    CtrValuesCacheSize = cacheSize;
+}
+
+TIntrusivePtr<ICtrCalcPlan> TStaticCtrProvider::CreateCtrCalcPlan(const TVector<TModelCtr>& neededCtrs) const {
+    return BuildCtrCalcPlan(neededCtrs, CtrValuesCacheSize);
+}
+
+TIntrusivePtr<TStaticCtrProvider::TCtrCalcPlan> TStaticCtrProvider::BuildCtrCalcPlan(
+    const TVector<TModelCtr>& neededCtrs,
+    size_t valuesCacheSize
+) const {
+    TIntrusivePtr<TCtrCalcPlan> plan = new TCtrCalcPlan;
+    plan->Provider = this;
+    plan->Generation = AtomicGet(Generation);
+    plan->NeededCtrCount = neededCtrs.size();
+    size_t maxProjectionCtrCount = 0;
+    for (size_t i = 0; i < neededCtrs.size(); ++i) {
+        Y_ASSERT(i == 0 || neededCtrs[i - 1] < neededCtrs[i]); // needed ctrs should be sorted
+        const auto& proj = neededCtrs[i].Base.Projection;
+        if (i == 0 || neededCtrs[i - 1].Base.Projection != proj) {
+            auto& projection = plan->Projections.emplace_back();
+            for (const auto feature : proj.CatFeatures) {
+                projection.TransposedCatFeatureIndexes.push_back(CatFeatureIndex.at(feature));
+            }
+            for (const auto feature : proj.BinFeatures ) {
+                projection.BinarizedIndexes.push_back(FloatFeatureIndexes.at(feature));
+            }
+            for (const auto feature : proj.OneHotFeatures ) {
+                projection.BinarizedIndexes.push_back(OneHotFeatureIndexes.at(feature));
+            }
+        }
+        auto& projection = plan->Projections.back();
+        projection.ModelCtrs.push_back(neededCtrs[i]);
+        projection.LearnCtrs.push_back(&CtrData.LearnCtrs.at(neededCtrs[i].Base));
+        maxProjectionCtrCount = Max(maxProjectionCtrCount, projection.ModelCtrs.size());
+    }
+    if (valuesCacheSize > 0) {
+        plan->ValuesCache = MakeHolder<TCtrValuesCache>(valuesCacheSize, maxProjectionCtrCount);
+    }
+    return plan;
+}
+
 void TStaticCtrProvider::CalcCtrs(const TVector<TModelCtr>& neededCtrs,
                                   const TConstArrayRef<ui8>& binarizedFeatures,
                                   const TConstArrayRef<int>& hashedCatFeatures,
                                   size_t docCount,
-                                  TArrayRef<float> result) {
+                                  TArrayRef<float> result,
+                                  const ICtrCalcPlan* ctrCalcPlan) {
     if (neededCtrs.empty()) {
         return;
     }
-    TVector<TCompressedModelCtr> compressedModelCtrs;
-    compressedModelCtrs.emplace_back(TCompressedModelCtr{&neededCtrs[0].Base.Projection, {&neededCtrs[0]}});
-    for (size_t i = 1; i < neededCtrs.size(); ++i) {
-        Y_ASSERT(neededCtrs[i - 1] < neededCtrs[i]); // needed ctrs should be sorted
-        if (*(compressedModelCtrs.back().Projection) != neededCtrs[i].Base.Projection) {
-            compressedModelCtrs.emplace_back(TCompressedModelCtr{&neededCtrs[i].Base.Projection, {}});
-        }
-        compressedModelCtrs.back().ModelCtrs.push_back(&neededCtrs[i]);
+    // models keep plans for their needed ctrs, a stale or missing plan is rebuilt for this call only
+    const TCtrCalcPlan* plan = static_cast<const TCtrCalcPlan*>(ctrCalcPlan);
+    TIntrusivePtr<TCtrCalcPlan> localPlan;
+    if (!plan || plan->Provider.Get() != this || plan->Generation != AtomicGet(Generation)) {
+        localPlan = BuildCtrCalcPlan(neededCtrs, /*valuesCacheSize*/ 0);
+        plan = localPlan.Get();
     }
+    Y_ASSERT(plan->NeededCtrCount == neededCtrs.size());
+    TCtrValuesCache* valuesCache = (docCount == 1) ? plan->ValuesCache.Get() : nullptr;
     size_t samplesCount = docCount;
-    TVector<ui64> ctrHashes(samplesCount);
-    TVector<ui64> buckets(samplesCount);
+    // single documents are scored in a loop, so the buffers are reused between calls
+    Y_STATIC_THREAD(TVector<ui64>) ctrHashesTls;
+    Y_STATIC_THREAD(TVector<ui64>) bucketsTls;
+    TVector<ui64>& ctrHashes = ctrHashesTls.Get();
+    TVector<ui64>& buckets = bucketsTls.Get();
+    ctrHashes.yresize(samplesCount);
+    buckets.yresize(samplesCount);
     size_t resultIdx = 0;
     float* resultPtr = result.data();
-    TVector<int> transposedCatFeatureIndexes;
-    TVector<TBinFeatureIndexValue> binarizedIndexes;
-    for (size_t i = 0; i < compressedModelCtrs.size(); ++i) {
-        auto& proj = *compressedModelCtrs[i].Projection;
-        binarizedIndexes.clear();
-        transposedCatFeatureIndexes.clear();
-        for (const auto feature : proj.CatFeatures) {
-            transposedCatFeatureIndexes.push_back(CatFeatureIndex.at(feature));
+    for (size_t i = 0; i < plan->Projections.size(); ++i) {
+        const auto& projection = plan->Projections[i];
+        CalcHashes(binarizedFeatures, hashedCatFeatures, projection.TransposedCatFeatureIndexes, projection.BinarizedIndexes, docCount, &ctrHashes);
+        const auto projectionValues = MakeArrayRef(resultPtr + resultIdx, projection.ModelCtrs.size());
+        if (valuesCache && valuesCache->Get(i, ctrHashes[0], projectionValues)) {
+            resultIdx += projection.ModelCtrs.size();
+            continue;
         }
-        for (const auto feature : proj.BinFeatures ) {
-            binarizedIndexes.push_back(FloatFeatureIndexes.at(feature));
-        }
-        for (const auto feature : proj.OneHotFeatures ) {
-            binarizedIndexes.push_back(OneHotFeatureIndexes.at(feature));
-        }
-        CalcHashes(binarizedFeatures, hashedCatFeatures, transposedCatFeatureIndexes, binarizedIndexes, docCount, &ctrHashes);
-        for (size_t j = 0; j < compressedModelCtrs[i].ModelCtrs.size(); ++j) {
-            auto& ctr = *compressedModelCtrs[i].ModelCtrs[j];
-            auto& learnCtr = CtrData.LearnCtrs.at(ctr.Base);
+        for (size_t j = 0; j < projection.ModelCtrs.size(); ++j) {
+            auto& ctr = projection.ModelCtrs[j];
+            auto& learnCtr = *projection.LearnCtrs[j];
             auto hashIndexResolver = learnCtr.GetIndexHashViewer();
             const ECtrType ctrType = ctr.Base.CtrType;
             auto ptrBuckets = buckets.data();
@@ -128,6 +258,9 @@ void TStaticCtrProvider::CalcCtrs(const TVector<TModelCtr>& neededCtrs,
             }
             resultIdx += docCount;
         }
+        if (valuesCache) {
+            valuesCache->Put(i, ctrHashes[0], projectionValues);
+        }
     }
 }
 
@@ -144,27 +277,34 @@ void TStaticCtrProvider::SetupBinFeatureIndexes(const TVector<TFloatFeature> &fl
                                                 const TVector<TOneHotFeature> &oheFeatures,
                                                 const TVector<TCatFeature> &catFeatures) {
     ui32 currentIndex = 0;
-    FloatFeatureIndexes.clear();
+    THashMap<TFloatSplit, TBinFeatureIndexValue> floatFeatureIndexes;
     for (const auto& floatFeature : floatFeatures) {
         for (size_t borderIdx = 0; borderIdx < floatFeature.Borders.size(); ++borderIdx) {
             TBinFeatureIndexValue featureIdx{currentIndex, false, (ui8)(borderIdx + 1)};
             TFloatSplit split{floatFeature.FeatureIndex, floatFeature.Borders[borderIdx]};
-            FloatFeatureIndexes[split] = featureIdx;
+            floatFeatureIndexes[split] = featureIdx;
         }
         ++currentIndex;
     }
-    OneHotFeatureIndexes.clear();
+    THashMap<TOneHotSplit, TBinFeatureIndexValue> oneHotFeatureIndexes;
     for (const auto& oheFeature : oheFeatures) {
         for (int valueId = 0; valueId < oheFeature.Values.ysize(); ++valueId) {
             TBinFeatureIndexValue featureIdx{currentIndex, true, (ui8)(valueId + 1)};
             TOneHotSplit feature{oheFeature.CatFeatureIndex, oheFeature.Values[valueId]};
-            OneHotFeatureIndexes[feature] = featureIdx;
+            oneHotFeatureIndexes[feature] = featureIdx;
         }
         ++currentIndex;
     }
-    CatFeatureIndex.clear();
+    THashMap<int, int> catFeatureIndex;
     for (const auto& catFeature : catFeatures) {
-        const int prevSize = CatFeatureIndex.ysize();
-        CatFeatureIndex[catFeature.FeatureIndex] = prevSize;
+        const int prevSize = catFeatureIndex.ysize();
+        catFeatureIndex[catFeature.FeatureIndex] = prevSize;
+    }
+    // models sharing the provider set up the same indexes, their plans stay valid then
+    if (floatFeatureIndexes != FloatFeatureIndexes || oneHotFeatureIndexes != OneHotFeatureIndexes || catFeatureIndex != CatFeatureIndex) {
+        FloatFeatureIndexes.swap(floatFeatureIndexes);
+        OneHotFeatureIndexes.swap(oneHotFeatureIndexes);
+        CatFeatureIndex.swap(catFeatureIndex);
+        AtomicIncrement(Generation);
     }
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <util/generic/ptr.h>
+#include <util/system/atomic.h>
 #include <util/system/mutex.h>
 #include <library/threading/local_executor/local_executor.h>
 #include <catboost/libs/helpers/exception.h>
@@ -9,10 +11,8 @@
 
 struct TStaticCtrProvider: public ICtrProvider {
 public:
-    TStaticCtrProvider() = default;
-    explicit TStaticCtrProvider(TCtrData& ctrData)
-        : CtrData(ctrData)
-    {}
+    TStaticCtrProvider();
+    explicit TStaticCtrProvider(TCtrData& ctrData);
 
     bool HasNeededCtrs(const TVector<TModelCtr>& neededCtrs) const override;
 
@@ -21,7 +21,10 @@ public:
         const TConstArrayRef<ui8>& binarizedFeatures, // vector of binarized float & one hot features
         const TConstArrayRef<int>& hashedCatFeatures,
         size_t docCount,
-        TArrayRef<float> result) override;
+        TArrayRef<float> result,
+        const ICtrCalcPlan* ctrCalcPlan) override;
+
+    TIntrusivePtr<ICtrCalcPlan> CreateCtrCalcPlan(const TVector<TModelCtr>& neededCtrs) const override;
 
     void SetupBinFeatureIndexes(
         const TVector<TFloatFeature>& floatFeatures,
@@ -33,6 +36,7 @@ public:
     void AddCtrCalcerData(TCtrValueTable&& valueTable) override {
         auto ctrBase = valueTable.ModelCtrBase;
         CtrData.LearnCtrs[ctrBase] = std::move(valueTable);
+        AtomicIncrement(Generation);
     }
 
     void Save(IOutputStream* out) const override {
@@ -41,8 +45,17 @@ public:
 
     void Load(IInputStream* inp) override {
         ::Load(inp, CtrData);
+        AtomicIncrement(Generation);
     }
 
+    /**
+     * Enable cache of CTR values for single document evaluation in plans created after the call,
+     * see TFullModel::SetCtrValuesCacheSize. The cache of a plan is shared by all threads.
+     * Documents with hot categorical values skip CTR tables lookups. Zero size disables the cache.
+     * @param cacheSize max count of cached feature combination values
+     */
+    void SetCtrValuesCacheSize(size_t cacheSize);
+
     TString ModelPartIdentifier() const override {
         return "static_provider_v1";
     }
@@ -59,12 +72,21 @@ public:
         return OneHotFeatureIndexes;
     }
 
-    ~TStaticCtrProvider() override {}
+    ~TStaticCtrProvider() override;
     TCtrData CtrData;
+private:
+    // CTRs grouped by feature combinations with resolved feature indexes and tables
+    struct TCtrCalcPlan;
+
+    TIntrusivePtr<TCtrCalcPlan> BuildCtrCalcPlan(const TVector<TModelCtr>& neededCtrs, size_t valuesCacheSize) const;
+
 private:
     THashMap<TFloatSplit, TBinFeatureIndexValue> FloatFeatureIndexes;
     THashMap<int, int> CatFeatureIndex;
     THashMap<TOneHotSplit, TBinFeatureIndexValue> OneHotFeatureIndexes;
+    size_t CtrValuesCacheSize = 0;
+    // changes with tables or feature indexes and invalidates plans
+    TAtomic Generation = 0;
 };
 
 struct TStaticCtrOnFlightSerializationProvider: public ICtrProvider {
@@ -89,7 +111,8 @@ public:
         const TConstArrayRef<ui8>& ,
         const TConstArrayRef<int>& ,
         size_t,
-        TArrayRef<float>) override {
+        TArrayRef<float>,
+        const ICtrCalcPlan*) override {
         ythrow yexception() << "TStaticCtrOnFlightSerializationProvider is for streamed serialization only";
     }
 
@@ -0,0 +1,115 @@
+#include "tree_reordering.h"
+
+#include <catboost/libs/helpers/exception.h>
+
+#include <util/generic/algorithm.h>
+#include <util/generic/hash.h>
+#include <util/string/builder.h>
+#include <util/string/cast.h>
+#include <util/string/iterator.h>
+
+// Greedy chain: the next tree is the unused one sharing most features buckets with the current tree.
+static void AddCacheFriendlyRangeOrder(
+    const TVector<TVector<ui32>>& treeBuckets,
+    size_t rangeBegin,
+    size_t rangeEnd,
+    TVector<size_t>* treeOrder
+) {
+    THashMap<ui32, TVector<size_t>> bucketTrees;
+    for (size_t treeIdx = rangeBegin; treeIdx < rangeEnd; ++treeIdx) {
+        for (ui32 bucket : treeBuckets[treeIdx]) {
+            bucketTrees[bucket].push_back(treeIdx);
+        }
+    }
+    TVector<bool> isTreeUsed(rangeEnd - rangeBegin, false);
+    TVector<ui32> sharedBucketCounts(rangeEnd - rangeBegin, 0);
+    TVector<size_t> candidates;
+    size_t firstUnusedTree = rangeBegin;
+    size_t currentTree = rangeBegin;
+    for (size_t orderIdx = rangeBegin; orderIdx < rangeEnd; ++orderIdx) {
+        treeOrder->push_back(currentTree);
+        isTreeUsed[currentTree - rangeBegin] = true;
+        candidates.clear();
+        for (ui32 bucket : treeBuckets[currentTree]) {
+            for (size_t treeIdx : bucketTrees[bucket]) {
+                if (isTreeUsed[treeIdx - rangeBegin]) {
+                    continue;
+                }
+                if (sharedBucketCounts[treeIdx - rangeBegin]++ == 0) {
+                    candidates.push_back(treeIdx);
+                }
+            }
+        }
+        size_t nextTree = rangeEnd;
+        for (size_t treeIdx : candidates) {
+            const ui32 sharedBucketCount = sharedBucketCounts[treeIdx - rangeBegin];
+            if (nextTree == rangeEnd ||
+                sharedBucketCount > sharedBucketCounts[nextTree - rangeBegin] ||
+                (sharedBucketCount == sharedBucketCounts[nextTree - rangeBegin] && treeIdx < nextTree)
+            ) {
+                nextTree = treeIdx;
+            }
+        }
+        for (size_t treeIdx : candidates) {
+            sharedBucketCounts[treeIdx - rangeBegin] = 0;
+        }
+        if (nextTree == rangeEnd) {
+            while (firstUnusedTree < rangeEnd && isTreeUsed[firstUnusedTree - rangeBegin]) {
+                ++firstUnusedTree;
+            }
+            nextTree = firstUnusedTree;
+        }
+        currentTree = nextTree;
+    }
+}
+
+TVector<size_t> GetCacheFriendlyTreeOrder(const TObliviousTrees& trees, size_t preservedTreeRangeSize) {
+    const size_t treeCount = trees.GetTreeCount();
+    const auto& repackedBins = trees.GetRepackedBins();
+    TVector<TVector<ui32>> treeBuckets(treeCount);
+    for (size_t treeIdx = 0; treeIdx < treeCount; ++treeIdx) {
+        auto& buckets = treeBuckets[treeIdx];
+        for (int depth = 0; depth < trees.TreeSizes[treeIdx]; ++depth) {
+            buckets.push_back(repackedBins[trees.TreeStartOffsets[treeIdx] + depth].FeatureIndex);
+        }
+        SortUnique(buckets);
+    }
+    const size_t rangeSize = preservedTreeRangeSize > 0 ? preservedTreeRangeSize : Max<size_t>(treeCount, 1);
+    TVector<size_t> treeOrder;
+    treeOrder.reserve(treeCount);
+    for (size_t rangeBegin = 0; rangeBegin < treeCount; rangeBegin += rangeSize) {
+        AddCacheFriendlyRangeOrder(treeBuckets, rangeBegin, Min(rangeBegin + rangeSize, treeCount), &treeOrder);
+    }
+    return treeOrder;
+}
+
+void OptimizeTreeOrder(size_t preservedTreeRangeSize, TFullModel* model) {
+    const size_t treeCount = model->GetTreeCount();
+    if (treeCount == 0) {
+        return;
+    }
+    TVector<size_t> originalTreeOrder(treeCount);
+    if (model->ModelInfo.has(ORIGINAL_TREE_ORDER_KEY)) {
+        size_t treeIdx = 0;
+        for (const auto& index : StringSplitter(model->ModelInfo.at(ORIGINAL_TREE_ORDER_KEY)).Split(',')) {
+            CB_ENSURE(treeIdx < treeCount, "Incorrect " << ORIGINAL_TREE_ORDER_KEY << " in model info");
+            originalTreeOrder[treeIdx++] = FromString<size_t>(index.Token());
+        }
+        CB_ENSURE(treeIdx == treeCount, "Incorrect " << ORIGINAL_TREE_ORDER_KEY << " in model info");
+    } else {
+        Iota(originalTreeOrder.begin(), originalTreeOrder.end(), 0);
+    }
+
+    const auto treeOrder = GetCacheFriendlyTreeOrder(model->ObliviousTrees, preservedTreeRangeSize);
+    model->ObliviousTrees.ReorderTrees(treeOrder);
+    model->UpdateDynamicData();
+
+    TStringBuilder orderDescription;
+    for (size_t treeIdx = 0; treeIdx < treeCount; ++treeIdx) {
+        if (treeIdx > 0) {
+            orderDescription << ',';
+        }
+        orderDescription << originalTreeOrder[treeOrder[treeIdx]];
+    }
+    model->ModelInfo[ORIGINAL_TREE_ORDER_KEY] = orderDescription;
+}
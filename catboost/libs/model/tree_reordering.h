@@ -0,0 +1,23 @@
+#pragma once
+
+#include "model.h"
+
+#include <util/generic/vector.h>
+
+/**
+ * Order of trees in which consecutive trees use the same binary features buckets as much as possible,
+ * so model apply reads the same binarized features rows for neighbouring trees.
+ * @param trees
+ * @param preservedTreeRangeSize if positive, trees are reordered only inside consecutive ranges of this size,
+ * so staged predictions for multiples of it are not changed
+ * @return tree order for TObliviousTrees::ReorderTrees
+ */
+TVector<size_t> GetCacheFriendlyTreeOrder(const TObliviousTrees& trees, size_t preservedTreeRangeSize = 0);
+
+/**
+ * Reorder model trees by GetCacheFriendlyTreeOrder.
+ * Original index of each tree is stored in ModelInfo["original_tree_order"] as a comma separated list.
+ * @param preservedTreeRangeSize
+ * @param model
+ */
+void OptimizeTreeOrder(size_t preservedTreeRangeSize, TFullModel* model);
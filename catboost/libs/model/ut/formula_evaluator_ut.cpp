@@ -1,7 +1,14 @@
 #include <catboost/libs/model/model.h>
 #include <catboost/libs/model/formula_evaluator.h>
+#include <catboost/libs/model/model_build_helper.h>
+#include <catboost/libs/model/tree_reordering.h>
+#include <catboost/libs/cat_feature/cat_feature.h>
+#include <catboost/libs/train_lib/train_model.h>
 #include <library/unittest/registar.h>
 
+#include <util/string/cast.h>
+#include <util/string/iterator.h>
+
 using namespace std;
 
 TFullModel SimpleFloatModel() {
@@ -34,6 +41,23 @@ TFullModel SimpleFloatModel() {
     return model;
 }
 
+TFullModel ManyTreesFloatModel() {
+    TFullModel model;
+    model.ObliviousTrees.FloatFeatures = SimpleFloatModel().ObliviousTrees.FloatFeatures;
+    model.ObliviousTrees.AddBinTree({1, 2});
+    model.ObliviousTrees.AddBinTree({3});
+    model.ObliviousTrees.AddBinTree({2});
+    model.ObliviousTrees.AddBinTree({0, 3});
+    model.ObliviousTrees.LeafValues = {
+        1., 2., 3., 4.,
+        10., 20.,
+        100., 200.,
+        1000., 2000., 3000., 4000.
+    };
+    model.UpdateDynamicData();
+    return model;
+}
+
 TFullModel MultiValueFloatModel() {
     TFullModel model;
     model.ObliviousTrees.FloatFeatures = {
@@ -63,6 +87,48 @@ TFullModel MultiValueFloatModel() {
     return model;
 }
 
+struct TCatFeaturesData {
+    TVector<float> FloatFeature;
+    TVector<TVector<int>> HashedCatFeatures;
+    TFullModel Model;
+};
+
+// model with one float and two categorical features, trained with CTRs
+TCatFeaturesData TrainCatFeaturesModel() {
+    const int docCount = 40;
+    TCatFeaturesData data;
+    TPool pool;
+    pool.Docs.Resize(docCount, /*factors count*/ 3, /*baseline dimension*/ 0, /*has queryId*/ false, /*has subgroupId*/ false);
+    pool.CatFeatures = {1, 2};
+    for (int doc = 0; doc < docCount; ++doc) {
+        const TString catValues[] = {"a" + ToString(doc % 5), "b" + ToString(doc % 3)};
+        data.FloatFeature.push_back((doc % 7) * 0.5f);
+        data.HashedCatFeatures.emplace_back();
+        pool.Docs.Factors[0][doc] = data.FloatFeature.back();
+        for (int catFeatureIdx = 0; catFeatureIdx < 2; ++catFeatureIdx) {
+            const int hash = CalcCatFeatureHash(catValues[catFeatureIdx]);
+            data.HashedCatFeatures.back().push_back(hash);
+            pool.Docs.Factors[1 + catFeatureIdx][doc] = ConvertCatFeatureHashToFloat(hash);
+            pool.CatFeaturesHashToString[hash] = catValues[catFeatureIdx];
+        }
+        pool.Docs.Target[doc] = (doc % 5 < 2) != (doc % 3 == 0) ? 1.0f : 0.0f;
+    }
+    TEvalResult evalResult;
+    NJson::TJsonValue params;
+    params.InsertValue("iterations", 10);
+    params.InsertValue("random_seed", 0);
+    TrainModel(params, Nothing(), Nothing(), pool, false, pool, "", &data.Model, &evalResult);
+    return data;
+}
+
+TVector<double> CalcSingleDocPredictions(const TFullModel& model, const TCatFeaturesData& data) {
+    TVector<double> predictions(data.FloatFeature.size());
+    for (size_t doc = 0; doc < predictions.size(); ++doc) {
+        model.Calc(MakeArrayRef(&data.FloatFeature[doc], 1), data.HashedCatFeatures[doc], MakeArrayRef(&predictions[doc], 1));
+    }
+    return predictions;
+}
+
 Y_UNIT_TEST_SUITE(TObliviousTreeModel) {
     Y_UNIT_TEST(TestFlatCalcFloat) {
         auto modelCalcer = SimpleFloatModel();
@@ -105,4 +171,134 @@ Y_UNIT_TEST_SUITE(TObliviousTreeModel) {
         };
         UNIT_ASSERT_EQUAL(canonVals, result);
     }
+
+    Y_UNIT_TEST(TestSumModels) {
+        const auto model = SimpleFloatModel();
+        const auto sumModel = SumModels({&model, &model}, {0.5, 2.});
+        UNIT_ASSERT_VALUES_EQUAL(sumModel.GetTreeCount(), 2u);
+        TVector<TConstArrayRef<float>> features = {
+            {0.f, 0.f, 0.f},
+            {3.f, 0.f, 0.f},
+            {0.f, 1.f, 1.f},
+            {3.f, 1.f, 1.f},
+        };
+        TVector<double> result(features.size());
+        sumModel.CalcFlat(features, result);
+        TVector<double> canonVals = {0., 2.5, 15., 17.5};
+        UNIT_ASSERT_EQUAL(canonVals, result);
+
+        auto leafValuesErrorModel = model;
+        leafValuesErrorModel.ModelInfo[LEAF_VALUES_MAX_ERROR_KEY] = "0.25";
+        leafValuesErrorModel.ModelInfo[ORIGINAL_TREE_ORDER_KEY] = "1,0";
+        const auto leafValuesErrorSumModel = SumModels({&leafValuesErrorModel, &model, &leafValuesErrorModel}, {0.5, 1., -2.});
+        UNIT_ASSERT(!leafValuesErrorSumModel.ModelInfo.has(ORIGINAL_TREE_ORDER_KEY));
+        UNIT_ASSERT_DOUBLES_EQUAL(FromString<double>(leafValuesErrorSumModel.ModelInfo.at(LEAF_VALUES_MAX_ERROR_KEY)), 0.625, 1e-12);
+        UNIT_ASSERT(!SumModels({&model, &model}, {0.5, 2.}).ModelInfo.has(LEAF_VALUES_MAX_ERROR_KEY));
+    }
+
+    Y_UNIT_TEST(TestOptimizeTreeOrder) {
+        const auto model = ManyTreesFloatModel();
+        TVector<TConstArrayRef<float>> features = {
+            {0.f, 0.f, 0.f},
+            {3.f, 0.f, 1.f},
+            {1.5f, 1.f, 0.f},
+            {3.f, 1.f, 1.f},
+        };
+        TVector<double> canonVals(features.size());
+        model.CalcFlat(features, canonVals);
+        TVector<double> canonStagedVals(features.size());
+        model.CalcFlat(features, 0, 2, canonStagedVals);
+
+        auto optimizedModel = model;
+        OptimizeTreeOrder(/*preservedTreeRangeSize*/ 0, &optimizedModel);
+        UNIT_ASSERT_VALUES_EQUAL(optimizedModel.ModelInfo.at("original_tree_order"), "0,2,1,3");
+        TVector<double> result(features.size());
+        optimizedModel.CalcFlat(features, result);
+        UNIT_ASSERT_EQUAL(canonVals, result);
+
+        auto rangePreservingModel = model;
+        OptimizeTreeOrder(/*preservedTreeRangeSize*/ 2, &rangePreservingModel);
+        rangePreservingModel.CalcFlat(features, 0, 2, result);
+        UNIT_ASSERT_EQUAL(canonStagedVals, result);
+        rangePreservingModel.CalcFlat(features, result);
+        UNIT_ASSERT_EQUAL(canonVals, result);
+
+        // original indexes are kept for the remaining trees of shrinked model, so it can be optimized again
+        auto shrinkedModel = optimizedModel.CopyTreeRange(1, 3);
+        UNIT_ASSERT_VALUES_EQUAL(shrinkedModel.ModelInfo.at(ORIGINAL_TREE_ORDER_KEY), "2,1");
+        TVector<double> canonShrinkedVals(features.size());
+        shrinkedModel.CalcFlat(features, canonShrinkedVals);
+        OptimizeTreeOrder(/*preservedTreeRangeSize*/ 0, &shrinkedModel);
+        UNIT_ASSERT_VALUES_EQUAL(shrinkedModel.GetTreeCount(), 2u);
+        const auto shrinkedTreeOrder = StringSplitter(shrinkedModel.ModelInfo.at(ORIGINAL_TREE_ORDER_KEY)).Split(',').ToList<TString>();
+        UNIT_ASSERT_VALUES_EQUAL(shrinkedTreeOrder.size(), 2u);
+        shrinkedModel.CalcFlat(features, result);
+        UNIT_ASSERT_EQUAL(canonShrinkedVals, result);
+
+        // stale original indexes are dropped
+        auto staleOrderModel = model;
+        staleOrderModel.ModelInfo[ORIGINAL_TREE_ORDER_KEY] = "0,1";
+        staleOrderModel.Truncate(0, 2);
+        UNIT_ASSERT(!staleOrderModel.ModelInfo.has(ORIGINAL_TREE_ORDER_KEY));
+    }
+
+    Y_UNIT_TEST(TestCtrValuesCache) {
+        auto data = TrainCatFeaturesModel();
+        TFullModel& model = data.Model;
+        UNIT_ASSERT(!model.ObliviousTrees.GetUsedModelCtrs().empty());
+        UNIT_ASSERT(model.ObliviousTrees.GetCtrCalcPlan());
+        const TVector<double> canonVals = CalcSingleDocPredictions(model, data);
+
+        TVector<TConstArrayRef<float>> floatFeatures;
+        TVector<TConstArrayRef<int>> catFeatures;
+        for (size_t doc = 0; doc < data.FloatFeature.size(); ++doc) {
+            floatFeatures.push_back(MakeArrayRef(&data.FloatFeature[doc], 1));
+            catFeatures.push_back(data.HashedCatFeatures[doc]);
+        }
+        TVector<double> blockVals(canonVals.size());
+        model.Calc(floatFeatures, catFeatures, blockVals);
+        UNIT_ASSERT_EQUAL(canonVals, blockVals);
+
+        // small cache to have both hits and evictions, repeated calls should hit
+        model.SetCtrValuesCacheSize(4);
+        for (int pass = 0; pass < 3; ++pass) {
+            UNIT_ASSERT_EQUAL(canonVals, CalcSingleDocPredictions(model, data));
+        }
+        model.SetCtrValuesCacheSize(1000);
+        for (int pass = 0; pass < 3; ++pass) {
+            UNIT_ASSERT_EQUAL(canonVals, CalcSingleDocPredictions(model, data));
+        }
+
+        // the truncated copy shares the CTR provider but has its own plan
+        const TFullModel truncatedModel = model.CopyTreeRange(0, 3);
+        TVector<double> truncatedVals(canonVals.size());
+        model.Calc(floatFeatures, catFeatures, 0, 3, truncatedVals);
+        UNIT_ASSERT_EQUAL(truncatedVals, CalcSingleDocPredictions(truncatedModel, data));
+        UNIT_ASSERT_EQUAL(canonVals, CalcSingleDocPredictions(model, data));
+
+        // reloaded tables invalidate the plan and its cache
+        TStringStream ctrDataStream;
+        model.CtrProvider->Save(&ctrDataStream);
+        model.CtrProvider->Load(&ctrDataStream);
+        UNIT_ASSERT_EQUAL(canonVals, CalcSingleDocPredictions(model, data));
+
+        TStringStream modelStream;
+        model.Save(&modelStream);
+        TFullModel reference;
+        reference.Load(&modelStream);
+
+        // replaced tables invalidate the plan and its cache, values come from the new tables
+        for (const auto& ctrBase : model.ObliviousTrees.GetUsedModelCtrBases()) {
+            for (auto* provider : {model.CtrProvider.Get(), reference.CtrProvider.Get()}) {
+                TCtrValueTable table = static_cast<TStaticCtrProvider*>(provider)->CtrData.LearnCtrs.at(ctrBase);
+                table.AllocateBlobAndGetArrayRef<ui8>(table.GetTypedArrayRefForBlobData<ui8>().size()); // zero statistics
+                provider->AddCtrCalcerData(std::move(table));
+            }
+        }
+        const TVector<double> zeroStatsVals = CalcSingleDocPredictions(reference, data);
+        UNIT_ASSERT_UNEQUAL(canonVals, zeroStatsVals);
+        for (int pass = 0; pass < 2; ++pass) {
+            UNIT_ASSERT_EQUAL(zeroStatsVals, CalcSingleDocPredictions(model, data));
+        }
+    }
 }
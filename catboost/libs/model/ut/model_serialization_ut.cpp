@@ -2,6 +2,8 @@
 
 #include <library/unittest/registar.h>
 
+#include <util/string/cast.h>
+
 using namespace std;
 
 Y_UNIT_TEST_SUITE(TModelSerialization) {
@@ -23,4 +25,92 @@ Y_UNIT_TEST_SUITE(TModelSerialization) {
         UNIT_ASSERT_EQUAL(trainedModel.ObliviousTrees.LeafValues, deserializedModel.ObliviousTrees.LeafValues);
         UNIT_ASSERT_EQUAL(trainedModel.ObliviousTrees.TreeSplits, deserializedModel.ObliviousTrees.TreeSplits);
     }
+
+    Y_UNIT_TEST(TestSerializeDeserializeCompactModel) {
+        const TFullModel trainedModel = TrainFloatCatboostModel();
+        const TVector<TConstArrayRef<float>> features = {
+            {+0.5f, +1.5f, -2.5f},
+            {+0.7f, +6.4f, +2.4f},
+            {-2.0f, -1.0f, +6.0f}
+        };
+        TVector<double> trainedPredictions(features.size());
+        trainedModel.CalcFlat(features, trainedPredictions);
+        for (auto precision : {NCatBoostFbs::ELeafValuesPrecision_Float, NCatBoostFbs::ELeafValuesPrecision_Int16}) {
+            TFullModel compactModel = trainedModel;
+            QuantizeLeafValues(precision, &compactModel);
+            const double maxError = FromString<double>(compactModel.ModelInfo.at("leaf_values_max_error"));
+            TStringStream strStream;
+            compactModel.Save(&strStream);
+            TFullModel deserializedModel;
+            deserializedModel.Load(&strStream);
+            UNIT_ASSERT_EQUAL(compactModel, deserializedModel);
+            TVector<double> compactPredictions(features.size());
+            deserializedModel.CalcFlat(features, compactPredictions);
+            for (size_t docId = 0; docId < features.size(); ++docId) {
+                UNIT_ASSERT_DOUBLES_EQUAL(compactPredictions[docId], trainedPredictions[docId], maxError + 1e-12);
+            }
+        }
+    }
+
+    Y_UNIT_TEST(TestInt16LeafValuesAtScaleBoundary) {
+        TFullModel model = TrainFloatCatboostModel();
+        // tree max equal to Max<i16>() * 2^-2 is exactly representable with scale 2^-2
+        const double boundaryLeafValue = Max<i16>() * 0.25;
+        model.ObliviousTrees.LeafValues[0] = boundaryLeafValue;
+        QuantizeLeafValues(NCatBoostFbs::ELeafValuesPrecision_Int16, &model);
+        UNIT_ASSERT_VALUES_EQUAL(TDoubleLeafValues(model.ObliviousTrees).GetLeafValues()[0], boundaryLeafValue);
+        TStringStream strStream;
+        model.Save(&strStream);
+        TFullModel deserializedModel;
+        deserializedModel.Load(&strStream);
+        UNIT_ASSERT_EQUAL(model, deserializedModel);
+        UNIT_ASSERT_EQUAL(model.ObliviousTrees.Int16LeafValues, deserializedModel.ObliviousTrees.Int16LeafValues);
+        UNIT_ASSERT_EQUAL(model.ObliviousTrees.Int16LeafValueScales, deserializedModel.ObliviousTrees.Int16LeafValueScales);
+    }
+
+    Y_UNIT_TEST(TestCompactModelLeafValuesStorage) {
+        const TFullModel trainedModel = TrainFloatCatboostModel();
+        // enough documents for blocked apply with SSE leaf gathering, and one document for single document apply
+        TVector<TVector<float>> featuresData;
+        for (int docId = 0; docId < 40; ++docId) {
+            featuresData.push_back({-2.5f + 0.1f * docId, 7.0f - 0.2f * docId, -3.0f + 0.25f * docId});
+        }
+        const TVector<TConstArrayRef<float>> features(featuresData.begin(), featuresData.end());
+        const size_t leafValueCount = trainedModel.ObliviousTrees.GetLeafValueCount();
+        for (auto precision : {NCatBoostFbs::ELeafValuesPrecision_Float, NCatBoostFbs::ELeafValuesPrecision_Int16}) {
+            TFullModel compactModel = trainedModel;
+            QuantizeLeafValues(precision, &compactModel);
+            TStringStream strStream;
+            compactModel.Save(&strStream);
+            TFullModel deserializedModel;
+            deserializedModel.Load(&strStream);
+            for (const TFullModel* model : {&compactModel, &deserializedModel}) {
+                const TObliviousTrees& trees = model->ObliviousTrees;
+                UNIT_ASSERT_VALUES_EQUAL(trees.LeafValues.capacity(), 0);
+                if (precision == NCatBoostFbs::ELeafValuesPrecision_Float) {
+                    UNIT_ASSERT_VALUES_EQUAL(trees.FloatLeafValues.size() * sizeof(float), leafValueCount * 4);
+                    UNIT_ASSERT(trees.Int16LeafValues.empty());
+                } else {
+                    UNIT_ASSERT_VALUES_EQUAL(trees.Int16LeafValues.size() * sizeof(i16), leafValueCount * 2);
+                    UNIT_ASSERT_VALUES_EQUAL(trees.Int16LeafValueScales.size(), trees.GetTreeCount());
+                    UNIT_ASSERT(trees.FloatLeafValues.empty());
+                }
+            }
+
+            // compact leaves are exact in double, so the widened model gives the same predictions
+            TFullModel widenedModel = compactModel;
+            QuantizeLeafValues(NCatBoostFbs::ELeafValuesPrecision_Double, &widenedModel);
+            UNIT_ASSERT_VALUES_EQUAL(widenedModel.ObliviousTrees.LeafValues.size(), leafValueCount);
+            TVector<double> compactPredictions(features.size());
+            deserializedModel.CalcFlat(features, compactPredictions);
+            TVector<double> widenedPredictions(features.size());
+            widenedModel.CalcFlat(features, widenedPredictions);
+            UNIT_ASSERT_EQUAL(compactPredictions, widenedPredictions);
+            for (size_t docId = 0; docId < features.size(); ++docId) {
+                TVector<double> singlePrediction(1);
+                deserializedModel.CalcFlatSingle(features[docId], singlePrediction);
+                UNIT_ASSERT_DOUBLES_EQUAL(singlePrediction[0], widenedPredictions[docId], 1e-12);
+            }
+        }
+    }
 }
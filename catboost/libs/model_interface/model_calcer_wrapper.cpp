@@ -56,6 +56,17 @@ EXPORT bool LoadFullModelFromBuffer(ModelCalcerHandle* modelHandle, const void*
     return true;
 }
 
+EXPORT bool SetCtrValuesCacheSize(ModelCalcerHandle* modelHandle, size_t cacheSize) {
+    try {
+        FULL_MODEL_PTR(modelHandle)->SetCtrValuesCacheSize(cacheSize);
+    } catch (...) {
+        Singleton<TErrorMessageHolder>()->Message = CurrentExceptionMessage();
+        return false;
+    }
+
+    return true;
+}
+
 EXPORT bool CalcModelPredictionFlat(ModelCalcerHandle* modelHandle, size_t docCount, const float** floatFeatures, size_t floatFeaturesSize, double* result, size_t resultSize) {
     try {
         if (docCount == 1) {
@@ -59,6 +59,17 @@ EXPORT bool LoadFullModelFromBuffer(
     const void* binaryBuffer,
     size_t binaryBufferSize);
 
+/**
+ * Enable cache of CTR values for single object evaluation of model with categorical features.
+ * Objects with repeated categorical values skip CTR tables lookups. The cache is shared by all threads.
+ * @param calcer model handle
+ * @param cacheSize max count of cached feature combination values, zero disables the cache
+ * @return false if error occured
+ */
+EXPORT bool SetCtrValuesCacheSize(
+    ModelCalcerHandle* calcer,
+    size_t cacheSize);
+
 /**
  * **Use this method only if you really understand what you want.**
  * Calculate raw model predictions on flat feature vectors
@@ -44,6 +44,16 @@ public:
             throw std::runtime_error(GetErrorString());
         }
     }
+    /**
+     * Enable cache of CTR values for single object evaluation, see SetCtrValuesCacheSize in model_calcer_wrapper.h
+     * @param[in] cacheSize max count of cached feature combination values, zero disables the cache
+     */
+    void SetCtrValuesCacheSize(size_t cacheSize) {
+        if (!::SetCtrValuesCacheSize(CalcerHolder.get(), cacheSize)) {
+            throw std::runtime_error(GetErrorString());
+        }
+    }
+
     /**
      * Evaluate model on single object flat features vector.
      * Flat here means that float features and categorical feature are in the same float array.
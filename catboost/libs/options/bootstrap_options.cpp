@@ -4,8 +4,12 @@ namespace NCatboostOptions {
     void TBootstrapConfig::Validate() const {
         CB_ENSURE((GetTakenFraction() > 0) && (GetTakenFraction() <= 1.0f), "Taken fraction should in in (0,1]");
         CB_ENSURE(GetBaggingTemperature() >= 0, "Bagging temperature should be >= 0");
+        CB_ENSURE((GetTopFraction() > 0) && (GetTopFraction() < 1.0f), "Top fraction should be in (0,1)");
 
         EBootstrapType type = BootstrapType;
+        if (type != EBootstrapType::GOSS && TopFraction.IsSet()) {
+            ythrow TCatboostException() << "Error: top fraction is available for GOSS bootstrap only";
+        }
         switch (type) {
             case EBootstrapType::Bayesian: {
                 if (TakenFraction.IsSet()) {
@@ -27,6 +31,16 @@ namespace NCatboostOptions {
                 }
                 break;
             }
+            case EBootstrapType::GOSS: {
+                if (TaskType == ETaskType::GPU) {
+                    ythrow TCatboostException()
+                        << "Error: GOSS bootstrap is not supported on GPU";
+                }
+                if (BaggingTemperature.IsSet()) {
+                    ythrow TCatboostException() << "Error: bagging temperature available for bayesian bootstrap only";
+                }
+                break;
+            }
             default: {
                 Y_ASSERT(type == EBootstrapType::Bernoulli);
                 if (BaggingTemperature.IsSet()) {
@@ -13,6 +13,7 @@ namespace NCatboostOptions {
         explicit TBootstrapConfig(ETaskType taskType)
             : TakenFraction("subsample", 0.66f)
             , BaggingTemperature("bagging_temperature", 1.0)
+            , TopFraction("top_fraction", 0.2f)
             , BootstrapType("type", EBootstrapType::Bayesian)
             , TaskType(taskType)
         {
@@ -27,6 +28,10 @@ namespace NCatboostOptions {
             return takenFraction < 1 ? -log(1 - takenFraction) : -1;
         }
 
+        float GetTopFraction() const {
+            return TopFraction.Get();
+        }
+
         EBootstrapType GetBootstrapType() const {
             return BootstrapType.Get();
         }
@@ -45,12 +50,16 @@ namespace NCatboostOptions {
             return BaggingTemperature;
         }
 
+        TOption<float>& GetTopFraction() {
+            return TopFraction;
+        }
+
         TOption<EBootstrapType>& GetBootstrapType() {
             return BootstrapType;
         }
 
         void Load(const NJson::TJsonValue& options) {
-            CheckedLoad(options, &TakenFraction, &BaggingTemperature, &BootstrapType);
+            CheckedLoad(options, &TakenFraction, &BaggingTemperature, &TopFraction, &BootstrapType);
         }
 
         void Save(NJson::TJsonValue* options) const {
@@ -63,6 +72,10 @@ namespace NCatboostOptions {
                     SaveFields(options, BootstrapType);
                     break;
                 }
+                case EBootstrapType::GOSS: {
+                    SaveFields(options, TakenFraction, TopFraction, BootstrapType);
+                    break;
+                }
                 default: {
                     SaveFields(options, TakenFraction, BootstrapType);
                     break;
@@ -71,8 +84,8 @@ namespace NCatboostOptions {
         }
 
         bool operator==(const TBootstrapConfig& rhs) const {
-            return std::tie(TakenFraction, BaggingTemperature, BootstrapType) ==
-                   std::tie(rhs.TakenFraction, rhs.BaggingTemperature, rhs.BootstrapType);
+            return std::tie(TakenFraction, BaggingTemperature, TopFraction, BootstrapType) ==
+                   std::tie(rhs.TakenFraction, rhs.BaggingTemperature, rhs.TopFraction, rhs.BootstrapType);
         }
 
         bool operator!=(const TBootstrapConfig& rhs) const {
@@ -83,6 +96,7 @@ namespace NCatboostOptions {
     private:
         TOption<float> TakenFraction;
         TOption<float> BaggingTemperature;
+        TOption<float> TopFraction; // for GOSS, fraction of documents with largest gradients, subsample is used for the rest
         TOption<EBootstrapType> BootstrapType;
         ETaskType TaskType;
     };
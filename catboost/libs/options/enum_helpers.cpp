@@ -124,6 +124,7 @@ bool AreZeroWeightsAfterBootstrap(EBootstrapType type) {
     switch (type) {
         case EBootstrapType::Bernoulli:
         case EBootstrapType::Poisson:
+        case EBootstrapType::GOSS:
             return true;
         default:
             return false;
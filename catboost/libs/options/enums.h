@@ -60,10 +60,18 @@ enum class EScoreFunction {
     L2
 };
 
+enum class EScoreStatsPrecision {
+    Double,
+    // histogram buckets are accumulated in float over blocks of documents, the block sums are added to double buckets
+    Mixed
+};
+
 enum class EBootstrapType {
     Poisson,
     Bayesian,
     Bernoulli,
+    // gradient-based one-side sampling: keep documents with largest gradients, sample the rest
+    GOSS,
     No
 };
 
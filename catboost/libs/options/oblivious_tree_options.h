@@ -30,6 +30,7 @@ namespace NCatboostOptions {
             , ScoreFunction("score_function", EScoreFunction::Correlation, taskType)
             , MaxCtrComplexityForBordersCaching("max_ctr_complexity_for_borders_cache", 1, taskType)
             , LeavesEstimationBacktrackingType("leaf_estimation_backtracking", ELeavesEstimationStepBacktracking::AnyImprovment, taskType)
+            , ScoreStatsPrecision("score_stats_precision", EScoreStatsPrecision::Double, taskType)
         {
             Rsm.ChangeLoadUnimplementedPolicy(ELoadUnimplementedPolicy::ExceptionOnChange);
             SamplingFrequency.ChangeLoadUnimplementedPolicy(ELoadUnimplementedPolicy::ExceptionOnChange);
@@ -52,7 +53,8 @@ namespace NCatboostOptions {
                         &ObservationsToBootstrap,
                         &PairwiseNonDiagReg,
                         &LeavesEstimationBacktrackingType,
-                        &SamplingFrequency);
+                        &SamplingFrequency,
+                        &ScoreStatsPrecision);
 
             Validate();
         }
@@ -64,19 +66,21 @@ namespace NCatboostOptions {
                        ScoreFunction,
                        PairwiseNonDiagReg,
                        LeavesEstimationBacktrackingType,
-                       MaxCtrComplexityForBordersCaching, Rsm, ObservationsToBootstrap, SamplingFrequency);
+                       MaxCtrComplexityForBordersCaching, Rsm, ObservationsToBootstrap, SamplingFrequency,
+                       ScoreStatsPrecision);
         }
 
         bool operator==(const TObliviousTreeLearnerOptions& rhs) const {
             return std::tie(MaxDepth, LeavesEstimationIterations, LeavesEstimationMethod, L2Reg, ModelSizeReg, RandomStrength,
                             BootstrapConfig, Rsm, SamplingFrequency, ObservationsToBootstrap, FoldSizeLossNormalization,
                             AddRidgeToTargetFunctionFlag, ScoreFunction, MaxCtrComplexityForBordersCaching,
-                            PairwiseNonDiagReg, LeavesEstimationBacktrackingType
+                            PairwiseNonDiagReg, LeavesEstimationBacktrackingType, ScoreStatsPrecision
             ) ==
                    std::tie(rhs.MaxDepth, rhs.LeavesEstimationIterations, rhs.LeavesEstimationMethod, rhs.L2Reg, rhs.ModelSizeReg,
                             rhs.RandomStrength, rhs.BootstrapConfig, rhs.Rsm, rhs.SamplingFrequency,
                             rhs.ObservationsToBootstrap, rhs.FoldSizeLossNormalization, rhs.AddRidgeToTargetFunctionFlag,
-                            rhs.ScoreFunction, rhs.MaxCtrComplexityForBordersCaching, rhs.PairwiseNonDiagReg, rhs.LeavesEstimationBacktrackingType);
+                            rhs.ScoreFunction, rhs.MaxCtrComplexityForBordersCaching, rhs.PairwiseNonDiagReg, rhs.LeavesEstimationBacktrackingType,
+                            rhs.ScoreStatsPrecision);
         }
 
         bool operator!=(const TObliviousTreeLearnerOptions& rhs) const {
@@ -105,6 +109,7 @@ namespace NCatboostOptions {
         TCpuOnlyOption<float> Rsm;
         TCpuOnlyOption<ESamplingFrequency> SamplingFrequency;
         TCpuOnlyOption<float> ModelSizeReg;
+        TCpuOnlyOption<EScoreStatsPrecision> ScoreStatsPrecision;
 
         TGpuOnlyOption<EObservationsToBootstrap> ObservationsToBootstrap;
         TGpuOnlyOption<bool> FoldSizeLossNormalization;
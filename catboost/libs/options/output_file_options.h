@@ -23,6 +23,8 @@ namespace NCatboostOptions {
             , TimeLeftLog("time_left_log", "time_left.tsv")
             , SnapshotPath("snapshot_file", "experiment.cbsnapshot")
             , SaveSnapshotFlag("save_snapshot", false)
+            , SnapshotCodec("snapshot_codec", "", taskType)
+            , TraceFileName("trace_file", "", taskType)
             , AllowWriteFilesFlag("allow_writing_files", true)
             , FinalCtrComputationMode("final_ctr_computation_mode", EFinalCtrComputationMode::Default)
             , EvalFileName("eval_file_name", "")
@@ -30,6 +32,7 @@ namespace NCatboostOptions {
             , OutputBordersFileName("output_borders", "", taskType)
             , VerbosePeriod("verbose", 1)
             , MetricPeriod("metric_period", 1)
+            , AsyncMetrics("async_metrics", false, taskType)
             , PredictionTypes("prediction_type", {EPredictionType::RawFormulaVal}, taskType)
             , OutputColumns("output_columns", {"DocId", "RawFormulaVal", "Label"}, taskType)
             , FstrRegularFileName("fstr_regular_file", "", taskType)
@@ -53,6 +56,14 @@ namespace NCatboostOptions {
             return GetFullPath(SnapshotPath.Get());
         }
 
+        TString CreateTraceFullPath() const {
+            return GetFullPath(TraceFileName.Get());
+        }
+
+        bool NeedTrace() const {
+            return TraceFileName.IsSet();
+        }
+
         TString CreateOutputBordersFullPath() const {
             return GetFullPath(OutputBordersFileName.Get());
         }
@@ -125,6 +136,10 @@ namespace NCatboostOptions {
             return SaveSnapshotFlag.Get();
         }
 
+        const TString& GetSnapshotCodec() const {
+            return SnapshotCodec.Get();
+        }
+
         ui64 GetSnapshotSaveInterval() const {
             return SnapshotSaveIntervalSeconds.Get();
         }
@@ -137,6 +152,10 @@ namespace NCatboostOptions {
             return MetricPeriod.Get();
         }
 
+        bool UseAsyncMetrics() const {
+            return AsyncMetrics.Get();
+        }
+
         TString CreateFstrRegularFullPath() const {
             return GetFullPath(FstrRegularFileName.Get());
         }
@@ -151,11 +170,11 @@ namespace NCatboostOptions {
 
         bool operator==(const TOutputFilesOptions& rhs) const {
             return std::tie(TrainDir, Name, MetaFile, JsonLogPath, ProfileLogPath, LearnErrorLogPath, TestErrorLogPath, TimeLeftLog, ResultModelPath,
-                            SnapshotPath, ModelFormats, SaveSnapshotFlag, AllowWriteFilesFlag, FinalCtrComputationMode, UseBestModel, SnapshotSaveIntervalSeconds,
+                            SnapshotPath, ModelFormats, SaveSnapshotFlag, AllowWriteFilesFlag, FinalCtrComputationMode, UseBestModel, SnapshotSaveIntervalSeconds, SnapshotCodec, TraceFileName, AsyncMetrics,
                             EvalFileName, FstrRegularFileName, FstrInternalFileName, OutputBordersFileName) ==
                    std::tie(rhs.TrainDir, rhs.Name, rhs.MetaFile, rhs.JsonLogPath, rhs.ProfileLogPath, rhs.LearnErrorLogPath, rhs.TestErrorLogPath,
                             rhs.TimeLeftLog, rhs.ResultModelPath, rhs.SnapshotPath, rhs.ModelFormats, rhs.SaveSnapshotFlag,
-                            rhs.AllowWriteFilesFlag, rhs.FinalCtrComputationMode, rhs.UseBestModel, rhs.SnapshotSaveIntervalSeconds,
+                            rhs.AllowWriteFilesFlag, rhs.FinalCtrComputationMode, rhs.UseBestModel, rhs.SnapshotSaveIntervalSeconds, rhs.SnapshotCodec, rhs.TraceFileName, rhs.AsyncMetrics,
                             rhs.EvalFileName, rhs.FstrRegularFileName, rhs.FstrInternalFileName, rhs.OutputBordersFileName);
         }
 
@@ -167,8 +186,8 @@ namespace NCatboostOptions {
             CheckedLoad(options,
                         &TrainDir, &Name, &MetaFile, &JsonLogPath, &ProfileLogPath, &LearnErrorLogPath, &TestErrorLogPath, &TimeLeftLog,
                         &ResultModelPath,
-                        &SnapshotPath, &ModelFormats, &SaveSnapshotFlag, &AllowWriteFilesFlag, &FinalCtrComputationMode, &UseBestModel, &SnapshotSaveIntervalSeconds,
-                        &EvalFileName, &OutputColumns, &FstrRegularFileName, &FstrInternalFileName, &MetricPeriod, &VerbosePeriod, &PredictionTypes, &OutputBordersFileName);
+                        &SnapshotPath, &ModelFormats, &SaveSnapshotFlag, &AllowWriteFilesFlag, &FinalCtrComputationMode, &UseBestModel, &SnapshotSaveIntervalSeconds, &SnapshotCodec, &TraceFileName,
+                        &EvalFileName, &OutputColumns, &FstrRegularFileName, &FstrInternalFileName, &MetricPeriod, &AsyncMetrics, &VerbosePeriod, &PredictionTypes, &OutputBordersFileName);
             if (!VerbosePeriod.IsSet()) {
                 VerbosePeriod.Set(MetricPeriod.Get());
             }
@@ -178,8 +197,8 @@ namespace NCatboostOptions {
         void Save(NJson::TJsonValue* options) const {
             SaveFields(options,
                        TrainDir, Name, MetaFile, JsonLogPath, ProfileLogPath, LearnErrorLogPath, TestErrorLogPath, TimeLeftLog, ResultModelPath,
-                       SnapshotPath, ModelFormats, SaveSnapshotFlag, AllowWriteFilesFlag, FinalCtrComputationMode, UseBestModel, SnapshotSaveIntervalSeconds,
-                       EvalFileName, OutputColumns, FstrRegularFileName, FstrInternalFileName, MetricPeriod, VerbosePeriod, PredictionTypes, OutputBordersFileName);
+                       SnapshotPath, ModelFormats, SaveSnapshotFlag, AllowWriteFilesFlag, FinalCtrComputationMode, UseBestModel, SnapshotSaveIntervalSeconds, SnapshotCodec, TraceFileName,
+                       EvalFileName, OutputColumns, FstrRegularFileName, FstrInternalFileName, MetricPeriod, AsyncMetrics, VerbosePeriod, PredictionTypes, OutputBordersFileName);
         }
 
         void Validate() const {
@@ -223,9 +242,12 @@ namespace NCatboostOptions {
         TOption<TString> EvalFileName;
 
         TGpuOnlyOption<ui64> SnapshotSaveIntervalSeconds;
+        TCpuOnlyOption<TString> SnapshotCodec;
+        TCpuOnlyOption<TString> TraceFileName;
         TGpuOnlyOption<TString> OutputBordersFileName;
         TOption<int> VerbosePeriod;
         TOption<int> MetricPeriod;
+        TCpuOnlyOption<bool> AsyncMetrics;
 
         TCpuOnlyOption<TVector<EPredictionType>> PredictionTypes;
         TCpuOnlyOption<TVector<TString>> OutputColumns;
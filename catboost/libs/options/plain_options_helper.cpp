@@ -101,8 +101,11 @@ namespace NCatboostOptions {
         CopyOption(plainOptions, "snapshot_file", &outputFilesJson, &seenKeys);
         CopyOption(plainOptions, "save_snapshot", &outputFilesJson, &seenKeys);
         CopyOption(plainOptions, "snapshot_save_interval_secs", &outputFilesJson, &seenKeys);
+        CopyOption(plainOptions, "snapshot_codec", &outputFilesJson, &seenKeys);
+        CopyOption(plainOptions, "trace_file", &outputFilesJson, &seenKeys);
         CopyOption(plainOptions, "verbose", &outputFilesJson, &seenKeys);
         CopyOption(plainOptions, "metric_period", &outputFilesJson, &seenKeys);
+        CopyOption(plainOptions, "async_metrics", &outputFilesJson, &seenKeys);
         CopyOption(plainOptions, "prediction_type", &outputFilesJson, &seenKeys);
         CopyOption(plainOptions, "output_columns", &outputFilesJson, &seenKeys);
         CopyOption(plainOptions, "allow_writing_files", &outputFilesJson, &seenKeys);
@@ -146,6 +149,7 @@ namespace NCatboostOptions {
         CopyOption(plainOptions, "l2_leaf_reg", &treeOptions, &seenKeys);
         CopyOption(plainOptions, "bayesian_matrix_reg", &treeOptions, &seenKeys);
         CopyOption(plainOptions, "model_size_reg", &treeOptions, &seenKeys);
+        CopyOption(plainOptions, "score_stats_precision", &treeOptions, &seenKeys);
         CopyOption(plainOptions, "random_strength", &treeOptions, &seenKeys);
         CopyOption(plainOptions, "leaf_estimation_method", &treeOptions, &seenKeys);
         CopyOption(plainOptions, "score_function", &treeOptions, &seenKeys);
@@ -161,6 +165,7 @@ namespace NCatboostOptions {
         CopyOptionWithNewKey(plainOptions, "bootstrap_type", "type", &bootstrapOptions, &seenKeys);
         CopyOption(plainOptions, "bagging_temperature", &bootstrapOptions, &seenKeys);
         CopyOption(plainOptions, "subsample", &bootstrapOptions, &seenKeys);
+        CopyOption(plainOptions, "top_fraction", &bootstrapOptions, &seenKeys);
 
         //cat-features
         auto& ctrOptions = trainOptions["cat_feature_params"];
@@ -43,6 +43,20 @@ Y_UNIT_TEST_SUITE(TOptionsTest) {
         }
     }
 
+    Y_UNIT_TEST(TestGossBootstrapOptions) {
+        TBootstrapConfig options(ETaskType::CPU);
+        options.Load(ReadTJsonValue("{ \"type\":\"GOSS\", \"top_fraction\":0.1, \"subsample\":0.2}"));
+        const TBootstrapConfig& constOptions = options;
+        constOptions.Validate();
+        UNIT_ASSERT_VALUES_EQUAL(constOptions.GetBootstrapType(), EBootstrapType::GOSS);
+        UNIT_ASSERT_DOUBLES_EQUAL(constOptions.GetTopFraction(), 0.1, 1e-6);
+        TestSaveLoad(options, ETaskType::CPU);
+
+        TBootstrapConfig bernoulliOptions(ETaskType::CPU);
+        bernoulliOptions.Load(ReadTJsonValue("{ \"type\":\"Bernoulli\", \"top_fraction\":0.1}"));
+        UNIT_ASSERT_EXCEPTION(bernoulliOptions.Validate(), TCatboostException);
+    }
+
     Y_UNIT_TEST(TestParseCtrParams) {
         TString ctr1 = "Buckets:TargetBorderType=GreedyLogSum:TargetBorderCount=2:Prior=1/2:Prior=2/4";
         TString ctr2 = "Borders:CtrBorderCount=33:CtrBorderType=GreedyLogSum";
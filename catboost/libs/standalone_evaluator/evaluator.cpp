@@ -22,6 +22,44 @@ namespace {
     static inline T Sigmoid(T val) {
         return 1 / (1 + exp(-val));
     }
+
+    // int16 leaf values are multiplied by the power of two scale of their tree
+    inline double DecodeLeafValue(double leafValue, const flatbuffers::Vector<float>*, size_t) {
+        return leafValue;
+    }
+
+    inline double DecodeLeafValue(float leafValue, const flatbuffers::Vector<float>*, size_t) {
+        return leafValue;
+    }
+
+    inline double DecodeLeafValue(int16_t leafValue, const flatbuffers::Vector<float>* leafValueScales, size_t treeId) {
+        return leafValue * (double)leafValueScales->Get(treeId);
+    }
+
+    template <typename TTreeSplit, typename TLeafValue>
+    double SumLeafValues(
+        const flatbuffers::Vector<int>& treeSizes,
+        const flatbuffers::Vector<TTreeSplit>& treeSplits,
+        const flatbuffers::Vector<TLeafValue>& leafValues,
+        const flatbuffers::Vector<float>* leafValueScales,
+        const std::vector<unsigned char>& binaryFeatures
+    ) {
+        double result = 0.0;
+        const auto treeCount = treeSizes.size();
+        size_t treeSplitsOffset = 0;
+        size_t leafValuesOffset = 0;
+        for (size_t treeId = 0; treeId < treeCount; ++treeId) {
+            const size_t treeSize = treeSizes.Get(treeId);
+            size_t index{};
+            for (size_t depth = 0; depth < treeSize; ++depth) {
+                index |= (binaryFeatures[treeSplits.Get(treeSplitsOffset + depth)] << depth);
+            }
+            result += DecodeLeafValue(leafValues.Get(leafValuesOffset + index), leafValueScales, treeId);
+            treeSplitsOffset += treeSize;
+            leafValuesOffset += (1 << treeSize);
+        }
+        return result;
+    }
 }
 
 namespace NCatboostStandalone {
@@ -44,19 +82,20 @@ namespace NCatboostStandalone {
             }
         }
 
+        const auto& treeSizes = *ObliviousTrees->TreeSizes();
         double result = 0.0;
-        auto treeSplitsPtr = ObliviousTrees->TreeSplits()->data();
-        const auto treeCount =  ObliviousTrees->TreeSizes()->size();
-        auto leafValuesPtr = ObliviousTrees->LeafValues()->data();
-        for (size_t treeId = 0; treeId < treeCount; ++treeId) {
-            const size_t treeSize = ObliviousTrees->TreeSizes()->Get(treeId);
-            size_t index{};
-            for (size_t depth = 0; depth < treeSize; ++depth) {
-                index |= (binaryFeatures[treeSplitsPtr[depth]] << depth);
-            }
-            result += leafValuesPtr[index];
-            treeSplitsPtr += treeSize;
-            leafValuesPtr += (1 << treeSize);
+        switch (ObliviousTrees->LeafValuesPrecision()) {
+        case NCatBoostFbs::ELeafValuesPrecision_Double:
+            result = SumLeafValues(treeSizes, *ObliviousTrees->TreeSplits(), *ObliviousTrees->LeafValues(), nullptr, binaryFeatures);
+            break;
+        case NCatBoostFbs::ELeafValuesPrecision_Float:
+            result = SumLeafValues(treeSizes, *ObliviousTrees->CompactTreeSplits(), *ObliviousTrees->FloatLeafValues(), nullptr, binaryFeatures);
+            break;
+        case NCatBoostFbs::ELeafValuesPrecision_Int16:
+            result = SumLeafValues(treeSizes, *ObliviousTrees->CompactTreeSplits(), *ObliviousTrees->Int16LeafValues(), ObliviousTrees->Int16LeafValueScales(), binaryFeatures);
+            break;
+        default:
+            throw std::runtime_error("unsupported leaf values precision");
         }
         switch(predictionType) {
         case EPredictionType::RawValue:
@@ -80,6 +119,25 @@ namespace NCatboostStandalone {
             throw std::runtime_error(
                 "trying to initialize TZeroCopyEvaluator from coreModel with categorical features");
         }
+        bool hasTreesData = false;
+        switch (ObliviousTrees->LeafValuesPrecision()) {
+        case NCatBoostFbs::ELeafValuesPrecision_Double:
+            hasTreesData = ObliviousTrees->TreeSplits() != nullptr && ObliviousTrees->LeafValues() != nullptr;
+            break;
+        case NCatBoostFbs::ELeafValuesPrecision_Float:
+            hasTreesData = ObliviousTrees->CompactTreeSplits() != nullptr && ObliviousTrees->FloatLeafValues() != nullptr;
+            break;
+        case NCatBoostFbs::ELeafValuesPrecision_Int16:
+            hasTreesData = ObliviousTrees->CompactTreeSplits() != nullptr && ObliviousTrees->Int16LeafValues() != nullptr
+                && ObliviousTrees->Int16LeafValueScales() != nullptr;
+            break;
+        default:
+            throw std::runtime_error("unsupported leaf values precision");
+        }
+        if (!hasTreesData || ObliviousTrees->TreeSizes() == nullptr) {
+            throw std::runtime_error(
+                "trying to initialize TZeroCopyEvaluator from coreModel without tree splits or leaf values");
+        }
         BinaryFeatureCount = 0;
         FloatFeatureCount = 0;
         for (const auto& ff : *ObliviousTrees->FloatFeatures()) {
@@ -330,13 +330,14 @@ void CrossValidate(
             ctx.PrevTreeLevelStats.Create(
                 ctx.LearnProgress.Folds,
                 CountNonCtrBuckets(CountSplits(ctx.LearnProgress.FloatFeatures), learnFolds[foldIdx].AllFeatures.OneHotValues),
-                static_cast<int>(ctx.Params.ObliviousTreeOptions->MaxDepth)
+                static_cast<int>(ctx.Params.ObliviousTreeOptions->MaxDepth),
+                GetBucketStatsSize(IsPlainMode(ctx.Params.BoostingOptions->BoostingType), ctx.Params.ObliviousTreeOptions->ScoreStatsPrecision)
             );
         }
         ctx.SampledDocs.Create(
             ctx.LearnProgress.Folds,
             isPairwiseScoring,
-            GetBernoulliSampleRate(ctx.Params.ObliviousTreeOptions->BootstrapConfig)
+            GetSampleRate(ctx.Params.ObliviousTreeOptions->BootstrapConfig)
         ); // TODO(espetrov): create only if sample rate < 1
     }
 
@@ -3,6 +3,7 @@
 #include <catboost/libs/helpers/vector_helpers.h>
 #include <catboost/libs/metrics/metric.h>
 #include <catboost/libs/loggers/catboost_logger_helpers.h>
+#include <catboost/libs/helpers/progress_helper.h>
 #include <catboost/libs/helpers/restorable_rng.h>
 
 static int CountGroups(const TVector<TGroupId>& queryIds) {
@@ -182,12 +183,11 @@ void CheckTestConsistency(const NCatboostOptions::TLossDescription& lossDescript
 void UpdateUndefinedRandomSeed(const NCatboostOptions::TOutputFilesOptions& outputOptions, NJson::TJsonValue* updatedJsonParams) {
     const TString snapshotFilename = TOutputFiles::AlignFilePath(outputOptions.GetTrainDir(), outputOptions.GetSnapshotFilename(), /*namePrefix=*/"");
     if (NFs::Exists(snapshotFilename)) {
-        TIFStream inputStream(snapshotFilename);
-
-        TString unusedLabel;
         TRestorableFastRng64 unusedRng(0);
         TString serializedTrainParams;
-        ::LoadMany(&inputStream, unusedLabel, unusedRng, serializedTrainParams);
+        TProgressHelper(ToString(ETaskType::CPU)).CheckedLoad(snapshotFilename, [&](IInputStream* in) {
+            ::LoadMany(in, unusedRng, serializedTrainParams);
+        });
         NJson::TJsonValue restoredJsonParams;
         ReadJsonTree(serializedTrainParams, &restoredJsonParams);
 
@@ -16,19 +16,23 @@
 #include <catboost/libs/algo/learn_context.h>
 #include <catboost/libs/algo/cv_data_partition.h>
 #include <catboost/libs/data/load_data.h>
+#include <catboost/libs/data_util/compressed_stream.h>
 #include <catboost/libs/helpers/eval_helpers.h>
 #include <catboost/libs/helpers/mem_usage.h>
 #include <catboost/libs/helpers/vector_helpers.h>
 #include <catboost/libs/logging/profile_info.h>
+#include <catboost/libs/logging/trace_session.h>
 #include <catboost/libs/loggers/logger.h>
 #include <catboost/app/output_fstr.h> // TODO(annaveronika): files from app/ should not be used here.
 
 #include <library/grid_creator/binarization.h>
+#include <library/threading/future/async.h>
 
 #include <util/random/shuffle.h>
 #include <util/generic/vector.h>
 #include <util/generic/ymath.h>
 #include <util/system/info.h>
+#include <util/thread/queue.h>
 #include <catboost/libs/loggers/catboost_logger_helpers.h>
 
 
@@ -122,6 +126,18 @@ static bool HasInvalidValues(const TVector<TVector<TVector<double>>>& leafValues
     return false;
 }
 
+// Errors of one iteration calculated on a copy of approxes, so the next tree can be built meanwhile
+struct TAsyncIterationErrors {
+    ui32 Iteration = 0;
+    bool CalcMetrics = false;
+    TVector<TVector<double>> LearnApprox; // [dim][doc]
+    TVector<TVector<TVector<double>>> TestApprox; // [test][dim][doc]
+    TVector<double> LearnErrors; // [metric]
+    TVector<TVector<double>> TestErrors; // [test][metric]
+    TProfileResults ProfileResults{/*passedTime*/ 0, /*remainingTime*/ 0};
+    NThreading::TFuture<void> Done;
+};
+
 static void Train(
     const TDataset& learnData,
     const TDatasetPtrs& testDataPtrs,
@@ -205,29 +221,17 @@ static void Train(
         ctx->PrevTreeLevelStats.Create(
             ctx->LearnProgress.Folds,
             CountNonCtrBuckets(CountSplits(ctx->LearnProgress.FloatFeatures), learnData.AllFeatures.OneHotValues),
-            static_cast<int>(ctx->Params.ObliviousTreeOptions->MaxDepth)
+            static_cast<int>(ctx->Params.ObliviousTreeOptions->MaxDepth),
+            GetBucketStatsSize(IsPlainMode(ctx->Params.BoostingOptions->BoostingType), ctx->Params.ObliviousTreeOptions->ScoreStatsPrecision)
         );
     }
     ctx->SampledDocs.Create(
         ctx->LearnProgress.Folds,
         isPairwiseScoring,
-        GetBernoulliSampleRate(ctx->Params.ObliviousTreeOptions->BootstrapConfig)
+        GetSampleRate(ctx->Params.ObliviousTreeOptions->BootstrapConfig)
     ); // TODO(espetrov): create only if sample rate < 1
 
-    for (ui32 iter = ctx->LearnProgress.TreeStruct.ysize(); iter < ctx->Params.BoostingOptions->IterationCount; ++iter) {
-        profile.StartNextIteration();
-
-        trainOneIterationFunc(learnData, testDataPtrs, ctx);
-
-        bool calcMetrics = DivisibleOrLastIteration(
-            iter,
-            ctx->Params.BoostingOptions->IterationCount,
-            ctx->OutputOptions.GetMetricPeriod()
-        );
-
-        CalcErrors(learnData, testDataPtrs, metrics, calcMetrics, ctx);
-
-        profile.AddOperation("Calc errors");
+    const auto addErrorsToTrackers = [&](ui32 iter, bool calcMetrics, const TVector<TVector<TVector<double>>>& testApprox) {
         if (hasTest) {
             // Use only (test0, metric0) for overfitting detection
             const int testIdxToLog = 0;
@@ -236,14 +240,13 @@ static void Train(
             if (calcMetrics) {
                 bestModelErrorTracker.AddError(ctx->LearnProgress.MetricsAndTimeHistory.TestMetricsHistory.back()[testIdxToLog][metricIdxToLog], iter);
                 if (useBestModel && iter == static_cast<ui32>(bestModelErrorTracker.GetBestIteration())) {
-                    ctx->LearnProgress.BestTestApprox = ctx->LearnProgress.TestApprox[0];
+                    ctx->LearnProgress.BestTestApprox = testApprox[0];
                 }
             }
         }
+    };
 
-        profile.FinishIteration();
-
-        TProfileResults profileResults = profile.GetProfileResults();
+    const auto logErrors = [&](bool calcMetrics, const TProfileResults& profileResults) {
         ctx->LearnProgress.MetricsAndTimeHistory.TimeHistory.push_back({profileResults.PassedTime, profileResults.RemainingTime});
 
         Log(
@@ -259,6 +262,114 @@ static void Train(
             calcMetrics,
             &logger
         );
+    };
+
+    // Snapshot must contain errors for all its trees, and custom metrics may not be callable from another thread
+    const bool useAsyncMetrics = ctx->OutputOptions.UseAsyncMetrics()
+        && !ctx->OutputOptions.SaveSnapshot()
+        && !ctx->EvalMetricDescriptor.Defined();
+    if (ctx->OutputOptions.UseAsyncMetrics() && !useAsyncMetrics) {
+        MATRIXNET_WARNING_LOG << "Warning: async_metrics is ignored with save_snapshot or custom eval metric" << Endl;
+    }
+    const bool hasLearn = learnData.GetSampleCount() > 0;
+    TAsyncIterationErrors asyncErrors; // approx copies are reused between iterations
+    bool hasAsyncErrors = false;
+    TMtpQueue asyncErrorsQueue; // declared after asyncErrors, so it is stopped before asyncErrors are destroyed
+    if (useAsyncMetrics) {
+        asyncErrorsQueue.Start(1);
+    }
+
+    const auto startAsyncErrors = [&](ui32 iter, bool calcMetrics) {
+        asyncErrors.Iteration = iter;
+        asyncErrors.CalcMetrics = calcMetrics;
+        if (hasLearn && calcMetrics) {
+            asyncErrors.LearnApprox = ctx->LearnProgress.AvrgApprox;
+        }
+        if (hasTest) {
+            asyncErrors.TestApprox = ctx->LearnProgress.TestApprox;
+        }
+        asyncErrors.LearnErrors.clear();
+        asyncErrors.TestErrors.clear();
+        asyncErrors.Done = NThreading::Async([&, calcMetrics]() {
+            CalcErrors(
+                learnData,
+                testDataPtrs,
+                metrics,
+                calcMetrics,
+                asyncErrors.LearnApprox,
+                asyncErrors.TestApprox,
+                &ctx->LocalExecutor,
+                hasLearn ? &asyncErrors.LearnErrors : nullptr,
+                hasTest ? &asyncErrors.TestErrors : nullptr
+            );
+        }, asyncErrorsQueue);
+        hasAsyncErrors = true;
+    };
+
+    const auto finishAsyncErrors = [&]() {
+        hasAsyncErrors = false;
+        asyncErrors.Done.GetValueSync(); // rethrows errors of metric calculation
+        if (hasLearn) {
+            ctx->LearnProgress.MetricsAndTimeHistory.LearnMetricsHistory.push_back(std::move(asyncErrors.LearnErrors));
+        }
+        if (hasTest) {
+            ctx->LearnProgress.MetricsAndTimeHistory.TestMetricsHistory.push_back(std::move(asyncErrors.TestErrors));
+        }
+        addErrorsToTrackers(asyncErrors.Iteration, asyncErrors.CalcMetrics, asyncErrors.TestApprox);
+        logErrors(asyncErrors.CalcMetrics, asyncErrors.ProfileResults);
+    };
+
+    for (ui32 iter = ctx->LearnProgress.TreeStruct.ysize(); iter < ctx->Params.BoostingOptions->IterationCount; ++iter) {
+        profile.StartNextIteration();
+
+        trainOneIterationFunc(learnData, testDataPtrs, ctx);
+
+        bool calcMetrics = DivisibleOrLastIteration(
+            iter,
+            ctx->Params.BoostingOptions->IterationCount,
+            ctx->OutputOptions.GetMetricPeriod()
+        );
+
+        if (useAsyncMetrics) {
+            // errors of the previous iteration were calculated while this tree was built,
+            // so overfitting detector stops training one iteration later than without async metrics
+            bool isNeedStop = false;
+            if (hasAsyncErrors) {
+                finishAsyncErrors();
+                isNeedStop = overfittingDetectorErrorTracker.GetIsNeedStop();
+                profile.AddOperation("Wait for previous iteration errors");
+            }
+            startAsyncErrors(iter, calcMetrics);
+            profile.AddOperation("Copy approxes for errors");
+            profile.FinishIteration();
+            asyncErrors.ProfileResults = profile.GetProfileResults();
+
+            if (HasInvalidValues(ctx->LearnProgress.LeafValues)) {
+                finishAsyncErrors();
+                ctx->LearnProgress.LeafValues.pop_back();
+                ctx->LearnProgress.TreeStruct.pop_back();
+                MATRIXNET_WARNING_LOG << "Training has stopped (degenerate solution on iteration "
+                    << iter << ", probably too small l2-regularization, try to increase it)" << Endl;
+                break;
+            }
+
+            if (isNeedStop) {
+                finishAsyncErrors();
+                MATRIXNET_NOTICE_LOG << "Stopped by overfitting detector "
+                    << " (" << overfittingDetectorErrorTracker.GetOverfittingDetectorIterationsWait() << " iterations wait)" << Endl;
+                break;
+            }
+            continue;
+        }
+
+        CalcErrors(learnData, testDataPtrs, metrics, calcMetrics, ctx);
+
+        profile.AddOperation("Calc errors");
+        addErrorsToTrackers(iter, calcMetrics, ctx->LearnProgress.TestApprox);
+
+        profile.FinishIteration();
+
+        logErrors(calcMetrics, profile.GetProfileResults());
 
         ctx->SaveProgress();
 
@@ -276,6 +387,9 @@ static void Train(
             break;
         }
     }
+    if (hasAsyncErrors) {
+        finishAsyncErrors();
+    }
 
     if (hasTest) {
         (*testMultiApprox) = ctx->LearnProgress.TestApprox;
@@ -371,6 +485,11 @@ class TCPUModelTrainer : public IModelTrainer {
 
         auto loggingGuard = Finally([&] { SetSilentLogingMode(); });
 
+        THolder<TTraceSession> traceSession;
+        if (updatedOutputOptions.NeedTrace()) {
+            traceSession = MakeHolder<TTraceSession>(updatedOutputOptions.CreateTraceFullPath());
+        }
+
         TVector<ui64> indices(learnPool.Docs.GetDocCount());
         std::iota(indices.begin(), indices.end(), 0);
 
@@ -561,6 +680,7 @@ class TCPUModelTrainer : public IModelTrainer {
                 catFeatureParams.CtrLeafCountLimit,
                 catFeatureParams.StoreAllSimpleCtrs,
                 catFeatureParams.CounterCalcMethod,
+                &ctx.LocalExecutor,
                 &resTable
             );
             resTable.ModelCtrBase = ctr;
@@ -700,7 +820,7 @@ class TCPUModelTrainer : public IModelTrainer {
                 MATRIXNET_WARNING_LOG << "No test files, can't output columns\n";
             }
             MATRIXNET_INFO_LOG << "Writing test eval to: " << evalFileName << Endl;
-            TOFStream fileStream(evalFileName);
+            THolder<IOutputStream> fileStream = NCB::OpenFileOutput(evalFileName);
             for (int testIdx = 0; testIdx < testPools.ysize(); ++testIdx) {
                 const TPool& testPool = testPools[testIdx];
                 const NCB::TPathWithScheme& testSetPath = testIdx < loadOptions.TestSetPaths.ysize() ? loadOptions.TestSetPaths[testIdx] : NCB::TPathWithScheme();
@@ -709,7 +829,7 @@ class TCPUModelTrainer : public IModelTrainer {
                                                   visibleLabelsHelper,
                                                   testPool,
                                                   false,
-                                                  &fileStream,
+                                                  fileStream.Get(),
                                                   testSetPath,
                                                   {testIdx, testPools.ysize()},
                                                   loadOptions.DsvPoolFormatParams.Format,
@@ -722,7 +842,7 @@ class TCPUModelTrainer : public IModelTrainer {
                                             visibleLabelsHelper,
                                             TPool(),
                                             false,
-                                            &fileStream,
+                                            fileStream.Get(),
                                             NCB::TPathWithScheme(),
                                             {0, 1},
                                             loadOptions.DsvPoolFormatParams.Format,
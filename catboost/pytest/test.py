@@ -7,6 +7,7 @@ import csv
 import numpy as np
 import time
 import json
+import struct
 
 import catboost
 from catboost_pytest_lib import data_file, local_canonical_file, remove_time_from_json
@@ -1927,6 +1928,77 @@ def test_classification_progress_restore(boosting_type):
     # assert filecmp.cmp(canon_model_path, model_path)
 
 
+def run_progress_restore(iters, model_path, eval_path, progress_path, codec=None, log_path=None):
+    cmd = [
+        CATBOOST_PATH,
+        'fit',
+        '--loss-function', 'Logloss',
+        '--learning-rate', '0.5',
+        '-f', data_file('adult', 'train_small'),
+        '-t', data_file('adult', 'test_small'),
+        '--column-description', data_file('adult', 'train.cd'),
+        '-i', str(iters),
+        '-T', '4',
+        '-r', '0',
+        '-m', model_path,
+        '--eval-file', eval_path,
+        '--snapshot-file', progress_path,
+        '--logging-level', 'Info',
+    ]
+    if codec:
+        cmd += ['--snapshot-codec', codec]
+    if log_path:
+        with open(log_path, 'w') as log:
+            yatest.common.execute(cmd, stdout=log, stderr=log)
+    else:
+        yatest.common.execute(cmd)
+
+
+def read_progress_label(progress_path):
+    with open(progress_path, 'rb') as f:
+        header = f.read(64)
+    # label is saved as little endian ui32 length followed by characters
+    label_size = struct.unpack('<I', header[:4])[0]
+    return header[4:4 + label_size]
+
+
+@pytest.mark.parametrize('codec', ['lz4', 'zstd08_1'])
+def test_compressed_progress_restore(codec):
+    canon_eval_path = yatest.common.test_output_path('canon_test.eval')
+    run_progress_restore(30, yatest.common.test_output_path('canon_model.bin'), canon_eval_path,
+                         yatest.common.test_output_path('canon.cbp'))
+
+    model_path = yatest.common.test_output_path('model.bin')
+    eval_path = yatest.common.test_output_path('test.eval')
+    progress_path = yatest.common.test_output_path('test.cbp')
+    log_path = yatest.common.test_output_path('log')
+    run_progress_restore(15, model_path, eval_path, progress_path, codec=codec)
+    assert read_progress_label(progress_path) == 'CPU:' + codec
+
+    run_progress_restore(30, model_path, eval_path, progress_path, codec=codec, log_path=log_path)
+    assert 'Loaded progress file containing 15 trees' in open(log_path).read()
+    assert filecmp.cmp(canon_eval_path, eval_path)
+
+
+def test_uncompressed_progress_restore_with_codec():
+    canon_eval_path = yatest.common.test_output_path('canon_test.eval')
+    run_progress_restore(30, yatest.common.test_output_path('canon_model.bin'), canon_eval_path,
+                         yatest.common.test_output_path('canon.cbp'))
+
+    model_path = yatest.common.test_output_path('model.bin')
+    eval_path = yatest.common.test_output_path('test.eval')
+    progress_path = yatest.common.test_output_path('test.cbp')
+    log_path = yatest.common.test_output_path('log')
+    run_progress_restore(15, model_path, eval_path, progress_path)
+    assert read_progress_label(progress_path) == 'CPU'
+
+    # snapshot written without codec is loaded as is and rewritten compressed
+    run_progress_restore(30, model_path, eval_path, progress_path, codec='lz4', log_path=log_path)
+    assert 'Loaded progress file containing 15 trees' in open(log_path).read()
+    assert read_progress_label(progress_path) == 'CPU:lz4'
+    assert filecmp.cmp(canon_eval_path, eval_path)
+
+
 @pytest.mark.parametrize('loss_function', CLASSIFICATION_LOSSES)
 @pytest.mark.parametrize('prediction_type', PREDICTION_TYPES)
 @pytest.mark.parametrize('boosting_type', BOOSTING_TYPE)
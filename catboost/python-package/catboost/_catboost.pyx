@@ -192,6 +192,7 @@ cdef extern from "catboost/libs/model/model.h":
         THashMap[TString, TString] ModelInfo
         void Swap(TFullModel& other) except +ProcessException
         size_t GetTreeCount() nogil except +ProcessException
+        void Truncate(size_t begin, size_t end) except +ProcessException
 
     cdef cppclass EModelType:
         pass
@@ -361,6 +362,17 @@ cdef extern from "catboost/libs/algo/apply.h":
         int threadCount
     ) nogil except +ProcessException
 
+    cdef cppclass TStagedModelCalcer:
+        TStagedModelCalcer(
+            const TFullModel& model,
+            const TPool& pool,
+            int begin,
+            int end,
+            int evalPeriod,
+            int threadCount
+        ) nogil except +ProcessException
+        bool_t Next(const EPredictionType predictionType, TVector[TVector[double]]* prediction) nogil except +ProcessException
+
 cdef extern from "catboost/libs/algo/helpers.h":
     cdef void ConfigureMalloc() nogil except *
 
@@ -1205,7 +1217,7 @@ cdef class _CatBoost:
         return indices, scores
 
     cpdef _base_shrink(self, int ntree_start, int ntree_end):
-        self.__model.ObliviousTrees.Truncate(ntree_start, ntree_end)
+        self.__model.Truncate(ntree_start, ntree_end)
 
     cpdef _load_model(self, model_file, format):
         cdef TFullModel tmp_model
@@ -1369,7 +1381,7 @@ cpdef _cv(dict params, _PoolBase pool, int fold_count, bool_t inverted, int part
 
 
 cdef class _StagedPredictIterator:
-    cdef TVector[TVector[double]] __approx
+    cdef TStagedModelCalcer* __calcer
     cdef TFullModel* __model
     cdef _PoolBase pool
     cdef str prediction_type
@@ -1378,6 +1390,14 @@ cdef class _StagedPredictIterator:
 
     cdef set_model(self, TFullModel* model):
         self.__model = model
+        self.__calcer = new TStagedModelCalcer(
+            dereference(self.__model),
+            dereference(self.pool.__pool),
+            self.ntree_start,
+            self.ntree_end,
+            self.eval_period,
+            self.thread_count
+        )
 
     def __cinit__(self, _PoolBase pool, str prediction_type, int ntree_start, int ntree_end, int eval_period, int thread_count, verbose):
         self.pool = pool
@@ -1389,32 +1409,16 @@ cdef class _StagedPredictIterator:
         self.verbose = verbose
 
     def __dealloc__(self):
-        pass
+        del self.__calcer
 
     def __deepcopy__(self, _):
         raise CatboostError('Can\'t deepcopy _StagedPredictIterator object')
 
     def next(self):
-        if self.ntree_start >= self.ntree_end:
-            raise StopIteration
-
         cdef TVector[TVector[double]] pred
         cdef EPredictionType predictionType = PyPredictionType(self.prediction_type).predictionType
-        pred = ApplyModelMulti(dereference(self.__model),
-                               dereference(self.pool.__pool),
-                               self.verbose,
-                               PyPredictionType('RawFormulaVal').predictionType,
-                               self.ntree_start,
-                               min(self.ntree_start + self.eval_period, self.ntree_end),
-                               self.thread_count)
-        if self.__approx.empty():
-            self.__approx = pred
-        else:
-            for i in range(self.__approx.size()):
-                for j in range(self.__approx[0].size()):
-                    self.__approx[i][j] += pred[i][j]
-        pred = PrepareEval(predictionType, self.__approx, 1)
-        self.ntree_start += self.eval_period
+        if not self.__calcer.Next(predictionType, &pred):
+            raise StopIteration
         return [[value for value in vec] for vec in pred]
 
 